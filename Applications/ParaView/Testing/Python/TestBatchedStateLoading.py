@@ -0,0 +1,66 @@
+import os
+
+from paraview import servermanager
+from paraview.vtk.util.misc import vtkGetTempDir
+import paraview.simple as smp
+
+
+# Make sure the test driver know that process has properly started
+print ("Process started")
+
+
+def getHost(url):
+   return url.split(':')[1][2:]
+
+
+def getPort(url):
+   return int(url.split(':')[2])
+
+
+def runTest():
+
+    options = servermanager.vtkProcessModule.GetProcessModule().GetOptions()
+    url = options.GetServerURL()
+
+    smp.Connect(getHost(url), getPort(url))
+
+    numSpheres = 20
+    for i in range(numSpheres):
+        sphere = smp.Sphere(Radius=i + 1, ThetaResolution=16)
+        smp.Shrink(Input=sphere, ShrinkFactor=0.5)
+
+    filename = os.path.join(vtkGetTempDir(), "TestBatchedStateLoading.pvsm")
+    smp.SaveState(filename)
+    smp.ResetSession()
+
+    # Loading state without a loader uses batched loading in client-server
+    # mode, hence the proxies are pushed with PUSH_BATCH requests.
+    session = servermanager.ActiveConnection.Session
+    smp.LoadState(filename)
+    os.remove(filename)
+
+    messages = session.GetPushStateBatchNumberOfMessages()
+    requests = session.GetPushStateBatchNumberOfRequests()
+    print("Messages: %d, Requests: %d" % (messages, requests))
+    assert messages >= 2 * numSpheres
+    assert requests > 0 and requests < messages
+
+    # The state must have reached the server and the deferred pipeline
+    # information must have been updated.
+    sources = servermanager.ProxyManager().GetProxiesInGroup("sources")
+    radii = []
+    for proxy in sources.values():
+        if proxy.GetXMLName() == "SphereSource":
+            # the poles of the sphere are at +/- Radius along Z.
+            bounds = proxy.GetDataInformation().GetBounds()
+            assert abs((bounds[5] - bounds[4]) / 2 - proxy.Radius) < 1e-3 * proxy.Radius
+            radii.append(proxy.Radius)
+        else:
+            assert proxy.Input is not None
+            assert proxy.GetDataInformation().GetNumberOfCells() > 0
+    assert sorted(radii) == [i + 1 for i in range(numSpheres)]
+
+    smp.Disconnect()
+
+
+runTest()
@@ -0,0 +1,40 @@
+from paraview import servermanager
+from paraview.benchmark import harness
+import paraview.simple as smp
+
+
+# Make sure the test driver know that process has properly started
+print ("Process started")
+
+
+def runTest():
+    options = servermanager.vtkProcessModule.GetProcessModule().GetOptions()
+    url = options.GetServerURL()
+    # the test driver gives the port of the server.
+    assert url.split(':')[2]
+
+    harness.connect()
+    assert servermanager.ActiveConnection is not None
+    assert servermanager.ActiveConnection.IsRemote()
+
+    def measure(value):
+        with harness.Timer() as timer:
+            pass
+        return timer.elapsed, value
+
+    elapsed, value = harness.average(measure, 3, 'result')
+    assert elapsed >= 0.0 and value == 'result'
+    assert harness.identical([[1, 2], None], [[1, 2], None])
+    assert not harness.identical([[1, 2]], [[1, 3]])
+
+    arguments = [
+        (('-n', '--number'), dict(dest='number', default=1, type=int,
+                                  help='Number')),
+    ]
+    assert harness.main(lambda number: number * 2, 'Test', arguments,
+                        ['-n', '21']) == 42
+
+    smp.Disconnect()
+
+
+runTest()
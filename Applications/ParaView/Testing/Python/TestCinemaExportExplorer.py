@@ -0,0 +1,110 @@
+# Tests the explorer and the store of paraview.detail.cinemaexport: the samples
+# whose file is already in the database are left out (SkipExistingFiles), each
+# time compartment explores its own share of the samples (DistributeCameras),
+# filter tracks are only executed when their value changes and only the first
+# compartment writes the description of the database.
+from __future__ import print_function
+import os
+import shutil
+
+from paraview.vtk.util.misc import vtkGetTempDir
+import paraview.detail.cinemaexport as cinemaexport
+from paraview.tpl.cinema_python.adaptors import explorers
+import paraview.tpl.cinema_python.adaptors.paraview.pv_explorers as pv_explorers
+from paraview.tpl.cinema_python.database import file_store
+from paraview.tpl.cinema_python.database import store
+
+directory = os.path.join(vtkGetTempDir(), "TestCinemaExportExplorer")
+if os.path.isdir(directory):
+    shutil.rmtree(directory)
+dbfilename = os.path.join(directory, "info.json")
+
+contours = [1.0, 2.0]
+phis = [0, 90, 180]
+definition = file_store.FileStore(dbfilename)
+definition.filename_pattern = "{contour}/{phi}.png"
+definition.add_parameter("contour", store.make_parameter("contour", contours))
+definition.add_parameter("phi", store.make_parameter("phi", phis))
+# the camera is innermost, as optimize_traversal_order does.
+parameters = ["contour", "phi"]
+samples = [(c, p) for c in contours for p in phis]
+
+class Filter(object):
+    """Records the values set by a Templated track."""
+    def __init__(self):
+        self.Values = []
+
+    def SetPropertyWithName(self, name, value):
+        self.Values.append(value[0])
+
+class Camera(explorers.Track):
+    """Records the samples, as the camera track runs for each of them."""
+    def __init__(self):
+        super(Camera, self).__init__()
+        self.Samples = []
+
+    def execute(self, doc):
+        self.Samples.append((doc.descriptor["contour"], doc.descriptor["phi"]))
+
+def run(cs, skipExisting=False, share=(0, 1)):
+    """Explores the samples without a view, hence without rendering, and
+    returns the values set on the filter and the samples explored."""
+    filt = Filter()
+    camera = Camera()
+    tracks = [pv_explorers.Templated("contour", filt, "ContourValues"), camera]
+    explorer = cinemaexport.ImageExplorer(cs, parameters, tracks,
+                                          skipExisting=skipExisting,
+                                          share=share)
+    explorer.prepare()
+    for desc in cs.iterate(parameters):
+        explorer.execute(desc)
+    return filt.Values, camera.Samples
+
+cs = cinemaexport.FileStore(dbfilename, definition)
+
+# the filter is only updated when the contour value changes.
+values, explored = run(cs)
+print(values, explored)
+if explored != samples:
+    raise RuntimeError("Expected the samples %s" % samples)
+if values != contours:
+    raise RuntimeError("Expected the contour values %s" % contours)
+
+# each compartment explores every other sample.
+values, explored = run(cs, share=(1, 2))
+print(values, explored)
+if explored != samples[1::2]:
+    raise RuntimeError("Expected the samples %s" % samples[1::2])
+if values != contours:
+    raise RuntimeError("Expected the contour values %s" % contours)
+
+# the samples whose file exists are left out, empty files are rendered again.
+def touch(desc, content):
+    fname = cs.get_file_name(desc)
+    if not os.path.isdir(os.path.dirname(fname)):
+        os.makedirs(os.path.dirname(fname))
+    with open(fname, "w") as f:
+        f.write(content)
+
+touch({"contour": 1.0, "phi": 0}, "image")
+touch({"contour": 1.0, "phi": 90}, "image")
+touch({"contour": 1.0, "phi": 180}, "")
+touch({"contour": 2.0, "phi": 90}, "image")
+values, explored = run(cs, skipExisting=True)
+print(values, explored)
+expected = [(1.0, 180), (2.0, 0), (2.0, 180)]
+if explored != expected:
+    raise RuntimeError("Expected the samples %s" % expected)
+if values != contours:
+    raise RuntimeError("Expected the contour values %s" % contours)
+
+# only the first compartment writes the description.
+other = cinemaexport.FileStore(dbfilename, definition, writeDescription=False)
+other.save()
+if os.path.exists(dbfilename):
+    raise RuntimeError("%s written by another compartment" % dbfilename)
+cs.save()
+if not os.path.isfile(dbfilename):
+    raise RuntimeError("%s not written" % dbfilename)
+
+shutil.rmtree(directory)
@@ -0,0 +1,68 @@
+# Client-server variant of ParaViewCore/ServerManager/Core/Testing/Cxx/TestPushStateBatch.cxx:
+# messages pushed in a batch are sent to pvserver in PUSH_BATCH requests.
+from paraview import servermanager
+import paraview.simple as smp
+
+
+# Make sure the test driver know that process has properly started
+print ("Process started")
+
+
+def getHost(url):
+   return url.split(':')[1][2:]
+
+
+def getPort(url):
+   return int(url.split(':')[2])
+
+
+def newSphere(pxm, radius):
+    sphere = pxm.NewProxy("sources", "SphereSource")
+    sphere.GetProperty("Radius").SetElement(0, radius)
+    sphere.UpdateVTKObjects()
+    return sphere
+
+
+def runTest():
+
+    options = servermanager.vtkProcessModule.GetProcessModule().GetOptions()
+    url = options.GetServerURL()
+
+    smp.Connect(getHost(url), getPort(url))
+
+    session = servermanager.ActiveConnection.Session
+    pxm = session.GetSessionProxyManager()
+
+    spheres = []
+    session.BeginPushStateBatch()
+    # nested batches are merged in the outermost one.
+    session.BeginPushStateBatch()
+    for cc in range(5):
+        spheres.append(newSphere(pxm, cc + 1))
+    session.EndPushStateBatch()
+    assert session.GetInPushStateBatch(), "batch ended by nested batch"
+    for cc in range(5, 10):
+        spheres.append(newSphere(pxm, cc + 1))
+    session.EndPushStateBatch()
+    assert not session.GetInPushStateBatch(), "batch not ended"
+
+    messages = session.GetPushStateBatchNumberOfMessages()
+    requests = session.GetPushStateBatchNumberOfRequests()
+    print("Messages: %d, Bytes: %d, Requests: %d" %
+          (messages, session.GetPushStateBatchNumberOfBytes(), requests))
+    assert messages >= 10 and session.GetPushStateBatchNumberOfBytes() > 0
+    # pushes are sent together, not one request per message.
+    assert requests > 0 and requests < messages
+
+    # Batching must not change the state pushed.
+    for cc, sphere in enumerate(spheres):
+        sphere.UpdatePipeline()
+        bounds = sphere.GetDataInformation().GetBounds()
+        # the poles of the sphere are at +/- Radius along Z.
+        assert abs((bounds[5] - bounds[4]) / 2 - (cc + 1)) < 1e-3 * (cc + 1), \
+            "state not pushed for proxy %d" % cc
+
+    smp.Disconnect()
+
+
+runTest()
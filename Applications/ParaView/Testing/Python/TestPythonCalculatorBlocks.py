@@ -0,0 +1,52 @@
+# Tests the Python Calculator evaluating its expression on each block of a
+# multiblock dataset (EvaluateBlocksIndependently) and the names it looks for
+# in an expression to convert only the arrays it uses.
+from paraview.simple import *
+from paraview import servermanager
+from paraview.detail.calculator import get_referenced_names
+from vtkmodules.numpy_interface import dataset_adapter as dsa
+import numpy
+
+# names used in nested scopes are found too.
+names = get_referenced_names("list(map(lambda x: x * Normals, [1, 2]))")
+print(names)
+assert 'Normals' in names and 'map' in names
+names = get_referenced_names("[mag(Normals[i]) for i in range(2)]")
+print(names)
+assert 'Normals' in names and 'mag' in names and 'range' in names
+names = get_referenced_names("sum([x for x in Normals[:,0] if x > Radius])")
+assert 'Normals' in names and 'Radius' in names
+assert get_referenced_names("Normals[") is None
+
+large = Sphere(Radius=1.0)
+small = Sphere(Radius=0.5, ThetaResolution=16)
+group = GroupDatasets(Input=[large, small])
+
+def evaluate(expression, independently):
+    """Returns the points and the result array of each leaf of the output."""
+    calculator = PythonCalculator(Input=group, Expression=expression,
+                                  EvaluateBlocksIndependently=independently)
+    output = dsa.WrapDataObject(servermanager.Fetch(calculator))
+    Delete(calculator)
+    leaves = [(leaf.Points, leaf.PointData['result']) for leaf in output
+              if leaf.GetNumberOfPoints() > 0]
+    assert len(leaves) > 0
+    return leaves
+
+# element-wise expressions give the same values on each block.
+expression = "Normals[:,0] * 2 + inputs[0].Points[:,1]"
+whole = evaluate(expression, 0)
+blocks = evaluate(expression, 1)
+assert len(whole) == len(blocks)
+for (points, a), (_, b) in zip(whole, blocks):
+    assert numpy.array_equal(a, b)
+
+# functions combining values operate on each block alone, so the largest x
+# coordinate is the radius of the block's sphere.
+expression = "max(inputs[0].Points[:,0])"
+for independently in (0, 1):
+    for points, result in evaluate(expression, independently):
+        radius = numpy.max(numpy.linalg.norm(points, axis=1))
+        expected = radius if independently else 1.0
+        print(independently, radius, result[0])
+        assert numpy.allclose(result, expected, atol=1e-6)
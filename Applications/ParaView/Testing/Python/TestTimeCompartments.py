@@ -0,0 +1,111 @@
+# Tests saving an animation with pvbatch split into time compartments
+# (--time-compartments): each compartment saves its own share of the frames
+# and the files must be numbered as when a single group of processes saves the
+# whole animation. Only the first compartment saves screenshots and data. The
+# test is run both ways: the single group run keeps its files, which the run
+# with compartments compares its own files to.
+from __future__ import print_function
+import os
+import shutil
+from paraview.simple import *
+from paraview import servermanager
+from paraview.vtk.util.misc import vtkGetTempDir
+
+pm = servermanager.vtkProcessModule
+numCompartments = pm.GetNumberOfTimeCompartments()
+compartment = pm.GetTimeCompartmentId()
+print("compartment %d of %d" % (compartment, numCompartments))
+
+numFrames = 9
+directory = os.path.join(vtkGetTempDir(), "TestTimeCompartments-%d" % numCompartments)
+if compartment == 0 and os.path.isdir(directory):
+    shutil.rmtree(directory)
+
+renderView = CreateView('RenderView')
+renderView.ViewSize = [200, 200]
+sphere = Sphere(ThetaResolution=32, PhiResolution=32)
+Show(sphere, renderView)
+ResetCamera(renderView)
+
+scene = GetAnimationScene()
+scene.PlayMode = 'Sequence'
+scene.StartTime = 0
+scene.EndTime = 1
+scene.NumberOfFrames = numFrames
+track = GetAnimationTrack('EndTheta', proxy=sphere)
+track.KeyFrames = [CompositeKeyFrame(KeyTime=0, KeyValues=[30]),
+                   CompositeKeyFrame(KeyTime=1, KeyValues=[360])]
+
+def wait_for_compartments(step):
+    """Waits for the first process of every compartment to reach `step`. The
+    script only runs on those processes, hence point to point messages are
+    used rather than a collective call."""
+    if numCompartments == 1:
+        return
+    from mpi4py import MPI
+    world = MPI.COMM_WORLD
+    if world.Get_rank() == 0:
+        for i in range(numCompartments - 1):
+            world.recv(source=MPI.ANY_SOURCE, tag=step)
+        for r in range(1, world.Get_size()):
+            if r * numCompartments // world.Get_size() != \
+                (r - 1) * numCompartments // world.Get_size():
+                world.send(step, dest=r, tag=step)
+    else:
+        world.send(step, dest=0, tag=step)
+        world.recv(source=0, tag=step)
+
+# the first compartment cleans up the files of an earlier run first.
+wait_for_compartments(1)
+if not os.path.isdir(directory):
+    try:
+        os.makedirs(directory)
+    except OSError:
+        pass
+SaveAnimation(os.path.join(directory, "frames.png"), renderView,
+              ImageResolution=[200, 200])
+scene.AnimationTime = 0.5
+SaveScreenshot(os.path.join(directory, "screenshot.png"), renderView,
+               ImageResolution=[200, 200])
+SaveData(os.path.join(directory, "sphere.csv"), proxy=sphere)
+wait_for_compartments(2)
+
+def read_rows(fname):
+    """Returns the header and the set of rows of a CSV file. The pieces of the
+    sphere differ with the number of processes, so the rows are compared
+    regardless of their order and of the points shared by several pieces."""
+    with open(fname) as f:
+        lines = f.read().splitlines()
+    return lines[0], set(lines[1:])
+
+def compare_to_reference(reference):
+    from paraview.vtk.vtkTestingRendering import vtkTesting
+    for fname in sorted(os.listdir(directory)):
+        path = os.path.join(directory, fname)
+        expected = os.path.join(reference, fname)
+        if fname.endswith(".csv"):
+            if read_rows(path) != read_rows(expected):
+                raise RuntimeError("%s differs from %s" % (path, expected))
+            continue
+        testing = vtkTesting()
+        testing.AddArgument("-T")
+        testing.AddArgument(vtkGetTempDir())
+        testing.AddArgument("-V")
+        testing.AddArgument(expected)
+        if testing.RegressionTest(path, 10) != testing.PASSED:
+            raise RuntimeError("%s differs from %s" % (path, expected))
+
+if compartment == 0:
+    files = sorted(os.listdir(directory))
+    print(files)
+    expected = sorted(["frames.%04d.png" % i for i in range(numFrames)] +
+                      ["screenshot.png", "sphere.csv"])
+    if files != expected:
+        raise RuntimeError("Expected %s" % expected)
+    if numCompartments > 1:
+        reference = os.path.join(vtkGetTempDir(), "TestTimeCompartments-1")
+        if not os.path.isdir(reference):
+            raise RuntimeError("%s is missing, run the test without "
+                               "compartments first" % reference)
+        compare_to_reference(reference)
+        shutil.rmtree(directory)
@@ -22,6 +22,7 @@
 #include "vtkMultiProcessController.h"
 #include "vtkNew.h"
 #include "vtkObjectFactory.h"
+#include "vtkProcessModule.h"
 #include "vtkPVProgressHandler.h"
 #include "vtkPVRenderingCapabilitiesInformation.h"
 #include "vtkPVServerInformation.h"
@@ -38,12 +39,49 @@
 #include "vtkSMViewLayoutProxy.h"
 #include "vtkSMViewProxy.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
 #include <vtksys/SystemTools.hxx>
 
 namespace vtkSMSaveAnimationProxyNS
 {
 
+/**
+ * Restricts `frameWindow` to the frames saved by the local time compartment
+ * (see vtkProcessModule::GetTimeCompartmentId). Frames are split in
+ * contiguous ranges so that each compartment reads consecutive timesteps.
+ * Returns false, leaving `frameWindow` unchanged, if the local compartment
+ * has no frame to save.
+ */
+bool SelectTimeCompartmentFrames(int frameWindow[2])
+{
+  const int numCompartments = vtkProcessModule::GetNumberOfTimeCompartments();
+  if (numCompartments <= 1)
+  {
+    return true;
+  }
+  const int compartment = vtkProcessModule::GetTimeCompartmentId();
+  const int numFrames = frameWindow[1] - frameWindow[0] + 1;
+  const int share = numFrames / numCompartments;
+  const int remainder = numFrames % numCompartments;
+  const int count = share + (compartment < remainder ? 1 : 0);
+  if (count == 0)
+  {
+    return false;
+  }
+  frameWindow[0] += compartment * share + std::min(compartment, remainder);
+  frameWindow[1] = frameWindow[0] + count - 1;
+  return true;
+}
+
 class SceneGrabber
 {
 public:
@@ -53,11 +91,125 @@ public:
   }
 };
 
+/**
+ * Encodes and writes captured frames on worker threads while the next frames
+ * are rendered. At most `capacity` frames wait in the queue; when it is full,
+ * rendering waits for an encoder to catch up, which bounds the memory used by
+ * captured images.
+ */
+class FrameEncoder
+{
+public:
+  /**
+   * Called on the worker threads with the index of the thread, to write the
+   * frame numbered `index`. Returns false on failure.
+   */
+  typedef std::function<bool(int thread, int index, vtkImageData* image)> EncodeFunction;
+
+  FrameEncoder(int numThreads, size_t capacity, const EncodeFunction& encode)
+    : Encode(encode)
+    , Capacity(std::max<size_t>(capacity, 1))
+    , Done(false)
+    , Failed(false)
+  {
+    for (int cc = 0; cc < numThreads; ++cc)
+    {
+      this->Threads.push_back(std::thread(&FrameEncoder::Run, this, cc));
+    }
+  }
+
+  ~FrameEncoder() { this->Finish(); }
+
+  /**
+   * Queues a frame, waiting while the queue is full. Returns false, dropping
+   * the frame, if writing an earlier frame failed.
+   */
+  bool Push(int index, vtkImageData* image)
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->NotFull.wait(
+      lock, [this] { return this->Queue.size() < this->Capacity || this->Failed; });
+    if (this->Failed)
+    {
+      return false;
+    }
+    this->Queue.push_back(Frame{ index, image });
+    this->NotEmpty.notify_one();
+    return true;
+  }
+
+  /**
+   * Waits for all queued frames to be written and stops the worker threads.
+   * Returns false if any frame failed to be written.
+   */
+  bool Finish()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Done = true;
+    }
+    this->NotEmpty.notify_all();
+    for (auto& thread : this->Threads)
+    {
+      thread.join();
+    }
+    this->Threads.clear();
+    return !this->Failed;
+  }
+
+private:
+  struct Frame
+  {
+    int Index;
+    vtkSmartPointer<vtkImageData> Image;
+  };
+
+  void Run(int thread)
+  {
+    while (true)
+    {
+      Frame frame;
+      {
+        std::unique_lock<std::mutex> lock(this->Mutex);
+        this->NotEmpty.wait(lock, [this] { return !this->Queue.empty() || this->Done; });
+        if (this->Queue.empty())
+        {
+          return;
+        }
+        frame = this->Queue.front();
+        this->Queue.pop_front();
+      }
+      this->NotFull.notify_one();
+
+      // once a frame failed, the remaining ones are dropped.
+      if (!this->Failed && !this->Encode(thread, frame.Index, frame.Image))
+      {
+        std::lock_guard<std::mutex> lock(this->Mutex);
+        this->Failed = true;
+        this->NotFull.notify_all();
+      }
+    }
+  }
+
+  EncodeFunction Encode;
+  const size_t Capacity;
+  std::vector<std::thread> Threads;
+  std::deque<Frame> Queue;
+  std::mutex Mutex;
+  std::condition_variable NotEmpty;
+  std::condition_variable NotFull;
+  bool Done;
+  std::atomic<bool> Failed;
+};
+
 template <class T>
 class SceneImageWriter : public vtkSMAnimationSceneWriter
 {
-  vtkSmartPointer<T> Writer;
+  std::vector<vtkSmartPointer<T> > Writers;
   vtkWeakPointer<vtkSMSaveAnimationProxy> Helper;
+  std::unique_ptr<FrameEncoder> Encoder;
+  int NumberOfEncoderThreads;
+  int FrameIndex;
 
 public:
   vtkTemplateTypeMacro(SceneImageWriter, vtkSMAnimationSceneWriter);
@@ -69,22 +221,54 @@ public:
   /**
    * Set the writer to use.
    */
-  void SetWriter(T* writer) { this->Writer = writer; }
-  T* GetWriter() { return this->Writer; }
+  void SetWriter(T* writer) { this->Writers.assign(1, writer); }
+  T* GetWriter(int thread = 0)
+  {
+    return thread < static_cast<int>(this->Writers.size()) ? this->Writers[thread].Get() : nullptr;
+  }
+
+  /**
+   * Add a writer, configured as the one passed to SetWriter(), for an
+   * additional encoder thread. Only writers that write each frame to its own
+   * file can be used by several threads.
+   */
+  void AddWriter(T* writer) { this->Writers.push_back(writer); }
+
+  /**
+   * Set the number of threads writing frames while the next frames are
+   * rendered. 0 writes each frame before rendering the next one. No more
+   * threads than writers are used.
+   */
+  void SetNumberOfEncoderThreads(int count) { this->NumberOfEncoderThreads = count; }
 
 protected:
-  SceneImageWriter() {}
+  SceneImageWriter()
+    : NumberOfEncoderThreads(0)
+    , FrameIndex(0)
+  {
+  }
   ~SceneImageWriter() {}
-  bool SaveInitialize(int vtkNotUsed(startCount)) override
+  bool SaveInitialize(int startCount) override
   {
     // Animation scene call render on each tick. We override that render call
     // since it's a waste of rendering, the code to save the images will call
     // render anyways.
     this->AnimationScene->SetOverrideStillRender(1);
+
+    this->FrameIndex = startCount;
+    const int numThreads =
+      std::min(this->NumberOfEncoderThreads, static_cast<int>(this->Writers.size()));
+    if (numThreads > 0)
+    {
+      this->Encoder.reset(new FrameEncoder(numThreads, 2 * numThreads,
+        [this](int thread, int index, vtkImageData* image) {
+          return this->WriteFrameImage(thread, index, image);
+        }));
+    }
     return true;
   }
 
-  bool SaveFrame(double time) override
+  bool SaveFrame(double vtkNotUsed(time)) override
   {
     vtkSmartPointer<vtkImageData> image = SceneGrabber::Grab(this->Helper);
 
@@ -99,16 +283,31 @@ protected:
       return true;
     }
 
-    return this->WriteFrameImage(time, image);
+    const int index = this->FrameIndex++;
+    if (this->Encoder)
+    {
+      return this->Encoder->Push(index, image);
+    }
+    return this->WriteFrameImage(0, index, image);
   }
 
   bool SaveFinalize() override
   {
+    bool status = true;
+    if (this->Encoder)
+    {
+      status = this->Encoder->Finish();
+      this->Encoder.reset();
+    }
     this->AnimationScene->SetOverrideStillRender(0);
-    return true;
+    return status;
   }
 
-  virtual bool WriteFrameImage(double time, vtkImageData* data) = 0;
+  /**
+   * Writes the frame numbered `index` with the writer of `thread`. Called on
+   * the encoder threads, in frame order when there is a single one.
+   */
+  virtual bool WriteFrameImage(int thread, int index, vtkImageData* data) = 0;
 
 private:
   SceneImageWriter(const SceneImageWriter&) = delete;
@@ -139,7 +338,7 @@ protected:
     return false;
   }
 
-  bool WriteFrameImage(double vtkNotUsed(time), vtkImageData* data) override
+  bool WriteFrameImage(int vtkNotUsed(thread), int vtkNotUsed(index), vtkImageData* data) override
   {
     assert(data);
     auto* writer = this->GetWriter();
@@ -156,12 +355,14 @@ protected:
 
   bool SaveFinalize() override
   {
+    // let the encoder thread write the queued frames first.
+    const bool status = this->Superclass::SaveFinalize();
     if (this->Started)
     {
       this->GetWriter()->End();
     }
     this->Started = false;
-    return this->Superclass::SaveFinalize();
+    return status;
   }
 
 private:
@@ -185,15 +386,13 @@ public:
 
 protected:
   SceneImageWriterImageSeries()
-    : Counter(0)
-    , SuffixFormat(nullptr)
+    : SuffixFormat(nullptr)
   {
   }
   ~SceneImageWriterImageSeries() { this->SetSuffixFormat(nullptr); }
 
   bool SaveInitialize(int startCount) override
   {
-    this->Counter = startCount;
     auto path = vtksys::SystemTools::GetFilenamePath(this->FileName);
     auto prefix = vtksys::SystemTools::GetFilenameWithoutLastExtension(this->FileName);
     this->Prefix = path.empty() ? prefix : path + "/" + prefix;
@@ -201,15 +400,15 @@ protected:
     return this->Superclass::SaveInitialize(startCount);
   }
 
-  bool WriteFrameImage(double vtkNotUsed(time), vtkImageData* data) override
+  bool WriteFrameImage(int thread, int index, vtkImageData* data) override
   {
-    auto writer = this->GetWriter();
+    auto writer = this->GetWriter(thread);
     assert(data);
     assert(this->SuffixFormat);
     assert(writer);
 
     char buffer[1024];
-    snprintf(buffer, 1024, this->SuffixFormat, this->Counter);
+    snprintf(buffer, 1024, this->SuffixFormat, index);
 
     std::ostringstream str;
     str << this->Prefix << buffer << this->Extension;
@@ -218,15 +417,12 @@ protected:
     writer->Write();
     writer->SetInputData(nullptr);
 
-    const bool success = writer->GetErrorCode() == vtkErrorCode::NoError;
-    this->Counter += success ? 1 : 0;
-    return success;
+    return writer->GetErrorCode() == vtkErrorCode::NoError;
   }
 
 private:
   SceneImageWriterImageSeries(const SceneImageWriterImageSeries&) = delete;
   void operator=(const SceneImageWriterImageSeries&) = delete;
-  int Counter;
   char* SuffixFormat;
   std::string Prefix;
   std::string Extension;
@@ -331,14 +527,43 @@ bool vtkSMSaveAnimationProxy::WriteAnimationLocally(const char* filename)
     .Set(vtkSMPropertyHelper(this, "FrameRate").GetAsInt());
   formatProxy->UpdateVTKObjects();
 
+  // frames are encoded and written on these many threads while the next
+  // frames are rendered.
+  const int numThreads =
+    std::max(vtkSMPropertyHelper(this, "EncoderThreads", true).GetAsInt(), 0);
+
   // based on the format, we create an appropriate SceneImageWriter.
   auto formatObj = formatProxy->GetClientSideObject();
+  std::vector<vtkSmartPointer<vtkSMProxy> > formatCopies;
+  bool splitFrames = true;
+  bool hasFrames = true;
   if (auto imgWriter = vtkImageWriter::SafeDownCast(formatObj))
   {
     vtkNew<vtkSMSaveAnimationProxyNS::SceneImageWriterImageSeries> realWriter;
     realWriter->SetWriter(imgWriter);
     realWriter->SetSuffixFormat(vtkSMPropertyHelper(formatProxy, "SuffixFormat").GetAsString());
     realWriter->SetHelper(this);
+
+    // every frame goes to its own file, so each additional thread writes with
+    // its own copy of the format.
+    vtkSMSessionProxyManager* pxm = this->GetSessionProxyManager();
+    for (int cc = 1; cc < numThreads; ++cc)
+    {
+      vtkSmartPointer<vtkSMProxy> copy;
+      copy.TakeReference(pxm->NewProxy(formatProxy->GetXMLGroup(), formatProxy->GetXMLName()));
+      if (!copy)
+      {
+        break;
+      }
+      copy->Copy(formatProxy);
+      copy->UpdateVTKObjects();
+      if (auto copyWriter = vtkImageWriter::SafeDownCast(copy->GetClientSideObject()))
+      {
+        realWriter->AddWriter(copyWriter);
+        formatCopies.push_back(copy);
+      }
+    }
+    realWriter->SetNumberOfEncoderThreads(numThreads);
     writer = realWriter;
   }
   else if (auto movieWriter = vtkGenericMovieWriter::SafeDownCast(formatObj))
@@ -346,7 +571,14 @@ bool vtkSMSaveAnimationProxy::WriteAnimationLocally(const char* filename)
     vtkNew<vtkSMSaveAnimationProxyNS::SceneImageWriterMovie> realWriter;
     realWriter->SetWriter(movieWriter);
     realWriter->SetHelper(this);
+    // frames of a movie are written in order, by a single thread.
+    realWriter->SetNumberOfEncoderThreads(std::min(numThreads, 1));
     writer = realWriter;
+
+    // a movie is a single file, hence it cannot be split across time
+    // compartments. The first one saves all the frames.
+    splitFrames = false;
+    hasFrames = vtkProcessModule::GetTimeCompartmentId() == 0;
   }
   else
   {
@@ -379,6 +611,10 @@ bool vtkSMSaveAnimationProxy::WriteAnimationLocally(const char* filename)
       double endTime = vtkSMPropertyHelper(sceneProxy, "EndTime").GetAsDouble();
       frameWindow[0] = frameWindow[0] < 0 ? 0 : frameWindow[0];
       frameWindow[1] = frameWindow[1] >= numFrames ? numFrames - 1 : frameWindow[1];
+      if (splitFrames)
+      {
+        hasFrames = vtkSMSaveAnimationProxyNS::SelectTimeCompartmentFrames(frameWindow);
+      }
       playbackTimeWindow[0] =
         startTime + ((endTime - startTime) * frameWindow[0]) / (numFrames - 1);
       playbackTimeWindow[1] =
@@ -392,6 +628,10 @@ bool vtkSMSaveAnimationProxy::WriteAnimationLocally(const char* filename)
       int numTS = tsValuesHelper.GetNumberOfElements();
       frameWindow[0] = frameWindow[0] < 0 ? 0 : frameWindow[0];
       frameWindow[1] = frameWindow[1] >= numTS ? numTS - 1 : frameWindow[1];
+      if (splitFrames)
+      {
+        hasFrames = vtkSMSaveAnimationProxyNS::SelectTimeCompartmentFrames(frameWindow);
+      }
       playbackTimeWindow[0] = tsValuesHelper.GetAsDouble(frameWindow[0]);
       playbackTimeWindow[1] = tsValuesHelper.GetAsDouble(frameWindow[1]);
     }
@@ -402,6 +642,15 @@ bool vtkSMSaveAnimationProxy::WriteAnimationLocally(const char* filename)
       // changed the play mode to SEQUENCE or SNAP_TO_TIMESTEPS.
       abort();
   }
+  if (!hasFrames)
+  {
+    // nothing to save in this time compartment.
+    this->Cleanup();
+    return true;
+  }
+
+  // when split across time compartments, frames keep their number in the
+  // whole animation, hence the files are named as when saved by a single one.
   writer->SetStartFileCount(frameWindow[0]);
   writer->SetPlaybackTimeWindow(playbackTimeWindow);
 
@@ -0,0 +1,275 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestCinemaDatabaseInternal.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Tests the native index of Spec A Cinema stores used by vtkCinemaDatabase:
+// values must be formatted as `cinema_python` does to find the image files,
+// queries built by vtkCinemaLayerRepresentation must be parsed, and the image
+// cache must evict the least recently used images, decode files again when
+// they change and only honor the latest prefetch request.
+#include "vtkCinemaDatabaseInternal.h"
+#include "vtkTestUtilities.h"
+
+#include <chrono>
+#include <vtksys/FStream.hxx>
+#include <vtksys/SystemTools.hxx>
+
+#define TASSERT(x)                                                                                 \
+  if (!(x))                                                                                        \
+  {                                                                                                \
+    cerr << "ERROR: failed at " << __LINE__ << "!" << endl;                                        \
+    return EXIT_FAILURE;                                                                           \
+  }
+
+using namespace vtkCinemaDatabase_detail;
+
+namespace
+{
+// Decodes fake images, recording the files decoded. Files can be blocked so
+// that their decoding only ends once they are released.
+class FakeDecoder
+{
+public:
+  vtkSmartPointer<vtkImageData> Decode(const std::string& fname)
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->Started.insert(fname);
+    this->Changed.notify_all();
+    this->Changed.wait(lock, [&] { return this->Blocked.find(fname) == this->Blocked.end(); });
+    this->Decoded.push_back(fname);
+    this->Changed.notify_all();
+    return vtkSmartPointer<vtkImageData>::New();
+  }
+
+  int Count(const std::string& fname)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    return static_cast<int>(std::count(this->Decoded.begin(), this->Decoded.end(), fname));
+  }
+
+  int Count()
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    return static_cast<int>(this->Decoded.size());
+  }
+
+  void Block(const std::string& fname)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Blocked.insert(fname);
+  }
+
+  void Release(const std::string& fname)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Blocked.erase(fname);
+    this->Changed.notify_all();
+  }
+
+  void WaitForStart(const std::string& fname)
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->Changed.wait(lock, [&] { return this->Started.find(fname) != this->Started.end(); });
+  }
+
+  void WaitForCount(int count)
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->Changed.wait(lock, [&] { return static_cast<int>(this->Decoded.size()) >= count; });
+  }
+
+private:
+  std::mutex Mutex;
+  std::condition_variable Changed;
+  std::vector<std::string> Decoded;
+  std::set<std::string> Started;
+  std::set<std::string> Blocked;
+};
+
+int TestFormatDouble()
+{
+  TASSERT(FormatDouble(0.1) == "0.1");
+  TASSERT(FormatDouble(1e-05) == "1e-05");
+  TASSERT(FormatDouble(1e16) == "1e+16");
+  TASSERT(FormatDouble(-0.0) == "-0.0");
+  TASSERT(FormatDouble(0.0) == "0.0");
+  TASSERT(FormatDouble(100) == "100.0");
+  TASSERT(FormatDouble(0.0001) == "0.0001");
+  TASSERT(FormatDouble(1234.5) == "1234.5");
+  TASSERT(FormatDouble(1.0 / 3) == "0.3333333333333333");
+  return EXIT_SUCCESS;
+}
+
+int TestParseQuery(const std::string& directory)
+{
+  const std::string filename = directory + "/info.json";
+  {
+    vtksys::ofstream file(filename.c_str());
+    file << "{\n"
+            "  \"type\": \"simple\",\n"
+            "  \"version\": \"0.0\",\n"
+            "  \"metadata\": { \"type\": \"parametric-image-stack\" },\n"
+            "  \"name_pattern\": \"{name}_{time}.png\",\n"
+            "  \"parameter_list\": {\n"
+            "    \"time\": { \"type\": \"range\", \"values\": [0.1, 1e-05, 1e16, -0.0],\n"
+            "      \"default\": 0.1 },\n"
+            "    \"name\": { \"type\": \"option\", \"values\": [\"b\", \"a c\"],\n"
+            "      \"default\": \"b\" }\n"
+            "  }\n"
+            "}\n";
+  }
+
+  SpecAIndex index;
+  TASSERT(index.Load(filename));
+  TASSERT(index.GetParameters().size() == 2);
+  const SpecAIndex::Parameter* time = index.GetParameter("time");
+  TASSERT(time != nullptr);
+  const std::vector<std::string> times = { "-0.0", "1e-05", "0.1", "1e+16" };
+  TASSERT(time->Values == times);
+  const SpecAIndex::Parameter* name = index.GetParameter("name");
+  TASSERT(name != nullptr);
+  TASSERT(name->Values.size() == 2 && name->Values[0] == "a c");
+  // parameters are sorted by name.
+  TASSERT(index.GetParameters()[0].Name == "name");
+
+  std::vector<int> point;
+  TASSERT(index.ParseQuery("{}", point));
+  TASSERT(point == std::vector<int>({ 1, 2 }));
+  TASSERT(index.GetFileName(point) == directory + "/b_0.1.png");
+
+  // quoted keys and values, with either quote.
+  TASSERT(index.ParseQuery("{'name': \"a c\", \"time\": '1e-05'}", point));
+  TASSERT(point == std::vector<int>({ 0, 1 }));
+  TASSERT(index.GetFileName(point) == directory + "/a c_1e-05.png");
+
+  // the first value of a list is used.
+  TASSERT(index.ParseQuery("{ 'time' : [ '-0.0', '0.1' ], 'name': ['b'] }", point));
+  TASSERT(point == std::vector<int>({ 1, 0 }));
+  TASSERT(index.ParseQuery("{'time': [1e+16,0.1]}", point));
+  TASSERT(point == std::vector<int>({ 1, 3 }));
+
+  // numbers that differ only by their formatting.
+  TASSERT(index.ParseQuery("{'time': 0.10}", point));
+  TASSERT(point[1] == 2);
+  TASSERT(index.ParseQuery("{'time': '10000000000000000.0'}", point));
+  TASSERT(point[1] == 3);
+  TASSERT(index.ParseQuery("{'time': 1E-5}", point));
+  TASSERT(point[1] == 1);
+
+  // keys not in the store are ignored.
+  TASSERT(index.ParseQuery("{'other': 'value', 'time': 0.1}", point));
+  TASSERT(point == std::vector<int>({ 1, 2 }));
+
+  // values not in the store and malformed queries.
+  TASSERT(!index.ParseQuery("{'time': 0.5}", point));
+  TASSERT(!index.ParseQuery("{'name': ['c', 'b']}", point));
+  TASSERT(!index.ParseQuery("{'name': 'a c}", point));
+  TASSERT(!index.ParseQuery("{'time': [0.1}", point));
+  TASSERT(!index.ParseQuery("{'time' 0.1}", point));
+
+  vtksys::SystemTools::RemoveFile(filename);
+  return EXIT_SUCCESS;
+}
+
+int TestImageCache()
+{
+  FakeDecoder decoder;
+  std::map<std::string, ImageCache::FileStamp> stamps;
+  ImageCache cache([&](const std::string& fname) { return decoder.Decode(fname); },
+    [&](const std::string& fname) { return stamps[fname]; });
+
+  // least recently used images are evicted first.
+  cache.SetCapacity(2);
+  vtkSmartPointer<vtkImageData> a = cache.Get("a");
+  TASSERT(a != nullptr);
+  cache.Get("b");
+  TASSERT(cache.Get("a") == a);
+  cache.Get("c");
+  TASSERT(decoder.Count() == 3);
+  TASSERT(cache.Get("a") == a);
+  TASSERT(decoder.Count() == 3);
+  cache.Get("b");
+  TASSERT(decoder.Count("b") == 2);
+
+  // a file written again is decoded again.
+  stamps["a"].first = 1;
+  a = cache.Get("a");
+  TASSERT(decoder.Count("a") == 2);
+
+  // even within the same second, when its size changed.
+  stamps["a"].second = 10;
+  TASSERT(cache.Get("a") != a);
+  TASSERT(decoder.Count("a") == 3);
+
+  // prefetched images are not decoded again.
+  cache.SetCapacity(8);
+  cache.SetNumberOfThreads(2);
+  const int count = decoder.Count();
+  cache.Prefetch({ "d", "e" });
+  decoder.WaitForCount(count + 2);
+  cache.Get("d");
+  cache.Get("e");
+  TASSERT(decoder.Count() == count + 2);
+
+  // only the latest prefetch request is honored.
+  cache.SetNumberOfThreads(1);
+  decoder.Block("f");
+  cache.Prefetch({ "f" });
+  decoder.WaitForStart("f");
+  cache.Prefetch({ "g", "h" });
+  cache.Prefetch({ "i" });
+  decoder.Release("f");
+  cache.Get("i");
+  cache.SetNumberOfThreads(0);
+  TASSERT(decoder.Count("f") == 1);
+  TASSERT(decoder.Count("g") == 0 && decoder.Count("h") == 0);
+  TASSERT(decoder.Count("i") == 1);
+
+  // getting a file being prefetched waits for it rather than decoding it again.
+  cache.SetNumberOfThreads(1);
+  decoder.Block("j");
+  cache.Prefetch({ "j" });
+  decoder.WaitForStart("j");
+  std::thread release([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    decoder.Release("j");
+  });
+  TASSERT(cache.Get("j") != nullptr);
+  release.join();
+  TASSERT(decoder.Count("j") == 1);
+
+  cache.Clear();
+  cache.Get("j");
+  TASSERT(decoder.Count("j") == 2);
+  return EXIT_SUCCESS;
+}
+}
+
+int TestCinemaDatabaseInternal(int argc, char* argv[])
+{
+  char* tempDir =
+    vtkTestUtilities::GetArgOrEnvOrDefault("-T", argc, argv, "VTK_TEMP_DIR", "Testing/Temporary");
+  if (!tempDir)
+  {
+    cerr << "Could not determine temporary directory.\n";
+    return EXIT_FAILURE;
+  }
+  const std::string directory = std::string(tempDir) + "/TestCinemaDatabaseInternal";
+  delete[] tempDir;
+  vtksys::SystemTools::MakeDirectory(directory);
+
+  TASSERT(TestFormatDouble() == EXIT_SUCCESS);
+  TASSERT(TestParseQuery(directory) == EXIT_SUCCESS);
+  TASSERT(TestImageCache() == EXIT_SUCCESS);
+  return EXIT_SUCCESS;
+}
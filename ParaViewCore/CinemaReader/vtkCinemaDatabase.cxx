@@ -14,18 +14,32 @@
 =========================================================================*/
 #include "vtkPython.h"
 
+#include "vtkBMPReader.h"
 #include "vtkCamera.h"
 #include "vtkCinemaDatabase.h"
+#include "vtkCinemaDatabaseInternal.h"
 #include "vtkImageData.h"
+#include "vtkImageReader2.h"
+#include "vtkJPEGReader.h"
+#include "vtkNew.h"
 #include "vtkObjectFactory.h"
+#include "vtkPNGReader.h"
+#include "vtkPNMReader.h"
+#include "vtkPointData.h"
 #include "vtkPythonInterpreter.h"
 #include "vtkPythonUtil.h"
 #include "vtkSmartPyObject.h"
+#include "vtkTIFFReader.h"
+#include "vtkUnsignedCharArray.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <vector>
+#include <vtksys/SystemTools.hxx>
 
 namespace
 {
@@ -101,6 +115,74 @@ std::vector<vtkSmartPointer<T> > PyListToVectorOfVTKObjects(vtkSmartPyObject pyo
 }
 }
 
+namespace
+{
+/**
+ * Decodes image files into vtkImageData laid out as `cinema_python` does,
+ * i.e. with the first row being the top of the image, and a "Colors" array.
+ */
+vtkSmartPointer<vtkImageData> DecodeImage(const std::string& fname)
+{
+  vtkSmartPointer<vtkImageReader2> reader;
+  const std::string ext =
+    vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(fname));
+  if (ext == ".png")
+  {
+    reader.TakeReference(vtkPNGReader::New());
+  }
+  else if (ext == ".jpg" || ext == ".jpeg")
+  {
+    reader.TakeReference(vtkJPEGReader::New());
+  }
+  else if (ext == ".tif" || ext == ".tiff")
+  {
+    reader.TakeReference(vtkTIFFReader::New());
+  }
+  else if (ext == ".bmp")
+  {
+    reader.TakeReference(vtkBMPReader::New());
+  }
+  else if (ext == ".ppm")
+  {
+    reader.TakeReference(vtkPNMReader::New());
+  }
+  if (!reader || !vtksys::SystemTools::FileExists(fname.c_str(), true))
+  {
+    return nullptr;
+  }
+  reader->SetFileName(fname.c_str());
+  reader->Update();
+  vtkImageData* decoded = reader->GetOutput();
+  vtkUnsignedCharArray* pixels =
+    vtkUnsignedCharArray::SafeDownCast(decoded->GetPointData()->GetScalars());
+  int dims[3];
+  decoded->GetDimensions(dims);
+  if (!pixels || dims[0] <= 0 || dims[1] <= 0)
+  {
+    return nullptr;
+  }
+
+  const int numComps = pixels->GetNumberOfComponents();
+  const vtkIdType rowSize = static_cast<vtkIdType>(dims[0]) * numComps;
+  vtkNew<vtkUnsignedCharArray> colors;
+  colors->SetName("Colors");
+  colors->SetNumberOfComponents(numComps);
+  colors->SetNumberOfTuples(static_cast<vtkIdType>(dims[0]) * dims[1]);
+  for (int row = 0; row < dims[1]; ++row)
+  {
+    std::copy(pixels->GetPointer(row * rowSize), pixels->GetPointer((row + 1) * rowSize),
+      colors->GetPointer((dims[1] - 1 - row) * rowSize));
+  }
+
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(dims[0], dims[1], 1);
+  image->GetPointData()->SetScalars(colors);
+  return image;
+}
+}
+
+using namespace vtkCinemaDatabase_detail;
+
 class vtkCinemaDatabase::vtkInternals
 {
   bool Initialized;
@@ -109,13 +191,54 @@ class vtkCinemaDatabase::vtkInternals
   vtkSmartPyObject CinemaReaderModule;
   vtkSmartPyObject FileStore;
 
+  // Spec A stores are indexed natively, in which case Python is not used.
+  std::unique_ptr<SpecAIndex> Native;
+  std::vector<vtkSmartPointer<vtkCamera> > NativeCameras;
+  mutable ImageCache Images;
+
 public:
   vtkInternals()
     : Initialized(false)
+    , Images(DecodeImage)
   {
   }
 
-  bool IsLoaded() const { return this->FileStore; }
+  bool IsLoaded() const { return this->Native || this->FileStore; }
+
+  // Indexes the database natively, if supported.
+  bool LoadNativeDatabase(const char* filename)
+  {
+    if (this->OldFileName == filename && this->IsLoaded())
+    {
+      return this->Native != nullptr;
+    }
+
+    // same logic as `cinema_python.database.file_store.FileStore`.
+    std::string infoFileName = filename;
+    const std::string suffix = "info.json";
+    if (infoFileName.size() < suffix.size() ||
+      infoFileName.compare(infoFileName.size() - suffix.size(), suffix.size(), suffix) != 0)
+    {
+      infoFileName += "/" + suffix;
+    }
+
+    this->Native.reset(new SpecAIndex());
+    this->NativeCameras.clear();
+    this->Images.Clear();
+    if (!this->Native->Load(infoFileName))
+    {
+      this->Native.reset();
+      return false;
+    }
+    this->NativeCameras = this->Native->GetCameras();
+    this->OldFileName = filename;
+    if (this->FileStore)
+    {
+      vtkPythonScopeGilEnsurer gilEnsurer;
+      this->FileStore.TakeReference(nullptr);
+    }
+    return true;
+  }
 
   // Will import necessary Python modules and return true if all's ready.
   bool InitializePython()
@@ -145,6 +268,10 @@ public:
   // Load a database.
   bool LoadDatabase(const char* filename)
   {
+    if (this->LoadNativeDatabase(filename))
+    {
+      return true;
+    }
     if (!this->InitializePython())
     {
       return false;
@@ -181,6 +308,10 @@ public:
 
   std::vector<std::string> GetPipelineObjects() const
   {
+    if (this->Native)
+    {
+      return std::vector<std::string>(1, "Cinema");
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(
       PyObject_CallMethod(this->FileStore, const_cast<char*>("get_objects"), NULL));
@@ -198,6 +329,10 @@ public:
 
   std::vector<std::string> GetPipelineObjectParents(const std::string& name) const
   {
+    if (this->Native)
+    {
+      return name == "Cinema" ? std::vector<std::string>() : std::vector<std::string>(1, "Cinema");
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(
       this->FileStore, const_cast<char*>("get_parents"), const_cast<char*>("s"), name.c_str()));
@@ -215,6 +350,10 @@ public:
 
   bool GetPipelineObjectVisibility(const std::string& name) const
   {
+    if (this->Native)
+    {
+      return true;
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(
       this->FileStore, const_cast<char*>("get_visibility"), const_cast<char*>("s"), name.c_str()));
@@ -232,6 +371,15 @@ public:
 
   std::vector<std::string> GetControlParameters(const std::string& name) const
   {
+    if (this->Native)
+    {
+      std::vector<std::string> names;
+      for (const SpecAIndex::Parameter& parameter : this->Native->GetParameters())
+      {
+        names.push_back(parameter.Name);
+      }
+      return names;
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(this->FileStore,
       const_cast<char*>("get_control_parameters"), const_cast<char*>("s"), name.c_str()));
@@ -249,6 +397,10 @@ public:
 
   std::string GetFieldName(const std::string& objectname) const
   {
+    if (this->Native)
+    {
+      return std::string();
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(this->FileStore,
       const_cast<char*>("get_field_name"), const_cast<char*>("s"), objectname.c_str()));
@@ -274,6 +426,10 @@ public:
   std::vector<std::string> GetFieldValues(
     const std::string& name, const std::string& valuetype) const
   {
+    if (this->Native)
+    {
+      return std::vector<std::string>();
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(
       PyObject_CallMethod(this->FileStore, const_cast<char*>("get_field_values"),
@@ -292,6 +448,10 @@ public:
   bool GetFieldValueRange(
     const std::string& object, const std::string& field, double range[2]) const
   {
+    if (this->Native)
+    {
+      return false;
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(
       PyObject_CallMethod(this->FileStore, const_cast<char*>("get_field_valuerange"),
@@ -316,6 +476,11 @@ public:
 
   std::vector<std::string> GetControlParameterValues(const std::string& name) const
   {
+    if (this->Native)
+    {
+      const SpecAIndex::Parameter* parameter = this->Native->GetParameter(name);
+      return parameter ? parameter->Values : std::vector<std::string>();
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(this->FileStore,
       const_cast<char*>("get_control_values_as_strings"), const_cast<char*>("s"), name.c_str()));
@@ -333,6 +498,11 @@ public:
 
   std::vector<double> GetControlParameterValuesAsDouble(const std::string& name) const
   {
+    if (this->Native)
+    {
+      const SpecAIndex::Parameter* parameter = this->Native->GetParameter(name);
+      return parameter ? parameter->Numbers : std::vector<double>();
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(this->FileStore,
       const_cast<char*>("get_control_values"), const_cast<char*>("s"), name.c_str()));
@@ -350,6 +520,10 @@ public:
 
   std::vector<std::string> GetTimeSteps() const
   {
+    if (this->Native)
+    {
+      return std::vector<std::string>();
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(
       PyObject_CallMethod(this->FileStore, const_cast<char*>("get_timesteps"), NULL));
@@ -365,8 +539,14 @@ public:
     return std::vector<std::string>();
   }
 
-  std::vector<vtkSmartPointer<vtkImageData> > TranslateQuery(const std::string& query) const
+  std::vector<vtkSmartPointer<vtkImageData> > TranslateQuery(
+    const std::string& query, int cacheSize, int numPrefetchThreads) const
   {
+    if (this->Native)
+    {
+      return this->TranslateNativeQuery(query, cacheSize, numPrefetchThreads);
+    }
+
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(this->FileStore,
       const_cast<char*>("translate_query"), const_cast<char*>("s"), query.c_str()));
@@ -382,8 +562,43 @@ public:
     }
   }
 
+  std::vector<vtkSmartPointer<vtkImageData> > TranslateNativeQuery(
+    const std::string& query, int cacheSize, int numPrefetchThreads) const
+  {
+    std::vector<int> point;
+    if (!this->Native->ParseQuery(query, point))
+    {
+      return std::vector<vtkSmartPointer<vtkImageData> >();
+    }
+    this->Images.SetCapacity(static_cast<size_t>(cacheSize));
+    this->Images.SetNumberOfThreads(numPrefetchThreads);
+
+    const std::string fname = this->Native->GetFileName(point);
+    vtkSmartPointer<vtkImageData> image = this->Images.Get(fname);
+
+    // while this image is shown, decode the ones the user is likely to
+    // browse to next.
+    std::vector<std::string> neighbors;
+    for (const std::vector<int>& neighbor : this->Native->GetNeighbors(point))
+    {
+      neighbors.push_back(this->Native->GetFileName(neighbor));
+    }
+    this->Images.Prefetch(neighbors);
+
+    if (!image)
+    {
+      vtkGenericWarningMacro("Failed to read Cinema image '" << fname << "'.");
+      return std::vector<vtkSmartPointer<vtkImageData> >();
+    }
+    return std::vector<vtkSmartPointer<vtkImageData> >(1, image);
+  }
+
   std::vector<vtkSmartPointer<vtkCamera> > Cameras(const std::string& ts) const
   {
+    if (this->Native)
+    {
+      return this->NativeCameras;
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(
       this->FileStore, const_cast<char*>("get_cameras"), const_cast<char*>("s"), ts.c_str()));
@@ -401,6 +616,10 @@ public:
 
   std::string GetSpec() const
   {
+    if (this->Native)
+    {
+      return "specA";
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(
       PyObject_CallMethod(this->FileStore, const_cast<char*>("get_spec"), NULL));
@@ -425,6 +644,8 @@ public:
 vtkStandardNewMacro(vtkCinemaDatabase);
 //----------------------------------------------------------------------------
 vtkCinemaDatabase::vtkCinemaDatabase()
+  : CacheSize(64)
+  , NumberOfPrefetchThreads(2)
 {
   this->Internals = new vtkCinemaDatabase::vtkInternals();
 }
@@ -524,8 +745,9 @@ bool vtkCinemaDatabase::GetFieldValueRange(
 std::vector<vtkSmartPointer<vtkImageData> > vtkCinemaDatabase::TranslateQuery(
   const std::string& query) const
 {
-  return this->Internals->IsLoaded() ? this->Internals->TranslateQuery(query)
-                                     : std::vector<vtkSmartPointer<vtkImageData> >();
+  return this->Internals->IsLoaded()
+    ? this->Internals->TranslateQuery(query, this->CacheSize, this->NumberOfPrefetchThreads)
+    : std::vector<vtkSmartPointer<vtkImageData> >();
 }
 
 //----------------------------------------------------------------------------
@@ -598,4 +820,6 @@ std::string vtkCinemaDatabase::GetNearestParameterValue(
 void vtkCinemaDatabase::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "CacheSize: " << this->CacheSize << endl;
+  os << indent << "NumberOfPrefetchThreads: " << this->NumberOfPrefetchThreads << endl;
 }
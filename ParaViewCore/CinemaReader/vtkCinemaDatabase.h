@@ -21,6 +21,15 @@
  * `cinema_python.database.file_store.FileStore` instance. The API is
  * limited to the functionality needed for the rendering Cinema layers in
  *  ParaView.
+ *
+ * Spec A stores (`parametric-image-stack`) are indexed natively instead: the
+ * parameter space is mapped to image files using the store's name pattern,
+ * without going through Python. Decoded images are kept in a least recently
+ * used cache, keyed by file name and modification time so that files written
+ * again are decoded again, and, after each query, the images for the neighboring values of
+ * each parameter are decoded ahead of time on background threads, so that
+ * browsing the database does not wait on reading files. Other stores, and
+ * Spec A stores using constraints among parameters, use `cinema_python`.
  */
 
 #ifndef vtkCinemaDatabase_h
@@ -108,7 +117,8 @@ public:
   std::vector<std::string> GetTimeSteps() const;
 
   /**
-   * Get the layers for a specific query.
+   * Get the layers for a specific query. For natively indexed stores, the
+   * images are shared with the cache and must not be modified.
    */
   std::vector<vtkSmartPointer<vtkImageData> > TranslateQuery(const std::string& query) const;
 
@@ -133,10 +143,31 @@ public:
    */
   std::string GetNearestParameterValue(const std::string& param, double value) const;
 
+  //@{
+  /**
+   * Maximum number of decoded images kept in memory for natively indexed
+   * stores. Default is 64.
+   */
+  vtkSetClampMacro(CacheSize, int, 0, VTK_INT_MAX);
+  vtkGetMacro(CacheSize, int);
+  //@}
+
+  //@{
+  /**
+   * Number of threads decoding the images next to the last queried one, for
+   * natively indexed stores. 0 disables prefetching. Default is 2.
+   */
+  vtkSetClampMacro(NumberOfPrefetchThreads, int, 0, VTK_INT_MAX);
+  vtkGetMacro(NumberOfPrefetchThreads, int);
+  //@}
+
 protected:
   vtkCinemaDatabase();
   ~vtkCinemaDatabase() override;
 
+  int CacheSize;
+  int NumberOfPrefetchThreads;
+
 private:
   vtkCinemaDatabase(const vtkCinemaDatabase&) = delete;
   void operator=(const vtkCinemaDatabase&) = delete;
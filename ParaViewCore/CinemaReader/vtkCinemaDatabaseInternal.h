@@ -0,0 +1,767 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkCinemaDatabaseInternal.h
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Native index and image cache of vtkCinemaDatabase for Spec A stores. This
+// header is private; it is only included by vtkCinemaDatabase.cxx and its
+// tests.
+#ifndef vtkCinemaDatabaseInternal_h
+#define vtkCinemaDatabaseInternal_h
+
+#include "vtkCamera.h"
+#include "vtkImageData.h"
+#include "vtkMath.h"
+#include "vtkNew.h"
+#include "vtkSmartPointer.h"
+#include "vtk_jsoncpp.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <vtksys/FStream.hxx>
+#include <vtksys/SystemTools.hxx>
+
+namespace vtkCinemaDatabase_detail
+{
+// Formats a number the way Python's `str()` does, since that is how
+// `cinema_python` substitutes parameter values in the file name pattern.
+inline std::string FormatDouble(double value)
+{
+  if (std::isnan(value))
+  {
+    return "nan";
+  }
+  if (std::isinf(value))
+  {
+    return value < 0 ? "-inf" : "inf";
+  }
+
+  // shortest representation that reads back to the same value.
+  char buffer[64];
+  for (int precision = 1; precision <= 17; ++precision)
+  {
+    snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, value);
+    if (std::strtod(buffer, nullptr) == value)
+    {
+      break;
+    }
+  }
+
+  std::string mantissa(buffer);
+  const size_t e = mantissa.find('e');
+  const int exponent = atoi(mantissa.c_str() + e + 1);
+  mantissa.erase(e);
+  const bool negative = mantissa[0] == '-';
+  std::string digits;
+  for (char c : mantissa)
+  {
+    if (isdigit(c))
+    {
+      digits += c;
+    }
+  }
+  digits.erase(std::max<size_t>(digits.find_last_not_of('0') + 1, 1));
+
+  std::string result = negative ? "-" : "";
+  if (exponent < -4 || exponent >= 16)
+  {
+    result += digits.substr(0, 1);
+    if (digits.size() > 1)
+    {
+      result += "." + digits.substr(1);
+    }
+    snprintf(buffer, sizeof(buffer), "e%+03d", exponent);
+    result += buffer;
+  }
+  else if (exponent < 0)
+  {
+    result += "0." + std::string(-exponent - 1, '0') + digits;
+  }
+  else
+  {
+    digits.resize(std::max<size_t>(digits.size(), exponent + 1), '0');
+    result += digits.substr(0, exponent + 1) + ".";
+    result += digits.size() > static_cast<size_t>(exponent + 1) ? digits.substr(exponent + 1) : "0";
+  }
+  return result;
+}
+
+// Formats a JSON value the way Python's `str()` does.
+inline std::string FormatValue(const Json::Value& value)
+{
+  if (value.isString())
+  {
+    return value.asString();
+  }
+  if (value.isBool())
+  {
+    return value.asBool() ? "True" : "False";
+  }
+  if (value.type() == Json::intValue || value.type() == Json::uintValue)
+  {
+    return value.type() == Json::uintValue ? std::to_string(value.asUInt64())
+                                           : std::to_string(value.asInt64());
+  }
+  if (value.isDouble())
+  {
+    return FormatDouble(value.asDouble());
+  }
+  return std::string();
+}
+
+// Returns true if `text` is a number, stored in `number`.
+inline bool ParseNumber(const std::string& text, double& number)
+{
+  if (text.empty())
+  {
+    return false;
+  }
+  char* end = nullptr;
+  number = std::strtod(text.c_str(), &end);
+  return end == text.c_str() + text.size();
+}
+
+/**
+ * Native index of a Spec A (`parametric-image-stack`) Cinema store. It maps
+ * each point of the parameter space to the image file holding it using the
+ * store's name pattern, without going through Python.
+ */
+class SpecAIndex
+{
+public:
+  struct Parameter
+  {
+    std::string Name;
+    // values, sorted, as Python formats them and as numbers (NaN when not a
+    // number).
+    std::vector<std::string> Values;
+    std::vector<double> Numbers;
+    int Default;
+  };
+
+  /**
+   * Loads the `info.json` file of a store. Returns false if the store is not
+   * one that this index supports, in which case `cinema_python` is used.
+   */
+  bool Load(const std::string& filename)
+  {
+    vtksys::ifstream file(filename.c_str());
+    if (!file)
+    {
+      return false;
+    }
+    Json::CharReaderBuilder builder;
+    builder["collectComments"] = false;
+    Json::Value root;
+    if (!parseFromStream(builder, file, &root, nullptr) || !root.isObject())
+    {
+      return false;
+    }
+
+    // only plain parametric image stacks are indexed: the file names of
+    // stores with constraints among parameters, or of later versions, depend
+    // on more than the name pattern.
+    this->Metadata = root["metadata"];
+    if (!this->Metadata.isObject() ||
+      this->Metadata["type"].asString() != "parametric-image-stack" ||
+      (this->Metadata.isMember("version") && this->Metadata["version"].asString() != "0.0") ||
+      !root["associations"].empty() || !root["constraints"].empty())
+    {
+      return false;
+    }
+
+    const Json::Value& parameters =
+      root.isMember("arguments") ? root["arguments"] : root["parameter_list"];
+    if (!parameters.isObject() || !root["name_pattern"].isString())
+    {
+      return false;
+    }
+    this->Parameters.clear();
+    for (const std::string& name : parameters.getMemberNames())
+    {
+      if (!this->AddParameter(name, parameters[name]))
+      {
+        return false;
+      }
+    }
+
+    const std::string pattern = root["name_pattern"].asString();
+    const std::string ext = vtksys::SystemTools::LowerCase(
+      vtksys::SystemTools::GetFilenameLastExtension(pattern));
+    if (ext != ".png" && ext != ".jpg" && ext != ".jpeg" && ext != ".tif" && ext != ".tiff" &&
+      ext != ".bmp" && ext != ".ppm")
+    {
+      return false;
+    }
+    this->Directory = vtksys::SystemTools::GetFilenamePath(filename);
+    return this->ParsePattern(pattern);
+  }
+
+  const std::vector<Parameter>& GetParameters() const { return this->Parameters; }
+
+  const Parameter* GetParameter(const std::string& name) const
+  {
+    for (const Parameter& parameter : this->Parameters)
+    {
+      if (parameter.Name == name)
+      {
+        return &parameter;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Parses a query, in the form of a Python dictionary literal as built by
+   * vtkCinemaLayerRepresentation, into the index of a value for each
+   * parameter. Parameters missing from the query take their default value,
+   * and the first value is used when several are given. Returns false if the
+   * query refers to a value not in the store.
+   */
+  bool ParseQuery(const std::string& query, std::vector<int>& point) const
+  {
+    point.resize(this->Parameters.size());
+    for (size_t cc = 0; cc < this->Parameters.size(); ++cc)
+    {
+      point[cc] = this->Parameters[cc].Default;
+    }
+
+    size_t pos = query.find('{');
+    pos = pos == std::string::npos ? 0 : pos + 1;
+    std::string key, value;
+    while (this->NextToken(query, pos, key))
+    {
+      if (!this->Skip(query, pos, ':'))
+      {
+        return false;
+      }
+      const bool list = this->Skip(query, pos, '[');
+      if (!this->NextToken(query, pos, value))
+      {
+        return false;
+      }
+      if (list)
+      {
+        std::string extra;
+        while (this->Skip(query, pos, ',') && this->NextToken(query, pos, extra))
+        {
+        }
+        if (!this->Skip(query, pos, ']'))
+        {
+          return false;
+        }
+      }
+      this->Skip(query, pos, ',');
+
+      for (size_t cc = 0; cc < this->Parameters.size(); ++cc)
+      {
+        if (this->Parameters[cc].Name == key)
+        {
+          point[cc] = this->FindValue(this->Parameters[cc], value);
+          if (point[cc] < 0)
+          {
+            return false;
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Returns the index of `value` among the values of `parameter`, matching
+   * numbers that differ only by their formatting, or -1 if not found.
+   */
+  int FindValue(const Parameter& parameter, const std::string& value) const
+  {
+    for (size_t cc = 0; cc < parameter.Values.size(); ++cc)
+    {
+      if (parameter.Values[cc] == value)
+      {
+        return static_cast<int>(cc);
+      }
+    }
+    double number;
+    if (ParseNumber(value, number))
+    {
+      for (size_t cc = 0; cc < parameter.Numbers.size(); ++cc)
+      {
+        const double other = parameter.Numbers[cc];
+        if (std::abs(other - number) <=
+          1e-6 * std::max(1.0, std::max(std::abs(other), std::abs(number))))
+        {
+          return static_cast<int>(cc);
+        }
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * Returns the path of the image file for a point of the parameter space.
+   */
+  std::string GetFileName(const std::vector<int>& point) const
+  {
+    std::string fname = this->Directory.empty() ? std::string() : this->Directory + "/";
+    for (const Segment& segment : this->Pattern)
+    {
+      fname += segment.Parameter < 0 ? segment.Text
+                                     : this->Parameters[segment.Parameter]
+                                         .Values[point[segment.Parameter]];
+    }
+    fname.erase(std::remove(fname.begin(), fname.end(), '*'), fname.end());
+    return fname;
+  }
+
+  /**
+   * Returns the points next to `point`, where a single parameter moved to
+   * its previous or next value, closest parameters first.
+   */
+  std::vector<std::vector<int> > GetNeighbors(const std::vector<int>& point) const
+  {
+    std::vector<std::vector<int> > neighbors;
+    for (size_t cc = 0; cc < point.size(); ++cc)
+    {
+      for (int delta : { 1, -1 })
+      {
+        const int value = point[cc] + delta;
+        if (value >= 0 && value < static_cast<int>(this->Parameters[cc].Values.size()))
+        {
+          neighbors.push_back(point);
+          neighbors.back()[cc] = value;
+        }
+      }
+    }
+    return neighbors;
+  }
+
+  /**
+   * Returns cameras for each combination of the `phi` and `theta` values,
+   * rotated from the camera recorded in the metadata.
+   */
+  std::vector<vtkSmartPointer<vtkCamera> > GetCameras() const
+  {
+    std::vector<vtkSmartPointer<vtkCamera> > cameras;
+    const Json::Value& md = this->Metadata;
+    if (!md["camera_eye"][0].isArray() || !md["camera_at"][0].isArray() ||
+      !md["camera_up"][0].isArray() || !md["camera_nearfar"][0].isArray() ||
+      !md["camera_angle"][0].isNumeric())
+    {
+      vtkGenericWarningMacro("Cannot initialize cameras. Interaction may not work correctly.");
+      return cameras;
+    }
+
+    vtkNew<vtkCamera> camera;
+    double eye[3], at[3], up[3];
+    for (Json::Value::ArrayIndex cc = 0; cc < 3; ++cc)
+    {
+      eye[cc] = md["camera_eye"][0][cc].asDouble();
+      at[cc] = md["camera_at"][0][cc].asDouble();
+      up[cc] = md["camera_up"][0][cc].asDouble();
+    }
+    camera->SetPosition(eye);
+    camera->SetFocalPoint(at);
+    camera->SetViewUp(up);
+    camera->SetViewAngle(md["camera_angle"][0].asDouble());
+    camera->SetClippingRange(
+      md["camera_nearfar"][0][0].asDouble(), md["camera_nearfar"][0][1].asDouble());
+
+    const Parameter* phi = this->GetParameter("phi");
+    const Parameter* theta = this->GetParameter("theta");
+    const std::vector<double> phis = phi ? phi->Numbers : std::vector<double>(1, 0.0);
+    const std::vector<double> thetas = theta ? theta->Numbers : std::vector<double>(1, 0.0);
+    for (double p : phis)
+    {
+      for (double t : thetas)
+      {
+        vtkSmartPointer<vtkCamera> c = vtkSmartPointer<vtkCamera>::New();
+        c->DeepCopy(camera);
+        c->Azimuth(p);
+        c->Elevation(t);
+        c->OrthogonalizeViewUp();
+        cameras.push_back(c);
+      }
+    }
+    return cameras;
+  }
+
+private:
+  struct Segment
+  {
+    std::string Text;
+    int Parameter; // -1 for literal text.
+  };
+
+  bool AddParameter(const std::string& name, const Json::Value& info)
+  {
+    const Json::Value& values = info["values"];
+    if (!values.isArray() || values.empty())
+    {
+      return false;
+    }
+    Parameter parameter;
+    parameter.Name = name;
+    std::vector<std::pair<double, std::string> > sorted;
+    bool numeric = true;
+    for (const Json::Value& value : values)
+    {
+      numeric = numeric && value.isNumeric();
+      sorted.push_back(std::make_pair(
+        value.isNumeric() ? value.asDouble() : vtkMath::Nan(), FormatValue(value)));
+    }
+    // same order as `get_control_values`.
+    if (numeric)
+    {
+      std::stable_sort(sorted.begin(), sorted.end(),
+        [](const std::pair<double, std::string>& a, const std::pair<double, std::string>& b) {
+          return a.first < b.first;
+        });
+    }
+    else
+    {
+      std::stable_sort(sorted.begin(), sorted.end(),
+        [](const std::pair<double, std::string>& a, const std::pair<double, std::string>& b) {
+          return a.second < b.second;
+        });
+    }
+    for (const auto& value : sorted)
+    {
+      parameter.Numbers.push_back(value.first);
+      parameter.Values.push_back(value.second);
+    }
+    parameter.Default = 0;
+    if (info.isMember("default"))
+    {
+      parameter.Default = std::max(this->FindValue(parameter, FormatValue(info["default"])), 0);
+    }
+    this->Parameters.push_back(parameter);
+    return true;
+  }
+
+  // Splits the name pattern, e.g. `{phi}/{theta}/{time}.png`, in literal text
+  // and parameter substitutions. Format specifications are not supported.
+  bool ParsePattern(const std::string& pattern)
+  {
+    this->Pattern.clear();
+    size_t pos = 0;
+    while (pos < pattern.size())
+    {
+      const size_t open = pattern.find('{', pos);
+      if (open != pos)
+      {
+        const std::string text = pattern.substr(pos, open - pos);
+        if (text.find('}') != std::string::npos)
+        {
+          return false;
+        }
+        this->Pattern.push_back(Segment{ text, -1 });
+        if (open == std::string::npos)
+        {
+          break;
+        }
+      }
+      const size_t close = pattern.find('}', open);
+      if (close == std::string::npos)
+      {
+        return false;
+      }
+      const std::string name = pattern.substr(open + 1, close - open - 1);
+      int index = -1;
+      for (size_t cc = 0; cc < this->Parameters.size(); ++cc)
+      {
+        if (this->Parameters[cc].Name == name)
+        {
+          index = static_cast<int>(cc);
+        }
+      }
+      if (index < 0)
+      {
+        return false;
+      }
+      this->Pattern.push_back(Segment{ std::string(), index });
+      pos = close + 1;
+    }
+    return true;
+  }
+
+  static bool Skip(const std::string& text, size_t& pos, char c)
+  {
+    while (pos < text.size() && isspace(text[pos]))
+    {
+      ++pos;
+    }
+    if (pos < text.size() && text[pos] == c)
+    {
+      ++pos;
+      return true;
+    }
+    return false;
+  }
+
+  // Reads a quoted string or a bare literal.
+  static bool NextToken(const std::string& text, size_t& pos, std::string& token)
+  {
+    while (pos < text.size() && isspace(text[pos]))
+    {
+      ++pos;
+    }
+    if (pos >= text.size())
+    {
+      return false;
+    }
+    const char quote = text[pos];
+    if (quote == '\'' || quote == '"')
+    {
+      const size_t end = text.find(quote, pos + 1);
+      if (end == std::string::npos)
+      {
+        return false;
+      }
+      token = text.substr(pos + 1, end - pos - 1);
+      pos = end + 1;
+      return true;
+    }
+    const size_t end = text.find_first_of(",:[]{} \t\n", pos);
+    token = text.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    pos = end == std::string::npos ? text.size() : end;
+    return !token.empty();
+  }
+
+  Json::Value Metadata;
+  std::string Directory;
+  std::vector<Parameter> Parameters;
+  std::vector<Segment> Pattern;
+};
+
+/**
+ * Least recently used cache of decoded images, keyed by file name,
+ * modification time and size so that a file written again is decoded again,
+ * even within the resolution of the modification time. Images are
+ * decoded on demand or, ahead of time, on prefetch threads. Only the latest
+ * prefetch request is honored: files queued by an earlier one and not yet
+ * started are dropped.
+ */
+class ImageCache
+{
+public:
+  typedef std::function<vtkSmartPointer<vtkImageData>(const std::string&)> DecodeFunction;
+  // modification time and size of a file.
+  typedef std::pair<long, unsigned long> FileStamp;
+  typedef std::function<FileStamp(const std::string&)> FileStampFunction;
+
+  /**
+   * `decode` reads an image file, on the calling thread or on a prefetch
+   * thread. `fileStamp` returns the modification time and the size of a file
+   * and defaults to those of the file system.
+   */
+  ImageCache(const DecodeFunction& decode, const FileStampFunction& fileStamp = FileStampFunction())
+    : Decode(decode)
+    , GetFileStamp(fileStamp)
+    , Capacity(64)
+    , Stop(false)
+  {
+    if (!this->GetFileStamp)
+    {
+      this->GetFileStamp = [](const std::string& fname) {
+        return FileStamp(static_cast<long>(vtksys::SystemTools::ModifiedTime(fname)),
+          vtksys::SystemTools::FileLength(fname));
+      };
+    }
+  }
+
+  ~ImageCache() { this->SetNumberOfThreads(0); }
+
+  void SetCapacity(size_t capacity)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Capacity = capacity;
+    this->Trim();
+  }
+
+  void SetNumberOfThreads(int count)
+  {
+    if (count == static_cast<int>(this->Threads.size()))
+    {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Stop = true;
+      this->Pending.clear();
+    }
+    this->WorkAvailable.notify_all();
+    for (auto& thread : this->Threads)
+    {
+      thread.join();
+    }
+    this->Threads.clear();
+    this->Stop = false;
+    for (int cc = 0; cc < count; ++cc)
+    {
+      this->Threads.push_back(std::thread(&ImageCache::Run, this));
+    }
+  }
+
+  void Clear()
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Pending.clear();
+    this->Entries.clear();
+    this->Lookup.clear();
+  }
+
+  /**
+   * Returns the decoded image for a file, decoding it now unless it is cached
+   * or already being decoded by a prefetch thread.
+   */
+  vtkSmartPointer<vtkImageData> Get(const std::string& fname)
+  {
+    const Key key(fname, this->GetFileStamp(fname));
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->ImageDecoded.wait(
+      lock, [&] { return this->Decoding.find(key) == this->Decoding.end(); });
+    auto iter = this->Lookup.find(key);
+    if (iter != this->Lookup.end())
+    {
+      this->Entries.splice(this->Entries.begin(), this->Entries, iter->second);
+      return iter->second->second;
+    }
+    this->Decoding.insert(key);
+    lock.unlock();
+
+    vtkSmartPointer<vtkImageData> image = this->Decode(fname);
+
+    lock.lock();
+    this->Decoding.erase(key);
+    this->Insert(key, image);
+    lock.unlock();
+    this->ImageDecoded.notify_all();
+    return image;
+  }
+
+  /**
+   * Queues files to be decoded by the prefetch threads, replacing the files
+   * queued earlier.
+   */
+  void Prefetch(const std::vector<std::string>& fnames)
+  {
+    if (this->Threads.empty())
+    {
+      return;
+    }
+    std::vector<Key> keys;
+    for (const std::string& fname : fnames)
+    {
+      keys.push_back(Key(fname, this->GetFileStamp(fname)));
+    }
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Pending.clear();
+      for (const Key& key : keys)
+      {
+        if (this->Lookup.find(key) == this->Lookup.end() &&
+          this->Decoding.find(key) == this->Decoding.end())
+        {
+          this->Pending.push_back(key);
+        }
+      }
+    }
+    this->WorkAvailable.notify_all();
+  }
+
+private:
+  // file name and stamp.
+  typedef std::pair<std::string, FileStamp> Key;
+  typedef std::list<std::pair<Key, vtkSmartPointer<vtkImageData> > > EntryList;
+
+  void Run()
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    while (true)
+    {
+      this->WorkAvailable.wait(lock, [this] { return this->Stop || !this->Pending.empty(); });
+      if (this->Stop)
+      {
+        return;
+      }
+      const Key key = this->Pending.front();
+      this->Pending.pop_front();
+      if (this->Lookup.find(key) != this->Lookup.end() ||
+        this->Decoding.find(key) != this->Decoding.end())
+      {
+        continue;
+      }
+      this->Decoding.insert(key);
+      lock.unlock();
+
+      vtkSmartPointer<vtkImageData> image = this->Decode(key.first);
+
+      lock.lock();
+      this->Decoding.erase(key);
+      this->Insert(key, image);
+      this->ImageDecoded.notify_all();
+    }
+  }
+
+  // must be called with the mutex locked.
+  void Insert(const Key& key, const vtkSmartPointer<vtkImageData>& image)
+  {
+    if (!image || this->Lookup.find(key) != this->Lookup.end())
+    {
+      return;
+    }
+    this->Entries.push_front(std::make_pair(key, image));
+    this->Lookup[key] = this->Entries.begin();
+    this->Trim();
+  }
+
+  // must be called with the mutex locked.
+  void Trim()
+  {
+    while (this->Entries.size() > this->Capacity)
+    {
+      this->Lookup.erase(this->Entries.back().first);
+      this->Entries.pop_back();
+    }
+  }
+
+  DecodeFunction Decode;
+  FileStampFunction GetFileStamp;
+  size_t Capacity;
+  EntryList Entries;
+  std::map<Key, EntryList::iterator> Lookup;
+  std::set<Key> Decoding;
+  std::deque<Key> Pending;
+  std::vector<std::thread> Threads;
+  std::mutex Mutex;
+  std::condition_variable WorkAvailable;
+  std::condition_variable ImageDecoded;
+  bool Stop;
+};
+}
+
+#endif
+// VTK-HeaderTest-Exclude: vtkCinemaDatabaseInternal.h
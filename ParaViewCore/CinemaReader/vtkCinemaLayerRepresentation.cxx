@@ -282,8 +282,10 @@ void vtkCinemaLayerRepresentation::UpdateMapper()
     layers = this->CinemaDatabase->TranslateQuery(queryString);
     if (layers.size() > 0)
     {
-      // Cache first layer (i.e. full image for spec A, but not for spec C)
-      this->CachedImage->DeepCopy(layers.at(0));
+      // Cache first layer (i.e. full image for spec A, but not for spec C).
+      // Layers are not modified afterwards, hence there is no need to copy
+      // the pixels.
+      this->CachedImage->ShallowCopy(layers.at(0));
     }
   }
   vtkImageData* image = this->CachedImage.Get();
@@ -77,6 +77,7 @@ vtkPVOptions::vtkPVOptions()
   this->DisableRegistry = 0;
   this->ForceMPIInitOnClient = 0;
   this->ForceNoMPIInitOnClient = 0;
+  this->TimeCompartments = 1;
   this->DisableXDisplayTests = 0;
   this->ForceOffscreenRendering = 0;
   this->ForceOnscreenRendering = 0;
@@ -295,6 +296,14 @@ void vtkPVOptions::Initialize()
   this->AddBooleanArgument("--no-mpi", 0, &this->ForceNoMPIInitOnClient,
     "Don't initialize MPI on processes. "
     "Cannot be used with --mpi.");
+  // Unlike the above, the time compartments are set up from the parsed value,
+  // see vtkProcessModule::InitializeTimeCompartments().
+  this->AddArgument("--time-compartments", 0, &this->TimeCompartments,
+    "Split the processes into the specified number of groups, at most one per "
+    "process, each of which runs the script and saves its own share of the "
+    "animation frames. Only the first group saves screenshots and data files, "
+    "including CSV files.",
+    vtkPVOptions::PVBATCH);
 #endif
 
   this->AddBooleanArgument("--force-offscreen-rendering", nullptr, &this->ForceOffscreenRendering,
@@ -445,6 +454,8 @@ int vtkPVOptions::PostProcess(int argc, const char* const* argv)
       break;
   }
 
+  this->TimeCompartments = std::max(1, this->TimeCompartments);
+
   if (this->TileDimensions[0] > 0 || this->TileDimensions[1] > 0)
   {
     this->TileDimensions[0] = std::max(1, this->TileDimensions[0]);
@@ -633,5 +644,6 @@ void vtkPVOptions::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "DisableXDisplayTests: " << this->DisableXDisplayTests << endl;
   os << indent << "ForceNoMPIInitOnClient: " << this->ForceNoMPIInitOnClient << endl;
   os << indent << "ForceMPIInitOnClient: " << this->ForceMPIInitOnClient << endl;
+  os << indent << "TimeCompartments: " << this->TimeCompartments << endl;
   os << indent << "CatalystLivePort: " << this->CatalystLivePort << endl;
 }
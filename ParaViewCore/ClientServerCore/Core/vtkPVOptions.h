@@ -262,6 +262,17 @@ public:
   vtkBooleanMacro(ForceMPIInitOnClient, int);
   //@}
 
+  //@{
+  /**
+   * Number of groups of processes, or time compartments, the processes are
+   * split into. Each time compartment runs the pipeline on its own share of
+   * the animation frames. This is applicable only to PVBATCH type of processes
+   * and is handled by vtkProcessModule::InitializeTimeCompartments(). Values
+   * below 1 are changed to 1. Defaults to 1.
+   */
+  vtkGetMacro(TimeCompartments, int);
+  //@}
+
   //@{
   /**
    * Returns the verbosity level for stderr output chosen.
@@ -362,6 +373,7 @@ private:
   int DisableRegistry;
   int ForceMPIInitOnClient;
   int ForceNoMPIInitOnClient;
+  int TimeCompartments;
   int DummyMesaFlag;
   int ForceOffscreenRendering;
   int ForceOnscreenRendering;
@@ -15,6 +15,8 @@
 #include "vtkPVPluginLoader.h"
 
 #include "vtkDynamicLoader.h"
+#include "vtkMultiProcessController.h"
+#include "vtkMultiProcessStream.h"
 #include "vtkNew.h"
 #include "vtkObjectFactory.h"
 #include "vtkPDirectory.h"
@@ -27,15 +29,29 @@
 #include "vtkPVServerManagerPluginInterface.h"
 #include "vtkPVXMLParser.h"
 #include "vtkProcessModule.h"
+#include "vtksys/SystemInformation.hxx"
 #include "vtksys/SystemTools.hxx"
 
+#include <algorithm>
+#include <cstdio>
 #include <cstdlib>
 #include <iterator>
 #include <memory>
+#include <set>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#if defined(_WIN32) && !defined(__CYGWIN__)
+#include <windows.h>
+
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach-o/dyld.h>
+#else
+#include <link.h>
+#endif
+
 #define vtkPVPluginLoaderErrorMacro(x)                                                             \
   if (!no_errors)                                                                                  \
   {                                                                                                \
@@ -92,6 +108,20 @@ public:
     return instance;
   }
 
+  static vtkPVXMLOnlyPlugin* Create(const char* xmlfile, const std::string& contents)
+  {
+    vtkNew<vtkPVXMLParser> parser;
+    if (!parser->Parse(contents.c_str()))
+    {
+      return NULL;
+    }
+
+    vtkPVXMLOnlyPlugin* instance = new vtkPVXMLOnlyPlugin();
+    instance->PluginName = vtksys::SystemTools::GetFilenameWithoutExtension(xmlfile);
+    instance->XML = contents;
+    return instance;
+  }
+
   /**
    * Returns the name for this plugin.
    */
@@ -144,6 +174,20 @@ public:
   const char* GetEULA() override { return nullptr; }
 };
 
+// FNV-1a hash used to name the staging directory for a plugin so that
+// different versions of a plugin with the same filename do not collide, and
+// to tell nodes apart by their host name.
+vtkTypeUInt64 vtkHashPluginContents(const std::vector<char>& contents)
+{
+  vtkTypeUInt64 hash = 14695981039346656037ull;
+  for (const char c : contents)
+  {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
 // Cleans successfully opened libs when the application quits.
 // BUG # 10293
 class vtkPVPluginLoaderCleaner
@@ -151,10 +195,45 @@ class vtkPVPluginLoaderCleaner
   typedef std::map<std::string, vtkLibHandle> HandlesType;
   HandlesType Handles;
   std::vector<vtkPVXMLOnlyPlugin*> XMLPlugins;
+  std::set<std::string> StagedDirectories;
 
 public:
   void Register(const char* pname, vtkLibHandle& handle) { this->Handles[pname] = handle; }
   void Register(vtkPVXMLOnlyPlugin* plugin) { this->XMLPlugins.push_back(plugin); }
+  void RegisterStagedDirectory(const std::string& dname) { this->StagedDirectories.insert(dname); }
+
+  void RemoveStagedDirectories(vtkMultiProcessController* controller)
+  {
+    if (controller && controller->GetNumberOfProcesses() > 1)
+    {
+      // ranks on the same node share the staged files: wait for all of them
+      // to be done before the first rank of the node that staged files
+      // removes them.
+      controller->Barrier();
+      const int numProcs = controller->GetNumberOfProcesses();
+      const int rank = controller->GetLocalProcessId();
+      vtkTypeUInt64 host = 0;
+      if (!this->StagedDirectories.empty())
+      {
+        vtksys::SystemInformation sysInfo;
+        const std::string hostname = sysInfo.GetHostname() ? sysInfo.GetHostname() : "";
+        // 0 stands for the ranks that staged nothing.
+        host = vtkHashPluginContents(std::vector<char>(hostname.begin(), hostname.end())) | 1;
+      }
+      std::vector<vtkTypeUInt64> hosts(numProcs);
+      controller->AllGather(&host, hosts.data(), 1);
+      if (std::find(hosts.begin(), hosts.begin() + rank, host) != hosts.begin() + rank)
+      {
+        this->StagedDirectories.clear();
+        return;
+      }
+    }
+    for (const auto& dname : this->StagedDirectories)
+    {
+      vtksys::SystemTools::RemoveADirectory(dname);
+    }
+    this->StagedDirectories.clear();
+  }
 
   ~vtkPVPluginLoaderCleaner()
   {
@@ -168,6 +247,10 @@ public:
     {
       delete *iter;
     }
+    // vtkProcessModule::Finalize() removes the files staged with other
+    // ranks. The ones left are removed after closing the libraries so that
+    // this works on all platforms.
+    this->RemoveStagedDirectories(nullptr);
   }
   static vtkPVPluginLoaderCleaner* GetInstance()
   {
@@ -198,6 +281,145 @@ private:
   static vtkPVPluginLoaderCleaner* LibCleaner;
 };
 vtkPVPluginLoaderCleaner* vtkPVPluginLoaderCleaner::LibCleaner = NULL;
+
+// Reads the entire file in `contents`.
+bool vtkReadPluginFile(const std::string& fname, std::vector<char>& contents)
+{
+  ifstream is(fname.c_str(), ios::binary);
+  if (!is)
+  {
+    return false;
+  }
+  is.seekg(0, ios::end);
+  const std::streamoff length = is.tellg();
+  is.seekg(0, ios::beg);
+  if (length < 0)
+  {
+    return false;
+  }
+  contents.resize(static_cast<size_t>(length));
+  is.read(contents.data(), length);
+  return !is.fail();
+}
+
+// Writes `contents` to `dir/<basename of fname>` unless an identical file is
+// already present e.g. written by another rank on the same node. Returns the
+// path to the staged file or an empty string on failure.
+std::string vtkStagePluginFile(
+  const std::string& dir, const std::string& fname, const std::vector<char>& contents, int rank)
+{
+  const std::string target = dir + "/" + vtksys::SystemTools::GetFilenameName(fname);
+  std::vector<char> existing;
+  if (vtksys::SystemTools::FileExists(target, true) &&
+    vtksys::SystemTools::FileLength(target) == static_cast<unsigned long>(contents.size()) &&
+    vtkReadPluginFile(target, existing) && existing == contents)
+  {
+    return target;
+  }
+
+  // Write to a rank specific file and then rename it so that other ranks on
+  // this node never see a partially written library.
+  std::ostringstream tmpname;
+  tmpname << target << "." << rank << ".tmp";
+  {
+    ofstream os(tmpname.str().c_str(), ios::binary);
+    os.write(contents.data(), contents.size());
+    if (!os)
+    {
+      return std::string();
+    }
+  }
+  if (std::rename(tmpname.str().c_str(), target.c_str()) != 0)
+  {
+    vtksys::SystemTools::RemoveFile(tmpname.str());
+    return std::string();
+  }
+  return target;
+}
+
+// Returns the paths of the shared libraries loaded in the process, as opened
+// by the dynamic loader.
+std::set<std::string> vtkGetLoadedLibraries()
+{
+  std::set<std::string> libraries;
+#if defined(_WIN32) && !defined(__CYGWIN__)
+  std::vector<HMODULE> modules(1024);
+  DWORD needed = 0;
+  if (K32EnumProcessModules(GetCurrentProcess(), modules.data(),
+        static_cast<DWORD>(modules.size() * sizeof(HMODULE)), &needed))
+  {
+    modules.resize(std::min<size_t>(modules.size(), needed / sizeof(HMODULE)));
+    for (HMODULE module : modules)
+    {
+      char name[MAX_PATH];
+      if (GetModuleFileNameA(module, name, MAX_PATH))
+      {
+        libraries.insert(name);
+      }
+    }
+  }
+#elif defined(__APPLE__)
+  for (uint32_t cc = 0, count = _dyld_image_count(); cc < count; ++cc)
+  {
+    libraries.insert(_dyld_get_image_name(cc));
+  }
+#else
+  dl_iterate_phdr(
+    [](struct dl_phdr_info* info, size_t, void* data) {
+      if (info->dlpi_name && info->dlpi_name[0])
+      {
+        static_cast<std::set<std::string>*>(data)->insert(info->dlpi_name);
+      }
+      return 0;
+    },
+    &libraries);
+#endif
+  return libraries;
+}
+
+// Returns the libraries loaded since `before` that are in the same directory
+// as the plugin `fname`: the dependencies that the plugin found beside itself
+// (`SearchBesideLibrary`, `$ORIGIN`). These are staged next to the plugin so
+// that they are still found when opening the staged copy. Dependencies
+// already loaded, e.g. by another plugin of the same directory, are left out
+// since the staged copy finds them loaded too.
+std::vector<std::string> vtkGetDependenciesBeside(
+  const std::string& fname, const std::set<std::string>& before)
+{
+  std::vector<std::string> dependencies;
+  const std::string self = vtksys::SystemTools::GetRealPath(fname);
+  const std::string dir = vtksys::SystemTools::GetFilenamePath(self);
+  for (const auto& library : vtkGetLoadedLibraries())
+  {
+    const std::string path = vtksys::SystemTools::GetRealPath(library);
+    if (before.find(library) == before.end() && path != self &&
+      vtksys::SystemTools::GetFilenamePath(path) == dir)
+    {
+      // keep the name the library was opened with e.g. its soname rather
+      // than the file it links to.
+      dependencies.push_back(library);
+    }
+  }
+  return dependencies;
+}
+
+std::string vtkGetDefaultNodeLocalDirectory()
+{
+  if (const char* env = vtksys::SystemTools::GetEnv("PV_PLUGIN_NODE_LOCAL_DIR"))
+  {
+    return env;
+  }
+  if (vtksys::SystemTools::FileIsDirectory("/dev/shm"))
+  {
+    return "/dev/shm";
+  }
+  const char* tmpdir = vtksys::SystemTools::GetEnv("TMPDIR");
+  if (!tmpdir)
+  {
+    tmpdir = vtksys::SystemTools::GetEnv("TEMP");
+  }
+  return tmpdir ? tmpdir : "/tmp";
+}
 };
 
 //=============================================================================
@@ -233,9 +455,14 @@ vtkPVPluginLoader::vtkPVPluginLoader()
   this->PluginVersion = NULL;
   this->FileName = NULL;
   this->SearchPaths = NULL;
+  this->NodeLocalDirectory = NULL;
   this->Loaded = false;
   this->SetErrorString("No plugin loaded yet.");
 
+  const char* collective = vtksys::SystemTools::GetEnv("PV_PLUGIN_COLLECTIVE_LOAD");
+  this->CollectiveLoading = (collective != nullptr && atoi(collective) != 0);
+  this->SetNodeLocalDirectory(vtkGetDefaultNodeLocalDirectory().c_str());
+
   std::string paths;
   const char* env = vtksys::SystemTools::GetEnv("PV_PLUGIN_PATH");
   if (env)
@@ -286,6 +513,7 @@ vtkPVPluginLoader::~vtkPVPluginLoader()
   this->SetPluginVersion(0);
   this->SetFileName(0);
   this->SetSearchPaths(0);
+  this->SetNodeLocalDirectory(0);
 }
 
 //-----------------------------------------------------------------------------
@@ -384,6 +612,12 @@ bool vtkPVPluginLoader::LoadPluginInternal(const char* file, bool no_errors)
     return true;
   }
 
+  vtkMultiProcessController* controller = vtkMultiProcessController::GetGlobalController();
+  if (this->CollectiveLoading && controller && controller->GetNumberOfProcesses() > 1)
+  {
+    return this->LoadPluginCollectively(file, no_errors);
+  }
+
   if (vtksys::SystemTools::GetFilenameLastExtension(file) == ".xml")
   {
     vtkVLogF(PARAVIEW_LOG_PLUGIN_VERBOSITY(), "Loading XML plugin.");
@@ -399,7 +633,229 @@ bool vtkPVPluginLoader::LoadPluginInternal(const char* file, bool no_errors)
     return false;
   }
 
+  return this->LoadPluginFromSharedLibrary(file, file, no_errors);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPVPluginLoader::LoadPluginCollectively(const char* file, bool no_errors)
+{
+  vtkVLogScopeF(PARAVIEW_LOG_PLUGIN_VERBOSITY(), "collective load of '%s'", file);
+
+  vtkMultiProcessController* controller = vtkMultiProcessController::GetGlobalController();
+  const int rank = controller->GetLocalProcessId();
+
+  int status = 0;
+  std::string resolved;
+  std::vector<char> contents;
+  if (rank == 0)
+  {
+    vtkVLogScopeF(PARAVIEW_LOG_PLUGIN_VERBOSITY(), "resolve and read plugin on root");
+    resolved = this->ResolvePluginFileName(file);
+    status = (!resolved.empty() && vtkReadPluginFile(resolved, contents)) ? 1 : 0;
+    vtkVLogF(PARAVIEW_LOG_PLUGIN_VERBOSITY(), "read %d bytes from '%s'",
+      static_cast<int>(contents.size()), resolved.c_str());
+  }
+
+  {
+    vtkVLogScopeF(PARAVIEW_LOG_PLUGIN_VERBOSITY(), "broadcast plugin");
+    vtkMultiProcessStream stream;
+    if (rank == 0)
+    {
+      stream << status << resolved << static_cast<vtkTypeUInt64>(contents.size());
+    }
+    controller->Broadcast(stream, 0);
+    if (rank != 0)
+    {
+      vtkTypeUInt64 length;
+      stream >> status >> resolved >> length;
+      contents.resize(static_cast<size_t>(length));
+    }
+    if (status && !contents.empty())
+    {
+      controller->Broadcast(contents.data(), static_cast<vtkIdType>(contents.size()), 0);
+    }
+  }
+
+  if (!status)
+  {
+    vtkPVPluginLoaderErrorMacro("Failed to locate or read the plugin file on the root rank.");
+    return false;
+  }
+
+  this->SetFileName(resolved.c_str());
+  if (vtksys::SystemTools::GetFilenameLastExtension(resolved) == ".xml")
+  {
+    vtkVLogF(PARAVIEW_LOG_PLUGIN_VERBOSITY(), "Loading XML plugin.");
+    vtkPVXMLOnlyPlugin* plugin = vtkPVXMLOnlyPlugin::Create(
+      resolved.c_str(), std::string(contents.begin(), contents.end()));
+    if (plugin)
+    {
+      vtkPVPluginLoaderCleaner::GetInstance()->Register(plugin);
+      plugin->SetFileName(resolved.c_str());
+      return this->LoadPluginInternal(plugin);
+    }
+    vtkPVPluginLoaderErrorMacro("Failed to load XML plugin. Not a valid XML.");
+    return false;
+  }
+
+  // The root rank has already touched the shared filesystem; it opens the
+  // library directly. The libraries beside the plugin that it loads are
+  // broadcast too since the staged copy can no longer find them in its own
+  // directory.
+  bool loaded = false;
+  std::vector<std::string> names;
+  if (rank == 0)
+  {
+    const std::set<std::string> before = vtkGetLoadedLibraries();
+    {
+      vtkVLogScopeF(
+        PARAVIEW_LOG_PLUGIN_VERBOSITY(), "open plugin library '%s'", resolved.c_str());
+      loaded = this->LoadPluginFromSharedLibrary(resolved.c_str(), resolved.c_str(), no_errors);
+    }
+    names = vtkGetDependenciesBeside(resolved, before);
+  }
+
+  StagedFileList dependencies;
+  {
+    vtkVLogScopeF(PARAVIEW_LOG_PLUGIN_VERBOSITY(), "broadcast dependencies");
+    int count = static_cast<int>(names.size());
+    controller->Broadcast(&count, 1, 0);
+    for (int cc = 0; cc < count; ++cc)
+    {
+      std::string name;
+      std::vector<char> bytes;
+      int ok = 0;
+      if (rank == 0)
+      {
+        name = names[cc];
+        ok = vtkReadPluginFile(name, bytes) ? 1 : 0;
+      }
+      vtkMultiProcessStream stream;
+      if (rank == 0)
+      {
+        stream << ok << name << static_cast<vtkTypeUInt64>(bytes.size());
+      }
+      controller->Broadcast(stream, 0);
+      if (rank != 0)
+      {
+        vtkTypeUInt64 length;
+        stream >> ok >> name >> length;
+        bytes.resize(static_cast<size_t>(length));
+      }
+      if (!ok)
+      {
+        // opening the staged plugin reports the missing library.
+        continue;
+      }
+      if (!bytes.empty())
+      {
+        controller->Broadcast(bytes.data(), static_cast<vtkIdType>(bytes.size()), 0);
+      }
+      if (rank != 0)
+      {
+        dependencies.push_back(std::make_pair(name, std::vector<char>()));
+        dependencies.back().second.swap(bytes);
+      }
+    }
+    vtkVLogF(PARAVIEW_LOG_PLUGIN_VERBOSITY(), "%d dependencies", count);
+  }
+  if (rank == 0)
+  {
+    return loaded;
+  }
+
+  std::string libfile;
+  {
+    vtkVLogScopeF(PARAVIEW_LOG_PLUGIN_VERBOSITY(), "stage plugin in '%s'",
+      this->NodeLocalDirectory ? this->NodeLocalDirectory : "(nullptr)");
+    libfile = this->StagePluginFiles(resolved, contents, dependencies, rank);
+    if (libfile.empty())
+    {
+      vtkPVPluginLoaderErrorMacro("Failed to stage plugin in node-local directory.");
+      return false;
+    }
+  }
+
+  // release memory before loading the library.
+  std::vector<char>().swap(contents);
+  StagedFileList().swap(dependencies);
+
+  vtkVLogScopeF(PARAVIEW_LOG_PLUGIN_VERBOSITY(), "open plugin library '%s'", libfile.c_str());
+  return this->LoadPluginFromSharedLibrary(libfile.c_str(), resolved.c_str(), no_errors);
+}
+
+//-----------------------------------------------------------------------------
+std::string vtkPVPluginLoader::StagePluginFiles(const std::string& filename,
+  const std::vector<char>& contents, const StagedFileList& dependencies, int rank)
+{
+  if (!this->NodeLocalDirectory)
+  {
+    return std::string();
+  }
+
+  // The directory is named after the contents of the plugin so that different
+  // versions of a plugin with the same filename do not collide.
+  std::ostringstream subdir;
+  subdir << this->NodeLocalDirectory << "/paraview-plugin-" << std::hex
+         << vtkHashPluginContents(contents);
+  if (!vtksys::SystemTools::MakeDirectory(subdir.str()))
+  {
+    return std::string();
+  }
+  vtkPVPluginLoaderCleaner::GetInstance()->RegisterStagedDirectory(subdir.str());
+
+  for (const auto& dependency : dependencies)
+  {
+    if (vtkStagePluginFile(subdir.str(), dependency.first, dependency.second, rank).empty())
+    {
+      return std::string();
+    }
+  }
+  return vtkStagePluginFile(subdir.str(), filename, contents, rank);
+}
+
+//-----------------------------------------------------------------------------
+void vtkPVPluginLoader::RemoveStagedPluginFiles(vtkMultiProcessController* controller)
+{
+  vtkPVPluginLoaderCleaner::GetInstance()->RemoveStagedDirectories(controller);
+}
+
+//-----------------------------------------------------------------------------
+std::string vtkPVPluginLoader::ResolvePluginFileName(const char* file)
+{
+  if (vtksys::SystemTools::FileExists(file, true))
+  {
+    return vtksys::SystemTools::CollapseFullPath(file);
+  }
+
+  if (!vtksys::SystemTools::FileIsFullPath(file) && this->SearchPaths)
+  {
+    std::vector<std::string> paths;
+    vtksys::SystemTools::Split(this->SearchPaths, paths, ENV_PATH_SEP);
+    for (const auto& path : paths)
+    {
+      std::vector<std::string> subpaths;
+      vtksys::SystemTools::Split(path, subpaths, ';');
+      for (const auto& subpath : subpaths)
+      {
+        const std::string candidate = subpath + "/" + file;
+        if (vtksys::SystemTools::FileExists(candidate, true))
+        {
+          return vtksys::SystemTools::CollapseFullPath(candidate);
+        }
+      }
+    }
+  }
+  return std::string();
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPVPluginLoader::LoadPluginFromSharedLibrary(
+  const char* libfile, const char* file, bool no_errors)
+{
 #ifndef BUILD_SHARED_LIBS
+  (void)libfile;
+  (void)file;
   vtkPVPluginLoaderErrorMacro("Could not find the plugin statically linked in, and "
                               "cannot load dynamic plugins  in static builds.");
   return false;
@@ -411,7 +867,7 @@ bool vtkPVPluginLoader::LoadPluginInternal(const char* file, bool no_errors)
   // to the plugin.
   flags |= vtksys::DynamicLoader::SearchBesideLibrary;
 #endif
-  vtkLibHandle lib = vtkDynamicLoader::OpenLibrary(file, flags);
+  vtkLibHandle lib = vtkDynamicLoader::OpenLibrary(libfile, flags);
   if (!lib)
   {
     vtkPVPluginLoaderErrorMacro(vtkDynamicLoader::LastError());
@@ -576,6 +1032,9 @@ void vtkPVPluginLoader::PrintSelf(ostream& os, vtkIndent indent)
      << endl;
   os << indent << "FileName: " << (this->FileName ? this->FileName : "(none)") << endl;
   os << indent << "SearchPaths: " << (this->SearchPaths ? this->SearchPaths : "(none)") << endl;
+  os << indent << "CollectiveLoading: " << this->CollectiveLoading << endl;
+  os << indent << "NodeLocalDirectory: "
+     << (this->NodeLocalDirectory ? this->NodeLocalDirectory : "(none)") << endl;
 }
 
 //-----------------------------------------------------------------------------
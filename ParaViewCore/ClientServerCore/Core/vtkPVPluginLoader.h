@@ -24,6 +24,21 @@
  * for information on using environment variables to override or elevate the
  * verbosity level.
  *
+ * When running with multiple MPI ranks, vtkPVPluginLoader can optionally load
+ * plugins collectively (see `SetCollectiveLoading`). In that mode, only the
+ * root rank resolves the plugin path and reads the plugin file from the
+ * (typically shared) filesystem. The file contents are then broadcast to all
+ * other ranks which stage shared libraries, together with the libraries beside
+ * them that the root rank loaded with them, in node-local storage (see
+ * `SetNodeLocalDirectory`) before opening them. Staged files are removed by
+ * the first rank of each node when the process module is finalized (see
+ * `RemoveStagedPluginFiles`). This avoids every rank hitting the shared
+ * filesystem's metadata servers when loading plugins. Collective loading
+ * requires that all ranks call `LoadPlugin` with the same filename
+ * at the same time, as is the case for plugins loaded on pvserver/pvbatch
+ * ranks. Time spent in each phase is logged at
+ * `PARAVIEW_LOG_PLUGIN_VERBOSITY` level.
+ *
  * This class only needed when loading plugins from shared libraries
  * dynamically. For statically importing plugins, one directly uses
  * PV_PLUGIN_IMPORT() macro defined in vtkPVPlugin.h.
@@ -36,7 +51,11 @@
 #include "vtkPVClientServerCoreCoreModule.h" //needed for exports
 
 #include <functional> // for std::function
+#include <string>     // for std::string
+#include <utility>    // for std::pair
+#include <vector>     // for std::vector
 
+class vtkMultiProcessController;
 class vtkPVPlugin;
 
 class VTKPVCLIENTSERVERCORECORE_EXPORT vtkPVPluginLoader : public vtkObject
@@ -134,6 +153,35 @@ public:
   vtkGetMacro(Loaded, bool);
   //@}
 
+  //@{
+  /**
+   * When set to true and running with more than one process, plugins are
+   * loaded collectively i.e. the root rank reads the plugin file and
+   * broadcasts it to all other ranks. All ranks must call `LoadPlugin` with
+   * the same arguments when this is enabled.
+   *
+   * Default is false unless the environment variable
+   * `PV_PLUGIN_COLLECTIVE_LOAD` is set to a non-zero value.
+   */
+  vtkSetMacro(CollectiveLoading, bool);
+  vtkGetMacro(CollectiveLoading, bool);
+  vtkBooleanMacro(CollectiveLoading, bool);
+  //@}
+
+  //@{
+  /**
+   * Directory used to stage shared libraries received from the root rank
+   * when `CollectiveLoading` is enabled. This should be storage local to each
+   * node, e.g. `/dev/shm`.
+   *
+   * Default is the value of the environment variable
+   * `PV_PLUGIN_NODE_LOCAL_DIR`, if set, otherwise `/dev/shm` if it exists,
+   * otherwise the system's temporary directory.
+   */
+  vtkSetStringMacro(NodeLocalDirectory);
+  vtkGetStringMacro(NodeLocalDirectory);
+  //@}
+
   //@{
   /**
    */
@@ -142,6 +190,15 @@ public:
   static void UnregisterLoadPluginCallback(int id);
   //@}
 
+  /**
+   * Removes the directories where the plugins loaded collectively were
+   * staged. With a `controller` of more than one process, this must be
+   * called on all its processes: they wait for each other and only the first
+   * rank of each node, among the ones that staged files, removes them.
+   * Called by vtkProcessModule::Finalize().
+   */
+  static void RemoveStagedPluginFiles(vtkMultiProcessController* controller = nullptr);
+
   /**
    * Internal method used in pqParaViewPlugin.cxx.in to tell the
    * vtkPVPluginLoader that a library was unloaded so it doesn't try to unload
@@ -161,6 +218,41 @@ protected:
    */
   bool LoadPluginInternal(vtkPVPlugin* plugin);
 
+  /**
+   * Called by LoadPluginInternal() when `CollectiveLoading` is enabled and
+   * more than one process is available.
+   */
+  bool LoadPluginCollectively(const char* filename, bool no_errors);
+
+  /**
+   * Opens the shared library `libfile` and loads the plugin in it. `filename`
+   * is the path to the plugin as requested by the user which may differ from
+   * `libfile` when the library has been staged in node-local storage.
+   */
+  bool LoadPluginFromSharedLibrary(const char* libfile, const char* filename, bool no_errors);
+
+  /**
+   * Returns the full path to the plugin file. If `filename` does not exist, it
+   * is looked up in the `SearchPaths`. Returns an empty string if not found.
+   */
+  std::string ResolvePluginFileName(const char* filename);
+
+  //@{
+  /**
+   * Writes the plugin library `filename` with the given `contents`, and its
+   * `dependencies` (pairs of filename and contents), to a directory under
+   * `NodeLocalDirectory` named after the plugin contents. Dependencies are
+   * the shared libraries beside the plugin that the root rank loaded with it;
+   * staging them in the same directory keeps the lookup of libraries beside
+   * the plugin working for the staged copy. Files already staged with the
+   * same contents are reused. Returns the path to the staged plugin or an
+   * empty string on failure.
+   */
+  typedef std::vector<std::pair<std::string, std::vector<char> > > StagedFileList;
+  std::string StagePluginFiles(const std::string& filename, const std::vector<char>& contents,
+    const StagedFileList& dependencies, int rank);
+  //@}
+
   vtkSetStringMacro(ErrorString);
   vtkSetStringMacro(PluginName);
   vtkSetStringMacro(PluginVersion);
@@ -172,7 +264,9 @@ protected:
   char* PluginVersion;
   char* FileName;
   char* SearchPaths;
+  char* NodeLocalDirectory;
   bool Loaded;
+  bool CollectiveLoading;
 
 private:
   vtkPVPluginLoader(const vtkPVPluginLoader&) = delete;
@@ -57,6 +57,7 @@
 // destroyed before the process module singleton is cleaned up.
 #include "vtkPVPluginLoader.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <clocale> // needed for setlocale()
 #include <sstream>
@@ -104,6 +105,9 @@ bool vtkProcessModule::FinalizePython = false;
 
 vtkSmartPointer<vtkProcessModule> vtkProcessModule::Singleton;
 vtkSmartPointer<vtkMultiProcessController> vtkProcessModule::GlobalController;
+vtkSmartPointer<vtkMultiProcessController> vtkProcessModule::WorldController;
+int vtkProcessModule::NumberOfTimeCompartments = 1;
+int vtkProcessModule::TimeCompartmentId = 0;
 
 int vtkProcessModule::DefaultMinimumGhostLevelsToRequestForUnstructuredPipelines = 1;
 int vtkProcessModule::DefaultMinimumGhostLevelsToRequestForStructuredPipelines = 0;
@@ -302,12 +306,25 @@ bool vtkProcessModule::Finalize()
   // destroy the process-module.
   vtkProcessModule::Singleton = NULL;
 
+  // all the ranks of a node, in every time compartment, share the files
+  // staged when loading plugins collectively.
+  vtkPVPluginLoader::RemoveStagedPluginFiles(vtkProcessModule::WorldController
+      ? vtkProcessModule::WorldController.GetPointer()
+      : vtkProcessModule::GlobalController.GetPointer());
+
   // We don't really need to call SetGlobalController(NULL) since
   // it's really stored with a weak pointer.  We set it to null anyways
   // in case it gets changed later to reference counting the pointer
   vtkMultiProcessController::SetGlobalController(NULL);
   vtkProcessModule::GlobalController->Finalize(/*finalizedExternally*/ 1);
   vtkProcessModule::GlobalController = NULL;
+  if (vtkProcessModule::WorldController)
+  {
+    vtkProcessModule::WorldController->Finalize(/*finalizedExternally*/ 1);
+    vtkProcessModule::WorldController = NULL;
+  }
+  vtkProcessModule::NumberOfTimeCompartments = 1;
+  vtkProcessModule::TimeCompartmentId = 0;
 
 #if VTK_MODULE_ENABLE_VTK_ParallelMPI
   if (vtkProcessModule::FinalizeMPI)
@@ -480,6 +497,44 @@ int vtkProcessModule::GetPartitionId()
   return this->GetGlobalController() ? this->GetGlobalController()->GetLocalProcessId() : 0;
 }
 
+//----------------------------------------------------------------------------
+int vtkProcessModule::InitializeTimeCompartments(int count)
+{
+  vtkMultiProcessController* world = vtkProcessModule::GlobalController;
+  const int numRanks = world ? world->GetNumberOfProcesses() : 1;
+  count = std::max(1, std::min(count, numRanks));
+  if (count <= 1 || vtkProcessModule::ProcessType != PROCESS_BATCH ||
+    vtkProcessModule::WorldController)
+  {
+    return vtkProcessModule::NumberOfTimeCompartments;
+  }
+
+  // Each compartment gets its own controller, set as the global one, so that
+  // it runs the script as an independent group of processes.
+  const int rank = world->GetLocalProcessId();
+  vtkProcessModule::WorldController = world;
+  vtkProcessModule::NumberOfTimeCompartments = count;
+  vtkProcessModule::TimeCompartmentId =
+    static_cast<int>(static_cast<long long>(rank) * count / numRanks);
+  vtkProcessModule::GlobalController.TakeReference(
+    world->PartitionController(vtkProcessModule::TimeCompartmentId, rank));
+  vtkProcessModule::GlobalController->BroadcastTriggerRMIOn();
+  vtkMultiProcessController::SetGlobalController(vtkProcessModule::GlobalController);
+  return count;
+}
+
+//----------------------------------------------------------------------------
+int vtkProcessModule::GetNumberOfTimeCompartments()
+{
+  return vtkProcessModule::NumberOfTimeCompartments;
+}
+
+//----------------------------------------------------------------------------
+int vtkProcessModule::GetTimeCompartmentId()
+{
+  return vtkProcessModule::TimeCompartmentId;
+}
+
 //----------------------------------------------------------------------------
 bool vtkProcessModule::IsMPIInitialized()
 {
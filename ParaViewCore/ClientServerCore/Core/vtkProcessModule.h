@@ -232,6 +232,30 @@ public:
    */
   int GetPartitionId();
 
+  //@{
+  /**
+   * When a batch process is started with `--time-compartments=N`, the MPI
+   * processes are split into N groups, or time compartments, of consecutive
+   * ranks. The global controller only spans the processes of the local
+   * compartment, so each compartment runs the script independently, on its
+   * own share of the animation frames (see vtkSMSaveAnimationProxy). These
+   * return the number of compartments (1 when the processes are not split) and
+   * the index of the local one.
+   */
+  static int GetNumberOfTimeCompartments();
+  static int GetTimeCompartmentId();
+  //@}
+
+  /**
+   * Splits the processes of a batch process into `count` time compartments,
+   * clamped between 1 and the number of processes. This is called by
+   * vtkInitializationHelper with vtkPVOptions::GetTimeCompartments(), after
+   * Initialize() and before any session is created, since views capture the
+   * global controller. It does nothing for other types of processes or if the
+   * processes are already split. Returns the number of time compartments.
+   */
+  static int InitializeTimeCompartments(int count);
+
   /**
    * Return whether MPI is initialized in this process group.
    */
@@ -359,6 +383,12 @@ private:
   static vtkSmartPointer<vtkProcessModule> Singleton;
   static vtkSmartPointer<vtkMultiProcessController> GlobalController;
 
+  // Controller spanning all processes when they are split into time
+  // compartments, in which case GlobalController spans the local compartment.
+  static vtkSmartPointer<vtkMultiProcessController> WorldController;
+  static int NumberOfTimeCompartments;
+  static int TimeCompartmentId;
+
   bool SymmetricMPIMode;
 
   bool MultipleSessionsSupport;
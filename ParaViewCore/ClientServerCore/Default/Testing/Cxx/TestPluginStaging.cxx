@@ -0,0 +1,124 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestPluginStaging.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkPVPluginLoader.h"
+#include "vtkTestUtilities.h"
+#include "vtksys/SystemTools.hxx"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// Exposes the staging used when loading plugins collectively.
+class vtkTestPluginLoader : public vtkPVPluginLoader
+{
+public:
+  static vtkTestPluginLoader* New();
+  vtkTypeMacro(vtkTestPluginLoader, vtkPVPluginLoader);
+
+  using vtkPVPluginLoader::StagedFileList;
+  using vtkPVPluginLoader::StagePluginFiles;
+};
+vtkStandardNewMacro(vtkTestPluginLoader);
+
+std::vector<char> MakeContents(const std::string& text)
+{
+  return std::vector<char>(text.begin(), text.end());
+}
+
+std::vector<char> ReadContents(const std::string& fname)
+{
+  std::ifstream is(fname.c_str(), std::ios::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+}
+}
+
+#define TASSERT(x)                                                                                 \
+  if (!(x))                                                                                        \
+  {                                                                                                \
+    cerr << "ERROR: failed assertion at line " << __LINE__ << ": " << #x << endl;                  \
+    return EXIT_FAILURE;                                                                           \
+  }
+
+int TestPluginStaging(int argc, char* argv[])
+{
+  char* tempDir =
+    vtkTestUtilities::GetArgOrEnvOrDefault("-T", argc, argv, "VTK_TEMP_DIR", "Testing/Temporary");
+  if (!tempDir)
+  {
+    cerr << "Could not determine temporary directory.\n";
+    return EXIT_FAILURE;
+  }
+  const std::string nodeLocal = std::string(tempDir) + "/TestPluginStaging";
+  delete[] tempDir;
+  vtksys::SystemTools::RemoveADirectory(nodeLocal);
+  TASSERT(vtksys::SystemTools::MakeDirectory(nodeLocal));
+
+  vtkNew<vtkTestPluginLoader> loader;
+  loader->SetNodeLocalDirectory(nodeLocal.c_str());
+
+  const std::vector<char> plugin = MakeContents("plugin library");
+  vtkTestPluginLoader::StagedFileList dependencies;
+  dependencies.push_back(
+    std::make_pair(std::string("/shared/plugins/libDependency.so.1"), MakeContents("dependency")));
+  dependencies.push_back(
+    std::make_pair(std::string("/shared/plugins/libOther.so"), MakeContents("other")));
+
+  const std::string staged =
+    loader->StagePluginFiles("/shared/plugins/libMyPlugin.so", plugin, dependencies, 1);
+  TASSERT(!staged.empty());
+  TASSERT(vtksys::SystemTools::GetFilenameName(staged) == "libMyPlugin.so");
+  TASSERT(ReadContents(staged) == plugin);
+
+  // dependencies must be next to the staged plugin.
+  const std::string stageDir = vtksys::SystemTools::GetFilenamePath(staged);
+  TASSERT(vtksys::SystemTools::GetFilenamePath(stageDir) == nodeLocal);
+  TASSERT(ReadContents(stageDir + "/libDependency.so.1") == dependencies[0].second);
+  TASSERT(ReadContents(stageDir + "/libOther.so") == dependencies[1].second);
+
+  // staging again, e.g. from another rank on the same node, reuses the files.
+  TASSERT(loader->StagePluginFiles("/shared/plugins/libMyPlugin.so", plugin, dependencies, 2) ==
+    staged);
+  TASSERT(!vtksys::SystemTools::FileExists(staged + ".2.tmp"));
+
+  // a staged file of the same size but with other contents is replaced.
+  dependencies[1].second = MakeContents("OTHER");
+  TASSERT(loader->StagePluginFiles("/shared/plugins/libMyPlugin.so", plugin, dependencies, 2) ==
+    staged);
+  TASSERT(ReadContents(stageDir + "/libOther.so") == dependencies[1].second);
+
+  // a different version of the plugin is staged in a different directory.
+  const std::string staged2 = loader->StagePluginFiles(
+    "/shared/plugins/libMyPlugin.so", MakeContents("plugin library v2"), dependencies, 1);
+  TASSERT(!staged2.empty() && staged2 != staged);
+
+  // staging directories are removed, without waiting for other processes.
+  vtkPVPluginLoader::RemoveStagedPluginFiles(nullptr);
+  TASSERT(!vtksys::SystemTools::FileExists(staged));
+  TASSERT(!vtksys::SystemTools::FileExists(stageDir));
+  TASSERT(!vtksys::SystemTools::FileExists(staged2));
+
+  // staging fails without a node-local directory.
+  loader->SetNodeLocalDirectory(nullptr);
+  TASSERT(loader->StagePluginFiles("libMyPlugin.so", plugin, dependencies, 1).empty());
+
+  vtksys::SystemTools::RemoveADirectory(nodeLocal);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestProminentValuesInformation.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Tests the serialization and merging of the sketches used by
+// vtkPVProminentValuesInformation to find the prominent values of an array,
+// as done when gathering the information from several ranks.
+
+#include "vtkAbstractArray.h"
+#include "vtkClientServerStream.h"
+#include "vtkDataObject.h"
+#include "vtkIntArray.h"
+#include "vtkPVProminentValuesInformation.h"
+#include "vtkSmartPointer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <vector>
+
+#define TASSERT(x)                                                                                 \
+  if (!(x))                                                                                        \
+  {                                                                                                \
+    cerr << "ERROR: failed at " << __LINE__ << "!" << endl;                                        \
+    return EXIT_FAILURE;                                                                           \
+  }
+
+namespace
+{
+// Returns an array whose first component takes `first + (i % modulo)` and the
+// second one `i % 2`.
+vtkSmartPointer<vtkIntArray> NewArray(vtkIdType numTuples, int first, int modulo)
+{
+  auto array = vtkSmartPointer<vtkIntArray>::New();
+  array->SetName("labels");
+  array->SetNumberOfComponents(2);
+  array->SetNumberOfTuples(numTuples);
+  for (vtkIdType cc = 0; cc < numTuples; ++cc)
+  {
+    array->SetTypedComponent(cc, 0, first + static_cast<int>(cc % modulo));
+    array->SetTypedComponent(cc, 1, static_cast<int>(cc % 2));
+  }
+  return array;
+}
+
+// Returns an array whose first component is `value` for every other tuple and
+// distinct values otherwise.
+vtkSmartPointer<vtkIntArray> NewDominatedArray(vtkIdType numTuples, int value)
+{
+  auto array = NewArray(numTuples, 0, 1);
+  for (vtkIdType cc = 0; cc < numTuples; ++cc)
+  {
+    array->SetTypedComponent(cc, 0, (cc % 2 == 0) ? value : 1000 + static_cast<int>(cc));
+  }
+  return array;
+}
+
+vtkSmartPointer<vtkPVProminentValuesInformation> NewInformation(
+  vtkAbstractArray* array, int capacity = 1024, bool force = false)
+{
+  auto info = vtkSmartPointer<vtkPVProminentValuesInformation>::New();
+  info->SetFieldAssociation(
+    vtkDataObject::GetAssociationTypeAsString(vtkDataObject::FIELD_ASSOCIATION_POINTS));
+  info->SetFieldName("labels");
+  info->SetNumberOfComponents(2);
+  info->SetFraction(0.);
+  info->SetUncertainty(0.);
+  info->SetForce(force);
+  info->SetSketchCapacity(capacity);
+  if (array)
+  {
+    info->CopyDistinctValuesFromObject(array);
+  }
+  return info;
+}
+
+// Serializes `info` and deserializes it into a new object.
+vtkSmartPointer<vtkPVProminentValuesInformation> RoundTrip(vtkPVProminentValuesInformation* info)
+{
+  vtkClientServerStream css;
+  info->CopyToStream(&css);
+  auto copy = vtkSmartPointer<vtkPVProminentValuesInformation>::New();
+  copy->CopyFromStream(&css);
+  return copy;
+}
+
+// Returns the prominent values of a component, one set entry per tuple.
+std::set<std::vector<int> > GetValues(vtkPVProminentValuesInformation* info, int component)
+{
+  std::set<std::vector<int> > result;
+  vtkSmartPointer<vtkAbstractArray> values;
+  values.TakeReference(info->GetProminentComponentValues(component));
+  if (values)
+  {
+    const int nc = values->GetNumberOfComponents();
+    for (vtkIdType t = 0; t < values->GetNumberOfTuples(); ++t)
+    {
+      std::vector<int> tuple(nc);
+      for (int c = 0; c < nc; ++c)
+      {
+        tuple[c] = values->GetVariantValue(t * nc + c).ToInt();
+      }
+      result.insert(tuple);
+    }
+  }
+  return result;
+}
+
+std::set<std::vector<int> > Range(int first, int last)
+{
+  std::set<std::vector<int> > result;
+  for (int cc = first; cc <= last; ++cc)
+  {
+    result.insert(std::vector<int>(1, cc));
+  }
+  return result;
+}
+}
+
+int TestProminentValuesInformation(int, char* [])
+{
+  // Exact sketches: values 0..4 and 3..7 for the first component.
+  auto infoA = NewInformation(NewArray(1000, 0, 5));
+  auto infoB = NewInformation(NewArray(1000, 3, 5));
+  TASSERT(infoA->GetValid());
+  TASSERT(GetValues(infoA, 0) == Range(0, 4));
+  TASSERT(GetValues(infoA, 1) == Range(0, 1));
+  TASSERT(GetValues(infoA, -1).size() == 10);
+  TASSERT(infoA->GetApproximateNumberOfDistinctValues(0) == 5);
+  TASSERT(infoA->GetApproximateNumberOfDistinctValues(-1) == 10);
+
+  // Round trip through a stream: parameters, values and sketches must be kept.
+  auto copyA = RoundTrip(infoA);
+  TASSERT(strcmp(copyA->GetFieldName(), "labels") == 0);
+  TASSERT(strcmp(copyA->GetFieldAssociation(), infoA->GetFieldAssociation()) == 0);
+  TASSERT(copyA->GetNumberOfComponents() == 2);
+  TASSERT(copyA->GetSketchCapacity() == 1024);
+  TASSERT(copyA->GetUseSketches());
+  TASSERT(copyA->GetValid());
+  for (int c = -1; c < 2; ++c)
+  {
+    TASSERT(GetValues(copyA, c) == GetValues(infoA, c));
+    TASSERT(copyA->GetApproximateNumberOfDistinctValues(c) ==
+      infoA->GetApproximateNumberOfDistinctValues(c));
+  }
+
+  // Merge the deserialized information, as done when gathering from ranks.
+  auto merged = NewInformation(nullptr);
+  merged->AddInformation(copyA);
+  merged->AddInformation(RoundTrip(infoB));
+  TASSERT(merged->GetValid());
+  TASSERT(GetValues(merged, 0) == Range(0, 7));
+  TASSERT(GetValues(merged, 1) == Range(0, 1));
+  TASSERT(merged->GetApproximateNumberOfDistinctValues(0) == 8);
+  TASSERT(GetValues(RoundTrip(merged), 0) == Range(0, 7));
+
+  // Overflowing sketches: 200 distinct values do not fit in 16 counters, so
+  // the values are not prominent unless forced, and their number is
+  // estimated from the registers, which must survive the round trip too.
+  auto infoC = NewInformation(NewArray(2000, 100, 200), 16);
+  TASSERT(!infoC->GetValid());
+  TASSERT(GetValues(infoC, 0).empty());
+  const vtkIdType estimate = infoC->GetApproximateNumberOfDistinctValues(0);
+  TASSERT(std::abs(estimate - 200) <= 20);
+  auto copyC = RoundTrip(infoC);
+  TASSERT(copyC->GetApproximateNumberOfDistinctValues(0) == estimate);
+
+  merged->AddInformation(copyC);
+  TASSERT(!merged->GetValid());
+  TASSERT(std::abs(merged->GetApproximateNumberOfDistinctValues(0) - 208) <= 21);
+
+  // When forced, the heavy hitters are reported: a value present in more than
+  // 1/17th of the tuples must survive trimming to 16 counters, merges
+  // included.
+  auto forced = NewInformation(NewDominatedArray(2000, 7), 16, true);
+  TASSERT(GetValues(forced, 0).count(std::vector<int>(1, 7)) == 1);
+  TASSERT(GetValues(forced, 0).size() <= 16);
+  auto forcedMerged = NewInformation(nullptr, 16, true);
+  forcedMerged->AddInformation(RoundTrip(forced));
+  forcedMerged->AddInformation(RoundTrip(NewInformation(NewArray(10000, 0, 1), 16, true)));
+  TASSERT(GetValues(forcedMerged, 0).count(std::vector<int>(1, 7)) == 1);
+  TASSERT(GetValues(forcedMerged, 0).count(std::vector<int>(1, 0)) == 1);
+  TASSERT(GetValues(forcedMerged, 0).size() <= 16);
+  return EXIT_SUCCESS;
+}
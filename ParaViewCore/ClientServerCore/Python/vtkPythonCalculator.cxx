@@ -24,6 +24,7 @@
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkObjectFactory.h"
+#include "vtkPVLogger.h"
 #include "vtkPVOptions.h"
 #include "vtkPointData.h"
 #include "vtkProcessModule.h"
@@ -61,6 +62,7 @@ vtkPythonCalculator::vtkPythonCalculator()
   this->SetArrayName("result");
   this->SetExecuteMethod(vtkPythonCalculator::ExecuteScript, this);
   this->ArrayAssociation = vtkDataObject::FIELD_ASSOCIATION_POINTS;
+  this->EvaluateBlocksIndependently = false;
 }
 
 //----------------------------------------------------------------------------
@@ -137,6 +139,11 @@ void vtkPythonCalculator::Exec(const char* expression)
     }
   }
 
+  // the conversion and evaluation times are logged within this scope by
+  // `paraview.detail.calculator`.
+  vtkVLogScopeF(PARAVIEW_LOG_PIPELINE_VERBOSITY(), "%s: execute expression '%s'",
+    vtkLogIdentifier(this), orgscript.c_str());
+
   // ensure Python is initialized (safe to call many times)
   vtkPythonInterpreter::Initialize();
 
@@ -192,4 +199,5 @@ int vtkPythonCalculator::FillInputPortInformation(int port, vtkInformation* info
 void vtkPythonCalculator::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "EvaluateBlocksIndependently: " << this->EvaluateBlocksIndependently << endl;
 }
@@ -59,20 +59,40 @@ public:
    * must return a scalar value (which is converted to an array) or a
    * numpy array.
    */
-  vtkSetStringMacro(Expression) vtkGetStringMacro(Expression)
-    //@}
+  vtkSetStringMacro(Expression);
+  vtkGetStringMacro(Expression);
+  //@}
 
-    //@{
-    /**
-     * Set the name of the output array.
-     */
-    vtkSetStringMacro(ArrayName) vtkGetStringMacro(ArrayName)
-    //@}
+  //@{
+  /**
+   * Set the name of the output array.
+   */
+  vtkSetStringMacro(ArrayName);
+  vtkGetStringMacro(ArrayName);
+  //@}
 
-    /**
-     * For internal use only.
-     */
-    static void ExecuteScript(void*);
+  //@{
+  /**
+   * When on and the input is a composite dataset, the expression is
+   * evaluated separately on each leaf, with several threads. This is faster
+   * for large composite datasets but changes the meaning of expressions
+   * that combine values across blocks: functions such as max() or mean()
+   * then operate on each block alone. When running on several processes, the
+   * blocks are evaluated one after the other, in the same order on every
+   * process, since these functions communicate. If the processes do not all
+   * hold the same number of leaves, with arrays split the same way, every
+   * process evaluates the expression on the whole dataset instead. The
+   * default is off.
+   */
+  vtkSetMacro(EvaluateBlocksIndependently, bool);
+  vtkGetMacro(EvaluateBlocksIndependently, bool);
+  vtkBooleanMacro(EvaluateBlocksIndependently, bool);
+  //@}
+
+  /**
+   * For internal use only.
+   */
+  static void ExecuteScript(void*);
 
 protected:
   vtkPythonCalculator();
@@ -96,6 +116,7 @@ protected:
   char* Expression;
   char* ArrayName;
   int ArrayAssociation;
+  bool EvaluateBlocksIndependently;
 
 private:
   vtkPythonCalculator(const vtkPythonCalculator&) = delete;
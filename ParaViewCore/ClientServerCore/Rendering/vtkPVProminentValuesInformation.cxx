@@ -34,15 +34,23 @@
 #include "vtkPVDataRepresentation.h"
 #include "vtkPVPostFilter.h"
 #include "vtkPointData.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPTools.h"
 #include "vtkStdString.h"
 #include "vtkStringArray.h"
 #include "vtkTable.h"
 #include "vtkVariant.h"
 #include "vtkVariantArray.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iterator>
 #include <map>
 #include <set>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
 #define VTK_MAX_CATEGORICAL_VALS (32)
@@ -50,6 +58,287 @@
 namespace
 {
 typedef std::map<int, std::set<std::vector<vtkVariant> > > vtkInternalDistinctValuesBase;
+
+// HyperLogLog precision: 2^12 one-byte registers per sketch, i.e. a standard
+// error of about 1.6% on the number of distinct values.
+const int VTK_PROMINENT_HLL_BITS = 12;
+const size_t VTK_PROMINENT_HLL_SIZE = static_cast<size_t>(1) << VTK_PROMINENT_HLL_BITS;
+
+inline vtkTypeUInt64 vtkMix64(vtkTypeUInt64 x)
+{
+  // splitmix64 finalizer.
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+// Returns a key that uniquely identifies the value; -0 and 0 as well as all
+// NaNs are folded together.
+inline vtkTypeUInt64 vtkValueKey(double value)
+{
+  if (value == 0.)
+  {
+    value = 0.;
+  }
+  else if (value != value)
+  {
+    return 0x7ff8000000000000ULL;
+  }
+  vtkTypeUInt64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline void vtkAddToRegisters(std::vector<unsigned char>& registers, vtkTypeUInt64 key)
+{
+  const vtkTypeUInt64 hash = vtkMix64(key);
+  const size_t index = static_cast<size_t>(hash >> (64 - VTK_PROMINENT_HLL_BITS));
+  vtkTypeUInt64 remainder = hash << VTK_PROMINENT_HLL_BITS;
+  unsigned char rank = 1;
+  while (rank <= 64 - VTK_PROMINENT_HLL_BITS && (remainder & 0x8000000000000000ULL) == 0)
+  {
+    ++rank;
+    remainder <<= 1;
+  }
+  registers[index] = std::max(registers[index], rank);
+}
+
+inline void vtkMergeRegisters(std::vector<unsigned char>& target,
+  const std::vector<unsigned char>& source)
+{
+  if (target.size() != source.size())
+  {
+    target.resize(std::max(target.size(), source.size()), 0);
+  }
+  for (size_t cc = 0; cc < source.size(); ++cc)
+  {
+    target[cc] = std::max(target[cc], source[cc]);
+  }
+}
+
+vtkIdType vtkEstimateCardinality(const std::vector<unsigned char>& registers)
+{
+  if (registers.empty())
+  {
+    return -1;
+  }
+  const double m = static_cast<double>(registers.size());
+  double sum = 0.;
+  size_t zeros = 0;
+  for (unsigned char reg : registers)
+  {
+    sum += std::ldexp(1., -static_cast<int>(reg));
+    zeros += (reg == 0) ? 1 : 0;
+  }
+  const double alpha = 0.7213 / (1. + 1.079 / m);
+  double estimate = alpha * m * m / sum;
+  if (estimate <= 2.5 * m && zeros > 0)
+  {
+    // small range correction (linear counting).
+    estimate = m * std::log(m / static_cast<double>(zeros));
+  }
+  return static_cast<vtkIdType>(estimate + 0.5);
+}
+
+// Trims a heavy-hitters summary back to `capacity` entries as done when merging
+// Misra-Gries summaries: the (capacity+1)-th largest count is subtracted from
+// all counters and non-positive ones are dropped. `offset` accumulates the
+// maximum under-estimation of the counts.
+template <typename MapType, typename CountFunctor>
+void vtkTrimSummary(MapType& counts, size_t capacity, vtkTypeInt64& offset, CountFunctor count)
+{
+  if (counts.size() <= capacity)
+  {
+    return;
+  }
+  std::vector<vtkTypeInt64> values;
+  values.reserve(counts.size());
+  for (auto& item : counts)
+  {
+    values.push_back(count(item.second));
+  }
+  std::nth_element(
+    values.begin(), values.begin() + capacity, values.end(), std::greater<vtkTypeInt64>());
+  const vtkTypeInt64 decrement = values[capacity];
+  for (auto iter = counts.begin(); iter != counts.end();)
+  {
+    if ((count(iter->second) -= decrement) <= 0)
+    {
+      iter = counts.erase(iter);
+    }
+    else
+    {
+      ++iter;
+    }
+  }
+  offset += decrement;
+}
+
+// Per-thread sketch over raw (double) values: the heavy hitters are keyed by
+// vtkValueKey() (or a hash of the tuple) and remember one tuple holding the
+// value so that it can be converted back to the array's type at the end.
+struct vtkLocalSketch
+{
+  struct Counter
+  {
+    vtkTypeInt64 Count;
+    vtkIdType Tuple;
+  };
+  std::unordered_map<vtkTypeUInt64, Counter> Counts;
+  std::vector<unsigned char> Registers;
+  vtkTypeInt64 Total = 0;
+  vtkTypeInt64 Offset = 0;
+
+  void Insert(vtkTypeUInt64 key, vtkIdType tuple, size_t capacity)
+  {
+    ++this->Total;
+    vtkAddToRegisters(this->Registers, key);
+    auto iter = this->Counts.find(key);
+    if (iter != this->Counts.end())
+    {
+      ++iter->second.Count;
+    }
+    else if (this->Counts.size() < capacity)
+    {
+      this->Counts.insert(std::make_pair(key, Counter{ 1, tuple }));
+    }
+    else
+    {
+      // Misra-Gries: decrement all counters, the new value included.
+      ++this->Offset;
+      for (auto citer = this->Counts.begin(); citer != this->Counts.end();)
+      {
+        citer = (--citer->second.Count == 0) ? this->Counts.erase(citer) : std::next(citer);
+      }
+    }
+  }
+
+  void Merge(const vtkLocalSketch& other, size_t capacity)
+  {
+    for (const auto& item : other.Counts)
+    {
+      auto iter = this->Counts.find(item.first);
+      if (iter != this->Counts.end())
+      {
+        iter->second.Count += item.second.Count;
+      }
+      else
+      {
+        this->Counts.insert(item);
+      }
+    }
+    this->Total += other.Total;
+    this->Offset += other.Offset;
+    vtkMergeRegisters(this->Registers, other.Registers);
+    vtkTrimSummary(this->Counts, capacity, this->Offset,
+      [](Counter& counter) -> vtkTypeInt64& { return counter.Count; });
+  }
+};
+
+// Computes the sketches for all components (and tuples) in a single pass.
+class vtkSketchWorker
+{
+public:
+  vtkDataArray* Array;
+  int NumberOfComponents;
+  int NumberOfSketches;
+  size_t Capacity;
+  vtkSMPThreadLocal<std::vector<vtkLocalSketch> > Sketches;
+  vtkSMPThreadLocal<std::vector<double> > Tuples;
+
+  vtkSketchWorker(vtkDataArray* array, size_t capacity)
+    : Array(array)
+    , NumberOfComponents(array->GetNumberOfComponents())
+    , NumberOfSketches(array->GetNumberOfComponents() > 1 ? array->GetNumberOfComponents() + 1 : 1)
+    , Capacity(capacity)
+  {
+  }
+
+  void Initialize()
+  {
+    auto& sketches = this->Sketches.Local();
+    sketches.resize(this->NumberOfSketches);
+    for (auto& sketch : sketches)
+    {
+      sketch.Registers.assign(VTK_PROMINENT_HLL_SIZE, 0);
+    }
+    this->Tuples.Local().resize(this->NumberOfComponents);
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    auto& sketches = this->Sketches.Local();
+    auto& tuple = this->Tuples.Local();
+    const int nc = this->NumberOfComponents;
+    for (vtkIdType t = begin; t < end; ++t)
+    {
+      this->Array->GetTuple(t, tuple.data());
+      if (nc == 1)
+      {
+        sketches[0].Insert(vtkValueKey(tuple[0]), t, this->Capacity);
+        continue;
+      }
+      // sketch 0 is for the tuples, the others for each component.
+      vtkTypeUInt64 tupleKey = 0;
+      for (int c = 0; c < nc; ++c)
+      {
+        const vtkTypeUInt64 key = vtkValueKey(tuple[c]);
+        tupleKey = vtkMix64(tupleKey ^ key);
+        sketches[c + 1].Insert(key, t, this->Capacity);
+      }
+      sketches[0].Insert(tupleKey, t, this->Capacity);
+    }
+  }
+
+  void Reduce() {}
+
+  // Returns the merged per-thread sketches.
+  std::vector<vtkLocalSketch> GetResult()
+  {
+    std::vector<vtkLocalSketch> result(this->NumberOfSketches);
+    for (auto& sketch : result)
+    {
+      sketch.Registers.assign(VTK_PROMINENT_HLL_SIZE, 0);
+    }
+    for (auto iter = this->Sketches.begin(); iter != this->Sketches.end(); ++iter)
+    {
+      for (int cc = 0; cc < this->NumberOfSketches; ++cc)
+      {
+        result[cc].Merge((*iter)[cc], this->Capacity);
+      }
+    }
+    return result;
+  }
+};
+
+// Mergeable sketch for a component (or the tuples) of an array: heavy-hitters
+// summary with an upper bound on the under-estimation of the counts (`Offset`,
+// zero if the counts are exact) and HyperLogLog registers to estimate the
+// number of distinct values.
+struct vtkProminentValuesSketch
+{
+  std::map<std::vector<vtkVariant>, vtkTypeInt64> Counts;
+  std::vector<unsigned char> Registers;
+  vtkTypeInt64 Total = 0;
+  vtkTypeInt64 Offset = 0;
+
+  void Merge(const vtkProminentValuesSketch& other, size_t capacity)
+  {
+    for (const auto& item : other.Counts)
+    {
+      this->Counts[item.first] += item.second;
+    }
+    this->Total += other.Total;
+    this->Offset += other.Offset;
+    vtkMergeRegisters(this->Registers, other.Registers);
+    vtkTrimSummary(this->Counts, capacity, this->Offset,
+      [](vtkTypeInt64& count) -> vtkTypeInt64& { return count; });
+  }
+};
+typedef std::map<int, vtkProminentValuesSketch> vtkInternalSketchesBase;
 }
 
 class vtkPVProminentValuesInformation::vtkInternalDistinctValues
@@ -57,6 +346,10 @@ class vtkPVProminentValuesInformation::vtkInternalDistinctValues
 {
 };
 
+class vtkPVProminentValuesInformation::vtkInternalSketches : public vtkInternalSketchesBase
+{
+};
+
 vtkStandardNewMacro(vtkPVProminentValuesInformation);
 
 //----------------------------------------------------------------------------
@@ -66,10 +359,13 @@ vtkPVProminentValuesInformation::vtkPVProminentValuesInformation()
   this->FieldName = 0;
   this->FieldAssociation = 0;
   this->DistinctValues = 0;
+  this->Sketches = 0;
   this->InitializeParameters();
   this->Initialize();
   this->Force = false;
   this->Valid = true;
+  this->UseSketches = true;
+  this->SketchCapacity = 1024;
 }
 
 //----------------------------------------------------------------------------
@@ -98,6 +394,8 @@ void vtkPVProminentValuesInformation::Initialize()
     delete this->DistinctValues;
     this->DistinctValues = 0;
   }
+  delete this->Sketches;
+  this->Sketches = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -142,6 +440,17 @@ void vtkPVProminentValuesInformation::PrintSelf(ostream& os, vtkIndent indent)
   }
   os << "Fraction: " << this->Fraction << endl;
   os << "Uncertainty: " << this->Uncertainty << endl;
+  os << indent << "UseSketches: " << this->UseSketches << endl;
+  os << indent << "SketchCapacity: " << this->SketchCapacity << endl;
+  if (this->Sketches)
+  {
+    for (const auto& item : *this->Sketches)
+    {
+      os << i2 << "Component " << item.first << " sketch: " << item.second.Counts.size()
+         << " heavy hitters over " << item.second.Total << " values, ~"
+         << vtkEstimateCardinality(item.second.Registers) << " distinct values" << endl;
+    }
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -156,6 +465,10 @@ void vtkPVProminentValuesInformation::SetNumberOfComponents(int numComps)
   {
     this->DistinctValues->clear();
   }
+  if (this->Sketches)
+  {
+    this->Sketches->clear();
+  }
   if (numComps <= 0)
   {
     this->NumberOfComponents = 0;
@@ -182,6 +495,9 @@ void vtkPVProminentValuesInformation::DeepCopy(vtkPVProminentValuesInformation*
     }
     *this->DistinctValues = *info->DistinctValues;
   }
+
+  delete this->Sketches;
+  this->Sketches = info->Sketches ? new vtkInternalSketches(*info->Sketches) : 0;
 }
 
 //----------------------------------------------------------------------------
@@ -251,6 +567,8 @@ void vtkPVProminentValuesInformation::DeepCopyParameters(vtkPVProminentValuesInf
   this->Uncertainty = other->Uncertainty;
   this->Force = other->Force;
   this->Valid = other->Valid;
+  this->UseSketches = other->UseSketches;
+  this->SketchCapacity = other->SketchCapacity;
 }
 
 //----------------------------------------------------------------------------
@@ -331,6 +649,18 @@ void vtkPVProminentValuesInformation::CopyDistinctValuesFromObject(vtkAbstractAr
   {
     this->DistinctValues = new vtkInternalDistinctValues;
   }
+  delete this->Sketches;
+  this->Sketches = 0;
+
+  vtkDataArray* dataArray = vtkDataArray::SafeDownCast(array);
+  if (this->UseSketches && dataArray &&
+    dataArray->GetNumberOfComponents() == this->GetNumberOfComponents())
+  {
+    this->ComputeSketches(dataArray);
+    this->UpdateDistinctValuesFromSketches();
+    return;
+  }
+
   int nc = this->GetNumberOfComponents();
   vtkNew<vtkVariantArray> cvalues;
   std::vector<vtkVariant> tuple;
@@ -379,6 +709,95 @@ void vtkPVProminentValuesInformation::CopyDistinctValuesFromObject(vtkAbstractAr
   }
 }
 
+//----------------------------------------------------------------------------
+void vtkPVProminentValuesInformation::ComputeSketches(vtkDataArray* array)
+{
+  const size_t capacity = static_cast<size_t>(this->SketchCapacity);
+  vtkSketchWorker worker(array, capacity);
+  vtkSMPTools::For(0, array->GetNumberOfTuples(), worker);
+  std::vector<vtkLocalSketch> local = worker.GetResult();
+
+  // Convert the raw keys back to values of the array's type.
+  const int nc = array->GetNumberOfComponents();
+  this->Sketches = new vtkInternalSketches;
+  for (int cc = 0; cc < worker.NumberOfSketches; ++cc)
+  {
+    const int component = nc > 1 ? cc - 1 : cc;
+    const int tupleSize = component < 0 ? nc : 1;
+    vtkProminentValuesSketch& sketch = (*this->Sketches)[component];
+    sketch.Total = local[cc].Total;
+    sketch.Offset = local[cc].Offset;
+    sketch.Registers.swap(local[cc].Registers);
+    std::vector<vtkVariant> tuple(tupleSize);
+    for (const auto& item : local[cc].Counts)
+    {
+      for (int i = 0; i < tupleSize; ++i)
+      {
+        tuple[i] = array->GetVariantValue(
+          item.second.Tuple * nc + (component < 0 ? i : component));
+      }
+      sketch.Counts[tuple] += item.second.Count;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPVProminentValuesInformation::UpdateDistinctValuesFromSketches()
+{
+  if (!this->Sketches)
+  {
+    return;
+  }
+  if (!this->DistinctValues)
+  {
+    this->DistinctValues = new vtkInternalDistinctValues;
+  }
+  this->DistinctValues->clear();
+
+  // Unless forced, values are only reported if the counts are exact (no value
+  // was ever evicted from the summaries) and there are few of them. When
+  // forced, the heavy hitters are reported, most frequent first if trimmed.
+  bool valid = true;
+  for (const auto& item : *this->Sketches)
+  {
+    const vtkProminentValuesSketch& sketch = item.second;
+    const bool exact = sketch.Offset == 0;
+    if (sketch.Total == 0 ||
+      (!this->Force &&
+          (!exact || sketch.Counts.size() > vtkAbstractArray::MAX_DISCRETE_VALUES)))
+    {
+      valid = valid && item.first < 0;
+      continue;
+    }
+    auto& compDistincts = (*this->DistinctValues)[item.first];
+    for (const auto& value : sketch.Counts)
+    {
+      compDistincts.insert(value.first);
+    }
+  }
+  this->Valid = valid;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkPVProminentValuesInformation::GetApproximateNumberOfDistinctValues(int component)
+{
+  if (component < 0 && this->NumberOfComponents == 1)
+  {
+    component = 0;
+  }
+  vtkInternalSketches::iterator iter;
+  if (!this->Sketches || (iter = this->Sketches->find(component)) == this->Sketches->end())
+  {
+    return -1;
+  }
+  if (iter->second.Offset == 0)
+  {
+    // the summary is exact.
+    return static_cast<vtkIdType>(iter->second.Counts.size());
+  }
+  return vtkEstimateCardinality(iter->second.Registers);
+}
+
 //----------------------------------------------------------------------------
 void vtkPVProminentValuesInformation::AddInformation(vtkPVInformation* info)
 {
@@ -398,6 +817,18 @@ void vtkPVProminentValuesInformation::AddInformation(vtkPVInformation* info)
     // If this object is uninitialized, copy.
     this->DeepCopy(aInfo);
   }
+  else if (this->Sketches && aInfo->Sketches)
+  {
+    // Merge the sketches and derive the prominent values from the result;
+    // validity only depends on the merged sketches.
+    const size_t capacity = static_cast<size_t>(this->SketchCapacity);
+    for (const auto& item : *aInfo->Sketches)
+    {
+      (*this->Sketches)[item.first].Merge(item.second, capacity);
+    }
+    this->UpdateDistinctValuesFromSketches();
+    return;
+  }
   else
   {
     // Add unique values to our own.
@@ -415,7 +846,7 @@ void vtkPVProminentValuesInformation::CopyToStream(vtkClientServerStream* css)
   // Copy parameter values to stream.
   *css << this->PortNumber << std::string(this->FieldAssociation) << std::string(this->FieldName)
        << this->NumberOfComponents << this->Fraction << this->Uncertainty << this->Force
-       << this->Valid;
+       << this->Valid << this->UseSketches << this->SketchCapacity;
 
   // Now copy results to stream.
   int numberOfDistinctValueComponents =
@@ -441,6 +872,29 @@ void vtkPVProminentValuesInformation::CopyToStream(vtkClientServerStream* css)
     }
   }
 
+  // Sketches are sent along so that they can be merged with other ranks.
+  int numberOfSketches = static_cast<int>(this->Sketches ? this->Sketches->size() : 0);
+  *css << numberOfSketches;
+  if (numberOfSketches)
+  {
+    for (const auto& item : *this->Sketches)
+    {
+      const vtkProminentValuesSketch& sketch = item.second;
+      *css << item.first << static_cast<long long>(sketch.Total)
+           << static_cast<long long>(sketch.Offset) << static_cast<unsigned>(sketch.Counts.size());
+      for (const auto& value : sketch.Counts)
+      {
+        for (const auto& var : value.first)
+        {
+          *css << var;
+        }
+        *css << static_cast<long long>(value.second);
+      }
+      *css << vtkClientServerStream::InsertArray(
+        sketch.Registers.data(), static_cast<int>(sketch.Registers.size()));
+    }
+  }
+
   *css << vtkClientServerStream::End;
 }
 
@@ -500,6 +954,18 @@ void vtkPVProminentValuesInformation::CopyFromStream(const vtkClientServerStream
     return;
   }
 
+  if (!css->GetArgument(0, pos++, &this->UseSketches))
+  {
+    vtkErrorMacro("Error parsing use-sketches flag from message.");
+    return;
+  }
+
+  if (!css->GetArgument(0, pos++, &this->SketchCapacity))
+  {
+    vtkErrorMacro("Error parsing sketch capacity from message.");
+    return;
+  }
+
   int numberOfDistinctValueComponents;
   if (!css->GetArgument(0, pos++, &numberOfDistinctValueComponents))
   {
@@ -552,6 +1018,62 @@ void vtkPVProminentValuesInformation::CopyFromStream(const vtkClientServerStream
       }
     }
   }
+
+  int numberOfSketches;
+  if (!css->GetArgument(0, pos++, &numberOfSketches))
+  {
+    vtkErrorMacro("Error parsing number of sketches from message.");
+    return;
+  }
+  delete this->Sketches;
+  this->Sketches = numberOfSketches > 0 ? new vtkInternalSketches : 0;
+  for (int i = 0; i < numberOfSketches; ++i)
+  {
+    int component;
+    long long total, offset;
+    unsigned numberOfCounts;
+    if (!css->GetArgument(0, pos++, &component) || !css->GetArgument(0, pos++, &total) ||
+      !css->GetArgument(0, pos++, &offset) || !css->GetArgument(0, pos++, &numberOfCounts))
+    {
+      vtkErrorMacro("Error decoding the " << i << "-th sketch.");
+      return;
+    }
+    vtkProminentValuesSketch& sketch = (*this->Sketches)[component];
+    sketch.Total = total;
+    sketch.Offset = offset;
+    std::vector<vtkVariant> tuple(component < 0 ? this->NumberOfComponents : 1);
+    for (unsigned j = 0; j < numberOfCounts; ++j)
+    {
+      long long count;
+      for (auto& var : tuple)
+      {
+        if (!css->GetArgument(0, pos, &var))
+        {
+          vtkErrorMacro("Error decoding the " << j << "-th heavy hitter of sketch " << i);
+          return;
+        }
+      }
+      if (!css->GetArgument(0, pos++, &count))
+      {
+        vtkErrorMacro("Error decoding the " << j << "-th count of sketch " << i);
+        return;
+      }
+      sketch.Counts[tuple] = count;
+    }
+    vtkTypeUInt32 length = 0;
+    if (!css->GetArgumentLength(0, pos, &length))
+    {
+      vtkErrorMacro("Error decoding the registers of sketch " << i);
+      return;
+    }
+    sketch.Registers.resize(length);
+    if (length > 0 && !css->GetArgument(0, pos, sketch.Registers.data(), length))
+    {
+      vtkErrorMacro("Error decoding the registers of sketch " << i);
+      return;
+    }
+    ++pos;
+  }
 }
 
 #define VTK_PROMINENT_MAGIC_NUMBER 573167
@@ -562,7 +1084,8 @@ void vtkPVProminentValuesInformation::CopyParametersToStream(vtkMultiProcessStre
   vtkTypeUInt32 magic_number = VTK_PROMINENT_MAGIC_NUMBER;
   mps << magic_number << this->PortNumber << std::string(this->FieldAssociation)
       << std::string(this->FieldName) << this->NumberOfComponents << this->Fraction
-      << this->Uncertainty << this->Force << this->Valid;
+      << this->Uncertainty << this->Force << this->Valid << this->UseSketches
+      << this->SketchCapacity;
 }
 
 //-----------------------------------------------------------------------------
@@ -573,7 +1096,8 @@ void vtkPVProminentValuesInformation::CopyParametersFromStream(vtkMultiProcessSt
   std::string fieldAssoc;
   std::string fieldName;
   mps >> magic_number >> this->PortNumber >> fieldAssoc >> fieldName >> this->NumberOfComponents >>
-    this->Fraction >> this->Uncertainty >> this->Force >> this->Valid;
+    this->Fraction >> this->Uncertainty >> this->Force >> this->Valid >> this->UseSketches >>
+    this->SketchCapacity;
   if (magic_number != VTK_PROMINENT_MAGIC_NUMBER)
   {
     vtkErrorMacro("Magic number mismatch.");
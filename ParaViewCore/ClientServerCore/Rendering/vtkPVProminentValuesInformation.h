@@ -26,7 +26,20 @@
  * given confidence that dictates the number of samples required), then
  * the prominent values are also made available.
  *
- * This class uses vtkAbstractArray::GetProminentComponentValues().
+ * For numeric arrays, when UseSketches is on (the default), the values are
+ * found in a single multithreaded pass over the array that builds, for each
+ * component (and for the tuples), a bounded heavy-hitters summary
+ * (Misra-Gries) and a HyperLogLog estimate of the number of distinct values.
+ * These sketches are mergeable, hence they are combined across blocks and
+ * ranks in AddInformation() and their size does not depend on the number of
+ * distinct values in the array. Otherwise, this class uses
+ * vtkAbstractArray::GetProminentComponentValues().
+ *
+ * Neither path samples the array: every value is inspected, so the
+ * uncertainty is always zero, and all the distinct values are reported
+ * whatever their frequency, as callers such as the color annotations expect.
+ * Fraction and Uncertainty are therefore only kept with the information so
+ * that vtkSMRepresentationProxy can tell when to gather it again.
 */
 
 #ifndef vtkPVProminentValuesInformation_h
@@ -38,6 +51,7 @@
 class vtkAbstractArray;
 class vtkClientServerStream;
 class vtkCompositeDataSet;
+class vtkDataArray;
 class vtkDataObject;
 class vtkStdString;
 class vtkStringArray;
@@ -89,6 +103,7 @@ public:
 
    * Setting this to one indicates that an array must have every value be
    * identical in order to have any considered prominent.
+   * Not applied when gathering the values, see the class description.
    */
   vtkSetClampMacro(Fraction, double, 0., 1.);
   vtkGetMacro(Fraction, double);
@@ -99,6 +114,7 @@ public:
    * Set/get the maximum uncertainty allowed in the detection of prominent values.
    * The uncertainty is the probability of prominent values going undetected.
    * Setting this to zero forces the entire array to be inspected.
+   * The entire array is always inspected, see the class description.
    */
   vtkSetClampMacro(Uncertainty, double, 0., 1.);
   vtkGetMacro(Uncertainty, double);
@@ -124,6 +140,35 @@ public:
    */
   vtkGetMacro(Valid, bool);
 
+  //@{
+  /**
+   * Set/get whether mergeable sketches are used to find the prominent values
+   * of numeric arrays. Default is true.
+   */
+  vtkSetMacro(UseSketches, bool);
+  vtkGetMacro(UseSketches, bool);
+  vtkBooleanMacro(UseSketches, bool);
+  //@}
+
+  //@{
+  /**
+   * Set/get the maximum number of values tracked by each heavy-hitters sketch.
+   * If an array component takes on more distinct values, only the most
+   * frequent ones are kept; they are reported only when Force is set.
+   * Default is 1024.
+   */
+  vtkSetClampMacro(SketchCapacity, int, 1, VTK_INT_MAX);
+  vtkGetMacro(SketchCapacity, int);
+  //@}
+
+  /**
+   * Returns the number of distinct values of a component (or of the tuples
+   * when \a component is -1). The number is exact when all the values fit in
+   * the heavy-hitters sketch and estimated otherwise. Returns -1 if sketches
+   * were not computed.
+   */
+  vtkIdType GetApproximateNumberOfDistinctValues(int component);
+
   /**
    * Returns 1 if the array can be combined.
    * It must have the same name and number of components.
@@ -204,6 +249,8 @@ protected:
   void DeepCopyParameters(vtkPVProminentValuesInformation* other);
   void CopyFromCompositeDataSet(vtkCompositeDataSet*);
   void CopyFromLeafDataObject(vtkDataObject*);
+  void ComputeSketches(vtkDataArray*);
+  void UpdateDistinctValuesFromSketches();
 
   /// Information parameters
   //@{
@@ -215,6 +262,8 @@ protected:
   double Uncertainty;
   bool Force;
   bool Valid;
+  bool UseSketches;
+  int SketchCapacity;
   //@}
 
   /// Information results
@@ -223,6 +272,9 @@ protected:
   class vtkInternalDistinctValues;
   vtkInternalDistinctValues* DistinctValues;
 
+  class vtkInternalSketches;
+  vtkInternalSketches* Sketches;
+
   //@}
 
   vtkPVProminentValuesInformation(const vtkPVProminentValuesInformation&) = delete;
@@ -15,21 +15,182 @@
 #include "vtkMultiBlockDataSet.h"
 #include "vtkNew.h"
 #include "vtkObjectFactory.h"
+#include "vtkPVLODActor.h"
+#include "vtkPVLogger.h"
 #include "vtkPVRenderView.h"
 #include "vtkPiecewiseFunction.h"
 #include "vtkPointData.h"
 #include "vtkPointGaussianMapper.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
 #include "vtkProperty.h"
 #include "vtkRenderer.h"
+#include "vtkSMPTools.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace
+{
+// Octree depth of the finest level of the hierarchy, 2^10 divisions per axis.
+const int MAX_LOD_LEVEL = 10;
+
+// Spreads the 10 lowest bits of v so that they occupy every third bit.
+uint32_t SpreadBits(uint32_t v)
+{
+  v &= 0x3ff;
+  v = (v | (v << 16)) & 0x30000ff;
+  v = (v | (v << 8)) & 0x300f00f;
+  v = (v | (v << 4)) & 0x30c30c3;
+  v = (v | (v << 2)) & 0x9249249;
+  return v;
+}
+
+// Index of the most significant bit set in v, which must not be 0.
+int MostSignificantBit(uint32_t v)
+{
+  int msb = 0;
+  while (v >>= 1)
+  {
+    ++msb;
+  }
+  return msb;
+}
+
+//----------------------------------------------------------------------------
+// Multi-resolution ordering of the points of a vtkPolyData. Points are sorted
+// along a Morton curve; the first point of each occupied octree node in that
+// order represents the node. A point that first represents a node at depth L
+// is at level L, and points sharing the finest node with another point are at
+// level MAX_LOD_LEVEL + 1. The points are then ordered by level, so that the
+// representatives down to depth L are the first LevelOffsets[L + 1] points.
+class vtkPointHierarchy
+{
+public:
+  void Build(vtkPolyData* pd)
+  {
+    const vtkIdType numPts = pd->GetNumberOfPoints();
+    this->OrderedIds.resize(numPts);
+    this->LevelOffsets.assign(MAX_LOD_LEVEL + 3, 0);
+    if (numPts == 0)
+    {
+      return;
+    }
+
+    vtkPoints* points = pd->GetPoints();
+    double bounds[6];
+    points->GetBounds(bounds);
+    double scale[3];
+    for (int c = 0; c < 3; ++c)
+    {
+      const double length = bounds[2 * c + 1] - bounds[2 * c];
+      scale[c] = length > 0 ? (1 << MAX_LOD_LEVEL) / length : 0;
+    }
+
+    std::vector<std::pair<uint32_t, vtkIdType> > keys(numPts);
+    vtkSMPTools::For(0, numPts, [&](vtkIdType begin, vtkIdType end) {
+      double x[3];
+      for (vtkIdType i = begin; i < end; ++i)
+      {
+        points->GetPoint(i, x);
+        uint32_t key = 0;
+        for (int c = 0; c < 3; ++c)
+        {
+          const int q = static_cast<int>((x[c] - bounds[2 * c]) * scale[c]);
+          const int clamped = std::min(std::max(q, 0), (1 << MAX_LOD_LEVEL) - 1);
+          key |= SpreadBits(static_cast<uint32_t>(clamped)) << (2 - c);
+        }
+        keys[i] = std::make_pair(key, i);
+      }
+    });
+    vtkSMPTools::Sort(keys.begin(), keys.end());
+
+    // Points i - 1 and i first differ in the octree node at the depth given by
+    // the most significant bit of their keys that differs.
+    std::vector<unsigned char> levels(numPts);
+    levels[0] = 0;
+    vtkSMPTools::For(1, numPts, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType i = begin; i < end; ++i)
+      {
+        const uint32_t diff = keys[i].first ^ keys[i - 1].first;
+        levels[i] = static_cast<unsigned char>(
+          diff ? MAX_LOD_LEVEL - MostSignificantBit(diff) / 3 : MAX_LOD_LEVEL + 1);
+      }
+    });
+
+    for (vtkIdType i = 0; i < numPts; ++i)
+    {
+      ++this->LevelOffsets[levels[i] + 1];
+    }
+    for (int l = 1; l <= MAX_LOD_LEVEL + 2; ++l)
+    {
+      this->LevelOffsets[l] += this->LevelOffsets[l - 1];
+    }
+    std::vector<vtkIdType> next(this->LevelOffsets.begin(), this->LevelOffsets.end() - 1);
+    for (vtkIdType i = 0; i < numPts; ++i)
+    {
+      this->OrderedIds[next[levels[i]]++] = keys[i].second;
+    }
+  }
+
+  // Returns the representatives of the octree nodes down to depth level.
+  vtkSmartPointer<vtkPolyData> Extract(vtkPolyData* pd, int level) const
+  {
+    auto lod = vtkSmartPointer<vtkPolyData>::New();
+    const vtkIdType numPts = this->LevelOffsets[level + 1];
+    if (numPts == 0)
+    {
+      return lod;
+    }
+
+    vtkPointData* inPD = pd->GetPointData();
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    points->SetDataType(pd->GetPoints()->GetDataType());
+    points->SetNumberOfPoints(numPts);
+
+    lod->SetPoints(points);
+    vtkPointData* outPD = lod->GetPointData();
+    outPD->CopyAllocate(inPD, numPts);
+    for (vtkIdType i = 0; i < numPts; ++i)
+    {
+      const vtkIdType id = this->OrderedIds[i];
+      points->SetPoint(i, pd->GetPoint(id));
+      outPD->CopyData(inPD, id, i);
+    }
+    return lod;
+  }
+
+private:
+  std::vector<vtkIdType> OrderedIds;
+  std::vector<vtkIdType> LevelOffsets;
+};
+}
+
+class vtkPointGaussianRepresentation::vtkInternals
+{
+public:
+  // One hierarchy per leaf of ProcessedData, in iteration order.
+  std::vector<vtkPointHierarchy> Hierarchies;
+  vtkTimeStamp HierarchyTime;
+
+  // The LOD geometry last provided to the view and the depth it was built for.
+  vtkSmartPointer<vtkDataObject> LODData;
+  int LODLevel = -1;
+};
 
 vtkStandardNewMacro(vtkPointGaussianRepresentation)
 
   //----------------------------------------------------------------------------
   vtkPointGaussianRepresentation::vtkPointGaussianRepresentation()
 {
+  this->Internals = new vtkInternals();
   this->Mapper = vtkSmartPointer<vtkPointGaussianMapper>::New();
-  this->Actor = vtkSmartPointer<vtkActor>::New();
+  this->LODMapper = vtkSmartPointer<vtkPointGaussianMapper>::New();
+  this->Actor = vtkSmartPointer<vtkPVLODActor>::New();
   this->Actor->SetMapper(this->Mapper);
+  this->Actor->SetLODMapper(this->LODMapper);
+  this->SuppressLOD = false;
   this->ScaleByArray = false;
   this->LastScaleArray = NULL;
   this->LastScaleArrayComponent = 0;
@@ -45,6 +206,7 @@ vtkPointGaussianRepresentation::~vtkPointGaussianRepresentation()
 {
   this->SetLastScaleArray(NULL);
   this->SetLastOpacityArray(NULL);
+  delete this->Internals;
 }
 
 //----------------------------------------------------------------------------
@@ -157,6 +319,7 @@ void vtkPointGaussianRepresentation::SetVisibility(bool val)
 void vtkPointGaussianRepresentation::SetEmissive(bool val)
 {
   this->Mapper->SetEmissive(val);
+  this->LODMapper->SetEmissive(val);
 }
 
 //----------------------------------------------------------------------------
@@ -170,6 +333,7 @@ void vtkPointGaussianRepresentation::SetMapScalars(int val)
   }
   int mapToColorMode[] = { VTK_COLOR_MODE_DIRECT_SCALARS, VTK_COLOR_MODE_MAP_SCALARS };
   this->Mapper->SetColorMode(mapToColorMode[val]);
+  this->LODMapper->SetColorMode(mapToColorMode[val]);
 }
 
 //----------------------------------------------------------------------------
@@ -293,16 +457,90 @@ int vtkPointGaussianRepresentation::ProcessViewRequest(
     vtkPVRenderView::SetGeometryBounds(inInfo, bounds, matrix.GetPointer());
     outInfo->Set(vtkPVRenderView::NEED_ORDERED_COMPOSITING(), 1);
   }
+  else if (request_type == vtkPVView::REQUEST_UPDATE_LOD())
+  {
+    // Called when the data is large enough for the view to use LOD rendering
+    // during interaction. Provide the representatives of the point hierarchy
+    // down to the depth matching the LOD resolution.
+    if (!this->SuppressLOD && this->ProcessedData)
+    {
+      const double resolution = inInfo->Has(vtkPVRenderView::LOD_RESOLUTION())
+        ? inInfo->Get(vtkPVRenderView::LOD_RESOLUTION())
+        : 0.5;
+      vtkPVRenderView::SetPieceLOD(inInfo, this, this->GetLODData(resolution));
+    }
+  }
   else if (request_type == vtkPVView::REQUEST_RENDER())
   {
     vtkAlgorithmOutput* producerPort = vtkPVRenderView::GetPieceProducer(inInfo, this);
+    vtkAlgorithmOutput* producerPortLOD = vtkPVRenderView::GetPieceProducerLOD(inInfo, this);
 
     this->Mapper->SetInputConnection(producerPort);
+    this->LODMapper->SetInputConnection(producerPortLOD);
+
+    bool lod = this->SuppressLOD ? false : (inInfo->Has(vtkPVRenderView::USE_LOD()) == 1);
+    this->Actor->SetEnableLOD(lod ? 1 : 0);
     this->UpdateColoringParameters();
   }
   return 1;
 }
 
+//----------------------------------------------------------------------------
+vtkDataObject* vtkPointGaussianRepresentation::GetLODData(double resolution)
+{
+  vtkCompositeDataSet* cd = vtkCompositeDataSet::SafeDownCast(this->ProcessedData);
+  if (!cd)
+  {
+    return this->ProcessedData;
+  }
+
+  vtkSmartPointer<vtkCompositeDataIterator> iter;
+  iter.TakeReference(cd->NewIterator());
+
+  // The hierarchy only depends on the data, build it once per dataset.
+  bool rebuilt = false;
+  if (this->Internals->HierarchyTime < cd->GetMTime())
+  {
+    vtkVLogScopeF(PARAVIEW_LOG_RENDERING_VERBOSITY(), "%s: build point hierarchy",
+      this->GetLogName().c_str());
+    this->Internals->Hierarchies.clear();
+    for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
+    {
+      this->Internals->Hierarchies.emplace_back();
+      if (vtkPolyData* pd = vtkPolyData::SafeDownCast(iter->GetCurrentDataObject()))
+      {
+        this->Internals->Hierarchies.back().Build(pd);
+      }
+    }
+    this->Internals->HierarchyTime.Modified();
+    rebuilt = true;
+  }
+
+  // Same mapping of the LOD resolution to the number of divisions per axis as
+  // the decimation used by vtkGeometryRepresentation: 64 divisions at 0, 256
+  // at 0.5 and 1024 at 1.
+  resolution = vtkMath::ClampValue(resolution, 0., 1.);
+  const int level = std::min(static_cast<int>(std::round(4. * resolution + 6.)), MAX_LOD_LEVEL);
+  if (!rebuilt && this->Internals->LODData && this->Internals->LODLevel == level)
+  {
+    return this->Internals->LODData;
+  }
+
+  vtkCompositeDataSet* lod = cd->NewInstance();
+  this->Internals->LODData.TakeReference(lod);
+  this->Internals->LODLevel = level;
+  lod->CopyStructure(cd);
+  size_t index = 0;
+  for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem(), ++index)
+  {
+    if (vtkPolyData* pd = vtkPolyData::SafeDownCast(iter->GetCurrentDataObject()))
+    {
+      lod->SetDataSet(iter, this->Internals->Hierarchies[index].Extract(pd, level));
+    }
+  }
+  return lod;
+}
+
 //----------------------------------------------------------------------------
 void vtkPointGaussianRepresentation::UpdateColoringParameters()
 {
@@ -315,25 +553,33 @@ void vtkPointGaussianRepresentation::UpdateColoringParameters()
     if (colorArrayName && colorArrayName[0])
     {
       this->Mapper->SetScalarVisibility(1);
+      this->LODMapper->SetScalarVisibility(1);
       this->Mapper->SelectColorArray(colorArrayName);
+      this->LODMapper->SelectColorArray(colorArrayName);
       this->Mapper->SetUseLookupTableScalarRange(1);
+      this->LODMapper->SetUseLookupTableScalarRange(1);
     }
     else
     {
       this->Mapper->SetScalarVisibility(0);
+      this->LODMapper->SetScalarVisibility(0);
       this->Mapper->SelectColorArray(static_cast<const char*>(NULL));
+      this->LODMapper->SelectColorArray(static_cast<const char*>(NULL));
     }
 
     switch (fieldAssociation)
     {
       case vtkDataObject::FIELD_ASSOCIATION_CELLS:
         this->Mapper->SetScalarVisibility(0);
+        this->LODMapper->SetScalarVisibility(0);
         this->Mapper->SelectColorArray(static_cast<const char*>(NULL));
+        this->LODMapper->SelectColorArray(static_cast<const char*>(NULL));
         break;
 
       case vtkDataObject::FIELD_ASSOCIATION_POINTS:
       default:
         this->Mapper->SetScalarMode(VTK_SCALAR_MODE_USE_POINT_FIELD_DATA);
+        this->LODMapper->SetScalarMode(VTK_SCALAR_MODE_USE_POINT_FIELD_DATA);
         break;
     }
   }
@@ -343,6 +589,7 @@ void vtkPointGaussianRepresentation::UpdateColoringParameters()
 void vtkPointGaussianRepresentation::SetLookupTable(vtkScalarsToColors* lut)
 {
   this->Mapper->SetLookupTable(lut);
+  this->LODMapper->SetLookupTable(lut);
 }
 
 //----------------------------------------------------------------------------
@@ -352,6 +599,7 @@ void vtkPointGaussianRepresentation::SetCustomShader(const char* shaderString)
   if (this->SelectedPreset == vtkPointGaussianRepresentation::CUSTOM)
   {
     this->Mapper->SetSplatShaderCode(this->PresetShaderStrings[this->SelectedPreset].c_str());
+    this->LODMapper->SetSplatShaderCode(this->PresetShaderStrings[this->SelectedPreset].c_str());
   }
 }
 
@@ -362,6 +610,7 @@ void vtkPointGaussianRepresentation::SetCustomTriangleScale(double scale)
   if (this->SelectedPreset == vtkPointGaussianRepresentation::CUSTOM)
   {
     this->Mapper->SetTriangleScale(this->PresetShaderScales[this->SelectedPreset]);
+    this->LODMapper->SetTriangleScale(this->PresetShaderScales[this->SelectedPreset]);
   }
 }
 
@@ -372,7 +621,9 @@ void vtkPointGaussianRepresentation::SelectShaderPreset(int preset)
   {
     this->SelectedPreset = preset;
     this->Mapper->SetSplatShaderCode(this->PresetShaderStrings[preset].c_str());
+    this->LODMapper->SetSplatShaderCode(this->PresetShaderStrings[preset].c_str());
     this->Mapper->SetTriangleScale(this->PresetShaderScales[preset]);
+    this->LODMapper->SetTriangleScale(this->PresetShaderScales[preset]);
   }
 }
 
@@ -380,6 +631,7 @@ void vtkPointGaussianRepresentation::SelectShaderPreset(int preset)
 void vtkPointGaussianRepresentation::SetSplatSize(double radius)
 {
   this->Mapper->SetScaleFactor(radius);
+  this->LODMapper->SetScaleFactor(radius);
 }
 
 //----------------------------------------------------------------------------
@@ -390,7 +642,9 @@ void vtkPointGaussianRepresentation::SetScaleByArray(bool newVal)
     this->ScaleByArray = newVal;
     this->Modified();
     this->Mapper->SetScaleArray(this->ScaleByArray ? this->LastScaleArray : NULL);
+    this->LODMapper->SetScaleArray(this->ScaleByArray ? this->LastScaleArray : NULL);
     this->Mapper->SetScaleArrayComponent(this->ScaleByArray ? this->LastScaleArrayComponent : 0);
+    this->LODMapper->SetScaleArrayComponent(this->ScaleByArray ? this->LastScaleArrayComponent : 0);
   }
 }
 
@@ -420,6 +674,7 @@ void vtkPointGaussianRepresentation::SetScaleTransferFunction(vtkPiecewiseFuncti
 void vtkPointGaussianRepresentation::UpdateMapperScaleFunction()
 {
   this->Mapper->SetScaleFunction(this->UseScaleFunction ? this->ScaleFunction : nullptr);
+  this->LODMapper->SetScaleFunction(this->UseScaleFunction ? this->ScaleFunction : nullptr);
 }
 
 //----------------------------------------------------------------------------
@@ -427,6 +682,7 @@ void vtkPointGaussianRepresentation::SelectScaleArray(int, int, int, int, const
 {
   this->SetLastScaleArray(name);
   this->Mapper->SetScaleArray(this->ScaleByArray ? name : NULL);
+  this->LODMapper->SetScaleArray(this->ScaleByArray ? name : NULL);
 }
 
 //----------------------------------------------------------------------------
@@ -434,6 +690,7 @@ void vtkPointGaussianRepresentation::SelectScaleArrayComponent(int component)
 {
   this->LastScaleArrayComponent = component;
   this->Mapper->SetScaleArrayComponent(this->ScaleByArray ? component : 0);
+  this->LODMapper->SetScaleArrayComponent(this->ScaleByArray ? component : 0);
 }
 
 //----------------------------------------------------------------------------
@@ -444,8 +701,11 @@ void vtkPointGaussianRepresentation::SetOpacityByArray(bool newVal)
     this->OpacityByArray = newVal;
     this->Modified();
     this->Mapper->SetOpacityArray(this->OpacityByArray ? this->LastOpacityArray : NULL);
+    this->LODMapper->SetOpacityArray(this->OpacityByArray ? this->LastOpacityArray : NULL);
     this->Mapper->SetOpacityArrayComponent(
       this->OpacityByArray ? this->LastOpacityArrayComponent : 0);
+    this->LODMapper->SetOpacityArrayComponent(
+      this->OpacityByArray ? this->LastOpacityArrayComponent : 0);
   }
 }
 
@@ -453,6 +713,7 @@ void vtkPointGaussianRepresentation::SetOpacityByArray(bool newVal)
 void vtkPointGaussianRepresentation::SetOpacityTransferFunction(vtkPiecewiseFunction* pwf)
 {
   this->Mapper->SetScalarOpacityFunction(pwf);
+  this->LODMapper->SetScalarOpacityFunction(pwf);
 }
 
 //----------------------------------------------------------------------------
@@ -460,6 +721,7 @@ void vtkPointGaussianRepresentation::SelectOpacityArray(int, int, int, int, cons
 {
   this->SetLastOpacityArray(name);
   this->Mapper->SetOpacityArray(this->OpacityByArray ? name : NULL);
+  this->LODMapper->SetOpacityArray(this->OpacityByArray ? name : NULL);
 }
 
 //----------------------------------------------------------------------------
@@ -467,6 +729,7 @@ void vtkPointGaussianRepresentation::SelectOpacityArrayComponent(int component)
 {
   this->LastOpacityArrayComponent = component;
   this->Mapper->SetOpacityArrayComponent(this->OpacityByArray ? component : 0);
+  this->LODMapper->SetOpacityArrayComponent(this->OpacityByArray ? component : 0);
 }
 
 //----------------------------------------------------------------------------
@@ -17,6 +17,13 @@
  *
  * Representation for showing point data as sprites, including gaussian
  * splats, spheres, or some custom shaded representation.
+ *
+ * When the view asks for level-of-detail geometry (see
+ * vtkPVRenderView::SetLODRenderingThreshold), the points of each block are
+ * ordered once into an octree hierarchy in which every occupied node keeps one
+ * representative point. The LOD geometry is the set of representatives down to
+ * the octree depth matching the view's LOD resolution, so interaction renders a
+ * spatially uniform subset while still-frames render every point.
 */
 
 #ifndef vtkPointGaussianRepresentation_h
@@ -28,8 +35,8 @@
 #include <string>            // for std::string
 #include <vector>            // for std::vector
 
-class vtkActor;
 class vtkDataObject;
+class vtkPVLODActor;
 class vtkPiecewiseFunction;
 class vtkPointGaussianMapper;
 class vtkScalarsToColors;
@@ -188,6 +195,15 @@ public:
   vtkBooleanMacro(ScaleByArray, bool);
   //@}
 
+  //@{
+  /**
+   * When set, the representation does not provide level-of-detail geometry
+   * and always renders every point, even during interaction.
+   */
+  virtual void SetSuppressLOD(bool suppress) { this->SuppressLOD = suppress; }
+  vtkGetMacro(SuppressLOD, bool);
+  //@}
+
 protected:
   vtkPointGaussianRepresentation();
   ~vtkPointGaussianRepresentation() override;
@@ -204,8 +220,15 @@ protected:
   void InitializeShaderPresets();
   void UpdateMapperScaleFunction();
 
-  vtkSmartPointer<vtkActor> Actor;
+  /**
+   * Builds the point hierarchy of ProcessedData if it changed, and returns the
+   * representatives down to the octree depth matching the LOD resolution.
+   */
+  vtkDataObject* GetLODData(double resolution);
+
+  vtkSmartPointer<vtkPVLODActor> Actor;
   vtkSmartPointer<vtkPointGaussianMapper> Mapper;
+  vtkSmartPointer<vtkPointGaussianMapper> LODMapper;
   vtkSmartPointer<vtkDataObject> ProcessedData;
   vtkSmartPointer<vtkPiecewiseFunction> ScaleFunction;
 
@@ -220,6 +243,7 @@ protected:
   int LastOpacityArrayComponent;
 
   bool UseScaleFunction;
+  bool SuppressLOD;
 
   std::vector<std::string> PresetShaderStrings;
   std::vector<float> PresetShaderScales;
@@ -227,6 +251,9 @@ protected:
 private:
   vtkPointGaussianRepresentation(const vtkPointGaussianRepresentation&) = delete;
   void operator=(const vtkPointGaussianRepresentation&) = delete;
+
+  class vtkInternals;
+  vtkInternals* Internals;
 };
 
 #endif // vtkPointGaussianRepresentation_h
@@ -27,9 +27,11 @@
 #include "vtkMemberFunctionCommand.h"
 #include "vtkMultiProcessController.h"
 #include "vtkMultiProcessStream.h"
+#include "vtkNew.h"
 #include "vtkObjectFactory.h"
 #include "vtkPVMergeTables.h"
 #include "vtkPVSession.h"
+#include "vtkPassArrays.h"
 #include "vtkProcessModule.h"
 #include "vtkReductionFilter.h"
 #include "vtkSmartPointer.h"
@@ -42,6 +44,7 @@
 #include <algorithm>
 #include <map>
 #include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 namespace
@@ -144,6 +147,75 @@ const char* get_userfriendly_name(
   }
   return name;
 }
+
+/// internal function to determine if a column is hidden, using the same
+/// label conventions as vtkSpreadSheetView::GetColumnLabel(). Unlike
+/// GetColumnLabel(), this relies only on the column itself and hence can be
+/// used on all ranks, including the ones that never see the column meta-data.
+bool is_hidden_column(vtkAbstractArray* column, vtkSpreadSheetView* self)
+{
+  const char* name = column->GetName();
+  if (name == nullptr || self->IsColumnInternal(name))
+  {
+    return false;
+  }
+
+  // these are needed to sort, merge and mark selected rows; never drop them.
+  const char* required[] = { "vtkOriginalProcessIds", "vtkCompositeIndexArray",
+    "vtkOriginalIndices", NULL };
+  for (int cc = 0; required[cc] != NULL; ++cc)
+  {
+    if (strcmp(required[cc], name) == 0)
+    {
+      return false;
+    }
+  }
+
+  if (self->IsColumnHiddenByName(name))
+  {
+    return true;
+  }
+
+  bool cleaned = false;
+  const char* cleanedname = get_userfriendly_name(name, self, &cleaned);
+  if (cleaned)
+  {
+    return self->IsColumnHiddenByLabel(cleanedname);
+  }
+
+  auto colInfo = column->GetInformation();
+  if (colInfo->Has(vtkSplitColumnComponents::ORIGINAL_ARRAY_NAME()) &&
+    colInfo->Has(vtkSplitColumnComponents::ORIGINAL_COMPONENT_NUMBER()) &&
+    colInfo->Get(vtkSplitColumnComponents::ORIGINAL_COMPONENT_NUMBER()) >= 0)
+  {
+    return self->IsColumnHiddenByLabel(
+      colInfo->Get(vtkSplitColumnComponents::ORIGINAL_ARRAY_NAME()));
+  }
+  return self->IsColumnHiddenByLabel(name);
+}
+
+/// internal function to extract a range of rows from a table into a new
+/// table, preserving the column information (used for column labels).
+vtkTable* new_subset_table(vtkTable* table, vtkIdType start, vtkIdType count)
+{
+  vtkTable* subset = vtkTable::New();
+  for (vtkIdType cc = 0, max = table->GetNumberOfColumns(); cc < max; ++cc)
+  {
+    vtkAbstractArray* column = table->GetColumn(cc);
+    vtkSmartPointer<vtkAbstractArray> clone;
+    clone.TakeReference(column->NewInstance());
+    clone->SetName(column->GetName());
+    clone->SetNumberOfComponents(column->GetNumberOfComponents());
+    clone->CopyComponentNames(column);
+    clone->CopyInformation(column->GetInformation(), /*deep=*/1);
+    if (count > 0)
+    {
+      clone->InsertTuples(0, count, start, column);
+    }
+    subset->AddColumn(clone);
+  }
+  return subset;
+}
 }
 
 class vtkSpreadSheetView::vtkInternals
@@ -201,10 +273,46 @@ class vtkSpreadSheetView::vtkInternals
     vtkTimeStamp RecentUseTime;
   };
 
-  typedef std::map<vtkIdType, CacheInfo> CacheType;
+  // Blocks are keyed by the configuration that affects their contents (sort
+  // column, sort order, field association and, when column projection is
+  // enabled, the hidden columns) and their index. Thus going back to a
+  // previous sort order does not need to refetch the blocks.
+  typedef std::pair<std::string, vtkIdType> CacheKeyType;
+  typedef std::map<CacheKeyType, CacheInfo> CacheType;
   CacheType CachedBlocks;
 
 public:
+  const std::string& GetConfigurationKey(vtkSpreadSheetView* self)
+  {
+    const vtkMTimeType mtime = std::max(std::max(self->GetMTime(), self->TableStreamer->GetMTime()),
+      this->HiddenColumnsTime.GetMTime());
+    if (this->ConfigurationKeyTime > mtime)
+    {
+      return this->ConfigurationKey;
+    }
+
+    std::ostringstream key;
+    const char* sortColumn = self->TableStreamer->GetColumnNameToSort();
+    key << (sortColumn ? sortColumn : "") << '\x1f' << self->TableStreamer->GetInvertOrder()
+        << '\x1f' << self->GetFieldAssociation();
+    if (self->GetColumnProjection())
+    {
+      for (const auto& name : this->HiddenColumnsByName)
+      {
+        key << '\x1f' << 'n' << name;
+      }
+      for (const auto& label : this->HiddenColumnsByLabel)
+      {
+        key << '\x1f' << 'l' << label;
+      }
+    }
+    this->ConfigurationKey = key.str();
+    this->ConfigurationKeyTime.Modified();
+    return this->ConfigurationKey;
+  }
+
+  bool HasColumnMetaData() const { return !this->ColumnMetaData.empty(); }
+
   void ClearCache()
   {
     this->CachedBlocks.clear();
@@ -241,9 +349,10 @@ public:
     return aname;
   }
 
-  vtkTable* GetDataObject(vtkIdType blockId)
+  vtkTable* GetDataObject(vtkSpreadSheetView* self, vtkIdType blockId)
   {
-    CacheType::iterator iter = this->CachedBlocks.find(blockId);
+    CacheType::iterator iter =
+      this->CachedBlocks.find(CacheKeyType(this->GetConfigurationKey(self), blockId));
     if (iter != this->CachedBlocks.end())
     {
       iter->second.RecentUseTime.Modified();
@@ -253,15 +362,17 @@ public:
     return NULL;
   }
 
-  void AddToCache(vtkIdType blockId, vtkTable* data, vtkIdType max)
+  void AddToCache(vtkSpreadSheetView* self, vtkIdType blockId, vtkTable* data, vtkIdType max)
   {
-    CacheType::iterator iter = this->CachedBlocks.find(blockId);
+    const CacheKeyType key(this->GetConfigurationKey(self), blockId);
+    CacheType::iterator iter = this->CachedBlocks.find(key);
     if (iter != this->CachedBlocks.end())
     {
       this->CachedBlocks.erase(iter);
     }
 
-    if (static_cast<vtkIdType>(this->CachedBlocks.size()) == max)
+    while (!this->CachedBlocks.empty() &&
+      static_cast<vtkIdType>(this->CachedBlocks.size()) >= std::max(max, vtkIdType(1)))
     {
       // remove least-recent-used block.
       iter = this->CachedBlocks.begin();
@@ -297,10 +408,12 @@ public:
     info.Dataobject = clone;
     clone->FastDelete();
     info.RecentUseTime.Modified();
-    this->CachedBlocks[blockId] = info;
+    this->CachedBlocks[key] = info;
     this->MostRecentlyAccessedBlock = blockId;
 
-    if (this->CachedBlocks.size() == 1)
+    // the first block fetched after the cache is cleared is never projected
+    // (see vtkSpreadSheetView::FetchBlock), hence it has all the columns.
+    if (this->ColumnMetaData.empty())
     {
       this->UpdateColumnMetaData(clone);
     }
@@ -314,7 +427,7 @@ public:
   vtkTable* GetSomeBlock(vtkSpreadSheetView* self)
   {
     const auto mrbId = this->GetMostRecentlyAccessedBlock(self);
-    if (auto table = this->GetDataObject(mrbId))
+    if (auto table = this->GetDataObject(self, mrbId))
     {
       return table;
     }
@@ -335,20 +448,26 @@ public:
 
   std::set<std::string> HiddenColumnsByName;
   std::set<std::string> HiddenColumnsByLabel;
+  vtkTimeStamp HiddenColumnsTime;
+
+private:
+  std::string ConfigurationKey;
+  vtkTimeStamp ConfigurationKeyTime;
 };
 
 namespace
 {
 void FetchRMI(void* localArg, void* remoteArg, int remoteArgLength, int)
 {
-  assert(remoteArgLength == sizeof(vtkTypeUInt64) * 2);
+  assert(remoteArgLength == sizeof(vtkTypeUInt64) * 4);
   (void)remoteArgLength;
 
   auto arg = reinterpret_cast<vtkTypeUInt64*>(remoteArg);
   vtkSpreadSheetView* self = reinterpret_cast<vtkSpreadSheetView*>(localArg);
   if (static_cast<vtkTypeUInt32>(self->GetIdentifier()) == arg[0])
   {
-    self->FetchBlockCallback(static_cast<vtkIdType>(arg[1]));
+    self->FetchBlockCallback(
+      static_cast<vtkIdType>(arg[1]), static_cast<vtkIdType>(arg[2]), arg[3] != 0);
   }
 }
 
@@ -416,6 +535,9 @@ vtkSpreadSheetView::vtkSpreadSheetView()
   , Identifier(0)
 {
   this->NumberOfRows = 0;
+  this->BlockCacheSize = 10;
+  this->NumberOfPrefetchBlocks = 1;
+  this->ColumnProjection = true;
   this->ShowExtractedSelection = false;
   this->TableStreamer = vtkSortedTableStreamer::New();
   this->TableSelectionMarker = vtkMarkSelectedRows::New();
@@ -494,6 +616,7 @@ void vtkSpreadSheetView::HideColumnByName(const char* columnName)
   {
     auto& internals = *this->Internals;
     internals.HiddenColumnsByName.insert(columnName);
+    internals.HiddenColumnsTime.Modified();
   }
 }
 
@@ -502,6 +625,7 @@ void vtkSpreadSheetView::ClearHiddenColumnsByName()
 {
   auto& internals = *this->Internals;
   internals.HiddenColumnsByName.clear();
+  internals.HiddenColumnsTime.Modified();
 }
 
 //----------------------------------------------------------------------------
@@ -520,6 +644,7 @@ void vtkSpreadSheetView::HideColumnByLabel(const char* columnLabel)
   {
     auto& internals = *this->Internals;
     internals.HiddenColumnsByLabel.insert(columnLabel);
+    internals.HiddenColumnsTime.Modified();
   }
 }
 
@@ -528,6 +653,7 @@ void vtkSpreadSheetView::ClearHiddenColumnsByLabel()
 {
   auto& internals = *this->Internals;
   internals.HiddenColumnsByLabel.clear();
+  internals.HiddenColumnsTime.Modified();
 }
 
 //----------------------------------------------------------------------------
@@ -569,6 +695,9 @@ bool vtkSpreadSheetView::IsColumnInternal(const char* columnName)
 void vtkSpreadSheetView::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "BlockCacheSize: " << this->BlockCacheSize << endl;
+  os << indent << "NumberOfPrefetchBlocks: " << this->NumberOfPrefetchBlocks << endl;
+  os << indent << "ColumnProjection: " << this->ColumnProjection << endl;
 }
 
 //----------------------------------------------------------------------------
@@ -669,18 +798,68 @@ void vtkSpreadSheetView::OnRepresentationUpdated()
 //----------------------------------------------------------------------------
 vtkTable* vtkSpreadSheetView::FetchBlock(vtkIdType blockindex)
 {
-  vtkTable* block = this->Internals->GetDataObject(blockindex);
-  if (!block)
+  auto& internals = *this->Internals;
+  vtkTable* block = internals.GetDataObject(this, blockindex);
+  if (block)
+  {
+    return block;
+  }
+
+  // Read ahead the next few blocks in the direction the user is scrolling,
+  // fetching them all in a single round trip.
+  const vtkIdType blockSize = this->TableStreamer->GetBlockSize();
+  const vtkIdType maxBlockId = (this->NumberOfRows + blockSize - 1) / blockSize - 1;
+  const vtkIdType numPrefetch = std::max(vtkIdType(0), this->NumberOfPrefetchBlocks);
+  vtkIdType first = blockindex;
+  vtkIdType last = blockindex;
+  if (numPrefetch > 0 && blockindex <= maxBlockId)
+  {
+    if (blockindex < internals.MostRecentlyAccessedBlock)
+    {
+      first = std::max(vtkIdType(0), blockindex - numPrefetch);
+    }
+    else
+    {
+      last = std::min(maxBlockId, blockindex + numPrefetch);
+    }
+  }
+
+  // Columns are only projected once we have the column meta-data, which is
+  // always built from a complete block.
+  const bool project = this->ColumnProjection && internals.HasColumnMetaData();
+  vtkTable* result = this->FetchBlockCallback(first, last - first + 1, project);
+  if (!result)
   {
-    block = this->FetchBlockCallback(blockindex);
-    this->Internals->AddToCache(blockindex, block, 10);
+    return NULL;
+  }
+
+  const vtkIdType cacheSize = std::max(this->BlockCacheSize, last - first + 1);
+  if (first == last)
+  {
+    internals.AddToCache(this, blockindex, result, cacheSize);
     this->InvokeEvent(vtkCommand::UpdateEvent, &blockindex);
+    return internals.GetDataObject(this, blockindex);
+  }
+
+  const vtkIdType blockSize = this->TableStreamer->GetBlockSize();
+  const vtkIdType numRows = result->GetNumberOfRows();
+  for (vtkIdType cc = first; cc <= last; ++cc)
+  {
+    // add the requested block last so that it is the most recently used one.
+    vtkIdType id = (cc == last) ? blockindex : (cc < blockindex ? cc : cc + 1);
+    vtkIdType start = std::min(numRows, (id - first) * blockSize);
+    vtkIdType count = std::min(numRows - start, blockSize);
+    vtkSmartPointer<vtkTable> subset;
+    subset.TakeReference(::new_subset_table(result, start, count));
+    internals.AddToCache(this, id, subset, cacheSize);
+    this->InvokeEvent(vtkCommand::UpdateEvent, &id);
   }
-  return block;
+  return internals.GetDataObject(this, blockindex);
 }
 
 //----------------------------------------------------------------------------
-vtkTable* vtkSpreadSheetView::FetchBlockCallback(vtkIdType blockindex)
+vtkTable* vtkSpreadSheetView::FetchBlockCallback(
+  vtkIdType blockindex, vtkIdType numberOfBlocks, bool projectColumns)
 {
   // Sanity Check
   if (!this->Internals->ActiveRepresentation)
@@ -689,21 +868,48 @@ vtkTable* vtkSpreadSheetView::FetchBlockCallback(vtkIdType blockindex)
   }
 
   // cout << "FetchBlockCallback" << endl;
-  vtkTypeUInt64 data[2] = { this->Identifier, static_cast<vtkTypeUInt64>(blockindex) };
+  vtkTypeUInt64 data[4] = { this->Identifier, static_cast<vtkTypeUInt64>(blockindex),
+    static_cast<vtkTypeUInt64>(numberOfBlocks), projectColumns ? 1u : 0u };
   if (auto dController = this->GetSession()->GetController(vtkPVSession::DATA_SERVER_ROOT))
   {
-    dController->TriggerRMIOnAllChildren(data, sizeof(vtkTypeUInt64) * 2, FETCH_BLOCK_TAG);
+    dController->TriggerRMIOnAllChildren(data, sizeof(vtkTypeUInt64) * 4, FETCH_BLOCK_TAG);
   }
   auto pController = vtkMultiProcessController::GetGlobalController();
   if (pController && pController->GetLocalProcessId() == 0 &&
     pController->GetNumberOfProcesses() > 1)
   {
-    pController->TriggerRMIOnAllChildren(data, sizeof(vtkTypeUInt64) * 2, FETCH_BLOCK_TAG);
+    pController->TriggerRMIOnAllChildren(data, sizeof(vtkTypeUInt64) * 4, FETCH_BLOCK_TAG);
   }
 
   this->TableStreamer->SetBlock(blockindex);
+  this->TableStreamer->SetNumberOfBlocks(numberOfBlocks);
   this->TableStreamer->Modified();
   this->TableSelectionMarker->SetFieldAssociation(this->FieldAssociation);
+  if (projectColumns)
+  {
+    // Drop the hidden columns before they are gathered and delivered to the
+    // client. The reduction filter runs the pre-gather helper on a shallow
+    // copy of the streamer's output, which is left untouched.
+    this->TableStreamer->Update();
+    vtkTable* streamed = this->TableStreamer->GetOutput();
+    vtkNew<vtkPassArrays> projector;
+    projector->RemoveArraysOn();
+    projector->UseFieldTypesOn();
+    projector->AddFieldType(vtkDataObject::ROW);
+    for (vtkIdType cc = 0; cc < streamed->GetNumberOfColumns(); ++cc)
+    {
+      vtkAbstractArray* column = streamed->GetColumn(cc);
+      if (::is_hidden_column(column, this))
+      {
+        projector->AddArray(vtkDataObject::ROW, column->GetName());
+      }
+    }
+    this->ReductionFilter->SetPreGatherHelper(projector);
+  }
+  else
+  {
+    this->ReductionFilter->SetPreGatherHelper(nullptr);
+  }
   this->ReductionFilter->Modified();
   this->DeliveryFilter->Modified();
   this->DeliveryFilter->Update();
@@ -750,11 +956,9 @@ std::string vtkSpreadSheetView::GetColumnLabel(const char* name)
 //----------------------------------------------------------------------------
 vtkVariant vtkSpreadSheetView::GetValue(vtkIdType row, vtkIdType col)
 {
-  vtkIdType blockSize = this->TableStreamer->GetBlockSize();
-  vtkIdType blockIndex = row / blockSize;
-  vtkTable* block = this->FetchBlock(blockIndex);
-  vtkIdType blockOffset = row - (blockIndex * blockSize);
-  return block->GetValue(blockOffset, col);
+  // blocks may be projected, hence column indices are only meaningful in the
+  // context of the column meta-data.
+  return this->GetValueByName(row, this->GetColumnName(col));
 }
 
 //----------------------------------------------------------------------------
@@ -762,8 +966,13 @@ vtkVariant vtkSpreadSheetView::GetValueByName(vtkIdType row, const char* columnN
 {
   vtkIdType blockSize = this->TableStreamer->GetBlockSize();
   vtkIdType blockIndex = row / blockSize;
-  vtkTable* block = this->FetchBlock(blockIndex);
+  vtkTable* block = columnName ? this->FetchBlock(blockIndex) : NULL;
   vtkIdType blockOffset = row - (blockIndex * blockSize);
+  vtkAbstractArray* column = block ? block->GetColumnByName(columnName) : NULL;
+  if (column == NULL || blockOffset >= column->GetNumberOfTuples())
+  {
+    return vtkVariant();
+  }
   return block->GetValueByName(blockOffset, columnName);
 }
 
@@ -775,7 +984,7 @@ bool vtkSpreadSheetView::IsRowSelected(vtkIdType row)
   vtkTable* block = this->FetchBlock(blockIndex);
   vtkIdType blockOffset = row - (blockIndex * blockSize);
   vtkCharArray* vtkIsSelected =
-    vtkCharArray::SafeDownCast(block->GetColumnByName("__vtkIsSelected__"));
+    block ? vtkCharArray::SafeDownCast(block->GetColumnByName("__vtkIsSelected__")) : NULL;
   if (vtkIsSelected)
   {
     return vtkIsSelected->GetValue(blockOffset) == 1;
@@ -788,7 +997,7 @@ bool vtkSpreadSheetView::IsAvailable(vtkIdType row)
 {
   vtkIdType blockSize = this->TableStreamer->GetBlockSize();
   vtkIdType blockIndex = row / blockSize;
-  return this->Internals->GetDataObject(blockIndex) != NULL;
+  return this->Internals->GetDataObject(this, blockIndex) != NULL;
 }
 
 //----------------------------------------------------------------------------
@@ -850,15 +1059,14 @@ bool vtkSpreadSheetView::Export(vtkCSVExporter* exporter)
 //----------------------------------------------------------------------------
 void vtkSpreadSheetView::SetColumnNameToSort(const char* name)
 {
+  // no need to clear the cache, blocks are cached per sort order.
   this->TableStreamer->SetColumnNameToSort(name);
-  this->ClearCache();
 }
 
 //----------------------------------------------------------------------------
 void vtkSpreadSheetView::SetInvertSortOrder(bool val)
 {
   this->TableStreamer->SetInvertOrder(val ? 1 : 0);
-  this->ClearCache();
 }
 
 //----------------------------------------------------------------------------
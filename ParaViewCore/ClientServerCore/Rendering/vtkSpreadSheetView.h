@@ -201,6 +201,37 @@ public:
    */
   void SetBlockSize(vtkIdType val);
 
+  //@{
+  /**
+   * Get/Set the maximum number of blocks cached on the client. Blocks are
+   * cached per sort order and set of hidden columns and are evicted in
+   * least-recently-used order. Default is 10.
+   */
+  vtkSetMacro(BlockCacheSize, vtkIdType);
+  vtkGetMacro(BlockCacheSize, vtkIdType);
+  //@}
+
+  //@{
+  /**
+   * Get/Set the number of blocks to read ahead, in the scrolling direction,
+   * when a block that is not cached is requested. The extra blocks are
+   * fetched synchronously, in the same request as the requested block, hence
+   * a cache miss waits for all of them. Set to 0 to disable. Default is 1.
+   */
+  vtkSetMacro(NumberOfPrefetchBlocks, vtkIdType);
+  vtkGetMacro(NumberOfPrefetchBlocks, vtkIdType);
+  //@}
+
+  //@{
+  /**
+   * When enabled, hidden columns are dropped on the data server before the
+   * blocks are delivered to the client. Default is true.
+   */
+  vtkSetMacro(ColumnProjection, bool);
+  vtkGetMacro(ColumnProjection, bool);
+  vtkBooleanMacro(ColumnProjection, bool);
+  //@}
+
   /**
    * Export the contents of this view using the exporter.
    */
@@ -212,7 +243,8 @@ public:
   void ClearCache();
 
   // INTERNAL METHOD. Don't call directly.
-  vtkTable* FetchBlockCallback(vtkIdType blockindex);
+  vtkTable* FetchBlockCallback(
+    vtkIdType blockindex, vtkIdType numberOfBlocks = 1, bool projectColumns = false);
 
 protected:
   vtkSpreadSheetView();
@@ -237,6 +269,9 @@ protected:
   vtkReductionFilter* ReductionFilter;
   vtkClientServerMoveData* DeliveryFilter;
   vtkIdType NumberOfRows;
+  vtkIdType BlockCacheSize;
+  vtkIdType NumberOfPrefetchBlocks;
+  bool ColumnProjection;
 
   enum
   {
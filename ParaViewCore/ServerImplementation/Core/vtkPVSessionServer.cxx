@@ -537,22 +537,20 @@ void vtkPVSessionServer::OnClientServerMessageRMI(void* message, int message_len
     {
       std::string string;
       stream >> string;
-      vtkSMMessage msg;
-      msg.ParseFromString(string);
-
-      //      cout << "=================================" << endl;
-      //      msg.PrintDebugString();
-      //      cout << "=================================" << endl;
+      this->PushStateInternal(string);
+    }
+    break;
 
-      // Do we skip the processing ?
-      if (!this->Internal->StoreShareOnly(&msg))
+    case vtkPVSessionServer::PUSH_BATCH:
+    {
+      int count;
+      stream >> count;
+      for (int cc = 0; cc < count; ++cc)
       {
-        this->PushState(&msg);
+        std::string string;
+        stream >> string;
+        this->PushStateInternal(string);
       }
-
-      // Notify when ProxyManager state has changed
-      // or any other state change
-      this->NotifyOtherClients(&msg);
     }
     break;
 
@@ -625,6 +623,23 @@ void vtkPVSessionServer::OnClientServerMessageRMI(void* message, int message_len
   }
 }
 
+//----------------------------------------------------------------------------
+void vtkPVSessionServer::PushStateInternal(const std::string& serialized)
+{
+  vtkSMMessage msg;
+  msg.ParseFromString(serialized);
+
+  // Do we skip the processing ?
+  if (!this->Internal->StoreShareOnly(&msg))
+  {
+    this->PushState(&msg);
+  }
+
+  // Notify when ProxyManager state has changed
+  // or any other state change
+  this->NotifyOtherClients(&msg);
+}
+
 //----------------------------------------------------------------------------
 void vtkPVSessionServer::SendLastResultToClient()
 {
@@ -28,6 +28,8 @@
 #include "vtkPVServerImplementationCoreModule.h" //needed for exports
 #include "vtkPVSessionBase.h"
 
+#include <string> // for std::string
+
 class vtkMultiProcessController;
 class vtkMultiProcessStream;
 
@@ -83,6 +85,7 @@ public:
     REGISTER_SI = 16,
     UNREGISTER_SI = 17,
     LAST_RESULT = 18,
+    PUSH_BATCH = 19,
     SERVER_NOTIFICATION_MESSAGE_RMI = 55624,
     CLIENT_SERVER_MESSAGE_RMI = 55625,
     CLOSE_SESSION = 55626,
@@ -151,6 +154,12 @@ protected:
    */
   void SendLastResultToClient();
 
+  /**
+   * Called when client triggers PushState() (or a batch of them) with the
+   * serialized vtkSMMessage.
+   */
+  void PushStateInternal(const std::string& serialized);
+
   vtkMPIMToNSocketConnection* MPIMToNSocketConnection;
 
   bool MultipleConnection;
@@ -0,0 +1,100 @@
+/*=========================================================================
+
+Program:   ParaView
+Module:    TestPushStateBatch.cxx
+
+Copyright (c) Kitware, Inc.
+All rights reserved.
+See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+
+#include "vtkInitializationHelper.h"
+#include "vtkNew.h"
+#include "vtkProcessModule.h"
+#include "vtkSMPropertyHelper.h"
+#include "vtkSMSession.h"
+#include "vtkSMSessionProxyManager.h"
+#include "vtkSMSessionPushStateBatchScope.h"
+#include "vtkSMSourceProxy.h"
+#include "vtkSmartPointer.h"
+#include "vtkSphereSource.h"
+
+int TestPushStateBatch(int argc, char* argv[])
+{
+  (void)argc;
+
+  vtkInitializationHelper::Initialize(argv[0], vtkProcessModule::PROCESS_CLIENT);
+
+  int exitCode = EXIT_SUCCESS;
+  {
+    vtkNew<vtkSMSession> session;
+    vtkSMSessionProxyManager* pxm = session->GetSessionProxyManager();
+
+    vtkSmartPointer<vtkSMSourceProxy> spheres[10];
+    {
+      vtkSMSessionPushStateBatchScope batch(session.GetPointer());
+      {
+        // nested batches are merged in the outermost one.
+        vtkSMSessionPushStateBatchScope nestedBatch(session.GetPointer());
+        for (int cc = 0; cc < 5; ++cc)
+        {
+          spheres[cc].TakeReference(
+            vtkSMSourceProxy::SafeDownCast(pxm->NewProxy("sources", "SphereSource")));
+          vtkSMPropertyHelper(spheres[cc], "Radius").Set(cc + 1);
+          spheres[cc]->UpdateVTKObjects();
+        }
+      }
+      if (!session->GetInPushStateBatch())
+      {
+        cerr << "ERROR: batch ended by nested scope!!!" << endl;
+        exitCode = EXIT_FAILURE;
+      }
+      for (int cc = 5; cc < 10; ++cc)
+      {
+        spheres[cc].TakeReference(
+          vtkSMSourceProxy::SafeDownCast(pxm->NewProxy("sources", "SphereSource")));
+        vtkSMPropertyHelper(spheres[cc], "Radius").Set(cc + 1);
+        spheres[cc]->UpdateVTKObjects();
+      }
+    }
+
+    if (session->GetInPushStateBatch())
+    {
+      cerr << "ERROR: batch not ended!!!" << endl;
+      exitCode = EXIT_FAILURE;
+    }
+
+    cout << "Messages: " << session->GetPushStateBatchNumberOfMessages() << endl
+         << "Bytes: " << session->GetPushStateBatchNumberOfBytes() << endl
+         << "Requests: " << session->GetPushStateBatchNumberOfRequests() << endl;
+    if (session->GetPushStateBatchNumberOfMessages() < 10 ||
+      session->GetPushStateBatchNumberOfBytes() <= 0)
+    {
+      cerr << "ERROR: batch statistics not recorded!!!" << endl;
+      exitCode = EXIT_FAILURE;
+    }
+    if (session->GetPushStateBatchNumberOfRequests() != 0)
+    {
+      cerr << "ERROR: builtin session must not send requests!!!" << endl;
+      exitCode = EXIT_FAILURE;
+    }
+
+    // Batching must not change the state pushed.
+    for (int cc = 0; cc < 10; ++cc)
+    {
+      auto sphere = vtkSphereSource::SafeDownCast(spheres[cc]->GetClientSideObject());
+      if (sphere == nullptr || sphere->GetRadius() != cc + 1)
+      {
+        cerr << "ERROR: state not pushed for proxy " << cc << "!!!" << endl;
+        exitCode = EXIT_FAILURE;
+      }
+    }
+  }
+  vtkInitializationHelper::Finalize();
+  return exitCode;
+}
@@ -0,0 +1,121 @@
+/*=========================================================================
+
+Program:   ParaView
+Module:    TestSettingsLookupIndex.cxx
+
+Copyright (c) Kitware, Inc.
+All rights reserved.
+See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Tests that the settings lookup index never returns stale values after the
+// settings are changed.
+#include "vtkInitializationHelper.h"
+#include "vtkNew.h"
+#include "vtkProcessModule.h"
+#include "vtkSMPropertyHelper.h"
+#include "vtkSMProxy.h"
+#include "vtkSMSession.h"
+#include "vtkSMSessionProxyManager.h"
+#include "vtkSMSettings.h"
+#include "vtkSmartPointer.h"
+
+#include <string>
+
+#define TASSERT(x)                                                                                 \
+  if (!(x))                                                                                        \
+  {                                                                                                \
+    cerr << "ERROR: failed at " << __LINE__ << ": " << #x << endl;                                 \
+    return EXIT_FAILURE;                                                                           \
+  }
+
+namespace
+{
+const char* RadiusSetting = ".sources.SphereSource.Radius";
+
+int TestLookups(vtkSMSettings* settings, vtkSMSessionProxyManager* pxm)
+{
+  TASSERT(!settings->HasSetting(RadiusSetting));
+  TASSERT(settings->GetSettingAsDouble(RadiusSetting, -1.0) == -1.0);
+
+  // adding a collection must invalidate negative lookups.
+  settings->AddCollectionFromString("{ \"sources\" : { \"SphereSource\" : "
+                                    "{ \"Radius\" : 1.0, \"Center\" : [1, 2, 3] } } }",
+    1.0);
+  TASSERT(settings->GetSettingAsDouble(RadiusSetting, -1.0) == 1.0);
+  TASSERT(settings->GetSettingAsDouble(".sources.SphereSource.Center", 2, -1.0) == 3.0);
+
+  // a higher priority collection overrides the memoized value, a lower
+  // priority one does not.
+  settings->AddCollectionFromString(
+    "{ \"sources\" : { \"SphereSource\" : { \"Radius\" : 2.0 } } }", 2.0);
+  TASSERT(settings->GetSettingAsDouble(RadiusSetting, -1.0) == 2.0);
+  settings->AddCollectionFromString(
+    "{ \"sources\" : { \"SphereSource\" : { \"Radius\" : 0.5 } } }", 0.5);
+  TASSERT(settings->GetSettingAsDouble(RadiusSetting, -1.0) == 2.0);
+
+  // lookups with different priority bounds are memoized separately.
+  TASSERT(settings->HasSetting(RadiusSetting, 0.5));
+  TASSERT(!settings->HasSetting(RadiusSetting, 0.25));
+  TASSERT(settings->HasSetting(RadiusSetting, 0.5));
+
+  // setting values, scalars or elements of arrays, updates lookups.
+  settings->SetSetting(RadiusSetting, 3.0);
+  TASSERT(settings->GetSettingAsDouble(RadiusSetting, -1.0) == 3.0);
+  settings->SetSetting(".sources.SphereSource.Center", 2, 6.0);
+  TASSERT(settings->GetSettingAsDouble(".sources.SphereSource.Center", 2, -1.0) == 6.0);
+  settings->SetSetting(".sources.SphereSource.ThetaResolution", 12);
+  TASSERT(settings->GetSettingAsInt(".sources.SphereSource.ThetaResolution", -1) == 12);
+
+  // proxies are initialized with, and save to, the current values.
+  vtkSmartPointer<vtkSMProxy> sphere;
+  sphere.TakeReference(pxm->NewProxy("sources", "SphereSource"));
+  settings->GetProxySettings(sphere);
+  TASSERT(vtkSMPropertyHelper(sphere, "Radius").GetAsDouble() == 3.0);
+  vtkSMPropertyHelper(sphere, "Radius").Set(4.0);
+  settings->SetProxySettings(sphere);
+  TASSERT(settings->GetSettingAsDouble(RadiusSetting, -1.0) == 4.0);
+  vtkSMPropertyHelper(sphere, "Radius").Set(0.0);
+  settings->GetProxySettings(sphere);
+  TASSERT(vtkSMPropertyHelper(sphere, "Radius").GetAsDouble() == 4.0);
+
+  settings->SetSettingDescription(RadiusSetting, "// sphere radius");
+  const std::string description = settings->GetSettingDescription(RadiusSetting);
+  TASSERT(description.find("sphere radius") != std::string::npos);
+  TASSERT(settings->GetSettingAsDouble(RadiusSetting, -1.0) == 4.0);
+
+  // clearing all settings must not leave memoized values behind.
+  settings->ClearAllSettings();
+  TASSERT(!settings->HasSetting(RadiusSetting));
+  TASSERT(settings->GetSettingAsDouble(RadiusSetting, -1.0) == -1.0);
+  TASSERT(settings->GetSettingAsDouble(".sources.SphereSource.Center", 2, -1.0) == -1.0);
+  return EXIT_SUCCESS;
+}
+}
+
+int TestSettingsLookupIndex(int argc, char* argv[])
+{
+  (void)argc;
+  vtkInitializationHelper::Initialize(argv[0], vtkProcessModule::PROCESS_CLIENT);
+
+  int exitCode = EXIT_SUCCESS;
+  {
+    vtkNew<vtkSMSession> session;
+    vtkSMSessionProxyManager* pxm = session->GetSessionProxyManager();
+
+    // the same lookups must give the same results with and without the index.
+    for (int useIndex = 1; useIndex >= 0 && exitCode == EXIT_SUCCESS; --useIndex)
+    {
+      vtkNew<vtkSMSettings> settings;
+      settings->SetUseLookupIndex(useIndex != 0);
+      cout << "UseLookupIndex: " << useIndex << endl;
+      exitCode = TestLookups(settings.GetPointer(), pxm);
+    }
+  }
+  vtkInitializationHelper::Finalize();
+  return exitCode;
+}
@@ -26,6 +26,64 @@
 
 #include <vtkNew.h>
 
+#include <map>
+#include <string>
+
+namespace
+{
+// Removes from `before` and `after` the proxy properties whose values are
+// identical in both states. Properties present in only one of the states are
+// kept. Returns false if nothing was removed.
+bool vtkRemoveUnchangedProperties(vtkSMMessage* before, vtkSMMessage* after)
+{
+  int nbBefore = before->ExtensionSize(ProxyState::property);
+  int nbAfter = after->ExtensionSize(ProxyState::property);
+  if (nbBefore == 0 || nbAfter == 0)
+  {
+    return false;
+  }
+
+  std::map<std::string, std::string> beforeValues;
+  for (int cc = 0; cc < nbBefore; ++cc)
+  {
+    const ProxyState_Property& prop = before->GetExtension(ProxyState::property, cc);
+    beforeValues[prop.name()] = prop.SerializeAsString();
+  }
+
+  std::map<std::string, bool> unchanged;
+  for (int cc = 0; cc < nbAfter; ++cc)
+  {
+    const ProxyState_Property& prop = after->GetExtension(ProxyState::property, cc);
+    std::map<std::string, std::string>::const_iterator iter = beforeValues.find(prop.name());
+    if (iter != beforeValues.end() && iter->second == prop.SerializeAsString())
+    {
+      unchanged[prop.name()] = true;
+    }
+  }
+  if (unchanged.empty())
+  {
+    return false;
+  }
+
+  vtkSMMessage* states[2] = { before, after };
+  for (int idx = 0; idx < 2; ++idx)
+  {
+    vtkSMMessage copy;
+    copy.CopyFrom(*states[idx]);
+    states[idx]->ClearExtension(ProxyState::property);
+    for (int cc = 0, max = copy.ExtensionSize(ProxyState::property); cc < max; ++cc)
+    {
+      const ProxyState_Property& prop = copy.GetExtension(ProxyState::property, cc);
+      if (unchanged.find(prop.name()) == unchanged.end())
+      {
+        states[idx]->AddExtension(ProxyState::property)->CopyFrom(prop);
+      }
+    }
+  }
+  return true;
+}
+}
+
 vtkStandardNewMacro(vtkSMRemoteObjectUpdateUndoElement);
 vtkSetObjectImplementationMacro(
   vtkSMRemoteObjectUpdateUndoElement, ProxyLocator, vtkSMProxyLocator);
@@ -33,6 +91,8 @@ vtkSetObjectImplementationMacro(
 vtkSMRemoteObjectUpdateUndoElement::vtkSMRemoteObjectUpdateUndoElement()
 {
   this->ProxyLocator = NULL;
+  this->DeltaEncoding = true;
+  this->DeltaEncoded = false;
   this->AfterState = new vtkSMMessage();
   this->BeforeState = new vtkSMMessage();
 }
@@ -53,6 +113,8 @@ void vtkSMRemoteObjectUpdateUndoElement::PrintSelf(ostream& os, vtkIndent indent
 {
   this->Superclass::PrintSelf(os, indent);
   os << indent << "GlobalId: " << this->GetGlobalId() << endl;
+  os << indent << "DeltaEncoding: " << this->DeltaEncoding << endl;
+  os << indent << "DeltaEncoded: " << this->DeltaEncoded << endl;
   os << indent << "Before state: " << endl;
   if (this->BeforeState)
     this->BeforeState->PrintDebugString();
@@ -107,10 +169,15 @@ void vtkSMRemoteObjectUpdateUndoElement::SetUndoRedoState(
 {
   this->BeforeState->Clear();
   this->AfterState->Clear();
+  this->DeltaEncoded = false;
   if (before && after)
   {
     this->BeforeState->CopyFrom(*before);
     this->AfterState->CopyFrom(*after);
+    if (this->DeltaEncoding && before->global_id() == after->global_id())
+    {
+      this->DeltaEncoded = vtkRemoveUnchangedProperties(this->BeforeState, this->AfterState);
+    }
   }
   else
   {
@@ -123,3 +190,38 @@ vtkTypeUInt32 vtkSMRemoteObjectUpdateUndoElement::GetGlobalId()
 {
   return this->BeforeState->global_id();
 }
+
+//-----------------------------------------------------------------------------
+void vtkSMRemoteObjectUpdateUndoElement::GetFullState(bool before, vtkSMMessage* result)
+{
+  const vtkSMMessage* state = before ? this->BeforeState : this->AfterState;
+  result->CopyFrom(*state);
+
+  vtkSMMessage current;
+  if (!this->DeltaEncoded || !this->Session || !this->Session->GetStateLocator() ||
+    !this->Session->GetStateLocator()->FindState(state->global_id(), &current))
+  {
+    return;
+  }
+
+  // Add the properties that were dropped by the delta encoding.
+  std::map<std::string, bool> recorded;
+  for (int cc = 0, max = state->ExtensionSize(ProxyState::property); cc < max; ++cc)
+  {
+    recorded[state->GetExtension(ProxyState::property, cc).name()] = true;
+  }
+  for (int cc = 0, max = current.ExtensionSize(ProxyState::property); cc < max; ++cc)
+  {
+    const ProxyState_Property& prop = current.GetExtension(ProxyState::property, cc);
+    if (recorded.find(prop.name()) == recorded.end())
+    {
+      result->AddExtension(ProxyState::property)->CopyFrom(prop);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+size_t vtkSMRemoteObjectUpdateUndoElement::GetMemorySize()
+{
+  return this->BeforeState->SpaceUsedLong() + this->AfterState->SpaceUsedLong();
+}
@@ -19,6 +19,12 @@
  * This class keeps the before and after state of the RemoteObject in the
  * vtkSMMessage form. It works with any proxy and RemoteObject. It is a very
  * generic undoElement.
+ *
+ * When DeltaEncoding is enabled (default), proxy properties whose values are
+ * identical in the before and after states are dropped from both, so only
+ * the properties that changed are kept. Since vtkSMProxy::LoadState() only
+ * updates the properties present in the state, undo/redo is unaffected. Use
+ * GetFullState() to reconstruct a complete state when needed.
 */
 
 #ifndef vtkSMRemoteObjectUpdateUndoElement_h
@@ -60,6 +66,36 @@ public:
    */
   virtual void SetUndoRedoState(const vtkSMMessage* before, const vtkSMMessage* after);
 
+  //@{
+  /**
+   * When enabled, SetUndoRedoState() only keeps the properties that differ
+   * between the before and after states. Default is true.
+   */
+  vtkSetMacro(DeltaEncoding, bool);
+  vtkGetMacro(DeltaEncoding, bool);
+  vtkBooleanMacro(DeltaEncoding, bool);
+  //@}
+
+  /**
+   * Returns true if the states currently held were delta encoded.
+   */
+  vtkGetMacro(DeltaEncoded, bool);
+
+  /**
+   * Fills \c result with a complete state for the before (or after) state.
+   * If the states are delta encoded, the missing properties are taken from
+   * the state registered for this object in the session's state locator.
+   * This is valid as long as the undo stack is traversed in order, since the
+   * current state of the object then only differs from the one to restore by
+   * the properties recorded in this element.
+   */
+  void GetFullState(bool before, vtkSMMessage* result);
+
+  /**
+   * Returns the memory used by the before and after states, in bytes.
+   */
+  size_t GetMemorySize() override;
+
   // Current full state of the UndoElement
   vtkSMMessage* BeforeState;
   vtkSMMessage* AfterState;
@@ -74,6 +110,8 @@ protected:
   int UpdateState(const vtkSMMessage* state);
 
   vtkSMProxyLocator* ProxyLocator;
+  bool DeltaEncoding;
+  bool DeltaEncoded;
 
 private:
   vtkSMRemoteObjectUpdateUndoElement(const vtkSMRemoteObjectUpdateUndoElement&) = delete;
@@ -18,6 +18,7 @@
 #include "vtkDebugLeaks.h"
 #include "vtkObjectFactory.h"
 #include "vtkPVCatalystSessionCore.h"
+#include "vtkPVLogger.h"
 #include "vtkPVServerInformation.h"
 #include "vtkPVSessionCore.h"
 #include "vtkProcessModule.h"
@@ -72,6 +73,10 @@ vtkSMSession::vtkSMSession(
   this->SessionProxyManager = NULL;
   this->StateLocator = vtkSMStateLocator::New();
   this->IsAutoMPI = false;
+  this->PushStateBatchDepth = 0;
+  this->PushStateBatchNumberOfMessages = 0;
+  this->PushStateBatchNumberOfBytes = 0;
+  this->PushStateBatchNumberOfRequests = 0;
 
   // Create and setup deserializer for the local ProxyLocator
   vtkNew<vtkSMDeserializerProtobuf> deserializer;
@@ -125,12 +130,54 @@ vtkSMSession::ServerFlags vtkSMSession::GetProcessRoles()
 //----------------------------------------------------------------------------
 void vtkSMSession::PushState(vtkSMMessage* msg)
 {
+  this->CountPushStateBatchMessage(msg);
+
   // Manage Undo/Redo if possible
   this->UpdateStateHistory(msg);
 
   this->Superclass::PushState(msg);
 }
 
+//----------------------------------------------------------------------------
+void vtkSMSession::BeginPushStateBatch()
+{
+  if (this->PushStateBatchDepth++ == 0)
+  {
+    this->PushStateBatchNumberOfMessages = 0;
+    this->PushStateBatchNumberOfBytes = 0;
+    this->PushStateBatchNumberOfRequests = 0;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSMSession::EndPushStateBatch()
+{
+  if (this->PushStateBatchDepth <= 0)
+  {
+    vtkErrorMacro("EndPushStateBatch() called without matching BeginPushStateBatch().");
+    return;
+  }
+  if (--this->PushStateBatchDepth == 0)
+  {
+    this->FlushPushStateBatch();
+    vtkVLogF(PARAVIEW_LOG_APPLICATION_VERBOSITY(),
+      "push-state batch: %lld message(s), %lld bytes, %lld request(s)",
+      static_cast<long long>(this->PushStateBatchNumberOfMessages),
+      static_cast<long long>(this->PushStateBatchNumberOfBytes),
+      static_cast<long long>(this->PushStateBatchNumberOfRequests));
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSMSession::CountPushStateBatchMessage(const vtkSMMessage* msg)
+{
+  if (this->PushStateBatchDepth > 0)
+  {
+    this->PushStateBatchNumberOfMessages++;
+    this->PushStateBatchNumberOfBytes += msg->ByteSize();
+  }
+}
+
 //----------------------------------------------------------------------------
 void vtkSMSession::UpdateStateHistory(vtkSMMessage* msg)
 {
@@ -159,18 +206,18 @@ void vtkSMSession::UpdateStateHistory(vtkSMMessage* msg)
     bool createAction = !this->StateLocator->FindState(globalId, &oldState,
       /* We want only a local lookup => false */ false);
 
-    // This is a filtering Hack, I don't like it. :-(
-    if (newState.GetExtension(ProxyState::xml_name) != "Camera")
-    {
-      this->StateLocator->RegisterState(&newState);
-    }
+    // Camera states are registered too, so that delta encoded undo elements
+    // of cameras can be expanded, but camera interactions are left to the
+    // interaction undo stack rather than recorded as state changes.
+    this->StateLocator->RegisterState(&newState);
+    const bool isCamera = newState.GetExtension(ProxyState::xml_name) == "Camera";
 
     // Propagate to undo stack builder if possible
     if (createAction)
     {
       usb->OnCreateObject(this, &newState);
     }
-    else if (oldState.SerializeAsString() != newState.SerializeAsString())
+    else if (!isCamera && oldState.SerializeAsString() != newState.SerializeAsString())
     {
       // Update
       usb->OnStateChange(this, globalId, &oldState, &newState);
@@ -239,6 +286,11 @@ bool vtkSMSession::IsMPIInitialized(vtkTypeUInt32)
 void vtkSMSession::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "PushStateBatchNumberOfMessages: " << this->PushStateBatchNumberOfMessages
+     << endl;
+  os << indent << "PushStateBatchNumberOfBytes: " << this->PushStateBatchNumberOfBytes << endl;
+  os << indent << "PushStateBatchNumberOfRequests: " << this->PushStateBatchNumberOfRequests
+     << endl;
 }
 
 //----------------------------------------------------------------------------
@@ -145,6 +145,43 @@ public:
    */
   void PushState(vtkSMMessage* msg) override;
 
+  //---------------------------------------------------------------------------
+  // API for batching state pushes
+  //---------------------------------------------------------------------------
+
+  //@{
+  /**
+   * Begin/End a batch of PushState() calls. While a batch is active, sessions
+   * that communicate with remote processes may queue messages bound for the
+   * server(s) and send them together when the outermost batch ends. Queued
+   * messages are also sent before any call that requires a reply from the
+   * server(s), hence the order in which the server processes requests is
+   * unchanged. Batches may be nested.
+   *
+   * The implementation provided by this class simply tracks the nesting level
+   * since all messages are processed locally.
+   *
+   * @sa vtkSMSessionPushStateBatchScope
+   */
+  void BeginPushStateBatch();
+  void EndPushStateBatch();
+  bool GetInPushStateBatch() const { return this->PushStateBatchDepth > 0; }
+  //@}
+
+  //@{
+  /**
+   * Statistics for the current, or most recently completed, PushState()
+   * batch. These are reset when an outermost batch begins.
+   * `PushStateBatchNumberOfMessages` is the number of messages pushed,
+   * `PushStateBatchNumberOfBytes` their total serialized size and
+   * `PushStateBatchNumberOfRequests` the number of requests sent to the
+   * server(s) to deliver them, which is 0 for builtin sessions.
+   */
+  vtkGetMacro(PushStateBatchNumberOfMessages, vtkTypeInt64);
+  vtkGetMacro(PushStateBatchNumberOfBytes, vtkTypeInt64);
+  vtkGetMacro(PushStateBatchNumberOfRequests, vtkTypeInt64);
+  //@}
+
   /**
    * Sends the message to all clients.
    */
@@ -281,11 +318,27 @@ protected:
    */
   void UpdateStateHistory(vtkSMMessage* msg);
 
+  /**
+   * Called when the outermost PushState() batch ends. Subclasses that queue
+   * messages should send them here. Default implementation does nothing.
+   */
+  virtual void FlushPushStateBatch() {}
+
+  /**
+   * Updates the PushState() batch statistics for the message, if a batch is
+   * active.
+   */
+  void CountPushStateBatchMessage(const vtkSMMessage* msg);
+
   vtkSMSessionProxyManager* SessionProxyManager;
   vtkSMStateLocator* StateLocator;
   vtkSMProxyLocator* ProxyLocator;
 
   bool IsAutoMPI;
+  int PushStateBatchDepth;
+  vtkTypeInt64 PushStateBatchNumberOfMessages;
+  vtkTypeInt64 PushStateBatchNumberOfBytes;
+  vtkTypeInt64 PushStateBatchNumberOfRequests;
 
 private:
   vtkSMSession(const vtkSMSession&) = delete;
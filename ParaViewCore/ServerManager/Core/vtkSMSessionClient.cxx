@@ -48,6 +48,7 @@
 
 #include <assert.h>
 #include <set>
+#include <vector>
 
 //****************************************************************************/
 //                    Internal Classes and typedefs
@@ -61,6 +62,20 @@ void RMICallback(
   self->OnServerNotificationMessageRMI(remoteArg, remoteArgLength);
 }
 };
+//****************************************************************************/
+// Serialized messages queued by PushState() while a batch is active.
+class vtkSMSessionClient::vtkPendingPushes
+{
+public:
+  std::vector<std::string> DataServer;
+  std::vector<std::string> RenderServer;
+  size_t NumberOfBytes = 0;
+
+  // Queued messages are sent once this many bytes have accumulated even if
+  // the batch is still active to avoid building arbitrarily large requests.
+  static const size_t MaximumNumberOfBytes = 16 * 1024 * 1024;
+};
+
 //****************************************************************************/
 vtkStandardNewMacro(vtkSMSessionClient);
 vtkCxxSetObjectMacro(vtkSMSessionClient, RenderServerController, vtkMultiProcessController);
@@ -92,6 +107,7 @@ vtkSMSessionClient::vtkSMSessionClient()
   // Default value
   this->NoMoreDelete = false;
   this->NotBusy = 0;
+  this->PendingPushes = new vtkPendingPushes();
 }
 
 //----------------------------------------------------------------------------
@@ -120,6 +136,8 @@ vtkSMSessionClient::~vtkSMSessionClient()
 
   delete this->ServerLastInvokeResult;
   this->ServerLastInvokeResult = NULL;
+  delete this->PendingPushes;
+  this->PendingPushes = NULL;
 }
 
 //----------------------------------------------------------------------------
@@ -447,6 +465,7 @@ bool vtkSMSessionClient::IsMPIInitialized(vtkTypeUInt32 servers)
 //----------------------------------------------------------------------------
 void vtkSMSessionClient::CloseSession()
 {
+  this->FlushPushStateBatch();
   if (this->DataServerController)
   {
     this->DataServerController->TriggerRMIOnAllChildren(vtkPVSessionServer::CLOSE_SESSION);
@@ -510,8 +529,35 @@ void vtkSMSessionClient::PushState(vtkSMMessage* message)
   {
     controllers[num_controllers++] = this->RenderServerController;
   }
-  if (num_controllers > 0)
+  if (num_controllers > 0 && this->GetInPushStateBatch() && !this->IsMultiClients())
   {
+    // Queue the message; it will be sent with the rest of the batch.
+    const std::string serialized = message->SerializeAsString();
+    for (int cc = 0; cc < num_controllers; cc++)
+    {
+      if (controllers[cc] == this->DataServerController)
+      {
+        this->PendingPushes->DataServer.push_back(serialized);
+      }
+      else
+      {
+        this->PendingPushes->RenderServer.push_back(serialized);
+      }
+      this->PendingPushes->NumberOfBytes += serialized.size();
+    }
+    if (this->PendingPushes->NumberOfBytes > vtkPendingPushes::MaximumNumberOfBytes)
+    {
+      this->FlushPushStateBatch();
+    }
+  }
+  else if (num_controllers > 0)
+  {
+    this->FlushPushStateBatch();
+    if (this->GetInPushStateBatch())
+    {
+      this->PushStateBatchNumberOfRequests += num_controllers;
+    }
+
     vtkMultiProcessStream stream;
     stream << static_cast<int>(vtkPVSessionServer::PUSH);
     stream << message->SerializeAsString();
@@ -574,6 +620,10 @@ void vtkSMSessionClient::PushState(vtkSMMessage* message)
   }
   else
   {
+    // Superclass::PushState() counts messages in a batch; since it's not
+    // called here, count this one explicitly.
+    this->CountPushStateBatchMessage(message);
+
     // We do not execute anything locally we just keep track
     // of the State History for Undo/Redo
     this->UpdateStateHistory(message);
@@ -583,6 +633,7 @@ void vtkSMSessionClient::PushState(vtkSMMessage* message)
 //----------------------------------------------------------------------------
 void vtkSMSessionClient::PullState(vtkSMMessage* message)
 {
+  this->FlushPushStateBatch();
   this->StartBusyWork();
   vtkTypeUInt32 location = this->GetRealLocation(message->location());
   message->set_location(location);
@@ -640,6 +691,7 @@ void vtkSMSessionClient::ExecuteStream(
   }
 
   location = this->GetRealLocation(location);
+  this->FlushPushStateBatch();
 
   vtkMultiProcessController* controllers[2] = { NULL, NULL };
   int num_controllers = 0;
@@ -682,6 +734,7 @@ void vtkSMSessionClient::ExecuteStream(
 //----------------------------------------------------------------------------
 const vtkClientServerStream& vtkSMSessionClient::GetLastResult(vtkTypeUInt32 location)
 {
+  this->FlushPushStateBatch();
   this->StartBusyWork();
   location = this->GetRealLocation(location);
 
@@ -730,6 +783,7 @@ const vtkClientServerStream& vtkSMSessionClient::GetLastResult(vtkTypeUInt32 loc
 bool vtkSMSessionClient::GatherInformation(
   vtkTypeUInt32 location, vtkPVInformation* information, vtkTypeUInt32 globalid)
 {
+  this->FlushPushStateBatch();
   this->StartBusyWork();
   if (this->RenderServerController == NULL)
   {
@@ -828,6 +882,7 @@ void vtkSMSessionClient::UnRegisterSIObject(vtkSMMessage* message)
   {
     return;
   }
+  this->FlushPushStateBatch();
 
   vtkTypeUInt32 location = this->GetRealLocation(message->location());
   message->set_location(location);
@@ -869,6 +924,7 @@ void vtkSMSessionClient::RegisterSIObject(vtkSMMessage* message)
   {
     return;
   }
+  this->FlushPushStateBatch();
 
   vtkTypeUInt32 location = this->GetRealLocation(message->location());
   message->set_location(location);
@@ -907,6 +963,40 @@ void vtkSMSessionClient::RegisterSIObject(vtkSMMessage* message)
   }
 }
 
+//----------------------------------------------------------------------------
+void vtkSMSessionClient::FlushPushStateBatch()
+{
+  vtkPendingPushes& pending = *this->PendingPushes;
+  vtkMultiProcessController* controllers[2] = { this->DataServerController,
+    this->RenderServerController };
+  std::vector<std::string>* queues[2] = { &pending.DataServer, &pending.RenderServer };
+  for (int cc = 0; cc < 2; cc++)
+  {
+    std::vector<std::string>& queue = *queues[cc];
+    if (queue.empty())
+    {
+      continue;
+    }
+    if (controllers[cc] != NULL && !this->NoMoreDelete)
+    {
+      this->PushStateBatchNumberOfRequests++;
+      vtkMultiProcessStream stream;
+      stream << static_cast<int>(vtkPVSessionServer::PUSH_BATCH)
+             << static_cast<int>(queue.size());
+      for (const auto& serialized : queue)
+      {
+        stream << serialized;
+      }
+      std::vector<unsigned char> raw_message;
+      stream.GetRawData(raw_message);
+      controllers[cc]->TriggerRMIOnAllChildren(&raw_message[0],
+        static_cast<int>(raw_message.size()), vtkPVSessionServer::CLIENT_SERVER_MESSAGE_RMI);
+    }
+    queue.clear();
+  }
+  pending.NumberOfBytes = 0;
+}
+
 //----------------------------------------------------------------------------
 void vtkSMSessionClient::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -239,6 +239,14 @@ protected:
    */
   vtkTypeUInt32 GetRealLocation(vtkTypeUInt32);
 
+  /**
+   * Sends all messages queued by PushState() while a batch was active as a
+   * single PUSH_BATCH request per server. Called when the outermost batch
+   * ends and before any request that needs to be processed in order with
+   * the queued messages.
+   */
+  void FlushPushStateBatch() override;
+
   // Both maybe the same when connected to pvserver.
   vtkMultiProcessController* RenderServerController;
   vtkMultiProcessController* DataServerController;
@@ -280,6 +288,9 @@ private:
   int NotBusy;
   vtkTypeUInt32 LastGlobalID;
   vtkTypeUInt32 LastGlobalIDAvailable;
+
+  class vtkPendingPushes;
+  vtkPendingPushes* PendingPushes;
 };
 
 #endif
@@ -1226,6 +1226,8 @@ void vtkSMSessionProxyManager::LoadXMLState(
   {
     spLoader = vtkSmartPointer<vtkSMStateLoader>::New();
     spLoader->SetSessionProxyManager(this);
+    // Batching saves round trips only when the server is remote.
+    spLoader->SetBatchedLoading(this->GetSession()->IsA("vtkSMSessionClient") != 0);
   }
   else
   {
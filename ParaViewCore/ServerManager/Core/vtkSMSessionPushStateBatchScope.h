@@ -0,0 +1,64 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkSMSessionPushStateBatchScope.h
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+/**
+ * @class vtkSMSessionPushStateBatchScope
+ * @brief scoped batching of vtkSMSession::PushState() calls.
+ *
+ * Calls vtkSMSession::BeginPushStateBatch() on construction and
+ * vtkSMSession::EndPushStateBatch() on destruction e.g.
+ *
+ * @code{cpp}
+ * {
+ *   vtkSMSessionPushStateBatchScope batch(proxy->GetSession());
+ *   proxy->UpdateVTKObjects();
+ *   otherProxy->UpdateVTKObjects();
+ * } // queued messages are sent here.
+ * @endcode
+ */
+
+#ifndef vtkSMSessionPushStateBatchScope_h
+#define vtkSMSessionPushStateBatchScope_h
+
+#include "vtkSMSession.h"    // for vtkSMSession
+#include "vtkSmartPointer.h" // for vtkSmartPointer
+
+class vtkSMSessionPushStateBatchScope
+{
+public:
+  vtkSMSessionPushStateBatchScope(vtkSMSession* session)
+    : Session(session)
+  {
+    if (this->Session)
+    {
+      this->Session->BeginPushStateBatch();
+    }
+  }
+  ~vtkSMSessionPushStateBatchScope()
+  {
+    if (this->Session)
+    {
+      this->Session->EndPushStateBatch();
+    }
+  }
+
+private:
+  vtkSmartPointer<vtkSMSession> Session;
+  vtkSMSessionPushStateBatchScope(const vtkSMSessionPushStateBatchScope&) = delete;
+  void operator=(const vtkSMSessionPushStateBatchScope&) = delete;
+};
+
+#endif
+
+// VTK-HeaderTest-Exclude: vtkSMSessionPushStateBatchScope.h
@@ -40,6 +40,7 @@
 #include <cfloat>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 //----------------------------------------------------------------------------
 namespace
@@ -77,8 +78,27 @@ public:
   std::vector<SettingsCollection> SettingCollections;
   bool SettingCollectionsAreSorted;
   bool IsModified;
+  bool UseLookupIndex;
 
-  void Modified() { this->IsModified = true; }
+  // Index of resolved settings, keyed by setting name. Each entry caches the
+  // result of a lookup for a given priority bound. Values point into
+  // SettingCollections, hence the index must be cleared whenever the
+  // collections are changed in any way.
+  struct LookupEntry
+  {
+    double Priority;
+    bool Inclusive;
+    const Json::Value* Value;
+  };
+  std::unordered_map<std::string, std::vector<LookupEntry> > LookupIndex;
+
+  void Modified()
+  {
+    this->IsModified = true;
+    this->ClearLookupIndex();
+  }
+
+  void ClearLookupIndex() { this->LookupIndex.clear(); }
 
   //----------------------------------------------------------------------------
   // Description:
@@ -89,6 +109,7 @@ public:
     std::stable_sort(
       this->SettingCollections.begin(), this->SettingCollections.end(), SortByPriority);
     this->SettingCollectionsAreSorted = true;
+    this->ClearLookupIndex();
   }
 
   //----------------------------------------------------------------------------
@@ -112,8 +133,7 @@ public:
   // See if given setting is defined
   bool HasSetting(const char* settingName, double maxPriority)
   {
-    // Json::Value value = this->GetSetting(settingName);
-    Json::Value value = this->GetSettingAtOrBelowPriority(settingName, maxPriority);
+    const Json::Value& value = this->GetSettingAtOrBelowPriority(settingName, maxPriority);
 
     return !value.isNull();
   }
@@ -136,50 +156,64 @@ public:
 
   //----------------------------------------------------------------------------
   const Json::Value& GetSettingBelowPriority(const char* settingName, double priority)
+  {
+    return this->FindSetting(settingName, priority, false);
+  }
+
+  //----------------------------------------------------------------------------
+  const Json::Value& GetSettingAtOrBelowPriority(const char* settingName, double maxPriority)
+  {
+    return this->FindSetting(settingName, maxPriority, true);
+  }
+
+  //----------------------------------------------------------------------------
+  // Description:
+  // Returns the highest-priority setting with a priority lower than (or equal
+  // to, if `inclusive` is true) `priority`. Results are memoized in
+  // LookupIndex when UseLookupIndex is true.
+  const Json::Value& FindSetting(const char* settingName, double priority, bool inclusive)
   {
     this->SortCollectionsIfNeeded();
 
-    // Iterate over settings, checking higher priority settings first
-    for (size_t i = 0; i < this->SettingCollections.size(); ++i)
+    std::vector<LookupEntry>* entries = nullptr;
+    if (this->UseLookupIndex)
     {
-      if (this->SettingCollections[i].Priority >= priority)
+      entries = &this->LookupIndex[settingName];
+      for (const auto& entry : *entries)
       {
-        continue;
-      }
-
-      Json::Path settingPath(settingName);
-      const Json::Value& setting = settingPath.resolve(this->SettingCollections[i].Value);
-      if (!setting.isNull())
-      {
-        return setting;
+        if (entry.Priority == priority && entry.Inclusive == inclusive)
+        {
+          return *entry.Value;
+        }
       }
     }
 
-    return Json::Value::nullSingleton();
-  }
-
-  //----------------------------------------------------------------------------
-  const Json::Value& GetSettingAtOrBelowPriority(const char* settingName, double maxPriority)
-  {
-    this->SortCollectionsIfNeeded();
+    const Json::Value* result = &Json::Value::nullSingleton();
 
     // Iterate over settings, checking higher priority settings first
+    Json::Path settingPath(settingName);
     for (size_t i = 0; i < this->SettingCollections.size(); ++i)
     {
-      if (this->SettingCollections[i].Priority > maxPriority)
+      const double collectionPriority = this->SettingCollections[i].Priority;
+      if (inclusive ? (collectionPriority > priority) : (collectionPriority >= priority))
       {
         continue;
       }
 
-      Json::Path settingPath(settingName);
       const Json::Value& setting = settingPath.resolve(this->SettingCollections[i].Value);
       if (!setting.isNull())
       {
-        return setting;
+        result = &setting;
+        break;
       }
     }
 
-    return Json::Value::nullSingleton();
+    if (entries)
+    {
+      LookupEntry entry = { priority, inclusive, result };
+      entries->push_back(entry);
+    }
+    return *result;
   }
 
   //----------------------------------------------------------------------------
@@ -188,7 +222,7 @@ public:
   {
     values.clear();
 
-    Json::Value setting = this->GetSettingAtOrBelowPriority(settingName, maxPriority);
+    const Json::Value& setting = this->GetSettingAtOrBelowPriority(settingName, maxPriority);
     if (!setting)
     {
       return false;
@@ -496,6 +530,7 @@ public:
   template <typename T>
   void SetSetting(const char* settingName, const std::vector<T>& values)
   {
+    this->ClearLookupIndex();
     this->CreateCollectionIfNeeded();
     this->SortCollectionsIfNeeded();
 
@@ -717,6 +752,7 @@ public:
     {
       return false;
     }
+    this->ClearLookupIndex();
     this->CreateCollectionIfNeeded();
     this->SortCollectionsIfNeeded();
 
@@ -930,6 +966,7 @@ vtkSMSettings::vtkSMSettings()
   this->Internal = new vtkSMSettingsInternal();
   this->Internal->SettingCollectionsAreSorted = false;
   this->Internal->IsModified = false;
+  this->Internal->UseLookupIndex = true;
   if (vtksys::SystemTools::GetEnv("PV_SETTINGS_DEBUG") != nullptr)
   {
     vtkWarningMacro("`PV_SETTINGS_DEBUG` environment variable has been deprecated."
@@ -989,6 +1026,7 @@ bool vtkSMSettings::AddCollectionFromString(const std::string& settings, double
   {
     this->Internal->SettingCollections.push_back(collection);
     this->Internal->SettingCollectionsAreSorted = false;
+    this->Internal->ClearLookupIndex();
     vtkVLogF(PARAVIEW_LOG_APPLICATION_VERBOSITY(), "successfully parsed settings string");
     return true;
   }
@@ -1036,6 +1074,7 @@ void vtkSMSettings::ClearAllSettings()
   this->Internal->SettingCollections.clear();
   this->Internal->SettingCollectionsAreSorted = false;
   this->Internal->IsModified = false;
+  this->Internal->ClearLookupIndex();
 }
 
 //----------------------------------------------------------------------------
@@ -1134,6 +1173,23 @@ bool vtkSMSettings::SaveSettingsToFile(const std::string& filePath)
   return false;
 }
 
+//----------------------------------------------------------------------------
+void vtkSMSettings::SetUseLookupIndex(bool val)
+{
+  if (this->Internal->UseLookupIndex != val)
+  {
+    this->Internal->UseLookupIndex = val;
+    this->Internal->ClearLookupIndex();
+    this->Modified();
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSMSettings::GetUseLookupIndex()
+{
+  return this->Internal->UseLookupIndex;
+}
+
 //----------------------------------------------------------------------------
 bool vtkSMSettings::HasSetting(const char* settingName)
 {
@@ -1149,7 +1205,7 @@ bool vtkSMSettings::HasSetting(const char* settingName, double maxPriority)
 //----------------------------------------------------------------------------
 unsigned int vtkSMSettings::GetSettingNumberOfElements(const char* settingName)
 {
-  Json::Value value = this->Internal->GetSetting(settingName);
+  const Json::Value& value = this->Internal->GetSetting(settingName);
   if (value.isArray())
   {
     return value.size();
@@ -1224,7 +1280,7 @@ std::string vtkSMSettings::GetSettingAsString(
 //----------------------------------------------------------------------------
 std::string vtkSMSettings::GetSettingDescription(const char* settingName)
 {
-  Json::Value value = this->Internal->GetSetting(settingName);
+  const Json::Value& value = this->Internal->GetSetting(settingName);
   if (!value)
   {
     return std::string();
@@ -1399,6 +1455,7 @@ void vtkSMSettings::SetProxySettings(const char* prefix, vtkSMProxy* proxy,
 //----------------------------------------------------------------------------
 void vtkSMSettings::SetSettingDescription(const char* settingName, const char* description)
 {
+  this->Internal->ClearLookupIndex();
   Json::Path settingPath(settingName);
   Json::Value& settingValue = settingPath.make(this->Internal->SettingCollections[0].Value);
   settingValue.setComment(std::string(description), Json::commentBefore);
@@ -1616,6 +1673,7 @@ bool vtkSMSettings::DeserializeFromJSON(vtkSMProxy* proxy, const Json::Value& va
 //----------------------------------------------------------------------------
 void vtkSMSettings::PrintSelf(ostream& os, vtkIndent indent)
 {
+  os << indent << "UseLookupIndex: " << this->Internal->UseLookupIndex << "\n";
   os << indent << "SettingCollections:\n";
   for (size_t i = 0; i < this->Internal->SettingCollections.size(); ++i)
   {
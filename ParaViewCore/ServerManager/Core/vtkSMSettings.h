@@ -117,6 +117,19 @@ public:
    */
   void ClearAllSettings();
 
+  //@{
+  /**
+   * When enabled (default), the result of every setting lookup is memoized in
+   * a hashed index so that subsequent lookups for the same setting, e.g. when
+   * creating many proxies of the same type, do not need to walk the JSON trees
+   * of all the collections again. The index is discarded whenever the
+   * collections are modified.
+   */
+  void SetUseLookupIndex(bool);
+  bool GetUseLookupIndex();
+  vtkBooleanMacro(UseLookupIndex, bool);
+  //@}
+
   /**
    * Distribute setting collections to all processes if in batch symmetric mode.
    */
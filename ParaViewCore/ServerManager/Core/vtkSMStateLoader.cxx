@@ -28,6 +28,7 @@
 #include "vtkSMSourceProxy.h"
 #include "vtkSMStateVersionController.h"
 #include "vtkSmartPointer.h"
+#include "vtkWeakPointer.h"
 
 #include <cassert>
 #include <cstdlib>
@@ -58,6 +59,10 @@ struct vtkSMStateLoaderInternals
   ProxyCreationOrderType ProxyCreationOrder;
   bool DeferProxyRegistration;
 
+  /// Source proxies whose pipeline information is to be updated once all
+  /// proxies have been created, in creation order. Used in batched mode.
+  std::vector<vtkWeakPointer<vtkSMSourceProxy> > DeferredPipelineInformation;
+
   vtkSMStateLoaderInternals()
     : KeepOriginalId(false)
     , DeferProxyRegistration(false)
@@ -71,6 +76,7 @@ vtkSMStateLoader::vtkSMStateLoader()
   this->Internal = new vtkSMStateLoaderInternals;
   this->ServerManagerStateElement = 0;
   this->KeepIdMapping = 0;
+  this->BatchedLoading = false;
   this->ProxyLocator = vtkSMProxyLocator::New();
 }
 
@@ -201,9 +207,18 @@ void vtkSMStateLoader::CreatedNewProxy(vtkTypeUInt32 id, vtkSMProxy* proxy)
 
   // Calling UpdateVTKObjects() will assign the proxy a GlobalId, if needed.
   proxy->UpdateVTKObjects();
-  if (proxy->IsA("vtkSMSourceProxy"))
+  if (vtkSMSourceProxy* source = vtkSMSourceProxy::SafeDownCast(proxy))
   {
-    vtkSMSourceProxy::SafeDownCast(proxy)->UpdatePipelineInformation();
+    // Only defer while LoadState() is in progress since it is the one that
+    // processes the deferred updates.
+    if (this->BatchedLoading && this->ServerManagerStateElement)
+    {
+      this->Internal->DeferredPipelineInformation.push_back(source);
+    }
+    else
+    {
+      source->UpdatePipelineInformation();
+    }
   }
   if (this->Internal->DeferProxyRegistration)
   {
@@ -216,6 +231,21 @@ void vtkSMStateLoader::CreatedNewProxy(vtkTypeUInt32 id, vtkSMProxy* proxy)
   }
 }
 
+//---------------------------------------------------------------------------
+void vtkSMStateLoader::UpdateDeferredPipelineInformation()
+{
+  // Copy since updating pipeline information may end up creating new proxies.
+  auto sources = this->Internal->DeferredPipelineInformation;
+  this->Internal->DeferredPipelineInformation.clear();
+  for (const auto& source : sources)
+  {
+    if (source)
+    {
+      source->UpdatePipelineInformation();
+    }
+  }
+}
+
 //---------------------------------------------------------------------------
 void vtkSMStateLoader::RegisterProxy(vtkTypeUInt32 id, vtkSMProxy* proxy)
 {
@@ -518,10 +548,26 @@ int vtkSMStateLoader::LoadState(vtkPVXMLElement* elem, bool keepOriginalId)
     return 0;
   }
 
+  vtkSMSession* session = this->BatchedLoading ? this->GetSession() : NULL;
+  if (session)
+  {
+    session->BeginPushStateBatch();
+  }
+
   this->ProxyLocator->SetDeserializer(this);
+  this->Internal->DeferredPipelineInformation.clear();
   int ret = this->LoadStateInternal(elem);
+  // LoadStateInternal() may return early on errors, leaving deferred updates
+  // for proxies that are never registered.
+  this->Internal->DeferredPipelineInformation.clear();
+  this->ServerManagerStateElement = 0;
   this->ProxyLocator->SetDeserializer(0);
 
+  if (session)
+  {
+    session->EndPushStateBatch();
+  }
+
   // BUG #10650. When animation scene time ranges are read from the state, they
   // often override those that the timekeeper painstakingly computed. Here we
   // explicitly trigger the timekeeper so that the scene re-determines the
@@ -627,6 +673,10 @@ int vtkSMStateLoader::LoadStateInternal(vtkPVXMLElement* parent)
     }
   }
 
+  // In batched mode, pipeline information was not updated as proxies were
+  // created. Do that now, before the proxies get registered.
+  this->UpdateDeferredPipelineInformation();
+
   // Register proxies in order they were created (as that's a good dependency
   // order).
   for (vtkSMStateLoaderInternals::ProxyCreationOrderType::const_iterator iter =
@@ -648,6 +698,7 @@ int vtkSMStateLoader::LoadStateInternal(vtkPVXMLElement* parent)
     }
   }
   assert(this->Internal->ProxyCreationOrder.size() == 0);
+  this->UpdateDeferredPipelineInformation();
 
   // Process link elements.
   for (i = 0; i < numElems; i++)
@@ -690,6 +741,7 @@ int vtkSMStateLoader::LoadStateInternal(vtkPVXMLElement* parent)
 void vtkSMStateLoader::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "BatchedLoading: " << this->BatchedLoading << endl;
 }
 
 //---------------------------------------------------------------------------
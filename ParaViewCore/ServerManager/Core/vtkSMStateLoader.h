@@ -68,6 +68,23 @@ public:
   vtkBooleanMacro(KeepIdMapping, int);
   //@}
 
+  //@{
+  /**
+   * When set to true, the state is loaded in batched mode: messages pushed to
+   * the server(s) while creating and updating proxies are queued and sent
+   * together (see vtkSMSession::BeginPushStateBatch) and updating of pipeline
+   * information for source proxies is deferred until all proxies have been
+   * created. This reduces the number of round trips when loading large
+   * states in client-server mode. Default is false.
+   *
+   * vtkSMSessionProxyManager::LoadXMLState() enables this on the loader it
+   * creates, when none is provided, for client-server sessions.
+   */
+  vtkSetMacro(BatchedLoading, bool);
+  vtkGetMacro(BatchedLoading, bool);
+  vtkBooleanMacro(BatchedLoading, bool);
+  //@}
+
   //@{
   /**
    * Return an array of ids. The ids are stored in the following order
@@ -97,12 +114,20 @@ protected:
    * true). It also called vtkSMProxy::UpdateVTKObjects() and
    * vtkSMProxy::UpdatePipelineInformation() (if applicable) to ensure that the
    * state loaded on the proxy is "pushed" and any info properties updated.
+   * When BatchedLoading is true, the pipeline information update is deferred
+   * until all proxies have been created.
    * We also create a list to track the order in which proxies are created.
    * This order is a dependency order too and hence helps us register proxies in
    * order of dependencies.
    */
   void CreatedNewProxy(vtkTypeUInt32 id, vtkSMProxy* proxy) override;
 
+  /**
+   * Calls vtkSMSourceProxy::UpdatePipelineInformation() on source proxies
+   * whose update was deferred by CreatedNewProxy() in batched mode.
+   */
+  void UpdateDeferredPipelineInformation();
+
   /**
    * Overridden so that when new views are to be created, we create views
    * suitable for the connection.
@@ -165,6 +190,7 @@ protected:
   vtkPVXMLElement* ServerManagerStateElement;
   vtkSMProxyLocator* ProxyLocator;
   int KeepIdMapping;
+  bool BatchedLoading;
 
 private:
   vtkSMStateLoader(const vtkSMStateLoader&) = delete;
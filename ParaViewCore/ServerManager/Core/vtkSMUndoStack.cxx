@@ -64,7 +64,15 @@ public:
       if (elem)
       {
         elem->SetProxyLocator(this->UndoSetProxyLocator.GetPointer());
-        if (useBeforeState)
+        if (elem->GetDeltaEncoded())
+        {
+          // Delta encoded states only hold the modified properties, expand
+          // them so that objects found through the locator get a full state.
+          vtkSMMessage state;
+          elem->GetFullState(useBeforeState, &state);
+          this->UndoSetStateLocator->RegisterState(&state);
+        }
+        else if (useBeforeState)
         {
           this->UndoSetStateLocator->RegisterState(elem->BeforeState);
         }
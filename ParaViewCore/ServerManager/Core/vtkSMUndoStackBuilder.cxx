@@ -16,6 +16,7 @@
 
 #include "vtkCommand.h"
 #include "vtkObjectFactory.h"
+#include "vtkPVLogger.h"
 #include "vtkPVXMLElement.h"
 #include "vtkProcessModule.h"
 #include "vtkSMMessage.h"
@@ -25,6 +26,7 @@
 #include "vtkSMRemoteObjectUpdateUndoElement.h"
 #include "vtkSMSession.h"
 #include "vtkSMUndoStack.h"
+#include "vtkTimerLog.h"
 #include "vtkUndoElement.h"
 #include "vtkUndoSet.h"
 #include "vtkUndoStackInternal.h"
@@ -42,6 +44,11 @@ vtkSMUndoStackBuilder::vtkSMUndoStackBuilder()
   this->Label = NULL;
   this->EnableMonitoring = 0;
   this->IgnoreAllChanges = false;
+  this->DeltaEncoding = true;
+  this->RecordingTime = 0.0;
+  this->LastUndoSetRecordingTime = 0.0;
+  this->LastUndoSetNumberOfElements = 0;
+  this->LastUndoSetMemorySize = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -87,7 +94,17 @@ void vtkSMUndoStackBuilder::PushToStack()
 
   if (this->UndoSet->GetNumberOfElements() > 0 && this->UndoStack)
   {
-    this->UndoStack->Push((this->Label ? this->Label : "Changes"), this->UndoSet);
+    const char* label = this->Label ? this->Label : "Changes";
+    this->LastUndoSetRecordingTime = this->RecordingTime;
+    this->LastUndoSetNumberOfElements = this->UndoSet->GetNumberOfElements();
+    this->LastUndoSetMemorySize = this->UndoSet->GetMemorySize();
+    this->UndoStack->Push(label, this->UndoSet);
+    vtkVLogF(PARAVIEW_LOG_APPLICATION_VERBOSITY(),
+      "undo set '%s': %d element(s), %llu bytes, recorded in %g s (stack uses %llu bytes)", label,
+      this->LastUndoSetNumberOfElements,
+      static_cast<unsigned long long>(this->LastUndoSetMemorySize),
+      this->LastUndoSetRecordingTime,
+      static_cast<unsigned long long>(this->UndoStack->GetMemorySize()));
   }
   this->InitializeUndoSet();
 }
@@ -103,6 +120,7 @@ void vtkSMUndoStackBuilder::InitializeUndoSet()
 {
   this->SetLabel(NULL);
   this->UndoSet->RemoveAllElements();
+  this->RecordingTime = 0.0;
 }
 
 //-----------------------------------------------------------------------------
@@ -131,12 +149,15 @@ void vtkSMUndoStackBuilder::OnStateChange(vtkSMSession* session, vtkTypeUInt32 v
     return;
   }
 
+  const double start = vtkTimerLog::GetUniversalTime();
   vtkSMRemoteObjectUpdateUndoElement* undoElement;
   undoElement = vtkSMRemoteObjectUpdateUndoElement::New();
   undoElement->SetSession(session);
+  undoElement->SetDeltaEncoding(this->DeltaEncoding);
   undoElement->SetUndoRedoState(previousState, newState);
   this->Add(undoElement);
   undoElement->FastDelete();
+  this->RecordingTime += vtkTimerLog::GetUniversalTime() - start;
 }
 
 //-----------------------------------------------------------------------------
@@ -155,4 +176,8 @@ void vtkSMUndoStackBuilder::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os, indent);
   os << indent << "IgnoreAllChanges: " << this->IgnoreAllChanges << endl;
   os << indent << "UndoStack: " << this->UndoStack << endl;
+  os << indent << "DeltaEncoding: " << this->DeltaEncoding << endl;
+  os << indent << "LastUndoSetRecordingTime: " << this->LastUndoSetRecordingTime << endl;
+  os << indent << "LastUndoSetNumberOfElements: " << this->LastUndoSetNumberOfElements << endl;
+  os << indent << "LastUndoSetMemorySize: " << this->LastUndoSetMemorySize << endl;
 }
@@ -122,6 +122,29 @@ public:
   vtkGetMacro(IgnoreAllChanges, bool);
   //@}
 
+  //@{
+  /**
+   * When enabled, state changes are recorded using delta encoded
+   * vtkSMRemoteObjectUpdateUndoElement instances that only keep the properties
+   * that changed. By default, it is set to true.
+   */
+  vtkSetMacro(DeltaEncoding, bool);
+  vtkGetMacro(DeltaEncoding, bool);
+  vtkBooleanMacro(DeltaEncoding, bool);
+  //@}
+
+  //@{
+  /**
+   * Statistics for the last undo set pushed on the stack: the time, in
+   * seconds, spent recording its state changes, its number of elements and
+   * the memory used by it, in bytes. These are also logged using
+   * `PARAVIEW_LOG_APPLICATION_VERBOSITY()` on every PushToStack().
+   */
+  vtkGetMacro(LastUndoSetRecordingTime, double);
+  vtkGetMacro(LastUndoSetNumberOfElements, int);
+  vtkGetMacro(LastUndoSetMemorySize, size_t);
+  //@}
+
   // Record a state change on a RemoteObject
   virtual void OnStateChange(vtkSMSession* session, vtkTypeUInt32 globalId,
     const vtkSMMessage* previousState, const vtkSMMessage* newState);
@@ -151,6 +174,12 @@ protected:
   // and make sure that a begin occurs before recording any event
   int EnableMonitoring;
   bool IgnoreAllChanges;
+  bool DeltaEncoding;
+
+  double RecordingTime;
+  double LastUndoSetRecordingTime;
+  int LastUndoSetNumberOfElements;
+  size_t LastUndoSetMemorySize;
 
 private:
   vtkSMUndoStackBuilder(const vtkSMUndoStackBuilder&) = delete;
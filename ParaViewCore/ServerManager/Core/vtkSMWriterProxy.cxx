@@ -17,6 +17,7 @@ PURPOSE.  See the above copyright notice for more information.
 #include "vtkClientServerStream.h"
 #include "vtkObjectFactory.h"
 #include "vtkPVXMLElement.h"
+#include "vtkProcessModule.h"
 #include "vtkSMSession.h"
 
 vtkStandardNewMacro(vtkSMWriterProxy);
@@ -66,6 +67,12 @@ int vtkSMWriterProxy::ReadXMLAttributes(vtkSMSessionProxyManager* pm, vtkPVXMLEl
 //-----------------------------------------------------------------------------
 void vtkSMWriterProxy::UpdatePipeline()
 {
+  // every time compartment runs the same script, only the first one writes.
+  if (vtkProcessModule::GetTimeCompartmentId() != 0)
+  {
+    return;
+  }
+
   this->GetSession()->PrepareProgress();
 
   vtkClientServerStream stream;
@@ -81,6 +88,11 @@ void vtkSMWriterProxy::UpdatePipeline()
 //-----------------------------------------------------------------------------
 void vtkSMWriterProxy::UpdatePipeline(double time)
 {
+  if (vtkProcessModule::GetTimeCompartmentId() != 0)
+  {
+    return;
+  }
+
   this->Session->PrepareProgress();
 
   // we have to manually set the time on the server
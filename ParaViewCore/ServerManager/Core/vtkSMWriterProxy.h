@@ -40,6 +40,8 @@ public:
    * Updates the pipeline and writes the file(s).
    * Must call UpdateVTKObjects() before calling UpdatePipeline()
    * to ensure that the filename etc. are set correctly.
+   * When pvbatch runs with several time compartments, only the first one
+   * writes, the others do nothing (see vtkProcessModule::GetTimeCompartmentId()).
    */
   void UpdatePipeline() override;
 
@@ -47,6 +49,7 @@ public:
    * Updates the pipeline and writes the file(s).
    * Must call UpdateVTKObjects() before calling UpdatePipeline()
    * to ensure that the filename etc. are set correctly.
+   * As UpdatePipeline(), this does nothing outside the first time compartment.
    */
   void UpdatePipeline(double time) override;
 
@@ -25,6 +25,8 @@ PURPOSE.  See the above copyright notice for more information.
 #include "vtkSMUndoStack.h"
 #include "vtkUndoSet.h"
 
+#include <algorithm>
+
 void vtkSMUndoStackTest::UndoRedo()
 {
   vtkSMSession* session = vtkSMSession::New();
@@ -48,6 +50,12 @@ void vtkSMUndoStackTest::UndoRedo()
   after.CopyFrom(*sphere->GetFullState());
   undoElement->SetUndoRedoState(&before, &after);
 
+  // only the modified property must be kept.
+  QVERIFY(undoElement->GetDeltaEncoded());
+  QCOMPARE(undoElement->BeforeState->ExtensionSize(ProxyState::property), 1);
+  QCOMPARE(undoElement->AfterState->ExtensionSize(ProxyState::property), 1);
+  QVERIFY(undoElement->GetMemorySize() < before.SpaceUsedLong() + after.SpaceUsedLong());
+
   undoSet->AddElement(undoElement);
   undoElement->Delete();
   undoStack->Push("ChangeRadius", undoSet);
@@ -77,3 +85,49 @@ void vtkSMUndoStackTest::StackDepth()
   QCOMPARE(stack->GetStackDepth(), 10);
   stack->Delete();
 }
+
+void vtkSMUndoStackTest::MaximumMemorySize()
+{
+  vtkSMSession* session = vtkSMSession::New();
+  vtkSMSessionProxyManager* pxm = session->GetSessionProxyManager();
+
+  vtkSMProxy* sphere = pxm->NewProxy("sources", "SphereSource");
+  sphere->UpdateVTKObjects();
+
+  vtkSMUndoStack* stack = vtkSMUndoStack::New();
+  QCOMPARE(stack->GetMaximumMemorySize(), static_cast<size_t>(0));
+
+  size_t setSize = 0;
+  for (int cc = 0; cc < 5; ++cc)
+  {
+    vtkSMMessage before;
+    before.CopyFrom(*sphere->GetFullState());
+    vtkSMPropertyHelper(sphere, "Radius").Set(1.0 + cc);
+    sphere->UpdateVTKObjects();
+    vtkSMMessage after;
+    after.CopyFrom(*sphere->GetFullState());
+
+    vtkSMRemoteObjectUpdateUndoElement* undoElement = vtkSMRemoteObjectUpdateUndoElement::New();
+    undoElement->SetSession(session);
+    undoElement->SetUndoRedoState(&before, &after);
+    vtkUndoSet* undoSet = vtkUndoSet::New();
+    undoSet->AddElement(undoElement);
+    undoElement->Delete();
+    setSize = std::max(setSize, undoSet->GetMemorySize());
+    if (cc == 0)
+    {
+      // allow for about two sets on the stack.
+      stack->SetMaximumMemorySize(2 * setSize + setSize / 2);
+    }
+    stack->Push("ChangeRadius", undoSet);
+    undoSet->Delete();
+  }
+
+  QVERIFY(setSize > 0);
+  QCOMPARE(stack->GetNumberOfUndoSets(), 2u);
+  QVERIFY(stack->GetMemorySize() <= stack->GetMaximumMemorySize());
+
+  stack->Delete();
+  sphere->Delete();
+  session->Delete();
+}
@@ -25,6 +25,7 @@ class vtkSMUndoStackTest : public QObject
 private slots:
   void UndoRedo();
   void StackDepth();
+  void MaximumMemorySize();
 };
 
 #endif
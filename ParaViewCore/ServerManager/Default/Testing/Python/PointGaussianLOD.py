@@ -0,0 +1,47 @@
+# Tests the level-of-detail points of the Point Gaussian representation: an
+# interactive render of a point cloud larger than the LOD threshold draws the
+# representatives of the point hierarchy instead of every point.
+
+from paraview import smtesting
+smtesting.ProcessCommandLineArguments()
+
+from paraview import simple
+from paraview.vtk.vtkTestingRendering import vtkTesting
+
+source = simple.Wavelet(WholeExtent=[-40, 40, -40, 40, -40, 40])
+rep = simple.Show(source)
+rep.Representation = 'Point Gaussian'
+rep.GaussianRadius = 0.4
+simple.ColorBy(rep, ('POINTS', 'RTData'))
+rep.RescaleTransferFunctionToDataRange(False, True)
+
+view = simple.GetActiveView()
+view.OrientationAxesVisibility = 0
+view.ViewSize = [300, 300]
+# any data is large enough for LOD rendering, with the coarsest points.
+view.LODThreshold = 0
+view.LODResolution = 0
+view.CameraPosition = [150, 100, 200]
+view.CameraFocalPoint = [0, 0, 0]
+view.CameraViewUp = [0, 1, 0]
+simple.Render(view)
+
+view.SMProxy.InteractiveRender()
+if not view.GetClientSideObject().GetUsedLODForLastRender():
+    raise RuntimeError("The interactive render did not use the LOD points.")
+
+# compares the window as left by the interactive render, vtkSMTesting would
+# render it again without LOD.
+testing = vtkTesting()
+testing.AddArgument("-T")
+testing.AddArgument(smtesting.TempDir)
+testing.AddArgument("-V")
+testing.AddArgument(smtesting.BaselineImage)
+testing.SetRenderWindow(view.GetRenderWindow())
+if testing.RegressionTest(smtesting.Threshold) != testing.PASSED:
+    raise smtesting.TestError('Image comparison failed.')
+
+# still renders draw every point again.
+simple.Render(view)
+if view.GetClientSideObject().GetUsedLODForLastRender():
+    raise RuntimeError("The still render used the LOD points.")
@@ -0,0 +1,62 @@
+# Tests saving an animation as a series of images with several encoder
+# threads: every frame must be written to the file numbered after its position
+# in the animation, with the same image as when frames are written one after
+# the other.
+from __future__ import print_function
+import os
+from paraview.simple import *
+from paraview import smtesting
+smtesting.ProcessCommandLineArguments()
+
+numFrames = 7
+
+renderView = CreateView('RenderView')
+renderView.ViewSize = [200, 200]
+renderView.OrientationAxesVisibility = 0
+
+sphere = Sphere(ThetaResolution=32, PhiResolution=32)
+Show(sphere, renderView)
+ResetCamera(renderView)
+
+# the sphere opens up along the animation so that every frame differs.
+scene = GetAnimationScene()
+scene.PlayMode = 'Sequence'
+scene.StartTime = 0
+scene.EndTime = 1
+scene.NumberOfFrames = numFrames
+track = GetAnimationTrack('EndTheta', proxy=sphere)
+track.KeyFrames = [CompositeKeyFrame(KeyTime=0, KeyValues=[30]),
+                   CompositeKeyFrame(KeyTime=1, KeyValues=[360])]
+
+def save(prefix, threads):
+    """Saves the animation and returns the names of the files written."""
+    directory = os.path.join(smtesting.TempDir, "SaveAnimationThreads")
+    if not os.path.isdir(directory):
+        os.makedirs(directory)
+    for name in os.listdir(directory):
+        if name.startswith(prefix + "."):
+            os.remove(os.path.join(directory, name))
+    SaveAnimation(os.path.join(directory, prefix + ".png"), renderView,
+                  ImageResolution=[200, 200], EncoderThreads=threads)
+    return sorted(os.path.join(directory, name) for name in os.listdir(directory)
+                  if name.startswith(prefix + "."))
+
+def read(filename):
+    with open(filename, "rb") as f:
+        return f.read()
+
+pm = servermanager.vtkProcessModule.GetProcessModule()
+inline = save("inline", 0)
+threaded = save("threaded", 3)
+if pm.GetPartitionId() == 0:
+    print(threaded)
+    expected = ["threaded.%04d.png" % i for i in range(numFrames)]
+    if [os.path.basename(name) for name in threaded] != expected:
+        raise RuntimeError("Unexpected files %s" % threaded)
+    if len(inline) != numFrames:
+        raise RuntimeError("Unexpected files %s" % inline)
+    if read(inline[0]) == read(inline[-1]):
+        raise RuntimeError("The frames of the animation do not differ")
+    for a, b in zip(inline, threaded):
+        if read(a) != read(b):
+            raise RuntimeError("%s differs from %s" % (b, a))
@@ -62,6 +62,7 @@ vtkPVGeneralSettings::vtkPVGeneralSettings()
   , GUIOverrideFont(false)
   , ColorByBlockColorsOnApply(true)
   , AnimationTimeNotation('g')
+  , UndoStackMemoryLimit(0)
 {
   this->SetDefaultViewType("RenderView");
 }
@@ -249,6 +250,7 @@ void vtkPVGeneralSettings::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "AnimationGeometryCacheLimit: " << this->AnimationGeometryCacheLimit << "\n";
   os << indent << "PropertiesPanelMode: " << this->PropertiesPanelMode << "\n";
   os << indent << "LockPanels: " << this->LockPanels << "\n";
+  os << indent << "UndoStackMemoryLimit: " << this->UndoStackMemoryLimit << "\n";
 }
 
 //----------------------------------------------------------------------------
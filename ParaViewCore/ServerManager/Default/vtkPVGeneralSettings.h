@@ -301,6 +301,16 @@ public:
   vtkGetMacro(ColorByBlockColorsOnApply, bool);
   //@}
 
+  //@{
+  /**
+   * Set the maximum memory, in megabytes (MB), used by the application wide
+   * undo stack. The oldest undo sets are removed when exceeded. 0 implies no
+   * limit. See vtkUndoStack::SetMaximumMemorySize().
+   */
+  vtkSetClampMacro(UndoStackMemoryLimit, int, 0, VTK_INT_MAX);
+  vtkGetMacro(UndoStackMemoryLimit, int);
+  //@}
+
 protected:
   vtkPVGeneralSettings();
   ~vtkPVGeneralSettings() override;
@@ -325,6 +335,7 @@ protected:
   int ConsoleFontSize;
   bool ColorByBlockColorsOnApply;
   char AnimationTimeNotation;
+  int UndoStackMemoryLimit;
 
 private:
   vtkPVGeneralSettings(const vtkPVGeneralSettings&) = delete;
@@ -16,6 +16,7 @@
 
 #include "vtkCSVExporter.h"
 #include "vtkObjectFactory.h"
+#include "vtkProcessModule.h"
 #include "vtkPVXYChartView.h"
 #include "vtkSMPropertyHelper.h"
 #include "vtkSMViewProxy.h"
@@ -52,6 +53,12 @@ bool vtkSMCSVExporterProxy::CanExport(vtkSMProxy* proxy)
 //----------------------------------------------------------------------------
 void vtkSMCSVExporterProxy::Write()
 {
+  // every time compartment runs the same script, only the first one writes.
+  if (vtkProcessModule::GetTimeCompartmentId() != 0)
+  {
+    return;
+  }
+
   this->CreateVTKObjects();
 
   vtkCSVExporter* exporter = vtkCSVExporter::SafeDownCast(this->GetClientSideObject());
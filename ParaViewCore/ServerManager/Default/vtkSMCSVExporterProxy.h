@@ -36,7 +36,8 @@ public:
   void PrintSelf(ostream& os, vtkIndent indent) override;
 
   /**
-   * Exports the view.
+   * Exports the view. When pvbatch runs with several time compartments, only
+   * the first one writes the file.
    */
   void Write() override;
 
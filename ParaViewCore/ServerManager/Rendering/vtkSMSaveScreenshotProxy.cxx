@@ -401,6 +401,13 @@ bool vtkSMSaveScreenshotProxy::WriteImage(const char* filename)
     return false;
   }
 
+  // every time compartment runs the same script, only the first one saves
+  // screenshots.
+  if (vtkProcessModule::GetTimeCompartmentId() != 0)
+  {
+    return true;
+  }
+
   auto format = this->GetFormatProxy(filename);
   if (!format)
   {
@@ -49,6 +49,9 @@ public:
   /**
    * Capture image. The properties for this proxy provide all the necessary
    * information to capture the image.
+   * When pvbatch runs with several time compartments, only the first one
+   * saves the image; the others return true without capturing it (see
+   * vtkProcessModule::GetTimeCompartmentId()).
    */
   virtual bool WriteImage(const char* filename);
 
@@ -231,6 +231,10 @@ void vtkInitializationHelper::Initialize(int argc, char** argv, int type, vtkPVO
 
   vtkProcessModule::GetProcessModule()->SetOptions(options);
 
+  // the time compartments have their own global controller, which must be set
+  // before any session is created.
+  vtkProcessModule::InitializeTimeCompartments(options->GetTimeCompartments());
+
   // this has to happen after process module is initialized and options have
   // been set.
   paraview_initialize();
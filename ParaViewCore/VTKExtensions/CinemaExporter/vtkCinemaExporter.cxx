@@ -17,6 +17,8 @@
 #include "vtkPythonInterpreter.h"
 #include "vtkStdString.h"
 
+#include <string>
+
 vtkStandardNewMacro(vtkCinemaExporter);
 
 vtkCinemaExporter::vtkCinemaExporter()
@@ -25,6 +27,9 @@ vtkCinemaExporter::vtkCinemaExporter()
   , ViewSelection(NULL)
   , TrackSelection(NULL)
   , ArraySelection(NULL)
+  , NumberOfWriterThreads(0)
+  , SkipExistingFiles(false)
+  , DistributeCameras(true)
 {
 }
 
@@ -83,13 +88,13 @@ const vtkStdString vtkCinemaExporter::GetPythonScript()
   script += "ready=True\n";
   script += "try:\n";
   script += "    import paraview.simple\n";
-  script += "    import paraview.tpl.cinema_python.adaptors.paraview.pv_introspect as pvi\n";
+  script += "    import paraview.detail.cinemaexport as cinemaexport\n";
   script += "except ImportError as e:\n";
   script += "    paraview.print_error('Cannot import cinema')\n";
   script += "    paraview.print_error(e)\n";
   script += "    ready=False\n";
   script += "if ready:\n";
-  script += "    pvi.export_scene(baseDirName=\"";
+  script += "    cinemaexport.export_scene(baseDirName=\"";
   script += this->FileName ? this->FileName : "";
   script += "\", viewSelection={";
   script += this->ViewSelection ? this->ViewSelection : "";
@@ -97,7 +102,13 @@ const vtkStdString vtkCinemaExporter::GetPythonScript()
   script += this->TrackSelection ? this->TrackSelection : "";
   script += "}, arraySelection={";
   script += this->ArraySelection ? this->ArraySelection : "";
-  script += "})\n";
+  script += "}, writerThreads=";
+  script += std::to_string(this->NumberOfWriterThreads);
+  script += ", skipExisting=";
+  script += this->SkipExistingFiles ? "True" : "False";
+  script += ", distributeCameras=";
+  script += this->DistributeCameras ? "True" : "False";
+  script += ")\n";
 
   return script;
 }
@@ -118,5 +129,9 @@ void vtkCinemaExporter::PrintSelf(ostream& os, vtkIndent indent)
   char const* arr = this->ArraySelection ? this->ArraySelection : "(null)";
   os << indent << "ArraySelection: " << arr << '\n';
 
+  os << indent << "NumberOfWriterThreads: " << this->NumberOfWriterThreads << '\n';
+  os << indent << "SkipExistingFiles: " << this->SkipExistingFiles << '\n';
+  os << indent << "DistributeCameras: " << this->DistributeCameras << '\n';
+
   os << indent << "PythonScript: " << this->GetPythonScript().c_str() << "\n";
 }
@@ -17,10 +17,17 @@
  * @brief   Exports a view as a Cinema database.
  *
  *
- * Specifies and runs a Python script which uses pv_introspect.py to generate
- * images from a set of parameters of the different elements in a pipeline for
- * later visualization. Takes different options from pqCinemaTrackSelection and
- * pqExportViewSelection as strings to be included in the script.
+ * Specifies and runs a Python script which uses pv_introspect.py, through
+ * paraview.detail.cinemaexport, to generate images from a set of parameters of
+ * the different elements in a pipeline for later visualization. Takes
+ * different options from pqCinemaTrackSelection and pqExportViewSelection as
+ * strings to be included in the script.
+ *
+ * The images are encoded and written by the threads of a
+ * vtkThreadedImageWriter while the next ones are rendered. An interrupted
+ * export can be resumed by leaving out the images already in the database.
+ * When pvbatch runs with --time-compartments, each compartment renders a share
+ * of the camera positions.
 */
 
 #ifndef vtkCinemaExporter_h
@@ -49,6 +56,36 @@ public:
   vtkSetStringMacro(ArraySelection);
   vtkGetStringMacro(ArraySelection);
 
+  //@{
+  /**
+   * Number of threads of the vtkThreadedImageWriter encoding and writing the
+   * images while the next ones are rendered. Default is 0, which keeps the
+   * number of threads the writer of cinema_python starts with.
+   */
+  vtkSetClampMacro(NumberOfWriterThreads, int, 0, VTK_INT_MAX);
+  vtkGetMacro(NumberOfWriterThreads, int);
+  //@}
+
+  //@{
+  /**
+   * When on, images whose file already exists are not rendered again, so that
+   * an interrupted export resumes where it stopped. Default is off.
+   */
+  vtkSetMacro(SkipExistingFiles, bool);
+  vtkGetMacro(SkipExistingFiles, bool);
+  vtkBooleanMacro(SkipExistingFiles, bool);
+  //@}
+
+  //@{
+  /**
+   * When on and pvbatch runs with several time compartments, each compartment
+   * renders a share of the camera positions. Default is on.
+   */
+  vtkSetMacro(DistributeCameras, bool);
+  vtkGetMacro(DistributeCameras, bool);
+  vtkBooleanMacro(DistributeCameras, bool);
+  //@}
+
 protected:
   vtkCinemaExporter();
   ~vtkCinemaExporter() override;
@@ -65,6 +102,12 @@ protected:
 
   char* ArraySelection;
 
+  int NumberOfWriterThreads;
+
+  bool SkipExistingFiles;
+
+  bool DistributeCameras;
+
 private:
   /// @brief Defines the Python script to be ran.
   const vtkStdString GetPythonScript();
@@ -72,6 +72,13 @@ public:
    */
   virtual bool Merge(vtkUndoElement* vtkNotUsed(new_element)) { return false; }
 
+  /**
+   * Returns an estimate of the memory used by this element, in bytes.
+   * vtkUndoStack uses it to enforce vtkUndoStack::MaximumMemorySize.
+   * Default implementation returns 0.
+   */
+  virtual size_t GetMemorySize() { return 0; }
+
   // Set the working context if run inside a UndoSet context, so object
   // that are cross referenced can leave long enough to be associated
   // to another object. Otherwise the undo of a Delete will create the object
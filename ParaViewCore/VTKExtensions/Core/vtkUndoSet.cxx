@@ -81,6 +81,19 @@ int vtkUndoSet::GetNumberOfElements()
   return this->Collection->GetNumberOfItems();
 }
 
+//-----------------------------------------------------------------------------
+size_t vtkUndoSet::GetMemorySize()
+{
+  size_t size = 0;
+  int max = this->Collection->GetNumberOfItems();
+  for (int cc = 0; cc < max; cc++)
+  {
+    vtkUndoElement* elem = vtkUndoElement::SafeDownCast(this->Collection->GetItemAsObject(cc));
+    size += elem ? elem->GetMemorySize() : 0;
+  }
+  return size;
+}
+
 //-----------------------------------------------------------------------------
 int vtkUndoSet::Redo()
 {
@@ -86,6 +86,12 @@ public:
    */
   int GetNumberOfElements();
 
+  /**
+   * Returns an estimate of the memory used by the elements in this set, in
+   * bytes. This is the sum of vtkUndoElement::GetMemorySize() for all elements.
+   */
+  size_t GetMemorySize();
+
 protected:
   vtkUndoSet();
   ~vtkUndoSet() override;
@@ -26,6 +26,7 @@ vtkUndoStack::vtkUndoStack()
   this->InUndo = false;
   this->InRedo = false;
   this->StackDepth = 10;
+  this->MaximumMemorySize = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -48,16 +49,29 @@ void vtkUndoStack::Push(const char* label, vtkUndoSet* changeSet)
 {
   this->Internal->RedoStack.clear();
 
-  while (this->Internal->UndoStack.size() >= static_cast<unsigned int>(this->StackDepth) &&
-    this->StackDepth > 0)
+  vtkUndoStackInternal::Element element(label, changeSet);
+  size_t memorySize =
+    vtkUndoStackInternal::GetMemorySize(this->Internal->UndoStack) + element.MemorySize;
+  while (!this->Internal->UndoStack.empty() &&
+    ((this->Internal->UndoStack.size() >= static_cast<unsigned int>(this->StackDepth) &&
+       this->StackDepth > 0) ||
+      (this->MaximumMemorySize > 0 && memorySize > this->MaximumMemorySize)))
   {
+    memorySize -= this->Internal->UndoStack.front().MemorySize;
     this->Internal->UndoStack.erase(this->Internal->UndoStack.begin());
     this->InvokeEvent(vtkUndoStack::UndoSetRemovedEvent);
   }
-  this->Internal->UndoStack.push_back(vtkUndoStackInternal::Element(label, changeSet));
+  this->Internal->UndoStack.push_back(element);
   this->Modified();
 }
 
+//-----------------------------------------------------------------------------
+size_t vtkUndoStack::GetMemorySize()
+{
+  return vtkUndoStackInternal::GetMemorySize(this->Internal->UndoStack) +
+    vtkUndoStackInternal::GetMemorySize(this->Internal->RedoStack);
+}
+
 //-----------------------------------------------------------------------------
 unsigned int vtkUndoStack::GetNumberOfUndoSets()
 {
@@ -181,4 +195,5 @@ void vtkUndoStack::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "InUndo: " << this->InUndo << endl;
   os << indent << "InRedo: " << this->InRedo << endl;
   os << indent << "StackDepth: " << this->StackDepth << endl;
+  os << indent << "MaximumMemorySize: " << this->MaximumMemorySize << endl;
 }
@@ -170,14 +170,33 @@ public:
    */
   vtkSetClampMacro(StackDepth, int, 1, 100);
   vtkGetMacro(StackDepth, int);
+  //@}
+
+  //@{
+  /**
+   * Get set the maximum memory, in bytes, that the sets on the undo stack may
+   * use, as reported by vtkUndoSet::GetMemorySize(). When pushing a new set
+   * would exceed this limit, the oldest entries are removed first, just as
+   * with StackDepth. The most recent set is always kept, even if it alone
+   * exceeds the limit. 0 (default) implies no limit.
+   */
+  vtkSetMacro(MaximumMemorySize, size_t);
+  vtkGetMacro(MaximumMemorySize, size_t);
+  //@}
+
+  /**
+   * Returns an estimate of the memory, in bytes, used by all sets on the undo
+   * and redo stacks.
+   */
+  size_t GetMemorySize();
 
 protected:
   vtkUndoStack();
   ~vtkUndoStack() override;
-  //@}
 
   vtkUndoStackInternal* Internal;
   int StackDepth;
+  size_t MaximumMemorySize;
 
 private:
   vtkUndoStack(const vtkUndoStack&) = delete;
@@ -25,6 +25,7 @@ public:
   {
     std::string Label;
     vtkSmartPointer<vtkUndoSet> UndoSet;
+    size_t MemorySize;
     Element(const char* label, vtkUndoSet* set)
     {
       this->Label = label;
@@ -33,11 +34,22 @@ public:
       {
         this->UndoSet->AddElement(set->GetElement(i));
       }
+      this->MemorySize = this->UndoSet->GetMemorySize();
     }
   };
   typedef std::vector<Element> VectorOfElements;
   VectorOfElements UndoStack;
   VectorOfElements RedoStack;
+
+  static size_t GetMemorySize(const VectorOfElements& elements)
+  {
+    size_t size = 0;
+    for (VectorOfElements::const_iterator iter = elements.begin(); iter != elements.end(); ++iter)
+    {
+      size += iter->MemorySize;
+    }
+    return size;
+  }
 };
 //****************************************************************************
 // VTK-HeaderTest-Exclude: vtkUndoStackInternal.h
@@ -19,11 +19,73 @@
 
 #include "vtkArrayCalculator.h"
 #include "vtkColorTransferFunction.h"
+#include "vtkDataArray.h"
 #include "vtkMPIController.h"
 #include "vtkRegressionTestImage.h"
 
 namespace
 {
+bool arraysAreIdentical(vtkDataArray* a, vtkDataArray* b)
+{
+  if (!a || !b || a->GetNumberOfTuples() != b->GetNumberOfTuples() ||
+    a->GetNumberOfComponents() != b->GetNumberOfComponents())
+  {
+    return false;
+  }
+  for (vtkIdType i = 0; i < a->GetNumberOfTuples(); ++i)
+  {
+    for (int c = 0; c < a->GetNumberOfComponents(); ++c)
+    {
+      if (a->GetComponent(i, c) != b->GetComponent(i, c))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void copyHaloFinderParameters(vtkPANLHaloFinder* source, vtkPANLHaloFinder* target)
+{
+  target->SetInputConnection(source->GetInputConnection(0, 0));
+  target->SetRL(source->GetRL());
+  target->SetParticleMass(source->GetParticleMass());
+  target->SetNP(source->GetNP());
+  target->SetPMin(source->GetPMin());
+  target->SetCenterFindingMode(source->GetCenterFindingMode());
+  target->SetOmegaDM(source->GetOmegaDM());
+  target->SetDeut(source->GetDeut());
+  target->SetHubble(source->GetHubble());
+}
+
+// Compares the halo tags, the FOF properties and the halo centers of both
+// finders.
+bool outputsAreIdentical(vtkPANLHaloFinder* a, vtkPANLHaloFinder* b)
+{
+  const char* particleArrays[] = { "fof_halo_tag", nullptr };
+  const char* haloArrays[] = { "fof_halo_tag", "fof_halo_count", "fof_halo_mass", "fof_halo_com",
+    "fof_center", nullptr };
+  for (int cc = 0; particleArrays[cc]; ++cc)
+  {
+    if (!arraysAreIdentical(a->GetOutput(0)->GetPointData()->GetArray(particleArrays[cc]),
+          b->GetOutput(0)->GetPointData()->GetArray(particleArrays[cc])))
+    {
+      std::cerr << "Particle array " << particleArrays[cc] << " differs." << std::endl;
+      return false;
+    }
+  }
+  for (int cc = 0; haloArrays[cc]; ++cc)
+  {
+    if (!arraysAreIdentical(a->GetOutput(1)->GetPointData()->GetArray(haloArrays[cc]),
+          b->GetOutput(1)->GetPointData()->GetArray(haloArrays[cc])))
+    {
+      std::cerr << "Halo array " << haloArrays[cc] << " differs." << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
 int runHaloFinderTest(int argc, char* argv[])
 {
   HaloFinderTestHelpers::HaloFinderTestVTKObjects to =
@@ -44,6 +106,24 @@ int runHaloFinderTest(int argc, char* argv[])
     return 0;
   }
 
+  // The serial halo and center finders must give exactly the same results as
+  // the threaded ones. The number of threads is set explicitly so that the
+  // threaded friends-of-friends linking runs whatever the hardware.
+  vtkNew<vtkPANLHaloFinder> serialFinder;
+  copyHaloFinderParameters(to.haloFinder.GetPointer(), serialFinder.GetPointer());
+  serialFinder->SetNumberOfThreads(1);
+  serialFinder->Update();
+  vtkNew<vtkPANLHaloFinder> threadedFinder;
+  copyHaloFinderParameters(to.haloFinder.GetPointer(), threadedFinder.GetPointer());
+  threadedFinder->SetNumberOfThreads(4);
+  threadedFinder->Update();
+  if (!outputsAreIdentical(serialFinder.GetPointer(), threadedFinder.GetPointer()) ||
+    !outputsAreIdentical(serialFinder.GetPointer(), to.haloFinder.GetPointer()))
+  {
+    std::cerr << "Error at line: " << __LINE__ << std::endl;
+    return 0;
+  }
+
   vtkNew<vtkArrayCalculator> calc;
   calc->SetInputConnection(to.haloFinder->GetOutputPort(1));
   calc->SetResultArrayName("Result");
@@ -25,6 +25,8 @@
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPoints.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPTools.h"
 #include "vtkTypeInt64Array.h"
 #include "vtkUnstructuredGrid.h"
 
@@ -219,6 +221,7 @@ vtkStandardNewMacro(vtkPANLHaloFinder)
   this->MinCandidateSize = 200;
   this->NumSPHNeighbors = 64;
   this->NumNeighbors = 20;
+  this->NumberOfThreads = 0;
 
   this->CenterFindingMode = NONE;
   this->SmoothingLength = 0.0;
@@ -373,6 +376,7 @@ void vtkPANLHaloFinder::ExecuteHaloFinder(
   this->Internal->haloFinder = new cosmotk::CosmoHaloFinderP();
   this->Internal->haloFinder->setParameters(
     "", this->RL, this->DeadSize, this->NP, this->PMin, this->BB, this->NMin);
+  this->Internal->haloFinder->setNumberOfThreads(this->NumberOfThreads);
   this->Internal->haloFinder->setParticles(this->Internal->xx.size(), &this->Internal->xx[0],
     &this->Internal->yy[0], &this->Internal->zz[0], &this->Internal->vx[0], &this->Internal->vy[0],
     &this->Internal->vz[0], &this->Internal->potential[0], &this->Internal->tag[0],
@@ -657,7 +661,9 @@ void vtkPANLHaloFinder::ExecuteSubHaloFinder(
 void vtkPANLHaloFinder::FindCenters(
   vtkUnstructuredGrid* allParticles, vtkUnstructuredGrid* fofProperties)
 {
-  if (this->CenterFindingMode == vtkPANLHaloFinder::NONE)
+  if (this->CenterFindingMode != MOST_BOUND_PARTICLE &&
+    this->CenterFindingMode != MOST_CONNECTED_PARTICLE &&
+    this->CenterFindingMode != HIST_CENTER_FINDING)
   {
     return;
   }
@@ -672,55 +678,66 @@ void vtkPANLHaloFinder::FindCenters(
   centers->SetNumberOfComponents(3);
   centers->SetNumberOfTuples(numberOfFOFHalos);
 
-  ExtractHalo haloData(numberOfFOFHalos, fofHaloCount, this->Internal->fof);
-  for (int halo = 0; halo < numberOfFOFHalos; ++halo)
-  {
-    haloData.SetCurrentHalo(halo);
-    cosmotk::HaloCenterFinder centerFinder;
-    haloData.SetParticles(centerFinder);
-    centerFinder.setParameters(this->BB, this->SmoothingLength, this->DistanceConvertFactor,
-      this->RL, this->NP, OmegaMatter, OmegaCB, this->Hubble, this->RedShift);
-    int centerIndex = -1;
-    if (this->CenterFindingMode == MOST_BOUND_PARTICLE)
+  // Halos are independent so each thread extracts the halos it is given into
+  // its own buffers and writes their centers at the halo index.
+  ExtractHalo exemplar(numberOfFOFHalos, fofHaloCount, this->Internal->fof);
+  vtkSMPThreadLocal<ExtractHalo> haloDataTL(exemplar);
+  auto findCenters = [&](vtkIdType begin, vtkIdType end) {
+    ExtractHalo& haloData = haloDataTL.Local();
+    for (vtkIdType halo = begin; halo < end; ++halo)
     {
-      float minPotential;
-      if (haloData.GetNumberOfParticlesInCurrentHalo() < MBP_THRESHOLD)
+      haloData.SetCurrentHalo(static_cast<int>(halo));
+      cosmotk::HaloCenterFinder centerFinder;
+      haloData.SetParticles(centerFinder);
+      centerFinder.setParameters(this->BB, this->SmoothingLength, this->DistanceConvertFactor,
+        this->RL, this->NP, OmegaMatter, OmegaCB, this->Hubble, this->RedShift);
+      int centerIndex = -1;
+      if (this->CenterFindingMode == MOST_BOUND_PARTICLE)
       {
-        centerIndex = centerFinder.mostBoundParticleN2(&minPotential);
+        float minPotential;
+        if (haloData.GetNumberOfParticlesInCurrentHalo() < MBP_THRESHOLD)
+        {
+          centerIndex = centerFinder.mostBoundParticleN2(&minPotential);
+        }
+        else
+        {
+          centerIndex = centerFinder.mostBoundParticleAStar(&minPotential);
+        }
       }
-      else
+      else if (this->CenterFindingMode == MOST_CONNECTED_PARTICLE)
       {
-        centerIndex = centerFinder.mostBoundParticleAStar(&minPotential);
+        if (haloData.GetNumberOfParticlesInCurrentHalo() < MCP_THRESHOLD)
+        {
+          centerIndex = centerFinder.mostConnectedParticleN2();
+        }
+        else
+        {
+          centerIndex = centerFinder.mostConnectedParticleChainMesh();
+        }
       }
-    }
-    else if (this->CenterFindingMode == MOST_CONNECTED_PARTICLE)
-    {
-      if (haloData.GetNumberOfParticlesInCurrentHalo() < MCP_THRESHOLD)
+      else
       {
-        centerIndex = centerFinder.mostConnectedParticleN2();
+        centerIndex = centerFinder.mostConnectedParticleHist();
       }
-      else
+      float center[] = { 0.0, 0.0, 0.0 };
+      if (centerIndex >= 0)
       {
-        centerIndex = centerFinder.mostConnectedParticleChainMesh();
+        double point[3];
+        allParticles->GetPoint(haloData.GetActualIndex(centerIndex), point);
+        center[0] = point[0];
+        center[1] = point[1];
+        center[2] = point[2];
       }
+      centers->SetTypedTuple(halo, center);
     }
-    else if (this->CenterFindingMode == HIST_CENTER_FINDING)
-    {
-      centerIndex = centerFinder.mostConnectedParticleHist();
-    }
-    else
-    {
-      return;
-    }
-    float center[] = { 0.0, 0.0, 0.0 };
-    if (centerIndex >= 0)
-    {
-      double* point = allParticles->GetPoint(haloData.GetActualIndex(centerIndex));
-      center[0] = point[0];
-      center[1] = point[1];
-      center[2] = point[2];
-    }
-    centers->SetTypedTuple(halo, center);
+  };
+  if (this->NumberOfThreads == 1)
+  {
+    findCenters(0, numberOfFOFHalos);
+  }
+  else
+  {
+    vtkSMPTools::For(0, numberOfFOFHalos, findCenters);
   }
   fofProperties->GetPointData()->AddArray(centers.GetPointer());
 }
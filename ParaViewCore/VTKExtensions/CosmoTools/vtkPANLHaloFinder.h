@@ -187,6 +187,17 @@ class VTKPVVTKEXTENSIONSCOSMOTOOLS_EXPORT vtkPANLHaloFinder : public vtkUnstruct
     vtkSetMacro(NumNeighbors, int) vtkGetMacro(NumNeighbors, int)
     //@}
 
+    //@{
+    /**
+     * Gets/Sets the number of threads used to link particles into halos on
+     * each rank.  0 uses all hardware threads and 1 runs the serial k-d tree
+     * halo finder and finds centers serially.  The halos found do not depend
+     * on this setting.
+     * Default: 0
+     */
+    vtkSetClampMacro(NumberOfThreads, int, 0, VTK_INT_MAX) vtkGetMacro(NumberOfThreads, int)
+    //@}
+
     enum CenterFindingType {
       NONE = 0,
       MOST_BOUND_PARTICLE = 1,
@@ -277,6 +288,7 @@ class VTKPVVTKEXTENSIONSCOSMOTOOLS_EXPORT vtkPANLHaloFinder : public vtkUnstruct
   int MinCandidateSize;
   int NumSPHNeighbors;
   int NumNeighbors;
+  int NumberOfThreads;
 
   bool RunSubHaloFinder;
 
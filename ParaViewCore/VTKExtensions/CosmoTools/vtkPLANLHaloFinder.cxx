@@ -82,6 +82,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPoints.h"
+#include "vtkSMPTools.h"
 #include "vtkSmartPointer.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkUnsignedCharArray.h"
@@ -214,6 +215,7 @@ vtkPLANLHaloFinder::vtkPLANLHaloFinder()
   this->SODBins = cosmotk::NUM_SOD_BINS;
   this->MinFOFSize = cosmotk::MIN_SOD_SIZE;
   this->MinFOFMass = cosmotk::MIN_SOD_MASS;
+  this->NumberOfThreads = 0;
 
   this->Particles = new HaloFinderInternals::ParticleData();
   this->Halos = new HaloFinderInternals::HaloData();
@@ -580,6 +582,7 @@ void vtkPLANLHaloFinder::ComputeFOFHalos(
 
   // STEP 2: Initialize halo-finder parameters
   this->HaloFinder->setParameters("", this->RL, this->Overlap, this->NP, this->PMin, this->BB);
+  this->HaloFinder->setNumberOfThreads(this->NumberOfThreads);
   this->HaloFinder->setParticles(this->Particles->xx.size(), &this->Particles->xx[0],
     &this->Particles->yy[0], &this->Particles->zz[0], &this->Particles->vx[0],
     &this->Particles->vy[0], &this->Particles->vz[0], &this->Particles->potential[0],
@@ -625,15 +628,39 @@ void vtkPLANLHaloFinder::ComputeFOFHalos(
   double* haloVelDisp = static_cast<double*>(PD->GetArray("VelocityDispersion")->GetVoidPointer(0));
   int* haloId = static_cast<int*>(PD->GetArray("HaloID")->GetVoidPointer(0));
 
-  double center[3];
+  if (this->CenterFindingMethod < 0 ||
+    this->CenterFindingMethod >= NUMBER_OF_CENTER_FINDING_METHODS)
+  {
+    vtkErrorMacro("Undefined center-finding method!");
+  }
+
+  // Halos own disjoint sets of particles so they are marked and their centers
+  // found concurrently, the centers are then stored in halo order.
+  vtkIdType numberOfExtractedHalos = static_cast<vtkIdType>(this->Halos->ExtractedHalos.size());
+  std::vector<double> centers(3 * numberOfExtractedHalos, 0.0);
+  auto markHalos = [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType halo = begin; halo < end; ++halo)
+    {
+      int haloIdx = this->Halos->ExtractedHalos[halo];
+      assert("pre: haloIdx is out-of-bounds!" && (haloIdx >= 0) &&
+        (haloIdx < static_cast<int>(this->Halos->fofMass.size())));
+      this->MarkHaloParticlesAndGetCenter(
+        static_cast<unsigned int>(halo), haloIdx, &centers[3 * halo], particles);
+    }
+  };
+  if (this->NumberOfThreads == 1)
+  {
+    markHalos(0, numberOfExtractedHalos);
+  }
+  else
+  {
+    vtkSMPTools::For(0, numberOfExtractedHalos, markHalos);
+  }
+
   for (unsigned int halo = 0; halo < this->Halos->ExtractedHalos.size(); ++halo)
   {
     int haloIdx = this->Halos->ExtractedHalos[halo];
-    assert("pre: haloIdx is out-of-bounds!" && (haloIdx >= 0) &&
-      (haloIdx < static_cast<int>(this->Halos->fofMass.size())));
-
-    this->MarkHaloParticlesAndGetCenter(halo, haloIdx, center, particles);
-    pnts->SetPoint(halo, center);
+    pnts->SetPoint(halo, &centers[3 * halo]);
 
     haloMass[halo] = this->Halos->fofMass[haloIdx];
     haloVelDisp[halo] = this->Halos->fofVelDisp[haloIdx];
@@ -750,7 +777,8 @@ void vtkPLANLHaloFinder::MarkHaloParticlesAndGetCenter(const unsigned int halo,
     }
     break;
     default:
-      vtkErrorMacro("Undefined center-finding method!");
+      // reported once by the caller
+      break;
   }
 
   delete[] xLocHalo;
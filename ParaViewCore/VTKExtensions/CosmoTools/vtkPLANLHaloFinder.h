@@ -245,6 +245,17 @@ public:
   vtkGetMacro(MinFOFMass, float);
   //@}
 
+  //@{
+  /**
+   * Specify the number of threads used on each rank to link particles into
+   * halos and to find their centers. 0 uses all hardware threads and 1 runs
+   * serially. The halos found do not depend on this setting.
+   * (default 0)
+   */
+  vtkSetClampMacro(NumberOfThreads, int, 0, VTK_INT_MAX);
+  vtkGetMacro(NumberOfThreads, int);
+  //@}
+
 protected:
   vtkPLANLHaloFinder();
   ~vtkPLANLHaloFinder();
@@ -321,6 +332,7 @@ protected:
   int SODBins;           // Number of log scale bins for SOD (20)
   int MinFOFSize;        // Minimum FOF size for SOD (1000)
   float MinFOFMass;      // Minimum FOF mass for SOD (5.0e12)
+  int NumberOfThreads;   // Threads used per rank, 0 for all (0)
 
   HaloFinderInternals::ParticleData* Particles;
   HaloFinderInternals::HaloData* Halos;
@@ -0,0 +1,275 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestAMRConnectivity.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkAMRConnectivity.h"
+#include "vtkCellData.h"
+#include "vtkCommunicator.h"
+#include "vtkDataArray.h"
+#include "vtkDataSetAttributes.h"
+#include "vtkDummyController.h"
+#include "vtkHierarchicalFractal.h"
+#include "vtkIdTypeArray.h"
+#include "vtkNew.h"
+#include "vtkNonOverlappingAMR.h"
+#include "vtkUniformGrid.h"
+#include "vtkUnsignedCharArray.h"
+
+#if VTK_MODULE_ENABLE_VTK_ParallelMPI
+#include "vtkMPIController.h"
+#endif
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <set>
+
+namespace
+{
+const char* VolumeName = "Fractal Volume Fraction";
+const char* RegionName = "RegionId-Fractal Volume Fraction";
+const double SurfaceValue = 0.5;
+
+typedef std::array<vtkIdType, 3> CellKey;
+typedef std::map<CellKey, vtkIdType> CellRegions;
+
+// Checks the region ids of a block: the cells above the surface value are in a
+// region and the others, as well as the ghost cells, are not. Cells of a region
+// that share a face have the same id.
+bool CheckBlock(vtkUniformGrid* grid)
+{
+  vtkDataArray* volume = grid->GetCellData()->GetArray(VolumeName);
+  vtkIdTypeArray* regions =
+    vtkIdTypeArray::SafeDownCast(grid->GetCellData()->GetArray(RegionName));
+  vtkUnsignedCharArray* ghosts = grid->GetCellGhostArray();
+  if (!volume || !regions || !ghosts ||
+    regions->GetNumberOfTuples() != grid->GetNumberOfCells())
+  {
+    cerr << "ERROR: missing cell arrays." << endl;
+    return false;
+  }
+
+  int dims[3];
+  grid->GetDimensions(dims);
+  const vtkIdType cellDims[3] = { std::max(dims[0] - 1, 1), std::max(dims[1] - 1, 1),
+    std::max(dims[2] - 1, 1) };
+  const vtkIdType strides[3] = { 1, cellDims[0], cellDims[0] * cellDims[1] };
+  vtkIdType cellId = 0;
+  for (vtkIdType k = 0; k < cellDims[2]; k++)
+  {
+    for (vtkIdType j = 0; j < cellDims[1]; j++)
+    {
+      for (vtkIdType i = 0; i < cellDims[0]; i++, cellId++)
+      {
+        const bool inRegion = volume->GetComponent(cellId, 0) > SurfaceValue &&
+          (ghosts->GetValue(cellId) & vtkDataSetAttributes::DUPLICATECELL) == 0;
+        const vtkIdType region = regions->GetValue(cellId);
+        if (inRegion != (region > 0) || region < 0)
+        {
+          cerr << "ERROR: cell " << cellId << " has region id " << region << "." << endl;
+          return false;
+        }
+        const vtkIdType ijk[3] = { i, j, k };
+        for (int dir = 0; dir < 3; dir++)
+        {
+          if (region > 0 && ijk[dir] + 1 < cellDims[dir])
+          {
+            const vtkIdType neighbor = regions->GetValue(cellId + strides[dir]);
+            if (neighbor > 0 && neighbor != region)
+            {
+              cerr << "ERROR: neighboring cells " << cellId << " and " << cellId + strides[dir]
+                   << " have region ids " << region << " and " << neighbor << "." << endl;
+              return false;
+            }
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Identifies the fragments of this process' share of a hierarchical fractal,
+// checks the region ids of every local block and appends the (level, index,
+// cell, region id) of their cells to records.
+bool FindFragments(vtkMultiProcessController* controller, bool resolveBlocks,
+  vtkIdTypeArray* records)
+{
+  vtkNew<vtkHierarchicalFractal> fractal;
+  fractal->SetMaximumLevel(4);
+  fractal->SetDimensions(8);
+  fractal->SetGhostLevels(1);
+  fractal->UpdatePiece(controller->GetLocalProcessId(), controller->GetNumberOfProcesses(), 0);
+
+  vtkNew<vtkNonOverlappingAMR> volume;
+  volume->ShallowCopy(fractal->GetOutputDataObject(0));
+
+  vtkNew<vtkAMRConnectivity> connectivity;
+  connectivity->SetInputData(volume.GetPointer());
+  connectivity->AddInputVolumeArrayToProcess(VolumeName);
+  connectivity->SetVolumeFractionSurfaceValue(SurfaceValue);
+  connectivity->SetResolveBlocks(resolveBlocks);
+  connectivity->Update();
+
+  vtkNonOverlappingAMR* output =
+    vtkNonOverlappingAMR::SafeDownCast(connectivity->GetOutputDataObject(0));
+  if (!output)
+  {
+    cerr << "ERROR: no output." << endl;
+    return false;
+  }
+  bool valid = true;
+  for (unsigned int level = 0; level < output->GetNumberOfLevels(); level++)
+  {
+    for (unsigned int index = 0; index < output->GetNumberOfDataSets(level); index++)
+    {
+      vtkUniformGrid* grid = output->GetDataSet(level, index);
+      if (!grid)
+      {
+        continue;
+      }
+      valid = CheckBlock(grid) && valid;
+      vtkIdTypeArray* regions =
+        vtkIdTypeArray::SafeDownCast(grid->GetCellData()->GetArray(RegionName));
+      for (vtkIdType cellId = 0; regions && cellId < regions->GetNumberOfTuples(); cellId++)
+      {
+        records->InsertNextValue(level);
+        records->InsertNextValue(index);
+        records->InsertNextValue(cellId);
+        records->InsertNextValue(regions->GetValue(cellId));
+      }
+    }
+  }
+  return valid;
+}
+
+CellRegions GetCellRegions(vtkIdTypeArray* records)
+{
+  CellRegions regions;
+  const vtkIdType* values = records->GetPointer(0);
+  for (vtkIdType i = 0; i + 3 < records->GetNumberOfTuples(); i += 4)
+  {
+    regions[CellKey{ { values[i], values[i + 1], values[i + 2] } }] = values[i + 3];
+  }
+  return regions;
+}
+
+size_t GetNumberOfRegions(const CellRegions& regions)
+{
+  std::set<vtkIdType> ids;
+  for (const auto& cell : regions)
+  {
+    if (cell.second > 0)
+    {
+      ids.insert(cell.second);
+    }
+  }
+  return ids.size();
+}
+
+// Returns true if every region of fine is within a single region of coarse,
+// whatever their ids. When bijective is true, the regions must be the same.
+bool IsRefinementOf(const CellRegions& fine, const CellRegions& coarse, bool bijective)
+{
+  if (fine.size() != coarse.size())
+  {
+    cerr << "ERROR: " << fine.size() << " cells instead of " << coarse.size() << "." << endl;
+    return false;
+  }
+  std::map<vtkIdType, vtkIdType> fineToCoarse;
+  std::map<vtkIdType, vtkIdType> coarseToFine;
+  for (auto f = fine.begin(), c = coarse.begin(); f != fine.end(); ++f, ++c)
+  {
+    if (f->first != c->first || (f->second > 0) != (c->second > 0))
+    {
+      cerr << "ERROR: cells are labeled differently." << endl;
+      return false;
+    }
+    if (f->second > 0 &&
+      (fineToCoarse.insert(std::make_pair(f->second, c->second)).first->second != c->second ||
+        (bijective &&
+          coarseToFine.insert(std::make_pair(c->second, f->second)).first->second != f->second)))
+    {
+      cerr << "ERROR: cell (" << f->first[0] << ", " << f->first[1] << ", " << f->first[2]
+           << ") is in region " << f->second << " and " << c->second << "." << endl;
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+int TestAMRConnectivity(int argc, char* argv[])
+{
+#if VTK_MODULE_ENABLE_VTK_ParallelMPI
+  vtkNew<vtkMPIController> controller;
+  controller->Initialize(&argc, &argv);
+#else
+  (void)argc;
+  (void)argv;
+  vtkNew<vtkDummyController> controller;
+#endif
+  vtkMultiProcessController::SetGlobalController(controller.GetPointer());
+  const int rank = controller->GetLocalProcessId();
+
+  // The reference is computed by the first process alone, with and without
+  // resolving the regions across blocks.
+  int status = EXIT_SUCCESS;
+  vtkNew<vtkIdTypeArray> serial;
+  vtkNew<vtkIdTypeArray> unresolved;
+  if (rank == 0)
+  {
+    vtkNew<vtkDummyController> dummy;
+    vtkMultiProcessController::SetGlobalController(dummy.GetPointer());
+    if (!FindFragments(dummy.GetPointer(), true, serial.GetPointer()) ||
+      !FindFragments(dummy.GetPointer(), false, unresolved.GetPointer()))
+    {
+      status = EXIT_FAILURE;
+    }
+    vtkMultiProcessController::SetGlobalController(controller.GetPointer());
+  }
+
+  vtkNew<vtkIdTypeArray> local;
+  vtkNew<vtkIdTypeArray> parallel;
+  int valid = FindFragments(controller.GetPointer(), true, local.GetPointer()) ? 1 : 0;
+  int allValid = 0;
+  controller->Reduce(&valid, &allValid, 1, vtkCommunicator::MIN_OP, 0);
+  controller->GatherV(local.GetPointer(), parallel.GetPointer(), 0);
+
+  if (rank == 0)
+  {
+    const CellRegions serialRegions = GetCellRegions(serial.GetPointer());
+    const CellRegions unresolvedRegions = GetCellRegions(unresolved.GetPointer());
+    const CellRegions parallelRegions = GetCellRegions(parallel.GetPointer());
+    const size_t numRegions = GetNumberOfRegions(serialRegions);
+    const size_t numUnresolved = GetNumberOfRegions(unresolvedRegions);
+    const size_t numParallel = GetNumberOfRegions(parallelRegions);
+    cout << numRegions << " regions (" << numUnresolved << " within blocks), " << numParallel
+         << " on " << controller->GetNumberOfProcesses() << " processes." << endl;
+
+    // Resolving merges the regions that touch across blocks, so it must
+    // coarsen the regions found within blocks. Running on several processes
+    // must find the same regions as the serial run.
+    if (!allValid || numRegions == 0 || numRegions >= numUnresolved ||
+      !IsRefinementOf(unresolvedRegions, serialRegions, false) || numParallel != numRegions ||
+      !IsRefinementOf(parallelRegions, serialRegions, true))
+    {
+      status = EXIT_FAILURE;
+    }
+  }
+  controller->Broadcast(&status, 1, 0);
+
+  vtkMultiProcessController::SetGlobalController(nullptr);
+  controller->Finalize();
+  return status;
+}
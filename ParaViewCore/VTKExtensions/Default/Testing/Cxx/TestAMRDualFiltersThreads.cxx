@@ -0,0 +1,184 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestAMRDualFiltersThreads.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// vtkAMRDualContour and vtkAMRDualClip process the blocks in parallel and
+// then merge the points shared by neighbor blocks in block order, so their
+// output must not depend on the number of threads.
+#include "vtkAMRDualClip.h"
+#include "vtkAMRDualContour.h"
+#include "vtkDataArray.h"
+#include "vtkDataObject.h"
+#include "vtkDataSet.h"
+#include "vtkDummyController.h"
+#include "vtkHierarchicalFractal.h"
+#include "vtkIdList.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkMultiPieceDataSet.h"
+#include "vtkNew.h"
+#include "vtkNonOverlappingAMR.h"
+#include "vtkPointData.h"
+#include "vtkSMPTools.h"
+#include "vtkSmartPointer.h"
+
+#define TASSERT(x)                                                                                 \
+  if (!(x))                                                                                        \
+  {                                                                                                \
+    cerr << "ERROR: failed at " << __LINE__ << "!" << endl;                                        \
+    return EXIT_FAILURE;                                                                           \
+  }
+
+namespace
+{
+// Runs a new filter on volume with the given number of threads and returns a
+// copy of its mesh.
+template <class Filter>
+vtkSmartPointer<vtkDataSet> RunDualFilter(
+  vtkNonOverlappingAMR* volume, int numberOfThreads, bool mergePoints)
+{
+  vtkSMPTools::Initialize(numberOfThreads);
+  vtkNew<Filter> filter;
+  filter->SetInputData(volume);
+  filter->SetInputArrayToProcess(
+    0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_CELLS, "Fractal Volume Fraction");
+  filter->SetIsoValue(0.5);
+  filter->SetEnableMergePoints(mergePoints ? 1 : 0);
+  filter->Update();
+
+  vtkMultiBlockDataSet* output = vtkMultiBlockDataSet::SafeDownCast(filter->GetOutputDataObject(0));
+  vtkMultiPieceDataSet* pieces =
+    vtkMultiPieceDataSet::SafeDownCast(output ? output->GetBlock(0) : nullptr);
+  vtkDataSet* mesh = pieces ? pieces->GetPiece(0) : nullptr;
+  if (!mesh)
+  {
+    return nullptr;
+  }
+  vtkSmartPointer<vtkDataSet> copy;
+  copy.TakeReference(mesh->NewInstance());
+  copy->DeepCopy(mesh);
+  return copy;
+}
+
+bool SameArrays(vtkDataArray* a, vtkDataArray* b)
+{
+  if (!a || !b || a->GetNumberOfTuples() != b->GetNumberOfTuples() ||
+    a->GetNumberOfComponents() != b->GetNumberOfComponents())
+  {
+    return false;
+  }
+  for (vtkIdType tuple = 0; tuple < a->GetNumberOfTuples(); tuple++)
+  {
+    for (int comp = 0; comp < a->GetNumberOfComponents(); comp++)
+    {
+      if (a->GetComponent(tuple, comp) != b->GetComponent(tuple, comp))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Returns true if both meshes have the same points, in the same order, the same
+// cells and the same point data.
+bool SameMeshes(vtkDataSet* a, vtkDataSet* b)
+{
+  if (!a || !b || a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+    a->GetNumberOfCells() != b->GetNumberOfCells())
+  {
+    cerr << "ERROR: different number of points or cells." << endl;
+    return false;
+  }
+  for (vtkIdType ptId = 0; ptId < a->GetNumberOfPoints(); ptId++)
+  {
+    double pa[3], pb[3];
+    a->GetPoint(ptId, pa);
+    b->GetPoint(ptId, pb);
+    if (pa[0] != pb[0] || pa[1] != pb[1] || pa[2] != pb[2])
+    {
+      cerr << "ERROR: point " << ptId << " differs." << endl;
+      return false;
+    }
+  }
+  vtkNew<vtkIdList> idsA;
+  vtkNew<vtkIdList> idsB;
+  for (vtkIdType cellId = 0; cellId < a->GetNumberOfCells(); cellId++)
+  {
+    a->GetCellPoints(cellId, idsA.GetPointer());
+    b->GetCellPoints(cellId, idsB.GetPointer());
+    bool same = a->GetCellType(cellId) == b->GetCellType(cellId) &&
+      idsA->GetNumberOfIds() == idsB->GetNumberOfIds();
+    for (vtkIdType i = 0; same && i < idsA->GetNumberOfIds(); i++)
+    {
+      same = idsA->GetId(i) == idsB->GetId(i);
+    }
+    if (!same)
+    {
+      cerr << "ERROR: cell " << cellId << " differs." << endl;
+      return false;
+    }
+  }
+  vtkPointData* pdA = a->GetPointData();
+  vtkPointData* pdB = b->GetPointData();
+  if (pdA->GetNumberOfArrays() != pdB->GetNumberOfArrays())
+  {
+    cerr << "ERROR: different point arrays." << endl;
+    return false;
+  }
+  for (int idx = 0; idx < pdA->GetNumberOfArrays(); idx++)
+  {
+    vtkDataArray* array = pdA->GetArray(idx);
+    if (array && !SameArrays(array, pdB->GetArray(array->GetName())))
+    {
+      cerr << "ERROR: point array " << array->GetName() << " differs." << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class Filter>
+bool CompareThreads(vtkNonOverlappingAMR* volume, bool mergePoints)
+{
+  vtkSmartPointer<vtkDataSet> serial = RunDualFilter<Filter>(volume, 1, mergePoints);
+  vtkSmartPointer<vtkDataSet> threaded = RunDualFilter<Filter>(volume, 4, mergePoints);
+  if (!serial || serial->GetNumberOfCells() == 0)
+  {
+    cerr << "ERROR: empty output." << endl;
+    return false;
+  }
+  return SameMeshes(serial, threaded);
+}
+}
+
+int TestAMRDualFiltersThreads(int, char* [])
+{
+  vtkNew<vtkDummyController> controller;
+  vtkMultiProcessController::SetGlobalController(controller.GetPointer());
+
+  vtkNew<vtkHierarchicalFractal> fractal;
+  fractal->SetMaximumLevel(4);
+  fractal->SetDimensions(8);
+  fractal->SetGhostLevels(1);
+  fractal->Update();
+  vtkNew<vtkNonOverlappingAMR> volume;
+  volume->ShallowCopy(fractal->GetOutputDataObject(0));
+
+  TASSERT(CompareThreads<vtkAMRDualContour>(volume.GetPointer(), true));
+  TASSERT(CompareThreads<vtkAMRDualContour>(volume.GetPointer(), false));
+  TASSERT(CompareThreads<vtkAMRDualClip>(volume.GetPointer(), true));
+  TASSERT(CompareThreads<vtkAMRDualClip>(volume.GetPointer(), false));
+
+  vtkMultiProcessController::SetGlobalController(nullptr);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestAMRDualGridReuse.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// The AMR dual filters keep their vtkAMRDualGridHelper between requests and
+// only swap the block images in when the AMR layout did not change. Updating
+// them again after the input values or the options changed must give the same
+// output as a new filter.
+#include "vtkAMRConnectivity.h"
+#include "vtkAMRDualClip.h"
+#include "vtkAMRDualContour.h"
+#include "vtkCellData.h"
+#include "vtkCompositeDataIterator.h"
+#include "vtkCompositeDataSet.h"
+#include "vtkDataArray.h"
+#include "vtkDataObject.h"
+#include "vtkDataSet.h"
+#include "vtkDummyController.h"
+#include "vtkHierarchicalFractal.h"
+#include "vtkNew.h"
+#include "vtkNonOverlappingAMR.h"
+#include "vtkSmartPointer.h"
+#include "vtkUniformGrid.h"
+
+#include <array>
+
+#define TASSERT(x)                                                                                 \
+  if (!(x))                                                                                        \
+  {                                                                                                \
+    cerr << "ERROR: failed at " << __LINE__ << "!" << endl;                                        \
+    return EXIT_FAILURE;                                                                           \
+  }
+
+namespace
+{
+const char* VolumeName = "Fractal Volume Fraction";
+
+// Number of points, number of cells, sum of the point coordinates and sum of
+// the cell values of the given array over all the leaves of the output.
+typedef std::array<double, 4> Signature;
+
+Signature GetSignature(vtkDataObject* output, const char* arrayName)
+{
+  Signature signature = { { 0, 0, 0, 0 } };
+  vtkCompositeDataSet* composite = vtkCompositeDataSet::SafeDownCast(output);
+  if (!composite)
+  {
+    return signature;
+  }
+  vtkSmartPointer<vtkCompositeDataIterator> iter;
+  iter.TakeReference(composite->NewIterator());
+  for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
+  {
+    vtkDataSet* ds = vtkDataSet::SafeDownCast(iter->GetCurrentDataObject());
+    if (!ds)
+    {
+      continue;
+    }
+    signature[0] += ds->GetNumberOfPoints();
+    signature[1] += ds->GetNumberOfCells();
+    for (vtkIdType ptId = 0; ptId < ds->GetNumberOfPoints(); ptId++)
+    {
+      const double* pt = ds->GetPoint(ptId);
+      signature[2] += pt[0] + pt[1] + pt[2];
+    }
+    vtkDataArray* array = arrayName ? ds->GetCellData()->GetArray(arrayName) : nullptr;
+    for (vtkIdType cellId = 0; array && cellId < array->GetNumberOfTuples(); cellId++)
+    {
+      signature[3] += array->GetComponent(cellId, 0);
+    }
+  }
+  return signature;
+}
+
+vtkSmartPointer<vtkNonOverlappingAMR> CreateVolume()
+{
+  vtkNew<vtkHierarchicalFractal> fractal;
+  fractal->SetMaximumLevel(4);
+  fractal->SetDimensions(8);
+  fractal->SetGhostLevels(1);
+  fractal->Update();
+
+  vtkSmartPointer<vtkNonOverlappingAMR> volume = vtkSmartPointer<vtkNonOverlappingAMR>::New();
+  volume->DeepCopy(fractal->GetOutputDataObject(0));
+  return volume;
+}
+
+// Changes the volume fraction of every cell in place, so the AMR layout stays
+// the same but the fragments move.
+void ChangeVolume(vtkNonOverlappingAMR* volume)
+{
+  for (unsigned int level = 0; level < volume->GetNumberOfLevels(); level++)
+  {
+    for (unsigned int index = 0; index < volume->GetNumberOfDataSets(level); index++)
+    {
+      vtkUniformGrid* grid = volume->GetDataSet(level, index);
+      vtkDataArray* array = grid ? grid->GetCellData()->GetArray(VolumeName) : nullptr;
+      for (vtkIdType cellId = 0; array && cellId < array->GetNumberOfTuples(); cellId++)
+      {
+        const double value = array->GetComponent(cellId, 0);
+        array->SetComponent(cellId, 0, value * value);
+      }
+      if (array)
+      {
+        array->Modified();
+      }
+    }
+  }
+  volume->Modified();
+}
+
+template <class Filter>
+Signature RunDualFilter(Filter* filter, vtkNonOverlappingAMR* volume)
+{
+  filter->SetInputData(volume);
+  filter->SetInputArrayToProcess(0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_CELLS, VolumeName);
+  filter->SetIsoValue(0.4);
+  filter->Update();
+  return GetSignature(filter->GetOutputDataObject(0), nullptr);
+}
+
+Signature RunConnectivity(vtkAMRConnectivity* filter, vtkNonOverlappingAMR* volume)
+{
+  filter->SetInputData(volume);
+  filter->ClearInputVolumeArrayToProcess();
+  filter->AddInputVolumeArrayToProcess(VolumeName);
+  filter->SetVolumeFractionSurfaceValue(0.4);
+  filter->Update();
+  return GetSignature(filter->GetOutputDataObject(0), "RegionId-Fractal Volume Fraction");
+}
+}
+
+int TestAMRDualGridReuse(int, char* [])
+{
+  vtkNew<vtkDummyController> controller;
+  vtkMultiProcessController::SetGlobalController(controller.GetPointer());
+
+  vtkSmartPointer<vtkNonOverlappingAMR> volume = CreateVolume();
+  vtkSmartPointer<vtkNonOverlappingAMR> changed = CreateVolume();
+  ChangeVolume(changed);
+
+  // Contour, updated again after the values and then an option changed.
+  vtkNew<vtkAMRDualContour> contour;
+  const Signature contour0 = RunDualFilter(contour.GetPointer(), volume);
+  TASSERT(contour0[1] > 0);
+  ChangeVolume(volume);
+  const Signature contour1 = RunDualFilter(contour.GetPointer(), volume);
+  TASSERT(contour1 != contour0);
+  vtkNew<vtkAMRDualContour> freshContour;
+  TASSERT(RunDualFilter(freshContour.GetPointer(), changed) == contour1);
+
+  contour->SetEnableDegenerateCells(0);
+  freshContour->SetEnableDegenerateCells(0);
+  const Signature contour2 = RunDualFilter(contour.GetPointer(), volume);
+  TASSERT(RunDualFilter(freshContour.GetPointer(), changed) == contour2);
+  contour->SetSkipGhostCopy(1);
+  freshContour->SetSkipGhostCopy(1);
+  const Signature contour3 = RunDualFilter(contour.GetPointer(), volume);
+  TASSERT(RunDualFilter(freshContour.GetPointer(), changed) == contour3);
+
+  // Clip.
+  volume = CreateVolume();
+  vtkNew<vtkAMRDualClip> clip;
+  const Signature clip0 = RunDualFilter(clip.GetPointer(), volume);
+  TASSERT(clip0[1] > 0);
+  ChangeVolume(volume);
+  const Signature clip1 = RunDualFilter(clip.GetPointer(), volume);
+  TASSERT(clip1 != clip0);
+  vtkNew<vtkAMRDualClip> freshClip;
+  TASSERT(RunDualFilter(freshClip.GetPointer(), changed) == clip1);
+
+  // Connectivity.
+  volume = CreateVolume();
+  vtkNew<vtkAMRConnectivity> connectivity;
+  const Signature regions0 = RunConnectivity(connectivity.GetPointer(), volume);
+  TASSERT(regions0[3] > 0);
+  ChangeVolume(volume);
+  const Signature regions1 = RunConnectivity(connectivity.GetPointer(), volume);
+  TASSERT(regions1 != regions0);
+  vtkNew<vtkAMRConnectivity> freshConnectivity;
+  TASSERT(RunConnectivity(freshConnectivity.GetPointer(), changed) == regions1);
+
+  vtkMultiProcessController::SetGlobalController(nullptr);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,204 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestCleanUnstructuredGrid.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkCleanUnstructuredGrid.h"
+#include "vtkIdList.h"
+#include "vtkIntArray.h"
+#include "vtkNew.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkUnstructuredGrid.h"
+
+#include <limits>
+
+#define TASSERT(x)                                                                                 \
+  if (!(x))                                                                                        \
+  {                                                                                                \
+    cerr << "ERROR: failed at " << __LINE__ << "!" << endl;                                        \
+    return EXIT_FAILURE;                                                                           \
+  }
+
+namespace
+{
+// Two unit hexahedra side by side, each with its own 8 points, so the 4
+// points of the shared face are duplicated.
+void BuildGrid(vtkUnstructuredGrid* grid, double perturbation)
+{
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkIntArray> ids;
+  ids->SetName("ids");
+  for (int cell = 0; cell < 2; ++cell)
+  {
+    vtkIdType ptIds[8];
+    for (int k = 0; k < 2; ++k)
+    {
+      for (int j = 0; j < 2; ++j)
+      {
+        for (int i = 0; i < 2; ++i)
+        {
+          double x = cell + i;
+          if (cell == 1 && i == 0 && j == 0 && k == 0)
+          {
+            x += perturbation;
+          }
+          const vtkIdType id = points->InsertNextPoint(x, j, k);
+          ids->InsertNextValue(static_cast<int>(id));
+        }
+      }
+    }
+    const vtkIdType base = cell * 8;
+    const vtkIdType order[8] = { 0, 1, 3, 2, 4, 5, 7, 6 };
+    for (int cc = 0; cc < 8; ++cc)
+    {
+      ptIds[cc] = base + order[cc];
+    }
+    grid->InsertNextCell(VTK_HEXAHEDRON, 8, ptIds);
+  }
+  grid->SetPoints(points.GetPointer());
+  grid->GetPointData()->AddArray(ids.GetPointer());
+}
+
+bool SameOutput(vtkUnstructuredGrid* a, vtkUnstructuredGrid* b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+    a->GetNumberOfCells() != b->GetNumberOfCells())
+  {
+    return false;
+  }
+  vtkIntArray* aIds = vtkIntArray::SafeDownCast(a->GetPointData()->GetArray("ids"));
+  vtkIntArray* bIds = vtkIntArray::SafeDownCast(b->GetPointData()->GetArray("ids"));
+  for (vtkIdType cc = 0; cc < a->GetNumberOfPoints(); ++cc)
+  {
+    double pa[3], pb[3];
+    a->GetPoint(cc, pa);
+    b->GetPoint(cc, pb);
+    if (pa[0] != pb[0] || pa[1] != pb[1] || pa[2] != pb[2] ||
+      aIds->GetValue(cc) != bIds->GetValue(cc))
+    {
+      return false;
+    }
+  }
+  vtkNew<vtkIdList> aPts, bPts;
+  for (vtkIdType cc = 0; cc < a->GetNumberOfCells(); ++cc)
+  {
+    a->GetCellPoints(cc, aPts.GetPointer());
+    b->GetCellPoints(cc, bPts.GetPointer());
+    if (aPts->GetNumberOfIds() != bPts->GetNumberOfIds())
+    {
+      return false;
+    }
+    for (vtkIdType i = 0; i < aPts->GetNumberOfIds(); ++i)
+    {
+      if (aPts->GetId(i) != bPts->GetId(i))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}
+
+int TestCleanUnstructuredGrid(int, char* [])
+{
+  vtkNew<vtkUnstructuredGrid> grid;
+  BuildGrid(grid.GetPointer(), 0.0);
+
+  vtkNew<vtkCleanUnstructuredGrid> threaded;
+  threaded->SetInputData(grid.GetPointer());
+  threaded->ThreadedMergeOn();
+  threaded->Update();
+
+  vtkNew<vtkCleanUnstructuredGrid> locator;
+  locator->SetInputData(grid.GetPointer());
+  locator->ThreadedMergeOff();
+  locator->Update();
+
+  TASSERT(threaded->GetOutput()->GetNumberOfPoints() == 12);
+  TASSERT(SameOutput(threaded->GetOutput(), locator->GetOutput()));
+
+  // the first occurrence of each point is kept.
+  vtkIntArray* ids =
+    vtkIntArray::SafeDownCast(threaded->GetOutput()->GetPointData()->GetArray("ids"));
+  TASSERT(ids != nullptr && ids->GetValue(0) == 0 && ids->GetValue(8) == 9);
+
+  // a point slightly off is only merged within tolerance.
+  vtkNew<vtkUnstructuredGrid> perturbed;
+  BuildGrid(perturbed.GetPointer(), 1e-4);
+  threaded->SetInputData(perturbed.GetPointer());
+  threaded->Update();
+  TASSERT(threaded->GetOutput()->GetNumberOfPoints() == 13);
+
+  threaded->SetTolerance(1e-3);
+  threaded->Update();
+  TASSERT(threaded->GetOutput()->GetNumberOfPoints() == 12);
+
+  locator->SetInputData(perturbed.GetPointer());
+  locator->SetTolerance(1e-3);
+  locator->Update();
+  TASSERT(locator->GetOutput()->GetNumberOfPoints() == 12);
+
+  // a point with a NaN coordinate is kept as is, and does not prevent the
+  // other points from being merged.
+  vtkNew<vtkUnstructuredGrid> invalid;
+  BuildGrid(invalid.GetPointer(), std::numeric_limits<double>::quiet_NaN());
+  threaded->SetInputData(invalid.GetPointer());
+  threaded->SetTolerance(0.0);
+  threaded->Update();
+  TASSERT(threaded->GetOutput()->GetNumberOfPoints() == 13);
+  ids = vtkIntArray::SafeDownCast(threaded->GetOutput()->GetPointData()->GetArray("ids"));
+  TASSERT(ids != nullptr && ids->GetValue(8) == 8 && ids->GetValue(9) == 9);
+
+  // enough points with NaN coordinates for the sort not to fall back to an
+  // insertion sort: 10 distinct valid points, plus all the invalid ones.
+  vtkNew<vtkUnstructuredGrid> manyInvalid;
+  vtkNew<vtkPoints> points;
+  vtkIdType numInvalid = 0;
+  for (vtkIdType cc = 0; cc < 1000; ++cc)
+  {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const bool invalidX = cc % 3 == 0;
+    const bool invalidY = cc % 7 == 0;
+    numInvalid += (invalidX || invalidY) ? 1 : 0;
+    points->InsertNextPoint(invalidX ? nan : cc % 10, invalidY ? nan : 0.0, 0.0);
+    manyInvalid->InsertNextCell(VTK_VERTEX, 1, &cc);
+  }
+  manyInvalid->SetPoints(points.GetPointer());
+  threaded->SetInputData(manyInvalid.GetPointer());
+  threaded->Update();
+  TASSERT(threaded->GetOutput()->GetNumberOfPoints() == 10 + numInvalid);
+
+  // within a tolerance, points with a non-finite coordinate are never merged,
+  // not even with each other, nor do they change how the others are binned.
+  threaded->SetTolerance(1e-3);
+  threaded->Update();
+  TASSERT(threaded->GetOutput()->GetNumberOfPoints() == 10 + numInvalid);
+
+  vtkNew<vtkUnstructuredGrid> infinite;
+  BuildGrid(infinite.GetPointer(), std::numeric_limits<double>::infinity());
+  vtkNew<vtkUnstructuredGrid> twoInfinite;
+  twoInfinite->DeepCopy(infinite.GetPointer());
+  twoInfinite->GetPoints()->SetPoint(10, std::numeric_limits<double>::infinity(), 0.0, 0.0);
+  threaded->SetInputData(infinite.GetPointer());
+  threaded->Update();
+  TASSERT(threaded->GetOutput()->GetNumberOfPoints() == 13);
+  threaded->SetInputData(twoInfinite.GetPointer());
+  threaded->Update();
+  TASSERT(threaded->GetOutput()->GetNumberOfPoints() == 14);
+
+  // the locator is used by default.
+  vtkNew<vtkCleanUnstructuredGrid> defaults;
+  TASSERT(!defaults->GetThreadedMerge());
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestPVArrayCalculator.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkDataArray.h"
+#include "vtkDataObject.h"
+#include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+#include "vtkIntArray.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkPVArrayCalculator.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+
+#include <cmath>
+#include <cstring>
+
+#define TASSERT(x)                                                                                 \
+  if (!(x))                                                                                        \
+  {                                                                                                \
+    cerr << "ERROR: failed at " << __LINE__ << "!" << endl;                                        \
+    return EXIT_FAILURE;                                                                           \
+  }
+
+// Exposes which backend evaluated the function.
+class vtkTestPVArrayCalculator : public vtkPVArrayCalculator
+{
+public:
+  static vtkTestPVArrayCalculator* New();
+  vtkTypeMacro(vtkTestPVArrayCalculator, vtkPVArrayCalculator);
+  bool GetUsedCompiledProgram() const { return this->UsedCompiledProgram; }
+};
+vtkStandardNewMacro(vtkTestPVArrayCalculator);
+
+namespace
+{
+const vtkIdType NumberOfPoints = 5000;
+
+// Points along a spiral with double, float, int and vector arrays. "t" goes
+// through zero and negative values so that some functions hit invalid values.
+void BuildInput(vtkPolyData* input)
+{
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkDoubleArray> s;
+  s->SetName("s");
+  vtkNew<vtkFloatArray> t;
+  t->SetName("t");
+  vtkNew<vtkIntArray> i;
+  i->SetName("i");
+  vtkNew<vtkDoubleArray> v;
+  v->SetName("v");
+  v->SetNumberOfComponents(3);
+  for (vtkIdType cc = 0; cc < NumberOfPoints; ++cc)
+  {
+    const double a = 0.01 * cc;
+    points->InsertNextPoint(a * std::cos(a), a * std::sin(a), 0.1 * a);
+    s->InsertNextValue(1.0 + 0.001 * cc);
+    t->InsertNextValue(static_cast<float>(0.5 * std::sin(3 * a)));
+    i->InsertNextValue(static_cast<int>(cc % 17) - 8);
+    v->InsertNextTuple3(std::cos(a), 0.5, cc % 5 == 0 ? 0.0 : a);
+  }
+  t->SetValue(100, 0.0f);
+  input->SetPoints(points);
+  input->GetPointData()->AddArray(s);
+  input->GetPointData()->AddArray(t);
+  input->GetPointData()->AddArray(i);
+  input->GetPointData()->AddArray(v);
+}
+
+vtkDataArray* Evaluate(vtkTestPVArrayCalculator* calc, vtkPolyData* input, const char* function,
+  int backend, int resultType)
+{
+  calc->SetInputData(input);
+  calc->SetFunction(function);
+  calc->SetResultArrayName("Result");
+  calc->SetResultArrayType(resultType);
+  calc->SetReplaceInvalidValues(1);
+  calc->SetReplacementValue(-1.0);
+  calc->SetBackend(backend);
+  calc->Update();
+  vtkPolyData* output = vtkPolyData::SafeDownCast(calc->GetOutputDataObject(0));
+  return output ? output->GetPointData()->GetArray("Result") : nullptr;
+}
+}
+
+int TestPVArrayCalculator(int, char* [])
+{
+  vtkNew<vtkPolyData> input;
+  BuildInput(input);
+
+  // Supported functions, functions hitting invalid values and unsupported
+  // functions must give the same results with both backends.
+  const char* functions[] = { "s*2+1", "-s^2+t", "s-t-s+2", "sin(s)*cos(t)-t/3", "mag(v)",
+    "norm(v)", "cross(v,jHat)+2*v", "v.v", "-v", "coordsX*coordsY-coordsZ", "coords+v*s",
+    "min(s,t)+max(i,s)", "abs(t)+floor(s)-ceil(t)", "sign(t)*exp(s)+atan(t)", "s/t",
+    "sqrt(t)", "ln(s)+log10(s)", "asin(t)+acos(t)^2", "v_X*s^i", "\"s\"*iHat", "t/s*s",
+    "if(s>1.5,s,t)" };
+  const int resultTypes[] = { VTK_DOUBLE, VTK_FLOAT };
+  // The parser evaluates conditionals, and the functions hitting a division
+  // by zero or the square root of a negative number on this input.
+  const char* parsed[] = { "s/t", "sqrt(t)", "if(s>1.5,s,t)" };
+
+  for (const char* function : functions)
+  {
+    for (int resultType : resultTypes)
+    {
+      vtkNew<vtkTestPVArrayCalculator> parser;
+      vtkDataArray* expected =
+        Evaluate(parser, input, function, vtkPVArrayCalculator::PARSER_BACKEND, resultType);
+      TASSERT(!parser->GetUsedCompiledProgram());
+      vtkNew<vtkTestPVArrayCalculator> compiled;
+      vtkDataArray* result =
+        Evaluate(compiled, input, function, vtkPVArrayCalculator::COMPILED_BACKEND, resultType);
+      bool isParsed = false;
+      for (const char* name : parsed)
+      {
+        isParsed = isParsed || strcmp(name, function) == 0;
+      }
+      if (compiled->GetUsedCompiledProgram() == isParsed)
+      {
+        cerr << "ERROR: " << function << (isParsed ? " was" : " was not")
+             << " evaluated by the compiled program." << endl;
+        return EXIT_FAILURE;
+      }
+      if (!expected)
+      {
+        TASSERT(!result);
+        continue;
+      }
+      TASSERT(result != nullptr);
+      TASSERT(result->GetDataType() == expected->GetDataType());
+      TASSERT(result->GetNumberOfTuples() == expected->GetNumberOfTuples());
+      TASSERT(result->GetNumberOfComponents() == expected->GetNumberOfComponents());
+      for (vtkIdType cc = 0; cc < expected->GetNumberOfTuples(); ++cc)
+      {
+        for (int c = 0; c < expected->GetNumberOfComponents(); ++c)
+        {
+          const double a = expected->GetComponent(cc, c);
+          const double b = result->GetComponent(cc, c);
+          if (!(a == b || (std::isnan(a) && std::isnan(b))))
+          {
+            cerr << "ERROR: " << function << " differs at " << cc << ": " << a << " != " << b
+                 << endl;
+            return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
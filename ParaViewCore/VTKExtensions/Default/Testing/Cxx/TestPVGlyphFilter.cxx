@@ -0,0 +1,145 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestPVGlyphFilter.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkDataObject.h"
+#include "vtkDataSetAttributes.h"
+#include "vtkDoubleArray.h"
+#include "vtkIntArray.h"
+#include "vtkMath.h"
+#include "vtkNew.h"
+#include "vtkPVGlyphFilter.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkUnsignedCharArray.h"
+
+#include <cmath>
+
+#define TASSERT(x)                                                                                 \
+  if (!(x))                                                                                        \
+  {                                                                                                \
+    cerr << "ERROR: failed at " << __LINE__ << "!" << endl;                                        \
+    return EXIT_FAILURE;                                                                           \
+  }
+
+namespace
+{
+const vtkIdType NumberOfPoints = 1000;
+
+// Points along a helix with a scalar, a vector and an id array. Every 7th
+// point is flagged as a duplicated ghost point and must not be glyphed.
+void BuildInput(vtkPolyData* input)
+{
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkDoubleArray> scalars;
+  scalars->SetName("s");
+  vtkNew<vtkDoubleArray> vectors;
+  vectors->SetName("v");
+  vectors->SetNumberOfComponents(3);
+  vtkNew<vtkIntArray> ids;
+  ids->SetName("ids");
+  vtkNew<vtkUnsignedCharArray> ghosts;
+  ghosts->SetName(vtkDataSetAttributes::GhostArrayName());
+  for (vtkIdType cc = 0; cc < NumberOfPoints; ++cc)
+  {
+    const double t = 0.01 * cc;
+    points->InsertNextPoint(std::cos(t), std::sin(t), t);
+    scalars->InsertNextValue(1.0 + 0.001 * cc);
+    vectors->InsertNextTuple3(-std::sin(t), std::cos(t), cc % 3 == 0 ? 0.0 : 0.5);
+    ids->InsertNextValue(static_cast<int>(cc));
+    ghosts->InsertNextValue(cc % 7 == 0 ? vtkDataSetAttributes::DUPLICATEPOINT : 0);
+  }
+  input->SetPoints(points);
+  input->GetPointData()->AddArray(scalars);
+  input->GetPointData()->AddArray(vectors);
+  input->GetPointData()->AddArray(ids);
+  input->GetPointData()->AddArray(ghosts);
+}
+
+void SetupFilter(vtkPVGlyphFilter* glyph, vtkPolyData* input)
+{
+  glyph->SetInputData(input);
+  glyph->SetInputArrayToProcess(0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS, "s");
+  glyph->SetInputArrayToProcess(1, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS, "v");
+  glyph->SetGlyphMode(vtkPVGlyphFilter::ALL_POINTS);
+  glyph->SetScaleFactor(0.5);
+  glyph->SetOutputPointsPrecision(vtkAlgorithm::DOUBLE_PRECISION);
+}
+}
+
+int TestPVGlyphFilter(int, char* [])
+{
+  vtkNew<vtkPolyData> input;
+  BuildInput(input);
+  const vtkIdType numGlyphs = NumberOfPoints - (NumberOfPoints + 6) / 7;
+
+  // Glyph geometry, using the default line source.
+  vtkNew<vtkPVGlyphFilter> glyph;
+  SetupFilter(glyph, input);
+  glyph->Update();
+  vtkPolyData* geometry = vtkPolyData::SafeDownCast(glyph->GetOutputDataObject(0));
+  TASSERT(geometry != nullptr);
+  TASSERT(geometry->GetNumberOfPoints() == 2 * numGlyphs);
+  TASSERT(geometry->GetNumberOfLines() == numGlyphs);
+
+  // Instance table.
+  vtkNew<vtkPVGlyphFilter> instances;
+  SetupFilter(instances, input);
+  instances->OutputInstancesOn();
+  instances->Update();
+  vtkPolyData* table = vtkPolyData::SafeDownCast(instances->GetOutputDataObject(0));
+  TASSERT(table != nullptr);
+  TASSERT(table->GetNumberOfPoints() == numGlyphs);
+  vtkDataArray* orientations = table->GetPointData()->GetArray("GlyphOrientation");
+  vtkDataArray* scales = table->GetPointData()->GetArray("GlyphScale");
+  vtkDataArray* tableIds = table->GetPointData()->GetArray("ids");
+  vtkDataArray* geometryIds = geometry->GetPointData()->GetArray("ids");
+  TASSERT(orientations && scales && tableIds && geometryIds);
+
+  // Both outputs must describe the same glyphs, in input order: each line goes
+  // from the glyphed point along its vector, with a length of s * ScaleFactor.
+  vtkIdType previousId = -1;
+  for (vtkIdType cc = 0; cc < numGlyphs; ++cc)
+  {
+    const vtkIdType inId = static_cast<vtkIdType>(tableIds->GetComponent(cc, 0));
+    TASSERT(inId > previousId && inId % 7 != 0);
+    previousId = inId;
+    TASSERT(geometryIds->GetComponent(2 * cc, 0) == inId);
+    TASSERT(geometryIds->GetComponent(2 * cc + 1, 0) == inId);
+
+    double x[3], p0[3], p1[3], v[3], orient[3], scale[3];
+    input->GetPoint(inId, x);
+    table->GetPoint(cc, p0);
+    TASSERT(vtkMath::Distance2BetweenPoints(x, p0) < 1e-12);
+    geometry->GetPoint(2 * cc, p0);
+    TASSERT(vtkMath::Distance2BetweenPoints(x, p0) < 1e-12);
+
+    input->GetPointData()->GetArray("v")->GetTuple(inId, v);
+    orientations->GetTuple(cc, orient);
+    TASSERT(vtkMath::Distance2BetweenPoints(v, orient) < 1e-10);
+
+    const double s = 0.5 * input->GetPointData()->GetArray("s")->GetComponent(inId, 0);
+    scales->GetTuple(cc, scale);
+    TASSERT(std::abs(scale[0] - s) < 1e-6 && std::abs(scale[1] - s) < 1e-6 &&
+      std::abs(scale[2] - s) < 1e-6);
+
+    vtkMath::Normalize(v);
+    geometry->GetPoint(2 * cc + 1, p1);
+    for (int c = 0; c < 3; ++c)
+    {
+      TASSERT(std::abs(p1[c] - (x[c] + s * v[c])) < 1e-6);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
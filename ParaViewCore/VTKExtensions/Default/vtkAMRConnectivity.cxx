@@ -31,7 +31,9 @@
 #include "vtkIdTypeArray.h"
 #include "vtkIntArray.h"
 #include "vtkMultiProcessController.h"
+#include "vtkNew.h"
 #include "vtkNonOverlappingAMR.h"
+#include "vtkSMPTools.h"
 #include "vtkSmartPointer.h"
 #include "vtkTimerLog.h"
 #include "vtkUniformGrid.h"
@@ -43,149 +45,107 @@
 #include "vtkMPIController.h"
 #endif
 
+#include <algorithm>
 #include <list>
-#include <map>
+#include <unordered_map>
+#include <vector>
 
 vtkStandardNewMacro(vtkAMRConnectivity);
 
+// Union-find of the region ids that touch across block boundaries. The
+// representative of every set is its smallest id.
 class vtkAMRConnectivityEquivalence
 {
 public:
-  vtkAMRConnectivityEquivalence()
-  {
-    set_to_min_id = vtkSmartPointer<vtkIntArray>::New();
-    set_to_min_id->SetNumberOfComponents(1);
-    set_to_min_id->SetNumberOfTuples(0);
-  }
-
-  ~vtkAMRConnectivityEquivalence() {}
-
+  // Makes id1 and id2 equivalent. Returns 0 if they already were.
   int AddEquivalence(int id1, int id2)
   {
-    int min_id;
-    if (id1 < id2)
+    int root1 = this->Find(id1);
+    int root2 = this->Find(id2);
+    if (root1 == root2)
     {
-      min_id = id1;
+      return 0;
     }
-    else
+    if (root1 < root2)
     {
-      min_id = id2;
+      this->Parent[root2] = root1;
     }
-
-    std::map<int, int>::iterator iter;
-
-    iter = id_to_set.find(id1);
-    int set1 = (iter == id_to_set.end() ? -1 : iter->second);
-    iter = id_to_set.find(id2);
-    int set2 = (iter == id_to_set.end() ? -1 : iter->second);
-
-    if (set1 >= 0 && set_to_min_id->GetValue(set1) < 0)
-    {
-      set1 = -1;
-    }
-    if (set2 >= 0 && set_to_min_id->GetValue(set2) < 0)
+    else
     {
-      set2 = -1;
+      this->Parent[root1] = root2;
     }
+    return 1;
+  }
 
-    if (set1 >= 0 && set2 >= 0 && set1 == set2)
-    {
-      return 0;
-    }
-    else if (set1 >= 0 && set2 >= 0)
+  // Returns the smallest id equivalent to id, or -1 if no equivalence was
+  // added for id. This does not modify the set so it can be called from
+  // several threads.
+  int GetMinimumSetId(int id) const
+  {
+    std::unordered_map<int, int>::const_iterator iter = this->Parent.find(id);
+    if (iter == this->Parent.end())
     {
-      // merge sets
-      int min_set, max_set;
-      if (set1 < set2)
-      {
-        min_set = set1;
-        max_set = set2;
-      }
-      else
-      {
-        min_set = set2;
-        max_set = set1;
-      }
-      for (iter = id_to_set.begin(); iter != id_to_set.end(); iter++)
-      {
-        if (iter->second == max_set)
-        {
-          id_to_set[iter->first] = min_set;
-        }
-      }
-      int max_set_min = set_to_min_id->GetValue(max_set);
-      int min_set_min = set_to_min_id->GetValue(min_set);
-      // pick the smallest of the two mins to represent the set.
-      if (max_set_min < min_set_min)
-      {
-        set_to_min_id->SetValue(min_set, max_set_min);
-      }
-      set_to_min_id->SetValue(max_set, -1);
+      return -1;
     }
-    else if (set1 >= 0)
+    while (iter->second != id)
     {
-      id_to_set[id2] = set1;
-      if (id2 < set_to_min_id->GetValue(set1))
-      {
-        set_to_min_id->SetValue(set1, id2);
-      }
+      id = iter->second;
+      iter = this->Parent.find(id);
     }
-    else if (set2 >= 0)
+    return id;
+  }
+
+  // Points every id directly at the smallest id of its set, so that
+  // GetMinimumSetId only needs a single lookup.
+  void Flatten()
+  {
+    for (auto& member : this->Parent)
     {
-      id_to_set[id1] = set2;
-      if (id1 < set_to_min_id->GetValue(set2))
-      {
-        set_to_min_id->SetValue(set2, id1);
-      }
+      member.second = this->Find(member.first);
     }
-    else
+  }
+
+  // Appends an (id, smallest id) pair for every id that is not the smallest
+  // of its set. Adding these pairs to another set recreates this one.
+  void GetEquivalencePairs(vtkIntArray* pairs)
+  {
+    for (auto& member : this->Parent)
     {
-      // find an empty set.
-      int first_empty = -1;
-      for (int i = 0; i < set_to_min_id->GetNumberOfTuples(); i++)
+      int root = this->Find(member.first);
+      if (root != member.first)
       {
-        if (set_to_min_id->GetValue(i) < 0)
-        {
-          first_empty = i;
-          break;
-        }
+        pairs->InsertNextValue(member.first);
+        pairs->InsertNextValue(root);
       }
-      if (first_empty < 0)
-      {
-        first_empty = set_to_min_id->InsertNextValue(-1);
-      }
-
-      id_to_set[id1] = first_empty;
-      id_to_set[id2] = first_empty;
-      set_to_min_id->SetValue(first_empty, min_id);
-      // return zero here because its not values we've previously cared about.
     }
-    return 1;
   }
 
-  int GetMinimumSetId(int id)
+private:
+  int Find(int id)
   {
-    std::map<int, int>::iterator iter = id_to_set.find(id);
-    if (iter == id_to_set.end())
+    std::unordered_map<int, int>::iterator iter = this->Parent.emplace(id, id).first;
+    int root = id;
+    while (iter->second != root)
     {
-      // vtkErrorWithObjectMacro (id_to_set, << "ID out of range " << id << " (expected 0 <= x < "
-      // << id_to_set->GetNumberOfTuples () << ")");
-      return -1;
+      root = iter->second;
+      iter = this->Parent.find(root);
+    }
+    // compress the path to the root
+    while (id != root)
+    {
+      iter = this->Parent.find(id);
+      id = iter->second;
+      iter->second = root;
     }
-    int set = id_to_set[id];
-    return (set >= 0 ? set_to_min_id->GetValue(set) : -1);
+    return root;
   }
 
-private:
-  std::map<int, int> id_to_set;
-  vtkSmartPointer<vtkIntArray> set_to_min_id;
+  std::unordered_map<int, int> Parent;
 };
 
 #if VTK_MODULE_ENABLE_VTK_ParallelMPI
 
 static const int BOUNDARY_TAG = 857089;
-static const int EQUIV_SIZE_TAG = 748957;
-static const int EQUIV_TAG = 357345;
 
 //-----------------------------------------------------------------------------
 // Simple containers for managing asynchronous communication.
@@ -248,6 +208,11 @@ vtkAMRConnectivity::vtkAMRConnectivity()
 
 vtkAMRConnectivity::~vtkAMRConnectivity()
 {
+  if (this->Helper)
+  {
+    this->Helper->Delete();
+    this->Helper = 0;
+  }
 }
 
 void vtkAMRConnectivity::PrintSelf(ostream& os, vtkIndent indent)
@@ -312,22 +277,24 @@ int vtkAMRConnectivity::RequestData(vtkInformation* vtkNotUsed(request),
 
   amrOutput->ShallowCopy(amrInput);
 
-  this->Helper = vtkAMRDualGridHelper::New();
+  // Kept between requests, see vtkAMRDualGridHelper::ReleaseImages.
+  if (!this->Helper)
+  {
+    this->Helper = vtkAMRDualGridHelper::New();
+  }
   vtkMultiProcessController* controller = vtkMultiProcessController::GetGlobalController();
   this->Helper->SetController(controller);
   this->Helper->Initialize(amrInput);
 
+  int ret = 1;
   unsigned int noOfArrays = static_cast<unsigned int>(this->VolumeArrays.size());
-  for (unsigned int i = 0; i < noOfArrays; i++)
+  for (unsigned int i = 0; i < noOfArrays && ret; i++)
   {
-    if (this->DoRequestData(amrOutput, this->VolumeArrays[i].c_str()) == 0)
-    {
-      return 0;
-    }
+    ret = this->DoRequestData(amrOutput, this->VolumeArrays[i].c_str());
   }
-  this->Helper->Delete();
 
-  return 1;
+  this->Helper->ReleaseImages();
+  return ret;
 }
 
 //----------------------------------------------------------------------------
@@ -343,31 +310,23 @@ int vtkAMRConnectivity::DoRequestData(vtkNonOverlappingAMR* volume, const char*
   this->RegionName = std::string("RegionId-");
   this->RegionName += volumeName;
 
-  // initialize with a global unique region id
-  this->NextRegionId = myProc + 1;
-
   vtkTimerLog::MarkStartEvent("Initial fragment seeding");
 
-  // Find the block local fragments
-  vtkCompositeDataIterator* iter = volume->NewIterator();
+  // Go through each block and create an array RegionId.
+  std::vector<vtkUniformGrid*> grids;
+  std::vector<vtkIdTypeArray*> regionIds;
+  std::vector<vtkDataArray*> volArrays;
+  std::vector<vtkUnsignedCharArray*> ghostArrays;
+  vtkSmartPointer<vtkCompositeDataIterator> iter;
+  iter.TakeReference(volume->NewIterator());
   for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
   {
-    // Go through each block and create an array RegionId set all zero.
     vtkUniformGrid* grid = vtkUniformGrid::SafeDownCast(iter->GetCurrentDataObject());
     if (!grid)
     {
       vtkErrorMacro("NonOverlappingAMR not made up of UniformGrids");
       return 0;
     }
-    vtkSmartPointer<vtkIdTypeArray> regionId = vtkSmartPointer<vtkIdTypeArray>::New();
-    regionId->SetName(this->RegionName.c_str());
-    regionId->SetNumberOfComponents(1);
-    regionId->SetNumberOfTuples(grid->GetNumberOfCells());
-    for (int i = 0; i < grid->GetNumberOfCells(); i++)
-    {
-      regionId->SetTuple1(i, 0);
-    }
-    grid->GetCellData()->AddArray(regionId);
 
     vtkDataArray* volArray = grid->GetCellData()->GetArray(volumeName);
     if (!volArray)
@@ -383,31 +342,54 @@ int vtkAMRConnectivity::DoRequestData(vtkNonOverlappingAMR* volume, const char*
       return 0;
     }
 
-    // within each block find all fragments
-    int extents[6];
-    grid->GetExtent(extents);
+    vtkSmartPointer<vtkIdTypeArray> regionId = vtkSmartPointer<vtkIdTypeArray>::New();
+    regionId->SetName(this->RegionName.c_str());
+    regionId->SetNumberOfComponents(1);
+    regionId->SetNumberOfTuples(grid->GetNumberOfCells());
+    grid->GetCellData()->AddArray(regionId);
+
+    grids.push_back(grid);
+    regionIds.push_back(regionId);
+    volArrays.push_back(volArray);
+    ghostArrays.push_back(ghostArray);
+  }
 
-    for (int i = extents[0]; i < extents[1]; i++)
+  // Within each block find all fragments. Blocks are independent so they are
+  // labeled in parallel, each with its own local region ids starting at 1.
+  const vtkIdType numBlocks = static_cast<vtkIdType>(grids.size());
+  std::vector<vtkIdType> numRegions(numBlocks);
+  vtkSMPTools::For(0, numBlocks, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType b = begin; b < end; b++)
     {
-      for (int j = extents[2]; j < extents[3]; j++)
+      numRegions[b] = this->LabelBlockRegions(grids[b], regionIds[b], volArrays[b], ghostArrays[b]);
+    }
+  });
+
+  // Offset the local region ids so that they are globally unique: the n-th
+  // region of this process gets myProc + 1 + n * numProcs.
+  std::vector<vtkIdType> firstRegion(numBlocks);
+  vtkIdType nextRegion = 0;
+  for (vtkIdType b = 0; b < numBlocks; b++)
+  {
+    firstRegion[b] = nextRegion;
+    nextRegion += numRegions[b];
+  }
+  this->NextRegionId = myProc + 1 + nextRegion * numProcs;
+  vtkSMPTools::For(0, numBlocks, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType b = begin; b < end; b++)
+    {
+      vtkIdType* ids = regionIds[b]->GetPointer(0);
+      const vtkIdType numCells = regionIds[b]->GetNumberOfTuples();
+      const vtkIdType offset = myProc + 1 + (firstRegion[b] - 1) * numProcs;
+      for (vtkIdType cellId = 0; cellId < numCells; cellId++)
       {
-        for (int k = extents[4]; k < extents[5]; k++)
+        if (ids[cellId] > 0)
         {
-          int ijk[3] = { i, j, k };
-          vtkIdType cellId = grid->ComputeCellId(ijk);
-          if (regionId->GetTuple1(cellId) == 0 &&
-            volArray->GetTuple1(cellId) > this->VolumeFractionSurfaceValue &&
-            (ghostArray->GetValue(cellId) & vtkDataSetAttributes::DUPLICATECELL) == 0)
-          {
-            // wave propagation sets the region id as it propagates
-            this->WavePropagation(cellId, grid, regionId, volArray, ghostArray);
-            // increment this way so the region id remains globally unique
-            this->NextRegionId += numProcs;
-          }
+          ids[cellId] = offset + ids[cellId] * numProcs;
         }
       }
     }
-  }
+  });
 
   vtkTimerLog::MarkEndEvent("Initial fragment seeding");
 
@@ -418,26 +400,6 @@ int vtkAMRConnectivity::DoRequestData(vtkNonOverlappingAMR* volume, const char*
     // Determine boundaries at the block that need to be sent to neighbors
     this->BoundaryArrays.resize(numProcs);
     this->ReceiveList.resize(numProcs);
-    this->ValidNeighbor.resize(numProcs);
-    this->NeighborList.resize(this->Helper->GetNumberOfLevels());
-    for (int level = 0; level < this->Helper->GetNumberOfLevels(); level++)
-    {
-      int maxId = 0;
-      for (int blockId = 0; blockId < this->Helper->GetNumberOfBlocksInLevel(level); blockId++)
-      {
-        vtkAMRDualGridHelperBlock* block = this->Helper->GetBlock(level, blockId);
-        if (block->BlockId > maxId)
-        {
-          maxId = block->BlockId;
-        }
-      }
-      this->NeighborList[level].resize(maxId + 1);
-      for (int blockId = 0; blockId < maxId; blockId++)
-      {
-        this->NeighborList[level][blockId].resize(0);
-      }
-    }
-
     for (int level = 0; level < this->Helper->GetNumberOfLevels(); level++)
     {
       for (int blockId = 0; blockId < this->Helper->GetNumberOfBlocksInLevel(level); blockId++)
@@ -491,7 +453,6 @@ int vtkAMRConnectivity::DoRequestData(vtkNonOverlappingAMR* volume, const char*
     // Process all boundaries at the neighbors to find the equivalence pairs at the boundaries
     this->Equivalence = new vtkAMRConnectivityEquivalence;
 
-    // Initialize equivalence with all regions independent
     for (size_t i = 0; i < this->BoundaryArrays.size(); i++)
     {
       for (size_t j = 0; j < this->BoundaryArrays[i].size(); j++)
@@ -506,105 +467,36 @@ int vtkAMRConnectivity::DoRequestData(vtkNonOverlappingAMR* volume, const char*
     vtkTimerLog::MarkEndEvent("Computing boundary regions");
 
     vtkTimerLog::MarkStartEvent("Transferring equivalence");
-    this->EquivPairs.resize(numProcs);
-    while (true)
+    // Combine the equivalences found by all processes in a single collective
+    // instead of propagating them neighbor to neighbor.
+    if (numProcs > 1 && !this->GatherEquivalences(controller))
     {
-      int sets_changed = 0;
-      // Relabel all fragment IDs with the equivalence set number
-      // (set numbers start with 1 and 0 is considered "no set" or "no fragment")
-      for (int level = 0; level < this->Helper->GetNumberOfLevels(); level++)
+      delete this->Equivalence;
+      this->Equivalence = 0;
+      return 0;
+    }
+    this->Equivalence->Flatten();
+
+    // Relabel all fragment IDs with the smallest equivalent ID
+    // (0 is considered "no fragment")
+    vtkSMPTools::For(0, numBlocks, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType b = begin; b < end; b++)
       {
-        for (int blockId = 0; blockId < this->Helper->GetNumberOfBlocksInLevel(level); blockId++)
+        vtkIdType* ids = regionIds[b]->GetPointer(0);
+        const vtkIdType numCells = regionIds[b]->GetNumberOfTuples();
+        for (vtkIdType cellId = 0; cellId < numCells; cellId++)
         {
-          vtkAMRDualGridHelperBlock* block = this->Helper->GetBlock(level, blockId);
-          if (block->ProcessId != myProc)
-          {
-            continue;
-          }
-          vtkUniformGrid* grid = volume->GetDataSet(block->Level, block->BlockId);
-          vtkIdTypeArray* regionIdArray =
-            vtkIdTypeArray::SafeDownCast(grid->GetCellData()->GetArray(this->RegionName.c_str()));
-          if (regionIdArray == 0)
-          {
-            vtkErrorMacro("block Image doesn't not contain the regionId just added");
-            return 0;
-          }
-          for (int i = 0; i < regionIdArray->GetNumberOfTuples(); i++)
+          if (ids[cellId] > 0)
           {
-            vtkIdType regionId = regionIdArray->GetTuple1(i);
-            if (regionId > 0)
+            int setId = this->Equivalence->GetMinimumSetId(static_cast<int>(ids[cellId]));
+            if (setId > 0)
             {
-              int setId = this->Equivalence->GetMinimumSetId(regionId);
-              if (setId > 0 && setId != regionId)
-              {
-                regionIdArray->SetTuple1(i, setId);
-                sets_changed = 1;
-                for (size_t p = 0; p < this->NeighborList[block->Level][block->BlockId].size(); p++)
-                {
-                  int n = this->NeighborList[block->Level][block->BlockId][p];
-                  if (this->EquivPairs[n] == 0)
-                  {
-                    this->EquivPairs[n] = vtkSmartPointer<vtkIntArray>::New();
-                    this->EquivPairs[n]->SetNumberOfComponents(1);
-                    this->EquivPairs[n]->SetNumberOfTuples(0);
-                  }
-                  int contained = 0;
-                  for (int e = 0; e < this->EquivPairs[n]->GetNumberOfTuples(); e += 2)
-                  {
-                    int v1 = this->EquivPairs[n]->GetValue(e);
-                    int v2 = this->EquivPairs[n]->GetValue(e + 1);
-                    if ((v1 == regionId && v2 == setId) || (v2 == regionId && v1 == setId))
-                    {
-                      contained = 1;
-                    }
-                  }
-                  if (contained == 0)
-                  {
-                    this->EquivPairs[n]->InsertNextValue(regionId);
-                    this->EquivPairs[n]->InsertNextValue(setId);
-                  }
-                }
-              }
-            }
-            else
-            {
-              regionIdArray->SetTuple1(i, 0);
+              ids[cellId] = setId;
             }
           }
         }
       }
-#if VTK_MODULE_ENABLE_VTK_ParallelMPI
-      if (numProcs > 1)
-      {
-        int out;
-        controller->AllReduce(&sets_changed, &out, 1, vtkCommunicator::MAX_OP);
-        sets_changed = out;
-      }
-#endif
-      if (sets_changed == 0)
-      {
-        break;
-      }
-#if VTK_MODULE_ENABLE_VTK_ParallelMPI
-      if (numProcs > 1 && !this->ExchangeEquivPairs(mpiController))
-      {
-        return 0;
-      }
-#endif
-      // clear out the pairs after sending them.
-      for (int i = 0; i < numProcs; i++)
-      {
-        if (this->EquivPairs[i] != 0)
-        {
-          this->EquivPairs[i]->SetNumberOfTuples(0);
-        }
-      }
-    }
-
-    // clean up EquivPairs for the last time this update
-    this->EquivPairs.clear();
-    ValidNeighbor.clear();
-    NeighborList.clear();
+    });
 
     vtkTimerLog::MarkEndEvent("Transferring equivalence");
 
@@ -664,44 +556,98 @@ int vtkAMRConnectivity::DoRequestData(vtkNonOverlappingAMR* volume, const char*
 }
 
 //----------------------------------------------------------------------------
-int vtkAMRConnectivity::WavePropagation(vtkIdType cellIdStart, vtkUniformGrid* grid,
-  vtkIdTypeArray* regionId, vtkDataArray* volArray, vtkUnsignedCharArray* ghostArray)
+vtkIdType vtkAMRConnectivity::LabelBlockRegions(vtkUniformGrid* grid, vtkIdTypeArray* regionId,
+  vtkDataArray* volArray, vtkUnsignedCharArray* ghostArray)
 {
-  vtkSmartPointer<vtkIdList> todoList = vtkIdList::New();
-  todoList->SetNumberOfIds(0);
-  todoList->InsertNextId(cellIdStart);
-
-  vtkSmartPointer<vtkIdList> ptIds = vtkIdList::New();
-  vtkSmartPointer<vtkIdList> cellIds = vtkIdList::New();
+  vtkIdType* labels = regionId->GetPointer(0);
+  const vtkIdType numCells = regionId->GetNumberOfTuples();
+  std::fill(labels, labels + numCells, 0);
 
-  while (todoList->GetNumberOfIds() > 0)
+  int extent[6];
+  grid->GetExtent(extent);
+  const vtkIdType dims[3] = { std::max(extent[1] - extent[0], 1),
+    std::max(extent[3] - extent[2], 1), std::max(extent[5] - extent[4], 1) };
+  if (dims[0] * dims[1] * dims[2] != numCells)
   {
-    vtkIdType cellId = todoList->GetId(0);
-    todoList->DeleteId(cellId);
-    regionId->SetTuple1(cellId, this->NextRegionId);
+    return 0;
+  }
 
-    grid->GetCellPoints(cellId, ptIds);
-    for (int i = 0; i < ptIds->GetNumberOfIds(); i++)
+  // Two pass labeling with a union-find over the cells. Cells are connected
+  // when they share a point, so every cell is joined with the (up to) 13 of its
+  // 26 neighbors that come before it in memory order. The representative of a
+  // region is its first cell.
+  std::vector<vtkIdType> parent(numCells, -1);
+  auto find = [&parent](vtkIdType cellId) {
+    while (parent[cellId] != cellId)
+    {
+      // path halving
+      parent[cellId] = parent[parent[cellId]];
+      cellId = parent[cellId];
+    }
+    return cellId;
+  };
+
+  const vtkIdType sliceSize = dims[0] * dims[1];
+  vtkIdType cellId = 0;
+  for (vtkIdType k = 0; k < dims[2]; k++)
+  {
+    for (vtkIdType j = 0; j < dims[1]; j++)
     {
-      cellIds->SetNumberOfIds(0);
-      grid->GetPointCells(ptIds->GetId(i), cellIds);
-      for (int j = 0; j < cellIds->GetNumberOfIds(); j++)
+      for (vtkIdType i = 0; i < dims[0]; i++, cellId++)
       {
-        vtkIdType neighbor = cellIds->GetId(j);
-        if (neighbor == cellId || todoList->IsId(neighbor) >= 0)
+        if (volArray->GetComponent(cellId, 0) <= this->VolumeFractionSurfaceValue ||
+          (ghostArray->GetValue(cellId) & vtkDataSetAttributes::DUPLICATECELL) != 0)
         {
           continue;
         }
-        if (regionId->GetTuple1(neighbor) == 0 &&
-          volArray->GetTuple1(neighbor) > this->VolumeFractionSurfaceValue &&
-          (ghostArray->GetValue(neighbor) & vtkDataSetAttributes::DUPLICATECELL) == 0)
+        parent[cellId] = cellId;
+
+        for (int dk = -1; dk <= 0; dk++)
         {
-          todoList->InsertNextId(neighbor);
+          for (int dj = -1; dj <= (dk < 0 ? 1 : 0); dj++)
+          {
+            for (int di = -1; di <= (dk < 0 || dj < 0 ? 1 : -1); di++)
+            {
+              if (k + dk < 0 || j + dj < 0 || j + dj >= dims[1] || i + di < 0 ||
+                i + di >= dims[0])
+              {
+                continue;
+              }
+              vtkIdType neighbor = cellId + dk * sliceSize + dj * dims[0] + di;
+              if (parent[neighbor] < 0)
+              {
+                continue;
+              }
+              vtkIdType root1 = find(cellId);
+              vtkIdType root2 = find(neighbor);
+              if (root1 < root2)
+              {
+                parent[root2] = root1;
+              }
+              else if (root2 < root1)
+              {
+                parent[root1] = root2;
+              }
+            }
+          }
         }
       }
     }
   }
-  return 1;
+
+  // Number the regions in the order of their first cell. Representatives
+  // come first so their label is set before any other cell of the region.
+  vtkIdType numRegions = 0;
+  for (cellId = 0; cellId < numCells; cellId++)
+  {
+    if (parent[cellId] < 0)
+    {
+      continue;
+    }
+    vtkIdType root = find(cellId);
+    labels[cellId] = (root == cellId) ? ++numRegions : labels[root];
+  }
+  return numRegions;
 }
 
 //----------------------------------------------------------------------------
@@ -755,39 +701,6 @@ void vtkAMRConnectivity::ProcessBoundaryAtBlock(vtkNonOverlappingAMR* volume,
     return;
   }
 
-  if (block->ProcessId != neighbor->ProcessId)
-  {
-    int levelId, blockId, processId;
-    if (neighbor->ProcessId != myProc)
-    {
-      levelId = block->Level;
-      blockId = block->BlockId;
-      processId = neighbor->ProcessId;
-    }
-    else /* if (block->ProcessId != myProc) */
-    {
-      levelId = neighbor->Level;
-      blockId = neighbor->BlockId;
-      processId = block->ProcessId;
-    }
-
-    // Add this neighbor to this block's neighbor list.
-    bool contained = false;
-    for (size_t i = 0; i < this->NeighborList[levelId][blockId].size(); i++)
-    {
-      if (this->NeighborList[levelId][blockId][i] == processId)
-      {
-        contained = true;
-        break;
-      }
-    }
-    if (!contained)
-    {
-      this->NeighborList[levelId][blockId].push_back(processId);
-      this->ValidNeighbor[processId] = true;
-    }
-  }
-
   if (block->ProcessId == myProc)
   {
     vtkUniformGrid* grid = volume->GetDataSet(block->Level, block->BlockId);
@@ -1044,141 +957,25 @@ int vtkAMRConnectivity::ExchangeBoundaries(vtkMPIController* controller)
   return 1;
 }
 
-int vtkAMRConnectivity::ExchangeEquivPairs(vtkMPIController* controller)
+//----------------------------------------------------------------------------
+int vtkAMRConnectivity::GatherEquivalences(vtkMultiProcessController* controller)
 {
-  if (controller == 0)
-  {
-    vtkErrorMacro("vtkAMRConnectivity only works parallel in MPI environment");
-    return 0;
-  }
-#if VTK_MODULE_ENABLE_VTK_ParallelMPI
-  int myProc = controller->GetLocalProcessId();
-  int numProcs = controller->GetNumberOfProcesses();
+  vtkNew<vtkIntArray> localPairs;
+  this->Equivalence->GetEquivalencePairs(localPairs);
 
-  vtkAMRConnectivityCommRequestList receiveList;
-  for (size_t i = 0; i < static_cast<unsigned int>(numProcs); i++)
+  vtkNew<vtkIntArray> allPairs;
+  if (!controller->AllGatherV(localPairs, allPairs))
   {
-    if (i == static_cast<unsigned int>(myProc) || !this->ValidNeighbor[i])
-    {
-      continue;
-    }
-
-    vtkSmartPointer<vtkIntArray> array = vtkSmartPointer<vtkIntArray>::New();
-    array->SetNumberOfComponents(1);
-    array->SetNumberOfTuples(1);
-
-    vtkAMRConnectivityCommRequest request;
-    request.SendProcess = static_cast<int>(i);
-    request.ReceiveProcess = myProc;
-    request.Buffer = array;
-
-    controller->NoBlockReceive(
-      array->GetPointer(0), 1, static_cast<int>(i), EQUIV_SIZE_TAG, request.Request);
-
-    this->ReceiveList[i].clear();
-    receiveList.push_back(request);
-  }
-
-  vtkAMRConnectivityCommRequestList sendList;
-  for (size_t i = 0; i < static_cast<unsigned int>(numProcs); i++)
-  {
-    if (i == static_cast<unsigned int>(myProc) || !this->ValidNeighbor[i])
-    {
-      continue;
-    }
-
-    vtkSmartPointer<vtkIntArray> array = vtkSmartPointer<vtkIntArray>::New();
-    array->SetNumberOfComponents(1);
-    array->SetNumberOfTuples(1);
-    int size = this->EquivPairs[i] == 0 ? 0 : this->EquivPairs[i]->GetNumberOfTuples();
-    array->SetTuple1(0, size);
-
-    vtkAMRConnectivityCommRequest request;
-    request.SendProcess = myProc;
-    request.ReceiveProcess = static_cast<int>(i);
-    request.Buffer = array;
-
-    controller->NoBlockSend(
-      array->GetPointer(0), 1, static_cast<int>(i), EQUIV_SIZE_TAG, request.Request);
-
-    sendList.push_back(request);
-  }
-
-  std::vector<int> receive_sizes(numProcs);
-  for (int i = 0; i < numProcs; i++)
-  {
-    receive_sizes[i] = 0;
-  }
-
-  while (!receiveList.empty())
-  {
-    vtkAMRConnectivityCommRequest request = receiveList.WaitAny();
-    vtkSmartPointer<vtkIntArray> array = request.Buffer;
-    receive_sizes[request.SendProcess] = array->GetTuple1(0);
-  }
-
-  receiveList.clear();
-  sendList.WaitAll();
-  sendList.clear();
-
-  for (size_t i = 0; i < static_cast<unsigned int>(numProcs); i++)
-  {
-    if (i == static_cast<unsigned int>(myProc) || receive_sizes[i] == 0)
-    {
-      continue;
-    }
-
-    vtkSmartPointer<vtkIntArray> array = vtkSmartPointer<vtkIntArray>::New();
-    array->SetNumberOfComponents(1);
-    array->SetNumberOfTuples(receive_sizes[i]);
-
-    vtkAMRConnectivityCommRequest request;
-    request.SendProcess = static_cast<int>(i);
-    request.ReceiveProcess = myProc;
-    request.Buffer = array;
-
-    controller->NoBlockReceive(
-      array->GetPointer(0), receive_sizes[i], static_cast<int>(i), EQUIV_TAG, request.Request);
-
-    this->ReceiveList[i].clear();
-    receiveList.push_back(request);
-  }
-
-  for (size_t i = 0; i < static_cast<unsigned int>(numProcs); i++)
-  {
-    if (i == static_cast<unsigned int>(myProc) || this->EquivPairs[i] == 0 ||
-      this->EquivPairs[i]->GetNumberOfTuples() == 0)
-    {
-      continue;
-    }
-
-    vtkAMRConnectivityCommRequest request;
-    request.SendProcess = myProc;
-    request.ReceiveProcess = static_cast<int>(i);
-    request.Buffer = this->EquivPairs[i];
-
-    controller->NoBlockSend(this->EquivPairs[i]->GetPointer(0),
-      this->EquivPairs[i]->GetNumberOfTuples(), static_cast<int>(i), EQUIV_TAG, request.Request);
-
-    sendList.push_back(request);
+    vtkErrorMacro("Failed to gather the region equivalences");
+    return 0;
   }
 
-  while (!receiveList.empty())
+  const int* pairs = allPairs->GetPointer(0);
+  const vtkIdType numValues = allPairs->GetNumberOfTuples();
+  for (vtkIdType i = 0; i + 1 < numValues; i += 2)
   {
-    vtkAMRConnectivityCommRequest request = receiveList.WaitAny();
-    vtkSmartPointer<vtkIntArray> array = request.Buffer;
-    for (int i = 0; i < array->GetNumberOfTuples(); i += 2)
-    {
-      int v1 = array->GetValue(i);
-      int v2 = array->GetValue(i + 1);
-      this->Equivalence->AddEquivalence(v1, v2);
-    }
+    this->Equivalence->AddEquivalence(pairs[i], pairs[i + 1]);
   }
-
-  receiveList.clear();
-  sendList.WaitAll();
-  sendList.clear();
-#endif
   return 1;
 }
 
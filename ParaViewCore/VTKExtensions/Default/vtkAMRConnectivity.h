@@ -16,7 +16,12 @@
  * @class   vtkAMRConnectivity
  * @brief   Identify fragments in the grid
  *
- *
+ * Adds a "RegionId-<array>" cell array labeling the connected regions where
+ * the volume fraction is above VolumeFractionSurfaceValue. Regions are first
+ * labeled within each block, blocks being processed in parallel using
+ * vtkSMPTools, and are then merged across block boundaries. Equivalences
+ * between regions of blocks on different processes are combined in a single
+ * collective so that every region gets the smallest of its ids.
  *
  * .SEE vtkAMRConnectivity
 */
@@ -38,6 +43,7 @@ class vtkAMRDualGridHelper;
 class vtkAMRDualGridHelperBlock;
 class vtkAMRConnectivityEquivalence;
 class vtkMPIController;
+class vtkMultiProcessController;
 class vtkUnsignedCharArray;
 
 class VTKPVVTKEXTENSIONSDEFAULT_EXPORT vtkAMRConnectivity : public vtkMultiBlockDataSetAlgorithm
@@ -98,24 +104,26 @@ protected:
   std::vector<std::vector<vtkSmartPointer<vtkIdTypeArray> > > BoundaryArrays;
   std::vector<std::vector<int> > ReceiveList;
 
-  std::vector<bool> ValidNeighbor;
-  std::vector<std::vector<std::vector<int> > > NeighborList;
-  std::vector<vtkSmartPointer<vtkIntArray> > EquivPairs;
-
   int FillInputPortInformation(int port, vtkInformation* info) override;
   int FillOutputPortInformation(int port, vtkInformation* info) override;
 
   int RequestData(vtkInformation*, vtkInformationVector**, vtkInformationVector*) override;
 
   int DoRequestData(vtkNonOverlappingAMR*, const char*);
-  int WavePropagation(vtkIdType cellIdStart, vtkUniformGrid* grid, vtkIdTypeArray* regionId,
+
+  /**
+   * Labels the connected regions of a single block with ids starting at 1,
+   * leaving 0 in the cells outside of any region. Returns the number of
+   * regions. Only touches \c regionId so blocks can be labeled concurrently.
+   */
+  vtkIdType LabelBlockRegions(vtkUniformGrid* grid, vtkIdTypeArray* regionId,
     vtkDataArray* volArray, vtkUnsignedCharArray* ghostArray);
 
   vtkAMRDualGridHelperBlock* GetBlockNeighbor(vtkAMRDualGridHelperBlock* block, int dir);
   void ProcessBoundaryAtBlock(vtkNonOverlappingAMR* volume, vtkAMRDualGridHelperBlock* block,
     vtkAMRDualGridHelperBlock* neighbor, int dir);
   int ExchangeBoundaries(vtkMPIController* controller);
-  int ExchangeEquivPairs(vtkMPIController* controller);
+  int GatherEquivalences(vtkMultiProcessController* controller);
   void ProcessBoundaryAtNeighbor(vtkNonOverlappingAMR* volume, vtkIdTypeArray* array);
 
 private:
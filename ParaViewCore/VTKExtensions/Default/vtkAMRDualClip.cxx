@@ -15,6 +15,7 @@
 #include "vtkAMRDualClip.h"
 #include "vtkAMRDualGridHelper.h"
 
+#include <algorithm>
 #include <vector>
 
 // Pipeline & VTK
@@ -35,12 +36,15 @@
 #include "vtkCellData.h"
 #include "vtkCompositeDataIterator.h"
 #include "vtkDataSet.h"
+#include "vtkIdTypeArray.h"
 #include "vtkImageData.h"
 #include "vtkIntArray.h"
 #include "vtkMultiBlockDataSet.h"
 #include "vtkMultiPieceDataSet.h"
 #include "vtkNonOverlappingAMR.h"
 #include "vtkPointData.h"
+#include "vtkSMPTools.h"
+#include "vtkSmartPointer.h"
 #include "vtkUniformGrid.h"
 #include "vtkUnsignedCharArray.h"
 #include "vtkUnsignedCharArray.h"
@@ -145,7 +149,25 @@ public:
 
   vtkUnsignedCharArray* GetLevelMaskArray() { return this->LevelMaskArray; }
 
+  // Blocks are clipped in parallel, so the locator holds block-local point
+  // ids.  Once the block is clipped, the local ids are mapped to output ids:
+  // the points shared by an already numbered neighbor take its id and the
+  // others are numbered from "nextPointId".  Returns the next free point id.
+  void InitializeOutputIds(vtkIdType numberOfPoints);
+  vtkIdType NumberOutputIds(vtkIdType nextPointId);
+  void SwapOutputIds(std::vector<vtkIdType>& outputIds);
+
 private:
+  // Entries >= 0 are local point ids.  Output ids shared by a neighbor are
+  // stored as -2 - id so that -1 still marks an empty entry.
+  vtkIdType GetOutputId(vtkIdType entry) const
+  {
+    return entry >= 0 ? this->OutputIds[entry] : -2 - entry;
+  }
+  void ShareOutputId(vtkIdType* entry, vtkIdType outputId);
+
+  std::vector<vtkIdType> OutputIds;
+
   int DualCellDimensions[3];
   // Increments for translating 3d to 1d.  XIncrement = 1;
   int YIncrement;
@@ -182,6 +204,44 @@ unsigned char* vtkAMRDualClipLocator::GetLevelMaskPointer()
   return this->LevelMaskArray->GetPointer(0);
 }
 
+//----------------------------------------------------------------------------
+void vtkAMRDualClipLocator::InitializeOutputIds(vtkIdType numberOfPoints)
+{
+  this->OutputIds.assign(numberOfPoints, -1);
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkAMRDualClipLocator::NumberOutputIds(vtkIdType nextPointId)
+{
+  for (size_t ii = 0; ii < this->OutputIds.size(); ++ii)
+  {
+    if (this->OutputIds[ii] < 0)
+    {
+      this->OutputIds[ii] = nextPointId++;
+    }
+  }
+  return nextPointId;
+}
+
+//----------------------------------------------------------------------------
+void vtkAMRDualClipLocator::SwapOutputIds(std::vector<vtkIdType>& outputIds)
+{
+  this->OutputIds.swap(outputIds);
+}
+
+//----------------------------------------------------------------------------
+void vtkAMRDualClipLocator::ShareOutputId(vtkIdType* entry, vtkIdType outputId)
+{
+  if (*entry >= 0)
+  { // This block created the point too, merge it with the neighbor's.
+    this->OutputIds[*entry] = outputId;
+  }
+  else
+  {
+    *entry = -2 - outputId;
+  }
+}
+
 //----------------------------------------------------------------------------
 vtkAMRDualClipLocator* vtkAMRDualClipGetBlockLocator(vtkAMRDualGridHelperBlock* block)
 {
@@ -209,6 +269,49 @@ vtkAMRDualClipLocator* vtkAMRDualClipGetBlockLocator(vtkAMRDualGridHelperBlock*
   return (vtkAMRDualClipLocator*)(block->UserData);
 }
 
+//----------------------------------------------------------------------------
+// Blocks are clipped in parallel, each into its own mesh with block-local
+// point ids.  The meshes are appended to the output afterwards.
+class vtkAMRDualClipBlockOutput
+{
+public:
+  vtkAMRDualClipBlockOutput()
+    : Block(0)
+    , BlockId(0)
+    , Locator(0)
+    , PointOffset(0)
+    , NumberOfCells(0)
+    , ConnectivityLength(0)
+    , CellOffset(0)
+    , ConnectivityOffset(0)
+  {
+  }
+
+  vtkAMRDualGridHelperBlock* Block;
+  int BlockId;
+  vtkAMRDualClipLocator* Locator;
+
+  vtkSmartPointer<vtkUnstructuredGrid> Mesh;
+  vtkSmartPointer<vtkPoints> Points;
+  vtkSmartPointer<vtkCellArray> Cells;
+  vtkSmartPointer<vtkUnsignedCharArray> LevelMask;
+
+  // Output ids of the local points when merging points.  Points with an id
+  // below PointOffset were created by a previous block.
+  std::vector<vtkIdType> PointIds;
+  vtkIdType PointOffset;
+
+  vtkIdType NumberOfCells;
+  vtkIdType ConnectivityLength;
+  vtkIdType CellOffset;
+  vtkIdType ConnectivityOffset;
+
+  vtkIdType GetOutputId(vtkIdType localId) const
+  {
+    return this->PointIds.empty() ? this->PointOffset + localId : this->PointIds[localId];
+  }
+};
+
 //----------------------------------------------------------------------------
 // The only data specific stuff we need to do for the contour.
 template <class T>
@@ -988,24 +1091,28 @@ void vtkAMRDualClipLocator::ShareBlockLocatorWithNeighbor(
         outOffsetX = outOffsetY + xOut;
 
         pointId = blockLocator->XEdges[inOffsetX];
-        if (pointId >= 0)
+        if (pointId != -1)
         {
-          neighborLocator->XEdges[outOffsetX] = pointId;
+          neighborLocator->ShareOutputId(
+            neighborLocator->XEdges + outOffsetX, blockLocator->GetOutputId(pointId));
         }
         pointId = blockLocator->YEdges[inOffsetX];
-        if (pointId >= 0)
+        if (pointId != -1)
         {
-          neighborLocator->YEdges[outOffsetX] = pointId;
+          neighborLocator->ShareOutputId(
+            neighborLocator->YEdges + outOffsetX, blockLocator->GetOutputId(pointId));
         }
         pointId = blockLocator->ZEdges[inOffsetX];
-        if (pointId >= 0)
+        if (pointId != -1)
         {
-          neighborLocator->ZEdges[outOffsetX] = pointId;
+          neighborLocator->ShareOutputId(
+            neighborLocator->ZEdges + outOffsetX, blockLocator->GetOutputId(pointId));
         }
         pointId = blockLocator->Corners[inOffsetX];
-        if (pointId >= 0)
+        if (pointId != -1)
         {
-          neighborLocator->Corners[outOffsetX] = pointId;
+          neighborLocator->ShareOutputId(
+            neighborLocator->Corners + outOffsetX, blockLocator->GetOutputId(pointId));
         }
 
         inOffsetX += 1;
@@ -1040,17 +1147,15 @@ vtkAMRDualClip::vtkAMRDualClip()
   this->LevelMaskPointArray = 0;
   this->BlockIdCellArray = 0;
   this->Helper = 0;
-
-  this->BlockLocator = 0;
 }
 
 //----------------------------------------------------------------------------
 vtkAMRDualClip::~vtkAMRDualClip()
 {
-  if (this->BlockLocator)
+  if (this->Helper)
   {
-    delete this->BlockLocator;
-    this->BlockLocator = 0;
+    this->Helper->Delete();
+    this->Helper = 0;
   }
   this->SetController(NULL);
 }
@@ -1159,12 +1264,11 @@ vtkMultiBlockDataSet* vtkAMRDualClip::DoRequestData(
 
   mpds->SetNumberOfPieces(0);
 
-  if (this->Helper)
+  // Kept between requests, see vtkAMRDualGridHelper::ReleaseImages.
+  if (!this->Helper)
   {
-    this->Helper->Delete();
+    this->Helper = vtkAMRDualGridHelper::New();
   }
-
-  this->Helper = vtkAMRDualGridHelper::New();
   this->Helper->SetEnableDegenerateCells(this->EnableDegenerateCells);
   if (this->EnableMultiProcessCommunication)
   {
@@ -1207,16 +1311,69 @@ vtkMultiBlockDataSet* vtkAMRDualClip::DoRequestData(
   int numBlocks;
   int blockId;
 
-  // Add each block.
+  // Collect the local blocks in level order, each with its own mesh.
+  // Remote blocks are only to setup local block bit flags.
+  std::vector<vtkAMRDualClipBlockOutput> outputs;
   for (int level = 0; level < numLevels; ++level)
   {
     numBlocks = this->Helper->GetNumberOfBlocksInLevel(level);
     for (blockId = 0; blockId < numBlocks; ++blockId)
     {
       vtkAMRDualGridHelperBlock* block = this->Helper->GetBlock(level, blockId);
-      this->ProcessBlock(block, blockId, arrayNameToProcess);
+      if (block->Image == 0 || block->Image->GetCellData()->GetArray(arrayNameToProcess) == 0)
+      {
+        continue;
+      }
+      vtkAMRDualClipBlockOutput output;
+      output.Block = block;
+      output.BlockId = blockId;
+      // Same layout as the output mesh so the point data can be copied by index.
+      output.Mesh = vtkSmartPointer<vtkUnstructuredGrid>::New();
+      output.Points = vtkSmartPointer<vtkPoints>::New();
+      output.Cells = vtkSmartPointer<vtkCellArray>::New();
+      output.LevelMask = vtkSmartPointer<vtkUnsignedCharArray>::New();
+      output.LevelMask->SetName("LevelMask");
+      output.Mesh->SetPoints(output.Points);
+      output.Mesh->GetPointData()->AddArray(output.LevelMask);
+      this->InitializeCopyAttributes(hbdsInput, output.Mesh);
+      if (this->EnableMergePoints)
+      { // Neighbors are merged after all the blocks are clipped.
+        output.Locator = vtkAMRDualClipGetBlockLocator(block);
+      }
+      outputs.push_back(output);
     }
   }
+  const vtkIdType numOutputs = static_cast<vtkIdType>(outputs.size());
+
+  if (this->EnableMergePoints)
+  {
+    // Compute the center of every level mask before copying the ghost
+    // regions from the neighbors.
+    vtkSMPTools::For(0, numOutputs, 1, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType ii = begin; ii < end; ++ii)
+      {
+        vtkDataArray* volumeFractionArray =
+          outputs[ii].Block->Image->GetCellData()->GetArray(arrayNameToProcess);
+        outputs[ii].Locator->ComputeLevelMask(
+          volumeFractionArray, this->IsoValue, this->EnableInternalDecimation);
+      }
+    });
+    vtkSMPTools::For(0, numOutputs, 1, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType ii = begin; ii < end; ++ii)
+      {
+        this->InitializeLevelMask(outputs[ii].Block);
+      }
+    });
+  }
+
+  vtkSMPTools::For(0, numOutputs, 1, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType ii = begin; ii < end; ++ii)
+    {
+      this->ProcessBlock(&outputs[ii], arrayNameToProcess);
+    }
+  });
+
+  this->AppendBlockOutputs(outputs);
 
   this->BlockIdCellArray->Delete();
   this->BlockIdCellArray = 0;
@@ -1233,8 +1390,7 @@ vtkMultiBlockDataSet* vtkAMRDualClip::DoRequestData(
   this->Cells = 0;
 
   mpds->Delete();
-  this->Helper->Delete();
-  this->Helper = 0;
+  this->Helper->ReleaseImages();
 
   return mbdsOutput0;
 }
@@ -1305,6 +1461,9 @@ void vtkAMRDualClip::ShareBlockLocatorWithNeighbors(vtkAMRDualGridHelperBlock* b
 //----------------------------------------------------------------------------
 // This is called before we start processing a block to make sure
 // the locator is initialized in center and ghost regions.
+// The centers of all the local level masks must already be computed.  Only
+// the ghost regions of this block are written, so blocks can be initialized
+// in parallel.
 void vtkAMRDualClip::InitializeLevelMask(vtkAMRDualGridHelperBlock* block)
 {
   vtkImageData* image = block->Image;
@@ -1312,13 +1471,9 @@ void vtkAMRDualClip::InitializeLevelMask(vtkAMRDualGridHelperBlock* block)
   { // Remote blocks are only to setup local block bit flags.
     return;
   }
-  vtkDataArray* volumeFractionArray = image->GetCellData()->GetArray(this->Helper->GetArrayName());
 
   vtkAMRDualClipLocator* locator = vtkAMRDualClipGetBlockLocator(block);
-  locator->ComputeLevelMask(volumeFractionArray, this->IsoValue, this->EnableInternalDecimation);
-
   vtkAMRDualGridHelperBlock* neighbor;
-  vtkAMRDualClipLocator* neighborLocator;
 
   // We need to check for neighbors in lower or equal
   // to our level.  When blocks from different levels share a border
@@ -1352,20 +1507,11 @@ void vtkAMRDualClip::InitializeLevelMask(vtkAMRDualGridHelperBlock* block)
           {
             // I could further prune and only copy to regions I own.
             neighbor = this->Helper->GetBlock(level, ix, iy, iz);
-            // If the neighbor was already processed, then its level mask
-            // was copied to this block already.
-            if (neighbor && neighbor->RegionBits[1][1][1] != 0)
+            // Remote neighbors were copied by DistributeLevelMasks.
+            if (neighbor && neighbor->Image &&
+              neighbor->Image->GetCellData()->GetArray(this->Helper->GetArrayName()))
             {
-              neighborLocator = vtkAMRDualClipGetBlockLocator(neighbor);
-              image = neighbor->Image;
-              if (image)
-              {
-                //                volumeFractionArray = this->GetInputArrayToProcess(0, image);
-                volumeFractionArray = image->GetCellData()->GetArray(this->Helper->GetArrayName());
-                neighborLocator->ComputeLevelMask(
-                  volumeFractionArray, this->IsoValue, this->EnableInternalDecimation);
-                locator->CopyNeighborLevelMask(block, neighbor);
-              }
+              locator->CopyNeighborLevelMask(block, neighbor);
             }
           }
         }
@@ -1401,63 +1547,11 @@ void vtkAMRDualClip::InitializeLevelMask(vtkAMRDualGridHelperBlock* block)
   }
 }
 
-//----------------------------------------------------------------------------
-// This is called after we finished processing a block to share the locator
-// level mask with neighbors before we delete the locator.
-void vtkAMRDualClip::ShareLevelMask(vtkAMRDualGridHelperBlock* block)
-{
-  vtkAMRDualGridHelperBlock* neighbor;
-  vtkAMRDualClipLocator* neighborLocator;
-  int numLevels = this->Helper->GetNumberOfLevels();
-
-  // We need to check for neighbors in higher or equal
-  // to our level.  When blocks from different levels share a border
-  // the high level block always owns the shared region.
-  int xMid, yMid, zMid;
-  int xMin, xMax, yMin, yMax, zMin, zMax;
-
-  for (int level = block->Level; level < numLevels; ++level)
-  {
-    // Neighborhood.
-    int levelDiff = level - block->Level;
-    xMid = block->GridIndex[0];
-    xMin = (xMid << levelDiff) - 1;
-    xMax = (xMid + 1) << levelDiff;
-    yMid = block->GridIndex[1];
-    yMin = (yMid << levelDiff) - 1;
-    yMax = (yMid + 1) << levelDiff;
-    zMid = block->GridIndex[2];
-    zMin = (zMid << levelDiff) - 1;
-    zMax = (zMid + 1) << levelDiff;
-
-    for (int iz = zMin; iz <= zMax; ++iz)
-    {
-      for (int iy = yMin; iy <= yMax; ++iy)
-      {
-        for (int ix = xMin; ix <= xMax; ++ix)
-        {
-          if ((ix >> levelDiff) != xMid || (iy >> levelDiff) != yMid || (iz >> levelDiff) != zMid)
-          {
-            // I could further prune and only copy to regions owned by neighbor.
-            neighbor = this->Helper->GetBlock(level, ix, iy, iz);
-            // If the neighbor was already processed, then its level mask
-            // was copied to this block already.
-            if (neighbor && neighbor->Image && neighbor->RegionBits[1][1][1] != 0)
-            {
-              neighborLocator = vtkAMRDualClipGetBlockLocator(neighbor);
-              neighborLocator->CopyNeighborLevelMask(neighbor, block);
-            }
-          }
-        }
-      }
-    }
-  }
-}
-
 //----------------------------------------------------------------------------
 void vtkAMRDualClip::ProcessBlock(
-  vtkAMRDualGridHelperBlock* block, int blockId, const char* arrayNameToProcess)
+  vtkAMRDualClipBlockOutput* output, const char* arrayNameToProcess)
 {
+  vtkAMRDualGridHelperBlock* block = output->Block;
   vtkImageData* image = block->Image;
   if (image == 0)
   { // Remote blocks are only to setup local block bit flags.
@@ -1486,20 +1580,12 @@ void vtkAMRDualClip::ProcessBlock(
 
   // Locator merges points in this block.
   // Input the dimensions of the dual cells with ghosts.
-  if (this->EnableMergePoints)
-  {
-    this->InitializeLevelMask(block);
-    this->BlockLocator = vtkAMRDualClipGetBlockLocator(block);
-  }
-  else
-  { // Shared locator.
-    if (this->BlockLocator == 0)
-    {
-      this->BlockLocator = new vtkAMRDualClipLocator;
-    }
-    this->BlockLocator->Initialize(
+  // When merging points, the level mask was initialized in DoRequestData.
+  if (!this->EnableMergePoints)
+  { // Temporary locator.
+    output->Locator = new vtkAMRDualClipLocator;
+    output->Locator->Initialize(
       extent[1] - extent[0], extent[3] - extent[2], extent[5] - extent[4]);
-    // this->BlockLocator->CopyRegionLevelDifferences(block);
   }
   image->GetOrigin(origin);
   spacing = image->GetSpacing();
@@ -1575,7 +1661,7 @@ void vtkAMRDualClip::ProcessBlock(
           cornerOffsets[5] = xOffset + 1 + zInc;
           cornerOffsets[6] = xOffset + yInc + zInc;
           cornerOffsets[7] = xOffset + 1 + yInc + zInc;
-          this->ProcessDualCell(block, blockId, x, y, z, cornerOffsets, volumeFractionArray);
+          this->ProcessDualCell(output, x, y, z, cornerOffsets, volumeFractionArray);
         }
         xOffset += 1; // xInc
       }
@@ -1586,30 +1672,157 @@ void vtkAMRDualClip::ProcessBlock(
 
   if (this->EnableMergePoints)
   {
-    this->ShareLevelMask(block);
+    // The points are merged with the neighbors in AppendBlockOutputs.
+    output->Locator->InitializeOutputIds(output->Points->GetNumberOfPoints());
+  }
+  else
+  {
+    delete output->Locator;
+    output->Locator = 0;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkAMRDualClip::AppendBlockOutputs(std::vector<vtkAMRDualClipBlockOutput>& outputs)
+{
+  const vtkIdType numOutputs = static_cast<vtkIdType>(outputs.size());
+
+  // Number the points in block order.  The locator of each block is shared
+  // with its unprocessed neighbors just like when blocks are clipped one
+  // after the other, so the output does not depend on the number of threads.
+  vtkIdType numPoints = 0;
+  for (vtkIdType ii = 0; ii < numOutputs; ++ii)
+  {
+    vtkAMRDualClipBlockOutput& output = outputs[ii];
+    output.PointOffset = numPoints;
+    if (!this->EnableMergePoints)
+    {
+      numPoints += output.Points->GetNumberOfPoints();
+      continue;
+    }
+    vtkAMRDualGridHelperBlock* block = output.Block;
+    numPoints = output.Locator->NumberOutputIds(numPoints);
     // Copy point ids into neighbor locators.
     this->ShareBlockLocatorWithNeighbors(block);
+    output.Locator->SwapOutputIds(output.PointIds);
     // We are done.  We no longer need the locator for this block.
-    delete this->BlockLocator;
-    this->BlockLocator = 0;
+    delete output.Locator;
+    output.Locator = 0;
     block->UserData = 0;
     // Lets use this unused flag (owner of center region/block) to indicate
     // that the block is already processes.
     // This will keep neighbors from recreating the locator.
-    // Another option would be to create the locator object for
-    // all blocks but do not allocate until needed.  Then the existence of the locator
-    // would tell whether the block was processed.
     block->RegionBits[1][1][1] = 0;
   }
+  // Blocks without the array (or all blocks when points are not merged) may
+  // still hold a locator made by a neighbor or by DistributeLevelMasks.
+  for (int level = 0; level < this->Helper->GetNumberOfLevels(); ++level)
+  {
+    int numBlocks = this->Helper->GetNumberOfBlocksInLevel(level);
+    for (int blockId = 0; blockId < numBlocks; ++blockId)
+    {
+      vtkAMRDualGridHelperBlock* block = this->Helper->GetBlock(level, blockId);
+      delete static_cast<vtkAMRDualClipLocator*>(block->UserData);
+      block->UserData = 0;
+    }
+  }
+
+  // Convert the tetrahedra to output point ids.  Merging points can make
+  // them degenerate, those are dropped as if they were never added.
+  vtkSMPTools::For(0, numOutputs, 1, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType ii = begin; ii < end; ++ii)
+    {
+      vtkAMRDualClipBlockOutput& output = outputs[ii];
+      const vtkIdType numCells = output.Cells->GetNumberOfCells();
+      vtkIdType* inPtr = output.Cells->GetData()->GetPointer(0);
+      vtkIdType* outPtr = inPtr;
+      vtkIdType* start = inPtr;
+      output.NumberOfCells = 0;
+      for (vtkIdType cellId = 0; cellId < numCells; ++cellId, inPtr += 5)
+      {
+        // outPtr never passes inPtr, so the cells can be compacted in place.
+        vtkIdType ids[4];
+        for (int jj = 0; jj < 4; ++jj)
+        {
+          ids[jj] = output.GetOutputId(inPtr[jj + 1]);
+        }
+        if (ids[0] == ids[1] || ids[0] == ids[2] || ids[0] == ids[3] || ids[1] == ids[2] ||
+          ids[1] == ids[3] || ids[2] == ids[3])
+        {
+          continue;
+        }
+        outPtr[0] = 4;
+        std::copy(ids, ids + 4, outPtr + 1);
+        outPtr += 5;
+        ++output.NumberOfCells;
+      }
+      output.ConnectivityLength = outPtr - start;
+    }
+  });
+
+  vtkIdType numCells = 0;
+  vtkIdType connectivityLength = 0;
+  for (vtkIdType ii = 0; ii < numOutputs; ++ii)
+  {
+    outputs[ii].CellOffset = numCells;
+    outputs[ii].ConnectivityOffset = connectivityLength;
+    numCells += outputs[ii].NumberOfCells;
+    connectivityLength += outputs[ii].ConnectivityLength;
+  }
+
+  // Allocate the output and copy the blocks into it.  The point data of the
+  // blocks was set up the same way as the output, level mask included.
+  vtkPointData* outPD = this->Mesh->GetPointData();
+  this->Points->SetNumberOfPoints(numPoints);
+  for (int arrayIdx = 0; arrayIdx < outPD->GetNumberOfArrays(); ++arrayIdx)
+  {
+    outPD->GetAbstractArray(arrayIdx)->SetNumberOfTuples(numPoints);
+  }
+  vtkIdTypeArray* connectivity = vtkIdTypeArray::New();
+  connectivity->SetNumberOfValues(connectivityLength);
+  this->BlockIdCellArray->SetNumberOfValues(numCells);
+
+  vtkSMPTools::For(0, numOutputs, 1, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType ii = begin; ii < end; ++ii)
+    {
+      vtkAMRDualClipBlockOutput& output = outputs[ii];
+      vtkPointData* inPD = output.Mesh->GetPointData();
+      const int numArrays = std::min(inPD->GetNumberOfArrays(), outPD->GetNumberOfArrays());
+      const vtkIdType numLocalPoints = output.Points->GetNumberOfPoints();
+      for (vtkIdType localId = 0; localId < numLocalPoints; ++localId)
+      {
+        const vtkIdType outId = output.GetOutputId(localId);
+        if (outId < output.PointOffset)
+        { // Merged with a point of a previous block.
+          continue;
+        }
+        this->Points->GetData()->SetTuple(outId, localId, output.Points->GetData());
+        for (int arrayIdx = 0; arrayIdx < numArrays; ++arrayIdx)
+        {
+          outPD->GetAbstractArray(arrayIdx)->SetTuple(
+            outId, localId, inPD->GetAbstractArray(arrayIdx));
+        }
+      }
+      const vtkIdType* cells = output.Cells->GetData()->GetPointer(0);
+      std::copy(cells, cells + output.ConnectivityLength,
+        connectivity->GetPointer(output.ConnectivityOffset));
+      int* blockIds = this->BlockIdCellArray->GetPointer(output.CellOffset);
+      std::fill(blockIds, blockIds + output.NumberOfCells, output.BlockId);
+    }
+  });
+
+  this->Cells->SetCells(numCells, connectivity);
+  connectivity->Delete();
 }
 
 //----------------------------------------------------------------------------
 // Not implemented as optimally as we could.  It can be improved by making
 // a fast path for internal cells (with no degeneracies).
-void vtkAMRDualClip::ProcessDualCell(vtkAMRDualGridHelperBlock* block, int blockId, int x, int y,
-  int z, vtkIdType cornerOffsets[8], vtkDataArray* volumeFractionArray)
+void vtkAMRDualClip::ProcessDualCell(vtkAMRDualClipBlockOutput* output, int x, int y, int z,
+  vtkIdType cornerOffsets[8], vtkDataArray* volumeFractionArray)
 {
   // compute the case index
+  vtkAMRDualGridHelperBlock* block = output->Block;
   vtkImageData* image = block->Image;
   if (image == 0)
   { // Remote blocks are only to setup local block bit flags.
@@ -1835,8 +2048,8 @@ void vtkAMRDualClip::ProcessDualCell(vtkAMRDualGridHelperBlock* block, int block
       // convert from VTK corner ids to bit (x,y,z) corner ids.
       if (casePtId < 8)
       { // Corner (internal point)
-        ptIdPtr = this->BlockLocator->GetCornerPointer(x, y, z, casePtId, block->OriginIndex);
-        levelMaskValue = this->BlockLocator->GetLevelMaskValue(
+        ptIdPtr = output->Locator->GetCornerPointer(x, y, z, casePtId, block->OriginIndex);
+        levelMaskValue = output->Locator->GetLevelMaskValue(
           x + ((casePtId & 1) ? 1 : 0), y + ((casePtId & 2) ? 1 : 0), z + ((casePtId & 4) ? 1 : 0));
         if (levelMaskValue == 0)
         { // bug !!!!! trying to figure out what is going on.
@@ -1888,7 +2101,7 @@ void vtkAMRDualClip::ProcessDualCell(vtkAMRDualGridHelperBlock* block, int block
           pt[0] = origin[0] + spacing[0] * (double)(1 << levelDiff) * ((double)(px) + dx);
           pt[1] = origin[1] + spacing[1] * (double)(1 << levelDiff) * ((double)(py) + dy);
           pt[2] = origin[2] + spacing[2] * (double)(1 << levelDiff) * ((double)(pz) + dz);
-          *ptIdPtr = this->Points->InsertNextPoint(pt);
+          *ptIdPtr = output->Points->InsertNextPoint(pt);
           if (pt[1] > 100000.0)
           {
             cerr << "bug\n";
@@ -1902,14 +2115,14 @@ void vtkAMRDualClip::ProcessDualCell(vtkAMRDualGridHelperBlock* block, int block
           // Averaging could be a pre processing step but we would have to modify input attributes
           // .......
           vtkIdType offset = cornerOffsets[casePtId];
-          this->Mesh->GetPointData()->CopyData(block->Image->GetCellData(), offset, *ptIdPtr);
+          output->Mesh->GetPointData()->CopyData(block->Image->GetCellData(), offset, *ptIdPtr);
 
-          this->LevelMaskPointArray->InsertNextValue(levelMaskValue);
+          output->LevelMask->InsertNextValue(levelMaskValue);
         }
       }
       else
       { // Edge (clipped cell, point on iso surface)
-        ptIdPtr = this->BlockLocator->GetEdgePointer(x, y, z, casePtId - 8);
+        ptIdPtr = output->Locator->GetEdgePointer(x, y, z, casePtId - 8);
         if (*ptIdPtr == -1)
         {
           int edge = casePtId - 8;
@@ -1926,7 +2139,7 @@ void vtkAMRDualClip::ProcessDualCell(vtkAMRDualGridHelperBlock* block, int block
             cornerPoints[pt1Idx | 1] + k * (cornerPoints[pt2Idx | 1] - cornerPoints[pt1Idx | 1]);
           pt[2] =
             cornerPoints[pt1Idx | 2] + k * (cornerPoints[pt2Idx | 2] - cornerPoints[pt1Idx | 2]);
-          *ptIdPtr = this->Points->InsertNextPoint(pt);
+          *ptIdPtr = output->Points->InsertNextPoint(pt);
           if (pt[1] > 100000.0)
           {
             cerr << "bug\n";
@@ -1936,10 +2149,10 @@ void vtkAMRDualClip::ProcessDualCell(vtkAMRDualGridHelperBlock* block, int block
           // Find the offsets of the two attributes to interpolate
           vtkIdType offset0 = cornerOffsets[pt1Idx >> 2];
           vtkIdType offset1 = cornerOffsets[pt2Idx >> 2];
-          this->Mesh->GetPointData()->InterpolateEdge(
+          output->Mesh->GetPointData()->InterpolateEdge(
             block->Image->GetCellData(), *ptIdPtr, offset0, offset1, k);
 
-          this->LevelMaskPointArray->InsertNextValue(levelMaskValue);
+          output->LevelMask->InsertNextValue(levelMaskValue);
         }
       }
       pointIds[ii] = *ptIdPtr;
@@ -1947,8 +2160,7 @@ void vtkAMRDualClip::ProcessDualCell(vtkAMRDualGridHelperBlock* block, int block
     if (pointIds[0] != pointIds[1] && pointIds[0] != pointIds[2] && pointIds[0] != pointIds[3] &&
       pointIds[1] != pointIds[2] && pointIds[1] != pointIds[3] && pointIds[2] != pointIds[3])
     {
-      this->Cells->InsertNextCell(4, pointIds);
-      this->BlockIdCellArray->InsertNextValue(blockId);
+      output->Cells->InsertNextCell(4, pointIds);
     }
   }
 }
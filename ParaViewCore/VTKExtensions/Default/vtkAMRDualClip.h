@@ -21,6 +21,11 @@
  * transitions are handled correctly, and second is that internal
  * cells are decimated.  I use a variation of degenerate points/cells
  * used for level transitions.
+ *
+ * The local blocks are clipped in parallel (see vtkSMPTools), each into its
+ * own mesh.  The meshes are then appended in block order and the points
+ * shared by neighbor blocks are merged, so the output does not depend on the
+ * number of threads.
 */
 
 #ifndef vtkAMRDualClip_h
@@ -28,6 +33,7 @@
 
 #include "vtkMultiBlockDataSetAlgorithm.h"
 #include "vtkPVVTKExtensionsDefaultModule.h" //needed for exports
+#include <vector>                             // for std::vector
 
 class vtkDataSet;
 class vtkImageData;
@@ -47,6 +53,7 @@ class vtkAMRDualGridHelper;
 class vtkAMRDualGridHelperBlock;
 class vtkAMRDualGridHelperFace;
 class vtkAMRDualClipLocator;
+class vtkAMRDualClipBlockOutput;
 
 class VTKPVVTKEXTENSIONSDEFAULT_EXPORT vtkAMRDualClip : public vtkMultiBlockDataSetAlgorithm
 {
@@ -118,13 +125,18 @@ protected:
 
   void ShareBlockLocatorWithNeighbors(vtkAMRDualGridHelperBlock* block);
 
-  void ProcessBlock(vtkAMRDualGridHelperBlock* block, int blockId, const char* arrayName);
+  // Clips one block into its own output.  This is called from several
+  // threads at once.
+  void ProcessBlock(vtkAMRDualClipBlockOutput* output, const char* arrayName);
 
-  void ProcessDualCell(vtkAMRDualGridHelperBlock* block, int blockId, int x, int y, int z,
+  void ProcessDualCell(vtkAMRDualClipBlockOutput* output, int x, int y, int z,
     vtkIdType cornerOffsets[8], vtkDataArray* volumeFractionArray);
 
+  // Appends the outputs of the blocks to the output mesh in block order,
+  // merging the points shared between blocks.
+  void AppendBlockOutputs(std::vector<vtkAMRDualClipBlockOutput>& outputs);
+
   void InitializeLevelMask(vtkAMRDualGridHelperBlock* block);
-  void ShareLevelMask(vtkAMRDualGridHelperBlock* block);
   void DistributeLevelMasks();
 
   // void DebugCases();
@@ -148,8 +160,6 @@ protected:
   int* MessageBuffer;
   int* MessageBufferLength;
 
-  vtkAMRDualClipLocator* BlockLocator;
-
 private:
   vtkAMRDualClip(const vtkAMRDualClip&) = delete;
   void operator=(const vtkAMRDualClip&) = delete;
@@ -14,6 +14,7 @@
 =========================================================================*/
 #include "vtkAMRDualContour.h"
 #include "vtkAMRDualGridHelper.h"
+#include <algorithm>
 #include <vector>
 
 // Pipeline & VTK
@@ -35,12 +36,15 @@
 #include "vtkCompositeDataIterator.h"
 #include "vtkDataSet.h"
 #include "vtkFloatArray.h"
+#include "vtkIdTypeArray.h"
 #include "vtkImageData.h"
 #include "vtkMultiBlockDataSet.h"
 #include "vtkMultiPieceDataSet.h"
 #include "vtkNonOverlappingAMR.h"
 #include "vtkPointData.h"
 #include "vtkPolyData.h"
+#include "vtkSMPTools.h"
+#include "vtkSmartPointer.h"
 #include "vtkUniformGrid.h"
 #include "vtkUnsignedCharArray.h"
 #include "vtkUnstructuredGrid.h"
@@ -103,7 +107,26 @@ public:
   void ShareBlockLocatorWithNeighbor(
     vtkAMRDualGridHelperBlock* block, vtkAMRDualGridHelperBlock* neighbor);
 
+  // Description:
+  // Blocks are contoured in parallel, so the locator holds block-local point
+  // ids.  Once the block is contoured, the local ids are mapped to output ids:
+  // the points shared by an already numbered neighbor take its id and the
+  // others are numbered from "nextPointId".  Returns the next free point id.
+  void InitializeOutputIds(vtkIdType numberOfPoints);
+  vtkIdType NumberOutputIds(vtkIdType nextPointId);
+  void SwapOutputIds(std::vector<vtkIdType>& outputIds);
+
 private:
+  // Entries >= 0 are local point ids.  Output ids shared by a neighbor are
+  // stored as -2 - id so that -1 still marks an empty entry.
+  vtkIdType GetOutputId(vtkIdType entry) const
+  {
+    return entry >= 0 ? this->OutputIds[entry] : -2 - entry;
+  }
+  void ShareOutputId(vtkIdType* entry, vtkIdType outputId);
+
+  std::vector<vtkIdType> OutputIds;
+
   int DualCellDimensions[3];
   // Increments for translating 3d to 1d.  XIncrement = 1;
   int YIncrement;
@@ -134,6 +157,40 @@ void vtkAMRDualContourEdgeLocator::CopyRegionLevelDifferences(vtkAMRDualGridHelp
   }
 }
 //----------------------------------------------------------------------------
+void vtkAMRDualContourEdgeLocator::InitializeOutputIds(vtkIdType numberOfPoints)
+{
+  this->OutputIds.assign(numberOfPoints, -1);
+}
+//----------------------------------------------------------------------------
+vtkIdType vtkAMRDualContourEdgeLocator::NumberOutputIds(vtkIdType nextPointId)
+{
+  for (size_t ii = 0; ii < this->OutputIds.size(); ++ii)
+  {
+    if (this->OutputIds[ii] < 0)
+    {
+      this->OutputIds[ii] = nextPointId++;
+    }
+  }
+  return nextPointId;
+}
+//----------------------------------------------------------------------------
+void vtkAMRDualContourEdgeLocator::SwapOutputIds(std::vector<vtkIdType>& outputIds)
+{
+  this->OutputIds.swap(outputIds);
+}
+//----------------------------------------------------------------------------
+void vtkAMRDualContourEdgeLocator::ShareOutputId(vtkIdType* entry, vtkIdType outputId)
+{
+  if (*entry >= 0)
+  { // This block created the point too, merge it with the neighbor's.
+    this->OutputIds[*entry] = outputId;
+  }
+  else
+  {
+    *entry = -2 - outputId;
+  }
+}
+//----------------------------------------------------------------------------
 vtkAMRDualContourEdgeLocator::vtkAMRDualContourEdgeLocator()
 {
   this->DualCellDimensions[0] = 0;
@@ -457,6 +514,51 @@ vtkAMRDualContourEdgeLocator* vtkAMRDualContourGetBlockLocator(vtkAMRDualGridHel
   return (vtkAMRDualContourEdgeLocator*)(block->UserData);
 }
 
+//============================================================================
+// Blocks are contoured in parallel, each into its own mesh with block-local
+// point ids.  The meshes are appended to the output afterwards.
+class vtkAMRDualContourBlockOutput
+{
+public:
+  vtkAMRDualContourBlockOutput()
+    : Block(0)
+    , BlockId(0)
+    , Locator(0)
+    , PointOffset(0)
+    , NumberOfFaces(0)
+    , ConnectivityLength(0)
+    , FaceOffset(0)
+    , ConnectivityOffset(0)
+  {
+  }
+
+  vtkAMRDualGridHelperBlock* Block;
+  int BlockId;
+  vtkAMRDualContourEdgeLocator* Locator;
+
+  vtkSmartPointer<vtkPolyData> Mesh;
+  vtkSmartPointer<vtkPoints> Points;
+  vtkSmartPointer<vtkCellArray> Faces;
+  // Whether each face is dropped when merging points makes it degenerate.
+  // Untriangulated cap polygons are not checked.
+  std::vector<unsigned char> CheckDegenerate;
+
+  // Output ids of the local points when merging points.  Points with an id
+  // below PointOffset were created by a previous block.
+  std::vector<vtkIdType> PointIds;
+  vtkIdType PointOffset;
+
+  vtkIdType NumberOfFaces;
+  vtkIdType ConnectivityLength;
+  vtkIdType FaceOffset;
+  vtkIdType ConnectivityOffset;
+
+  vtkIdType GetOutputId(vtkIdType localId) const
+  {
+    return this->PointIds.empty() ? this->PointOffset + localId : this->PointIds[localId];
+  }
+};
+
 //----------------------------------------------------------------------------
 // This version works with higher level neighbor blocks.
 void vtkAMRDualContourEdgeLocator::ShareBlockLocatorWithNeighbor(
@@ -580,24 +682,28 @@ void vtkAMRDualContourEdgeLocator::ShareBlockLocatorWithNeighbor(
         outOffsetX = outOffsetY + xOut;
 
         pointId = blockLocator->XEdges[inOffsetX];
-        if (pointId >= 0)
+        if (pointId != -1)
         {
-          neighborLocator->XEdges[outOffsetX] = pointId;
+          neighborLocator->ShareOutputId(
+            neighborLocator->XEdges + outOffsetX, blockLocator->GetOutputId(pointId));
         }
         pointId = blockLocator->YEdges[inOffsetX];
-        if (pointId >= 0)
+        if (pointId != -1)
         {
-          neighborLocator->YEdges[outOffsetX] = pointId;
+          neighborLocator->ShareOutputId(
+            neighborLocator->YEdges + outOffsetX, blockLocator->GetOutputId(pointId));
         }
         pointId = blockLocator->ZEdges[inOffsetX];
-        if (pointId >= 0)
+        if (pointId != -1)
         {
-          neighborLocator->ZEdges[outOffsetX] = pointId;
+          neighborLocator->ShareOutputId(
+            neighborLocator->ZEdges + outOffsetX, blockLocator->GetOutputId(pointId));
         }
         pointId = blockLocator->Corners[inOffsetX];
-        if (pointId >= 0)
+        if (pointId != -1)
         {
-          neighborLocator->Corners[outOffsetX] = pointId;
+          neighborLocator->ShareOutputId(
+            neighborLocator->Corners + outOffsetX, blockLocator->GetOutputId(pointId));
         }
 
         inOffsetX += 1;
@@ -633,17 +739,15 @@ vtkAMRDualContour::vtkAMRDualContour()
   this->TemperatureArray = 0;
   this->BlockIdCellArray = 0;
   this->Helper = 0;
-
-  this->BlockLocator = 0;
 }
 
 //----------------------------------------------------------------------------
 vtkAMRDualContour::~vtkAMRDualContour()
 {
-  if (this->BlockLocator)
+  if (this->Helper)
   {
-    delete this->BlockLocator;
-    this->BlockLocator = 0;
+    this->Helper->Delete();
+    this->Helper = 0;
   }
   this->SetController(NULL);
 }
@@ -755,12 +859,11 @@ int vtkAMRDualContour::RequestData(vtkInformation* vtkNotUsed(request),
 
 void vtkAMRDualContour::InitializeRequest(vtkNonOverlappingAMR* hbdsInput)
 {
-  if (this->Helper)
+  // Kept between requests, see vtkAMRDualGridHelper::ReleaseImages.
+  if (!this->Helper)
   {
-    this->Helper->Delete();
+    this->Helper = vtkAMRDualGridHelper::New();
   }
-
-  this->Helper = vtkAMRDualGridHelper::New();
   this->Helper->SetEnableDegenerateCells(this->EnableDegenerateCells);
   this->Helper->SetSkipGhostCopy(this->SkipGhostCopy);
   if (this->EnableMultiProcessCommunication)
@@ -776,8 +879,7 @@ void vtkAMRDualContour::InitializeRequest(vtkNonOverlappingAMR* hbdsInput)
 
 void vtkAMRDualContour::FinalizeRequest()
 {
-  this->Helper->Delete();
-  this->Helper = 0;
+  this->Helper->ReleaseImages();
 }
 
 vtkMultiBlockDataSet* vtkAMRDualContour::DoRequestData(
@@ -809,17 +911,46 @@ vtkMultiBlockDataSet* vtkAMRDualContour::DoRequestData(
   // Loop through blocks
   int numLevels = hbdsInput->GetNumberOfLevels();
 
-  // Add each block.
+  // Collect the local blocks in level order, each with its own mesh.
+  // Remote blocks are only to setup local block bit flags.
+  std::vector<vtkAMRDualContourBlockOutput> outputs;
   for (int level = 0; level < numLevels; ++level)
   {
     int numBlocks = this->Helper->GetNumberOfBlocksInLevel(level);
     for (int blockId = 0; blockId < numBlocks; ++blockId)
     {
       vtkAMRDualGridHelperBlock* block = this->Helper->GetBlock(level, blockId);
-      this->ProcessBlock(block, blockId, arrayNameToProcess);
+      if (block->Image == 0 || block->Image->GetCellData()->GetArray(arrayNameToProcess) == 0)
+      {
+        continue;
+      }
+      vtkAMRDualContourBlockOutput output;
+      output.Block = block;
+      output.BlockId = blockId;
+      output.Mesh = vtkSmartPointer<vtkPolyData>::New();
+      output.Points = vtkSmartPointer<vtkPoints>::New();
+      output.Faces = vtkSmartPointer<vtkCellArray>::New();
+      output.Mesh->SetPoints(output.Points);
+      output.Mesh->SetPolys(output.Faces);
+      this->InitializeCopyAttributes(hbdsInput, output.Mesh);
+      if (this->EnableMergePoints)
+      { // Neighbors are merged after all the blocks are contoured.
+        output.Locator = vtkAMRDualContourGetBlockLocator(block);
+      }
+      outputs.push_back(output);
     }
   }
 
+  vtkSMPTools::For(0, static_cast<vtkIdType>(outputs.size()), 1,
+    [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType ii = begin; ii < end; ++ii)
+      {
+        this->ProcessBlock(&outputs[ii], arrayNameToProcess);
+      }
+    });
+
+  this->AppendBlockOutputs(outputs);
+
   this->FinalizeCopyAttributes(this->Mesh);
   this->BlockIdCellArray->Delete();
   this->BlockIdCellArray = 0;
@@ -885,8 +1016,9 @@ void vtkAMRDualContour::ShareBlockLocatorWithNeighbors(vtkAMRDualGridHelperBlock
 
 //----------------------------------------------------------------------------
 void vtkAMRDualContour::ProcessBlock(
-  vtkAMRDualGridHelperBlock* block, int blockId, const char* arrayNameToProcess)
+  vtkAMRDualContourBlockOutput* output, const char* arrayNameToProcess)
 {
+  vtkAMRDualGridHelperBlock* block = output->Block;
   vtkImageData* image = block->Image;
   if (image == 0)
   { // Remote blocks are only to setup local block bit flags.
@@ -914,19 +1046,12 @@ void vtkAMRDualContour::ProcessBlock(
 
   // Locator merges points in this block.
   // Input the dimensions of the dual cells with ghosts.
-  if (this->EnableMergePoints)
-  {
-    this->BlockLocator = vtkAMRDualContourGetBlockLocator(block);
-  }
-  else
-  { // Shared locator.
-    if (this->BlockLocator == 0)
-    {
-      this->BlockLocator = new vtkAMRDualContourEdgeLocator;
-    }
-    this->BlockLocator->Initialize(
+  if (!this->EnableMergePoints)
+  { // Temporary locator.
+    output->Locator = new vtkAMRDualContourEdgeLocator;
+    output->Locator->Initialize(
       extent[1] - extent[0], extent[3] - extent[2], extent[5] - extent[4]);
-    this->BlockLocator->CopyRegionLevelDifferences(block);
+    output->Locator->CopyRegionLevelDifferences(block);
   }
   image->GetOrigin(origin);
   spacing = image->GetSpacing();
@@ -1007,7 +1132,7 @@ void vtkAMRDualContour::ProcessBlock(
           cornerOffsets[5] = xOffset + 1 + zInc;
           cornerOffsets[6] = xOffset + 1 + yInc + zInc;
           cornerOffsets[7] = xOffset + yInc + zInc;
-          this->ProcessDualCell(block, blockId, x, y, z, cornerOffsets, volumeFractionArray);
+          this->ProcessDualCell(output, x, y, z, cornerOffsets, volumeFractionArray);
         }
         xOffset += 1; // xInc
       }
@@ -1018,20 +1143,146 @@ void vtkAMRDualContour::ProcessBlock(
 
   if (this->EnableMergePoints)
   {
+    // The points are merged with the neighbors in AppendBlockOutputs.
+    output->Locator->InitializeOutputIds(output->Points->GetNumberOfPoints());
+  }
+  else
+  {
+    delete output->Locator;
+    output->Locator = 0;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkAMRDualContour::AppendBlockOutputs(std::vector<vtkAMRDualContourBlockOutput>& outputs)
+{
+  const vtkIdType numOutputs = static_cast<vtkIdType>(outputs.size());
+
+  // Number the points in block order.  The locator of each block is shared
+  // with its unprocessed neighbors just like when blocks are contoured one
+  // after the other, so the output does not depend on the number of threads.
+  vtkIdType numPoints = 0;
+  for (vtkIdType ii = 0; ii < numOutputs; ++ii)
+  {
+    vtkAMRDualContourBlockOutput& output = outputs[ii];
+    output.PointOffset = numPoints;
+    if (!this->EnableMergePoints)
+    {
+      numPoints += output.Points->GetNumberOfPoints();
+      continue;
+    }
+    vtkAMRDualGridHelperBlock* block = output.Block;
+    numPoints = output.Locator->NumberOutputIds(numPoints);
     // Copy point ids into neighbor locators.
     this->ShareBlockLocatorWithNeighbors(block);
+    output.Locator->SwapOutputIds(output.PointIds);
     // We are done.  We no longer need the locator for this block.
-    delete this->BlockLocator;
-    this->BlockLocator = 0;
+    delete output.Locator;
+    output.Locator = 0;
     block->UserData = 0;
     // Lets use this unused flag (owner of center region/block) to indicate
     // that the block is already processes.
     // This will keep neighbors from recreating the locator.
-    // Another option would be to create the locator object for
-    // all blocks but do not allocate until needed.  Then the existence of the locator
-    // would tell whether the block was processed.
     block->RegionBits[1][1][1] = 0;
   }
+  // Blocks without the array may have been given a locator by a neighbor.
+  for (int level = 0; level < this->Helper->GetNumberOfLevels(); ++level)
+  {
+    int numBlocks = this->Helper->GetNumberOfBlocksInLevel(level);
+    for (int blockId = 0; blockId < numBlocks; ++blockId)
+    {
+      vtkAMRDualGridHelperBlock* block = this->Helper->GetBlock(level, blockId);
+      delete static_cast<vtkAMRDualContourEdgeLocator*>(block->UserData);
+      block->UserData = 0;
+    }
+  }
+
+  // Convert the faces to output point ids.  Merging points can make
+  // triangles degenerate, those are dropped as if they were never added.
+  vtkSMPTools::For(0, numOutputs, 1, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType ii = begin; ii < end; ++ii)
+    {
+      vtkAMRDualContourBlockOutput& output = outputs[ii];
+      const vtkIdType numCells = output.Faces->GetNumberOfCells();
+      vtkIdType* inPtr = output.Faces->GetData()->GetPointer(0);
+      vtkIdType* outPtr = inPtr;
+      vtkIdType* start = inPtr;
+      output.NumberOfFaces = 0;
+      for (vtkIdType cellId = 0; cellId < numCells; ++cellId)
+      {
+        const vtkIdType npts = inPtr[0];
+        // outPtr never passes inPtr, so the faces can be compacted in place.
+        for (vtkIdType jj = 1; jj <= npts; ++jj)
+        {
+          outPtr[jj] = output.GetOutputId(inPtr[jj]);
+        }
+        inPtr += npts + 1;
+        if (npts == 3 && output.CheckDegenerate[cellId] &&
+          (outPtr[1] == outPtr[2] || outPtr[1] == outPtr[3] || outPtr[2] == outPtr[3]))
+        {
+          continue;
+        }
+        outPtr[0] = npts;
+        outPtr += npts + 1;
+        ++output.NumberOfFaces;
+      }
+      output.ConnectivityLength = outPtr - start;
+    }
+  });
+
+  vtkIdType numFaces = 0;
+  vtkIdType connectivityLength = 0;
+  for (vtkIdType ii = 0; ii < numOutputs; ++ii)
+  {
+    outputs[ii].FaceOffset = numFaces;
+    outputs[ii].ConnectivityOffset = connectivityLength;
+    numFaces += outputs[ii].NumberOfFaces;
+    connectivityLength += outputs[ii].ConnectivityLength;
+  }
+
+  // Allocate the output and copy the blocks into it.  The point data of the
+  // blocks was allocated from the same input arrays as the output.
+  vtkPointData* outPD = this->Mesh->GetPointData();
+  this->Points->SetNumberOfPoints(numPoints);
+  for (int arrayIdx = 0; arrayIdx < outPD->GetNumberOfArrays(); ++arrayIdx)
+  {
+    outPD->GetAbstractArray(arrayIdx)->SetNumberOfTuples(numPoints);
+  }
+  vtkIdTypeArray* connectivity = vtkIdTypeArray::New();
+  connectivity->SetNumberOfValues(connectivityLength);
+  this->BlockIdCellArray->SetNumberOfValues(numFaces);
+
+  vtkSMPTools::For(0, numOutputs, 1, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType ii = begin; ii < end; ++ii)
+    {
+      vtkAMRDualContourBlockOutput& output = outputs[ii];
+      vtkPointData* inPD = output.Mesh->GetPointData();
+      const int numArrays = std::min(inPD->GetNumberOfArrays(), outPD->GetNumberOfArrays());
+      const vtkIdType numLocalPoints = output.Points->GetNumberOfPoints();
+      for (vtkIdType localId = 0; localId < numLocalPoints; ++localId)
+      {
+        const vtkIdType outId = output.GetOutputId(localId);
+        if (outId < output.PointOffset)
+        { // Merged with a point of a previous block.
+          continue;
+        }
+        this->Points->GetData()->SetTuple(outId, localId, output.Points->GetData());
+        for (int arrayIdx = 0; arrayIdx < numArrays; ++arrayIdx)
+        {
+          outPD->GetAbstractArray(arrayIdx)->SetTuple(
+            outId, localId, inPD->GetAbstractArray(arrayIdx));
+        }
+      }
+      const vtkIdType* faces = output.Faces->GetData()->GetPointer(0);
+      std::copy(faces, faces + output.ConnectivityLength,
+        connectivity->GetPointer(output.ConnectivityOffset));
+      int* blockIds = this->BlockIdCellArray->GetPointer(output.FaceOffset);
+      std::fill(blockIds, blockIds + output.NumberOfFaces, output.BlockId);
+    }
+  });
+
+  this->Faces->SetCells(numFaces, connectivity);
+  connectivity->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -1091,10 +1342,11 @@ static int vtkAMRDualLegacyIdToBitIdMap[8] = { 0, 1, 3, 2, 4, 5, 7, 6 };
 // Not implemented as optimally as we could.  It can be improved by making
 // a fast path for internal cells (with no degeneracies).
 // Corner offsets are absolute (relative to origin / 0).
-void vtkAMRDualContour::ProcessDualCell(vtkAMRDualGridHelperBlock* block, int blockId, int x, int y,
-  int z, vtkIdType cornerOffsets[8], vtkDataArray* volumeFractionArray)
+void vtkAMRDualContour::ProcessDualCell(vtkAMRDualContourBlockOutput* output, int x, int y, int z,
+  vtkIdType cornerOffsets[8], vtkDataArray* volumeFractionArray)
 {
   // compute the case index
+  vtkAMRDualGridHelperBlock* block = output->Block;
   vtkImageData* image = block->Image;
   if (image == 0)
   { // Remote blocks are only to setup local block bit flags.
@@ -1329,7 +1581,7 @@ void vtkAMRDualContour::ProcessDualCell(vtkAMRDualGridHelperBlock* block, int bl
     // Only permanently keep locator for edges shared between two blocks.
     for (int ii = 0; ii < 3; ++ii, ++edge) // insert triangle
     {
-      vtkIdType* ptIdPtr = this->BlockLocator->GetEdgePointer(x, y, z, *edge);
+      vtkIdType* ptIdPtr = output->Locator->GetEdgePointer(x, y, z, *edge);
 
       if (*ptIdPtr == -1)
       {
@@ -1357,31 +1609,32 @@ void vtkAMRDualContour::ProcessDualCell(vtkAMRDualGridHelperBlock* block, int bl
           cornerPoints[pt1Idx | 1] + k * (cornerPoints[pt2Idx | 1] - cornerPoints[pt1Idx | 1]);
         pt[2] =
           cornerPoints[pt1Idx | 2] + k * (cornerPoints[pt2Idx | 2] - cornerPoints[pt1Idx | 2]);
-        *ptIdPtr = this->Points->InsertNextPoint(pt);
+        *ptIdPtr = output->Points->InsertNextPoint(pt);
         // Interpolate attributes
         // Find the offsets of the two attributes to interpolate
         vtkIdType offset0 = cornerOffsets[vtkAMRDualIsoEdgeToVTKPointsTable[*edge][0]];
         vtkIdType offset1 = cornerOffsets[vtkAMRDualIsoEdgeToVTKPointsTable[*edge][1]];
-        this->InterpolateAttributes(block->Image, offset0, offset1, k, this->Mesh, *ptIdPtr);
+        this->InterpolateAttributes(block->Image, offset0, offset1, k, output->Mesh, *ptIdPtr);
       }
       edgePointIds[*edge] = pointIds[ii] = *ptIdPtr;
     }
     if (pointIds[0] != pointIds[1] && pointIds[0] != pointIds[2] && pointIds[1] != pointIds[2])
     {
-      this->Faces->InsertNextCell(3, pointIds);
-      this->BlockIdCellArray->InsertNextValue(blockId);
+      output->Faces->InsertNextCell(3, pointIds);
+      output->CheckDegenerate.push_back(1);
     }
   }
 
   if (this->EnableCapping)
   {
     this->CapCell(x, y, z, cubeBoundaryBits, cubeCase, edgePointIds, cornerPoints, cornerOffsets,
-      blockId, block->Image);
+      output, block->Image);
   }
 }
 
 //----------------------------------------------------------------------------
-void vtkAMRDualContour::AddCapPolygon(int ptCount, vtkIdType* pointIds, int blockId)
+void vtkAMRDualContour::AddCapPolygon(
+  vtkAMRDualContourBlockOutput* output, int ptCount, vtkIdType* pointIds)
 {
   if (this->TriangulateCap)
   {
@@ -1397,8 +1650,8 @@ void vtkAMRDualContour::AddCapPolygon(int ptCount, vtkIdType* pointIds, int bloc
         tri[2] = pointIds[low];
         if (tri[0] != tri[1] && tri[0] != tri[2] && tri[1] != tri[2])
         {
-          this->Faces->InsertNextCell(3, tri);
-          this->BlockIdCellArray->InsertNextValue(blockId);
+          output->Faces->InsertNextCell(3, tri);
+          output->CheckDegenerate.push_back(1);
         }
       }
       else
@@ -1408,16 +1661,16 @@ void vtkAMRDualContour::AddCapPolygon(int ptCount, vtkIdType* pointIds, int bloc
         tri[2] = pointIds[low];
         if (tri[0] != tri[1] && tri[0] != tri[2] && tri[1] != tri[2])
         {
-          this->Faces->InsertNextCell(3, tri);
-          this->BlockIdCellArray->InsertNextValue(blockId);
+          output->Faces->InsertNextCell(3, tri);
+          output->CheckDegenerate.push_back(1);
         }
         tri[0] = pointIds[high];
         tri[1] = pointIds[high + 1];
         tri[2] = pointIds[low];
         if (tri[0] != tri[1] && tri[0] != tri[2] && tri[1] != tri[2])
         {
-          this->Faces->InsertNextCell(3, tri);
-          this->BlockIdCellArray->InsertNextValue(blockId);
+          output->Faces->InsertNextCell(3, tri);
+          output->CheckDegenerate.push_back(1);
         }
       }
       ++low;
@@ -1427,8 +1680,8 @@ void vtkAMRDualContour::AddCapPolygon(int ptCount, vtkIdType* pointIds, int bloc
   else
   {
     // Do not worry about degenerate polygons in this path.
-    this->Faces->InsertNextCell(ptCount, pointIds);
-    this->BlockIdCellArray->InsertNextValue(blockId);
+    output->Faces->InsertNextCell(ptCount, pointIds);
+    output->CheckDegenerate.push_back(0);
   }
 }
 
@@ -1450,8 +1703,8 @@ void vtkAMRDualContour::CapCell(int cellX, int cellY, int cellZ, // cell index i
   double cornerPoints[32],
   // The id order is VTK from marching cube cases.  Different than axis ordered "cornerPoints".
   vtkIdType cornerOffsets[8],
-  // For block id array (for debugging).  I should just make this an ivar.
-  int blockId,
+  // Mesh and locator of the block.
+  vtkAMRDualContourBlockOutput* output,
   // For passing attributes to output mesh
   vtkDataSet* inData)
 {
@@ -1472,12 +1725,12 @@ void vtkAMRDualContour::CapCell(int cellX, int cellY, int cellZ, // cell index i
         if (*capPtr < 4)
         {
           cornerIdx = (vtkAMRDualIsoNXCapEdgeMap[*capPtr]);
-          ptIdPtr = this->BlockLocator->GetCornerPointer(cellX, cellY, cellZ, cornerIdx);
+          ptIdPtr = output->Locator->GetCornerPointer(cellX, cellY, cellZ, cornerIdx);
           if (*ptIdPtr == -1)
           {
-            *ptIdPtr = this->Points->InsertNextPoint(cornerPoints + (cornerIdx << 2));
-            this->CopyAttributes(
-              inData, cornerOffsets[vtkAMRDualLegacyIdToBitIdMap[cornerIdx]], this->Mesh, *ptIdPtr);
+            *ptIdPtr = output->Points->InsertNextPoint(cornerPoints + (cornerIdx << 2));
+            this->CopyAttributes(inData, cornerOffsets[vtkAMRDualLegacyIdToBitIdMap[cornerIdx]],
+              output->Mesh, *ptIdPtr);
           }
           pointIds[ptCount++] = *ptIdPtr;
         }
@@ -1487,7 +1740,7 @@ void vtkAMRDualContour::CapCell(int cellX, int cellY, int cellZ, // cell index i
         }
         ++capPtr;
       }
-      this->AddCapPolygon(ptCount, pointIds, blockId);
+      this->AddCapPolygon(output, ptCount, pointIds);
       if (*capPtr == -1)
       {
         ++capPtr;
@@ -1508,12 +1761,12 @@ void vtkAMRDualContour::CapCell(int cellX, int cellY, int cellZ, // cell index i
         if (*capPtr < 4)
         {
           cornerIdx = (vtkAMRDualIsoPXCapEdgeMap[*capPtr]);
-          ptIdPtr = this->BlockLocator->GetCornerPointer(cellX, cellY, cellZ, cornerIdx);
+          ptIdPtr = output->Locator->GetCornerPointer(cellX, cellY, cellZ, cornerIdx);
           if (*ptIdPtr == -1)
           {
-            *ptIdPtr = this->Points->InsertNextPoint(cornerPoints + (cornerIdx << 2));
-            this->CopyAttributes(
-              inData, cornerOffsets[vtkAMRDualLegacyIdToBitIdMap[cornerIdx]], this->Mesh, *ptIdPtr);
+            *ptIdPtr = output->Points->InsertNextPoint(cornerPoints + (cornerIdx << 2));
+            this->CopyAttributes(inData, cornerOffsets[vtkAMRDualLegacyIdToBitIdMap[cornerIdx]],
+              output->Mesh, *ptIdPtr);
           }
           pointIds[ptCount++] = *ptIdPtr;
         }
@@ -1523,7 +1776,7 @@ void vtkAMRDualContour::CapCell(int cellX, int cellY, int cellZ, // cell index i
         }
         ++capPtr;
       }
-      this->AddCapPolygon(ptCount, pointIds, blockId);
+      this->AddCapPolygon(output, ptCount, pointIds);
       if (*capPtr == -1)
       {
         ++capPtr;
@@ -1545,12 +1798,12 @@ void vtkAMRDualContour::CapCell(int cellX, int cellY, int cellZ, // cell index i
         if (*capPtr < 4)
         {
           cornerIdx = (vtkAMRDualIsoNYCapEdgeMap[*capPtr]);
-          ptIdPtr = this->BlockLocator->GetCornerPointer(cellX, cellY, cellZ, cornerIdx);
+          ptIdPtr = output->Locator->GetCornerPointer(cellX, cellY, cellZ, cornerIdx);
           if (*ptIdPtr == -1)
           {
-            *ptIdPtr = this->Points->InsertNextPoint(cornerPoints + (cornerIdx << 2));
-            this->CopyAttributes(
-              inData, cornerOffsets[vtkAMRDualLegacyIdToBitIdMap[cornerIdx]], this->Mesh, *ptIdPtr);
+            *ptIdPtr = output->Points->InsertNextPoint(cornerPoints + (cornerIdx << 2));
+            this->CopyAttributes(inData, cornerOffsets[vtkAMRDualLegacyIdToBitIdMap[cornerIdx]],
+              output->Mesh, *ptIdPtr);
           }
           pointIds[ptCount++] = *ptIdPtr;
         }
@@ -1560,7 +1813,7 @@ void vtkAMRDualContour::CapCell(int cellX, int cellY, int cellZ, // cell index i
         }
         ++capPtr;
       }
-      this->AddCapPolygon(ptCount, pointIds, blockId);
+      this->AddCapPolygon(output, ptCount, pointIds);
       if (*capPtr == -1)
       {
         ++capPtr;
@@ -1582,12 +1835,12 @@ void vtkAMRDualContour::CapCell(int cellX, int cellY, int cellZ, // cell index i
         if (*capPtr < 4)
         {
           cornerIdx = (vtkAMRDualIsoPYCapEdgeMap[*capPtr]);
-          ptIdPtr = this->BlockLocator->GetCornerPointer(cellX, cellY, cellZ, cornerIdx);
+          ptIdPtr = output->Locator->GetCornerPointer(cellX, cellY, cellZ, cornerIdx);
           if (*ptIdPtr == -1)
           {
-            *ptIdPtr = this->Points->InsertNextPoint(cornerPoints + (cornerIdx << 2));
-            this->CopyAttributes(
-              inData, cornerOffsets[vtkAMRDualLegacyIdToBitIdMap[cornerIdx]], this->Mesh, *ptIdPtr);
+            *ptIdPtr = output->Points->InsertNextPoint(cornerPoints + (cornerIdx << 2));
+            this->CopyAttributes(inData, cornerOffsets[vtkAMRDualLegacyIdToBitIdMap[cornerIdx]],
+              output->Mesh, *ptIdPtr);
           }
           pointIds[ptCount++] = *ptIdPtr;
         }
@@ -1597,7 +1850,7 @@ void vtkAMRDualContour::CapCell(int cellX, int cellY, int cellZ, // cell index i
         }
         ++capPtr;
       }
-      this->AddCapPolygon(ptCount, pointIds, blockId);
+      this->AddCapPolygon(output, ptCount, pointIds);
       if (*capPtr == -1)
       {
         ++capPtr;
@@ -1618,12 +1871,12 @@ void vtkAMRDualContour::CapCell(int cellX, int cellY, int cellZ, // cell index i
         if (*capPtr < 4)
         {
           cornerIdx = (vtkAMRDualIsoNZCapEdgeMap[*capPtr]);
-          ptIdPtr = this->BlockLocator->GetCornerPointer(cellX, cellY, cellZ, cornerIdx);
+          ptIdPtr = output->Locator->GetCornerPointer(cellX, cellY, cellZ, cornerIdx);
           if (*ptIdPtr == -1)
           {
-            *ptIdPtr = this->Points->InsertNextPoint(cornerPoints + (cornerIdx << 2));
-            this->CopyAttributes(
-              inData, cornerOffsets[vtkAMRDualLegacyIdToBitIdMap[cornerIdx]], this->Mesh, *ptIdPtr);
+            *ptIdPtr = output->Points->InsertNextPoint(cornerPoints + (cornerIdx << 2));
+            this->CopyAttributes(inData, cornerOffsets[vtkAMRDualLegacyIdToBitIdMap[cornerIdx]],
+              output->Mesh, *ptIdPtr);
           }
           pointIds[ptCount++] = *ptIdPtr;
         }
@@ -1633,7 +1886,7 @@ void vtkAMRDualContour::CapCell(int cellX, int cellY, int cellZ, // cell index i
         }
         ++capPtr;
       }
-      this->AddCapPolygon(ptCount, pointIds, blockId);
+      this->AddCapPolygon(output, ptCount, pointIds);
       if (*capPtr == -1)
       {
         ++capPtr;
@@ -1655,12 +1908,12 @@ void vtkAMRDualContour::CapCell(int cellX, int cellY, int cellZ, // cell index i
         if (*capPtr < 4)
         {
           cornerIdx = (vtkAMRDualIsoPZCapEdgeMap[*capPtr]);
-          ptIdPtr = this->BlockLocator->GetCornerPointer(cellX, cellY, cellZ, cornerIdx);
+          ptIdPtr = output->Locator->GetCornerPointer(cellX, cellY, cellZ, cornerIdx);
           if (*ptIdPtr == -1)
           {
-            *ptIdPtr = this->Points->InsertNextPoint(cornerPoints + (cornerIdx << 2));
-            this->CopyAttributes(
-              inData, cornerOffsets[vtkAMRDualLegacyIdToBitIdMap[cornerIdx]], this->Mesh, *ptIdPtr);
+            *ptIdPtr = output->Points->InsertNextPoint(cornerPoints + (cornerIdx << 2));
+            this->CopyAttributes(inData, cornerOffsets[vtkAMRDualLegacyIdToBitIdMap[cornerIdx]],
+              output->Mesh, *ptIdPtr);
           }
           pointIds[ptCount++] = *ptIdPtr;
         }
@@ -1670,7 +1923,7 @@ void vtkAMRDualContour::CapCell(int cellX, int cellY, int cellZ, // cell index i
         }
         ++capPtr;
       }
-      this->AddCapPolygon(ptCount, pointIds, blockId);
+      this->AddCapPolygon(output, ptCount, pointIds);
       if (*capPtr == -1)
       {
         ++capPtr;
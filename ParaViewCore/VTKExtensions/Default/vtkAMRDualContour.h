@@ -21,6 +21,11 @@
  * a particle index as part of the cell data of the output.  It computes
  * the volume of each particle from the volume fraction.
  *
+ * The local blocks are contoured in parallel (see vtkSMPTools), each into
+ * its own mesh.  The meshes are then appended in block order and the points
+ * shared by neighbor blocks are merged, so the output does not depend on the
+ * number of threads.
+ *
  * This will turn on validation and debug i/o of the filter.
  * \code{.cpp}
  * #define vtkAMRDualContourDEBUG
@@ -54,6 +59,7 @@ class vtkAMRDualGridHelper;
 class vtkAMRDualGridHelperBlock;
 class vtkAMRDualGridHelperFace;
 class vtkAMRDualContourEdgeLocator;
+class vtkAMRDualContourBlockOutput;
 
 class VTKPVVTKEXTENSIONSDEFAULT_EXPORT vtkAMRDualContour : public vtkMultiBlockDataSetAlgorithm
 {
@@ -154,12 +160,18 @@ protected:
 
   void ShareBlockLocatorWithNeighbors(vtkAMRDualGridHelperBlock* block);
 
-  void ProcessBlock(vtkAMRDualGridHelperBlock* block, int blockId, const char* arrayName);
+  // Contours one block into its own output.  This is called from several
+  // threads at once.
+  void ProcessBlock(vtkAMRDualContourBlockOutput* output, const char* arrayName);
 
-  void ProcessDualCell(vtkAMRDualGridHelperBlock* block, int blockId, int x, int y, int z,
+  void ProcessDualCell(vtkAMRDualContourBlockOutput* output, int x, int y, int z,
     vtkIdType cornerOffsets[8], vtkDataArray* volumeFractionArray);
 
-  void AddCapPolygon(int ptCount, vtkIdType* pointIds, int blockId);
+  void AddCapPolygon(vtkAMRDualContourBlockOutput* output, int ptCount, vtkIdType* pointIds);
+
+  // Appends the outputs of the blocks to the output mesh in block order,
+  // merging the points shared between blocks.
+  void AppendBlockOutputs(std::vector<vtkAMRDualContourBlockOutput>& outputs);
 
   // This method is getting too many arguments!
   // Capping was an after thought...
@@ -174,8 +186,8 @@ protected:
     double cornerPoints[32],
     // The id order is VTK from marching cube cases.  Different than axis ordered "cornerPoints".
     vtkIdType cornerOffsets[8],
-    // For block id array (for debugging).  I should just make this an ivar.
-    int blockId,
+    // Mesh and locator of the block.
+    vtkAMRDualContourBlockOutput* output,
     // For passing attributes to output mesh
     vtkDataSet* inData);
 
@@ -196,8 +208,6 @@ protected:
   int* MessageBuffer;
   int* MessageBufferLength;
 
-  vtkAMRDualContourEdgeLocator* BlockLocator;
-
   // Stuff for passing cell attributes to point attributes.
   void InitializeCopyAttributes(vtkNonOverlappingAMR* hbdsInput, vtkDataSet* mesh);
   void InterpolateAttributes(vtkDataSet* uGrid, vtkIdType offset0, vtkIdType offset1, double k,
@@ -206,6 +206,23 @@ public:
     vtkGenericWarningMacro(<< "Nothing to wait for.");
     return value_type();
   }
+  // Description:
+  // If one of the communications has completed, removes it from the list,
+  // copies it to request and returns true.  Returns false without waiting
+  // otherwise.
+  bool TestAny(value_type& request)
+  {
+    for (iterator i = this->begin(); i != this->end(); i++)
+    {
+      if (i->Request.Test())
+      {
+        request = *i;
+        this->erase(i);
+        return true;
+      }
+    }
+    return false;
+  }
 };
 #endif // VTK_AMR_DUAL_GRID_USE_MPI_ASYNCHRONOUS
 
@@ -740,24 +757,51 @@ vtkAMRDualGridHelper::vtkAMRDualGridHelper()
 //----------------------------------------------------------------------------
 vtkAMRDualGridHelper::~vtkAMRDualGridHelper()
 {
-  int ii;
-  int numberOfLevels = (int)(this->Levels.size());
-
   this->SetArrayName(0);
 
-  for (ii = 0; ii < numberOfLevels; ++ii)
+  this->ReleaseBlocks();
+
+  this->Controller->UnRegister(this);
+  this->Controller = NULL;
+}
+//----------------------------------------------------------------------------
+void vtkAMRDualGridHelper::ReleaseBlocks()
+{
+  int numberOfLevels = (int)(this->Levels.size());
+  for (int ii = 0; ii < numberOfLevels; ++ii)
   {
     delete this->Levels[ii];
     this->Levels[ii] = 0;
   }
+  this->Levels.clear();
+  this->BlockLayout.clear();
 
   // Todo: See if we really need this.
   this->NumberOfBlocksInThisProcess = 0;
 
   this->DegenerateRegionQueue.clear();
-
-  this->Controller->UnRegister(this);
-  this->Controller = NULL;
+  this->DegenerateRegionsToSend.clear();
+}
+//----------------------------------------------------------------------------
+void vtkAMRDualGridHelper::ReleaseImages()
+{
+  int numberOfLevels = this->GetNumberOfLevels();
+  for (int level = 0; level < numberOfLevels; ++level)
+  {
+    int numBlocks = this->GetNumberOfBlocksInLevel(level);
+    for (int blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+    {
+      vtkAMRDualGridHelperBlock* block = this->GetBlock(level, blockIdx);
+      if (block->Image && block->CopyFlag)
+      { // We made a copy of the image and have to delete it.
+        block->Image->Delete();
+      }
+      block->Image = 0;
+      block->CopyFlag = 0;
+    }
+  }
+  this->DegenerateRegionQueue.clear();
+  this->DegenerateRegionsToSend.clear();
 }
 //----------------------------------------------------------------------------
 void vtkAMRDualGridHelper::PrintSelf(ostream& os, vtkIndent indent)
@@ -790,6 +834,9 @@ void vtkAMRDualGridHelper::SetController(vtkMultiProcessController* controller)
     return;
   }
 
+  // Blocks are assigned to processes of the old controller.
+  this->ReleaseBlocks();
+
   // Controller is never NULL.
   this->Controller->UnRegister(this);
 
@@ -852,6 +899,20 @@ void vtkAMRDualGridHelper::AddBlock(int level, int id, vtkImageData* volume)
   int y = (int)((center[1] - this->GlobalOrigin[1]) / blockSize[1]);
   int z = (int)((center[2] - this->GlobalOrigin[2]) / blockSize[2]);
   vtkAMRDualGridHelperBlock* block = this->Levels[level]->AddGridBlock(x, y, z, id, volume);
+  this->SetBlockImage(level, block, volume);
+}
+
+//----------------------------------------------------------------------------
+// Attaches the image of a local block, completing its ghost levels.
+void vtkAMRDualGridHelper::SetBlockImage(
+  int level, vtkAMRDualGridHelperBlock* block, vtkImageData* volume)
+{
+  if (block->Image && block->CopyFlag)
+  { // A copy with the ghost levels of a previous image.
+    block->Image->Delete();
+  }
+  block->Image = volume;
+  block->CopyFlag = 0;
 
   // We need to set this ivar here because we need to compute the index
   // from the global origin and root spacing.  The issue is that some blocks
@@ -1391,6 +1452,8 @@ void vtkAMRDualGridHelper::DegenerateRegionMessageSize(
   // that the queue will be the same on all processes.  Message/region lengths
   // are computed implicitly.
 
+  this->DegenerateRegionsToSend.assign(numProcs, std::vector<size_t>());
+
   std::vector<vtkAMRDualGridHelperDegenerateRegion>::iterator region;
   for (region = this->DegenerateRegionQueue.begin(); region != this->DegenerateRegionQueue.end();
        region++)
@@ -1423,6 +1486,8 @@ void vtkAMRDualGridHelper::DegenerateRegionMessageSize(
       vtkIdType len = destProcs->GetValue(region->ReceivingBlock->ProcessId);
       len += messageLength;
       destProcs->SetValue(region->ReceivingBlock->ProcessId, len);
+      this->DegenerateRegionsToSend[region->ReceivingBlock->ProcessId].push_back(
+        region - this->DegenerateRegionQueue.begin());
     }
     if (region->ReceivingBlock->ProcessId == myProc)
     {
@@ -1871,18 +1936,18 @@ const void* vtkAMRDualGridHelper::CopyDegenerateRegionMessageToBlock(
 
 // Given a buffer (of size determined by DegenerateRegionMessageSize), fill it
 // with degenerate region information to be sent to the given process.
+// Only the regions DegenerateRegionMessageSize grouped for that process are
+// visited, in queue order.
 void vtkAMRDualGridHelper::MarshalDegenerateRegionMessage(void* messagePtr, int destProc)
 {
-  int myProcId = this->Controller->GetLocalProcessId();
-
-  std::vector<vtkAMRDualGridHelperDegenerateRegion>::iterator region;
-  for (region = this->DegenerateRegionQueue.begin(); region != this->DegenerateRegionQueue.end();
-       region++)
+  if (destProc >= 0 && destProc < static_cast<int>(this->DegenerateRegionsToSend.size()))
   {
-    if ((region->ReceivingBlock->ProcessId == destProc) &&
-      (region->SourceBlock->ProcessId == myProcId))
+    const std::vector<size_t>& regions = this->DegenerateRegionsToSend[destProc];
+    for (size_t idx = 0; idx < regions.size(); ++idx)
     {
-      messagePtr = this->CopyDegenerateRegionBlockToMessage(*region, messagePtr);
+      const vtkAMRDualGridHelperDegenerateRegion& region =
+        this->DegenerateRegionQueue[regions[idx]];
+      messagePtr = this->CopyDegenerateRegionBlockToMessage(region, messagePtr);
     }
   }
   int* gridPtr = static_cast<int*>(messagePtr);
@@ -2131,7 +2196,8 @@ void vtkAMRDualGridHelper::ProcessRegionRemoteCopyQueueMPIAsynchronous(bool hack
     }
   }
 
-  // Next initiate all sends.
+  // Next initiate all sends.  Messages that have already arrived are copied
+  // into the blocks while the remaining ones are packed.
   for (int recvProc = 0; recvProc < numProcs; recvProc++)
   {
     if (recvProc == myProc)
@@ -2141,6 +2207,13 @@ void vtkAMRDualGridHelper::ProcessRegionRemoteCopyQueueMPIAsynchronous(bool hack
     {
       this->SendDegenerateRegionsFromQueueMPIAsynchronous(recvProc, messageLength, sendList);
     }
+    vtkAMRDualGridHelperCommRequest request;
+    while (receiveList.TestAny(request))
+    {
+      vtkCharArray* recvBuffer = vtkCharArray::SafeDownCast(request.Buffer);
+      this->UnmarshalDegenerateRegionMessage(recvBuffer->GetPointer(0),
+        recvBuffer->GetNumberOfTuples(), request.SendProcess, hackLevelFlag);
+    }
   }
 
   // Finally, finish all communications as they come in.
@@ -2253,6 +2326,17 @@ int vtkAMRDualGridHelper::Initialize(vtkNonOverlappingAMR* input)
   int blockId, numBlocks;
   int numLevels = input->GetNumberOfLevels();
 
+  vtkIntArray* neighbors = vtkIntArray::SafeDownCast(input->GetFieldData()->GetArray("Neighbors"));
+  if (neighbors)
+  {
+    vtkSortDataArray::Sort(neighbors);
+  }
+
+  if (this->ReuseBlocks(input))
+  {
+    return VTK_OK;
+  }
+
   // Create the level objects.
   this->Levels.reserve(numLevels);
   for (int ii = 0; ii < numLevels; ++ii)
@@ -2271,7 +2355,6 @@ int vtkAMRDualGridHelper::Initialize(vtkNonOverlappingAMR* input)
   vtkIntArray* minLevelIa = vtkIntArray::SafeDownCast(inputFd->GetArray("MinLevel"));
   vtkDoubleArray* minLevelSpacingDa =
     vtkDoubleArray::SafeDownCast(inputFd->GetArray("MinLevelSpacing"));
-  vtkIntArray* neighbors = vtkIntArray::SafeDownCast(inputFd->GetArray("Neighbors"));
 
   // Take advantage of passed in global information if available
   if (globalBoundsDa && standardBoxSizeIa && minLevelIa && minLevelSpacingDa)
@@ -2319,7 +2402,6 @@ int vtkAMRDualGridHelper::Initialize(vtkNonOverlappingAMR* input)
   {
     // if we have passed neighbor information, use this to send blocks only to those
     // All processes will only have blocks from neigbhoring processes
-    vtkSortDataArray::Sort(neighbors);
     this->ShareBlocksWithNeighbors(neighbors);
   }
   else
@@ -2331,6 +2413,113 @@ int vtkAMRDualGridHelper::Initialize(vtkNonOverlappingAMR* input)
   return VTK_OK;
 }
 
+//----------------------------------------------------------------------------
+// Everything Initialize derives the levels, grids and shared blocks from:
+// the options, the local blocks with their extents and geometry, and the meta
+// information of the coprocessing adaptor.
+void vtkAMRDualGridHelper::ComputeBlockLayout(
+  vtkNonOverlappingAMR* input, std::vector<double>& layout)
+{
+  layout.clear();
+  // Both options change which blocks and degenerate regions are set up.
+  layout.push_back(this->EnableDegenerateCells);
+  layout.push_back(this->SkipGhostCopy);
+  int numLevels = input->GetNumberOfLevels();
+  layout.push_back(numLevels);
+  for (int level = 0; level < numLevels; ++level)
+  {
+    int numBlocks = input->GetNumberOfDataSets(level);
+    layout.push_back(numBlocks);
+    for (int blockId = 0; blockId < numBlocks; ++blockId)
+    {
+      vtkImageData* image = input->GetDataSet(level, blockId);
+      if (image)
+      {
+        layout.push_back(blockId);
+        int* ext = image->GetExtent();
+        layout.insert(layout.end(), ext, ext + 6);
+        double* origin = image->GetOrigin();
+        layout.insert(layout.end(), origin, origin + 3);
+        double* spacing = image->GetSpacing();
+        layout.insert(layout.end(), spacing, spacing + 3);
+      }
+    }
+  }
+
+  static const char* metaNames[] = { "GlobalBounds", "GlobalBoxSize", "MinLevel",
+    "MinLevelSpacing", "Neighbors" };
+  vtkFieldData* inputFd = input->GetFieldData();
+  for (int ii = 0; ii < 5; ++ii)
+  {
+    vtkDataArray* da = inputFd->GetArray(metaNames[ii]);
+    if (!da)
+    {
+      layout.push_back(-1);
+      continue;
+    }
+    vtkIdType numValues = da->GetNumberOfTuples() * da->GetNumberOfComponents();
+    layout.push_back(numValues);
+    for (vtkIdType idx = 0; idx < numValues; ++idx)
+    {
+      layout.push_back(da->GetComponent(idx / da->GetNumberOfComponents(),
+        static_cast<int>(idx % da->GetNumberOfComponents())));
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+// When the layout is the same as the last time on all processes, the levels
+// and the blocks shared by other processes are still valid.  Only the images
+// of the local blocks change, so the expensive global meta data computation
+// and block sharing are skipped.  Returns 1 if the blocks were reused.
+int vtkAMRDualGridHelper::ReuseBlocks(vtkNonOverlappingAMR* input)
+{
+  std::vector<double> layout;
+  this->ComputeBlockLayout(input, layout);
+
+  int reuse = (!this->Levels.empty() && layout == this->BlockLayout) ? 1 : 0;
+  if (this->Controller->GetNumberOfProcesses() > 1)
+  {
+    // Sharing blocks is collective so all processes have to agree.
+    int localReuse = reuse;
+    this->Controller->AllReduce(&localReuse, &reuse, 1, vtkCommunicator::MIN_OP);
+  }
+  if (!reuse)
+  {
+    this->ReleaseBlocks();
+    this->BlockLayout.swap(layout);
+    return 0;
+  }
+
+  int numLevels = this->GetNumberOfLevels();
+  for (int level = 0; level < numLevels; ++level)
+  {
+    int numBlocks = this->GetNumberOfBlocksInLevel(level);
+    for (int blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+    {
+      vtkAMRDualGridHelperBlock* block = this->GetBlock(level, blockIdx);
+      block->UserData = 0;
+      block->ResetRegionBits();
+    }
+  }
+  // The images may have been released after the last request.  Local blocks
+  // are found at the same grid location as when they were added.
+  for (int level = 0; level < numLevels; ++level)
+  {
+    int numBlocks = input->GetNumberOfDataSets(level);
+    for (int blockId = 0; blockId < numBlocks; ++blockId)
+    {
+      vtkImageData* image = input->GetDataSet(level, blockId);
+      if (image)
+      {
+        this->AddBlock(level, blockId, image);
+      }
+    }
+  }
+  this->DegenerateRegionQueue.clear();
+  return 1;
+}
+
 int vtkAMRDualGridHelper::SetupData(vtkNonOverlappingAMR* input, const char* arrayName)
 {
   vtkTimerLogSmartMarkEvent markevent("vtkAMRDualGridHelper::SetupData", this->Controller);
@@ -2471,13 +2660,15 @@ void vtkAMRDualGridHelper::ShareBlocksWithNeighborsAsynchronous(vtkIntArray* nei
     receiveList.push_back(request);
   }
 
+  // Every neighbor gets the same message so it is packed once and all sends
+  // share the buffer.
+  vtkSmartPointer<vtkIntArray> sendBuffer = vtkSmartPointer<vtkIntArray>::New();
+  this->MarshalBlocks(sendBuffer);
+
   for (vtkIdType i = 0; i < neighbors->GetNumberOfTuples(); i++)
   {
     int neighborProc = neighbors->GetValue(i);
 
-    vtkSmartPointer<vtkIntArray> sendBuffer = vtkSmartPointer<vtkIntArray>::New();
-    this->MarshalBlocks(sendBuffer);
-
     vtkAMRDualGridHelperCommRequest request;
     request.SendProcess = myProc;
     request.ReceiveProcess = neighborProc;
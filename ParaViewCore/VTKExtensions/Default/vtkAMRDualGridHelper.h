@@ -95,7 +95,26 @@ public:
   virtual void SetController(vtkMultiProcessController*);
   //@}
 
+  /**
+   * Builds the level grids and shares the block layout with the other
+   * processes.  When called again with an input that has the same blocks as
+   * the last call on every process (for example the next time step of a
+   * simulation, or the same data set with another array), the layout is kept
+   * and only the block images are updated, which skips all global
+   * communication but one reduction.
+   */
   int Initialize(vtkNonOverlappingAMR* input);
+
+  /**
+   * Drops the block images, including the copies made to fill in ghost
+   * values, while keeping the layout.  Filters keep one helper between
+   * requests so that Initialize can reuse its levels and shared blocks, and
+   * call ReleaseImages once done with each request so that the helper does
+   * not hold on to the input; the next call to Initialize attaches the new
+   * images.
+   */
+  void ReleaseImages();
+
   int SetupData(vtkNonOverlappingAMR* input, const char* arrayName);
   const double* GetGlobalOrigin() { return this->GlobalOrigin; }
   const double* GetRootSpacing() { return this->RootSpacing; }
@@ -163,6 +182,15 @@ private:
   vtkMultiProcessController* Controller;
   void ComputeGlobalMetaData(vtkNonOverlappingAMR* input);
   void AddBlock(int level, int id, vtkImageData* volume);
+  void SetBlockImage(int level, vtkAMRDualGridHelperBlock* block, vtkImageData* volume);
+
+  // Keep the levels built by the last call to Initialize when the block
+  // layout of the input has not changed on any process.  See ReleaseImages
+  // for how filters keep the helper between requests.
+  void ComputeBlockLayout(vtkNonOverlappingAMR* input, std::vector<double>& layout);
+  int ReuseBlocks(vtkNonOverlappingAMR* input);
+  void ReleaseBlocks();
+  std::vector<double> BlockLayout;
 
   // Manage connectivity seeds between blocks.
   void CreateFaces();
@@ -211,6 +239,9 @@ private:
   // Degenerate regions that span processes.  We keep them in a queue
   // to communicate and process all at once.
   std::vector<vtkAMRDualGridHelperDegenerateRegion> DegenerateRegionQueue;
+  // Indexes in the queue of the regions this process sends, grouped by
+  // destination process so that each message is packed in one pass.
+  std::vector<std::vector<size_t> > DegenerateRegionsToSend;
   void DegenerateRegionMessageSize(vtkIdTypeArray* srcProcs, vtkIdTypeArray* destProc);
   void* CopyDegenerateRegionBlockToMessage(
     const vtkAMRDualGridHelperDegenerateRegion& region, void* messagePtr);
@@ -17,21 +17,220 @@ PURPOSE.  See the above copyright notice for more information.
 #include "vtkCell.h"
 #include "vtkCellData.h"
 #include "vtkCollection.h"
+#include "vtkIdList.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkIntArray.h"
 #include "vtkMergePoints.h"
+#include "vtkNew.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPoints.h"
+#include "vtkSMPTools.h"
+#include "vtkSmartPointer.h"
 #include "vtkUnstructuredGrid.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+inline bool vtkSameCoordinates(const double* coords, vtkIdType a, vtkIdType b)
+{
+  const double* pa = coords + 3 * a;
+  const double* pb = coords + 3 * b;
+  return pa[0] == pb[0] && pa[1] == pb[1] && pa[2] == pb[2];
+}
+
+// Strict weak ordering of coordinates where NaN is greater than every number
+// and equivalent to itself; a plain `<` is not one, which is undefined
+// behavior when sorting.
+inline bool vtkCoordinateLess(double a, double b)
+{
+  return a < b || (a == a && b != b);
+}
+
+// Exact merge: sort the point ids lexicographically by coordinates (then by
+// id) so that coincident points are contiguous, lowest id first. Points with
+// NaN coordinates are sorted last and never merged.
+void vtkMergeCoincidentPoints(const double* coords, vtkIdType num, vtkIdType* mergeMap)
+{
+  std::vector<vtkIdType> order(num);
+  vtkSMPTools::For(0, num, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType cc = begin; cc < end; ++cc)
+    {
+      order[cc] = cc;
+    }
+  });
+  vtkSMPTools::Sort(order.begin(), order.end(), [coords](vtkIdType a, vtkIdType b) {
+    const double* pa = coords + 3 * a;
+    const double* pb = coords + 3 * b;
+    for (int i = 0; i < 3; ++i)
+    {
+      if (vtkCoordinateLess(pa[i], pb[i]))
+      {
+        return true;
+      }
+      if (vtkCoordinateLess(pb[i], pa[i]))
+      {
+        return false;
+      }
+    }
+    return a < b;
+  });
+
+  vtkSMPTools::For(0, num, [&](vtkIdType begin, vtkIdType end) {
+    // find the head of the run the first point of this range belongs to.
+    vtkIdType head = begin;
+    while (head > 0 && vtkSameCoordinates(coords, order[head - 1], order[head]))
+    {
+      --head;
+    }
+    vtkIdType representative = order[head];
+    for (vtkIdType cc = begin; cc < end; ++cc)
+    {
+      if (cc > begin && !vtkSameCoordinates(coords, order[cc - 1], order[cc]))
+      {
+        representative = order[cc];
+      }
+      mergeMap[order[cc]] = representative;
+    }
+  });
+}
+
+// Merge within tolerance: points are binned in a grid with a spacing of at
+// least `tol` and each point is mapped to the lowest id point within `tol`
+// found in the 27 neighboring bins. Chains are then collapsed so that each
+// point maps to a point that maps to itself. Points with a non-finite
+// coordinate cannot be binned: they are kept in a bucket of their own, sorted
+// last, and never merged.
+void vtkMergePointsWithinTolerance(
+  const double* coords, vtkIdType num, double tol, vtkIdType* mergeMap)
+{
+  auto finite = [](const double* x) {
+    return std::isfinite(x[0]) && std::isfinite(x[1]) && std::isfinite(x[2]);
+  };
+  double bounds[6] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX,
+    VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+  for (vtkIdType cc = 0; cc < num; ++cc)
+  {
+    const double* x = coords + 3 * cc;
+    if (finite(x))
+    {
+      for (int i = 0; i < 3; ++i)
+      {
+        bounds[2 * i] = std::min(bounds[2 * i], x[i]);
+        bounds[2 * i + 1] = std::max(bounds[2 * i + 1], x[i]);
+      }
+    }
+  }
+
+  const int maxBits = 20;
+  const vtkTypeUInt64 maxDim = static_cast<vtkTypeUInt64>(1) << maxBits;
+  // keys of binned points use the 63 lower bits only.
+  const vtkTypeUInt64 nonFiniteKey = ~static_cast<vtkTypeUInt64>(0);
+  double spacing = tol;
+  for (int i = 0; i < 3; ++i)
+  {
+    spacing = std::max(spacing, (bounds[2 * i + 1] - bounds[2 * i]) / (maxDim - 1));
+  }
+
+  auto bin = [&](const double* x, int i) {
+    return static_cast<vtkTypeInt64>((x[i] - bounds[2 * i]) / spacing);
+  };
+  auto key = [](vtkTypeInt64 i, vtkTypeInt64 j, vtkTypeInt64 k) {
+    return (static_cast<vtkTypeUInt64>(i) << (2 * (maxBits + 1))) |
+      (static_cast<vtkTypeUInt64>(j) << (maxBits + 1)) | static_cast<vtkTypeUInt64>(k);
+  };
+
+  std::vector<vtkTypeUInt64> keys(num);
+  std::vector<vtkIdType> order(num);
+  vtkSMPTools::For(0, num, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType cc = begin; cc < end; ++cc)
+    {
+      const double* x = coords + 3 * cc;
+      keys[cc] = finite(x) ? key(bin(x, 0), bin(x, 1), bin(x, 2)) : nonFiniteKey;
+      order[cc] = cc;
+    }
+  });
+  vtkSMPTools::Sort(order.begin(), order.end(), [&keys](vtkIdType a, vtkIdType b) {
+    return keys[a] != keys[b] ? keys[a] < keys[b] : a < b;
+  });
+  std::vector<vtkTypeUInt64> sortedKeys(num);
+  vtkSMPTools::For(0, num, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType cc = begin; cc < end; ++cc)
+    {
+      sortedKeys[cc] = keys[order[cc]];
+    }
+  });
+
+  const double tol2 = tol * tol;
+  std::vector<vtkIdType> candidates(num);
+  vtkSMPTools::For(0, num, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType cc = begin; cc < end; ++cc)
+    {
+      vtkIdType best = cc;
+      if (keys[cc] == nonFiniteKey)
+      {
+        candidates[cc] = best;
+        continue;
+      }
+      const double* x = coords + 3 * cc;
+      const vtkTypeInt64 ijk[3] = { bin(x, 0), bin(x, 1), bin(x, 2) };
+      for (vtkTypeInt64 i = std::max<vtkTypeInt64>(ijk[0] - 1, 0); i <= ijk[0] + 1; ++i)
+      {
+        for (vtkTypeInt64 j = std::max<vtkTypeInt64>(ijk[1] - 1, 0); j <= ijk[1] + 1; ++j)
+        {
+          for (vtkTypeInt64 k = std::max<vtkTypeInt64>(ijk[2] - 1, 0); k <= ijk[2] + 1; ++k)
+          {
+            auto range = std::equal_range(sortedKeys.begin(), sortedKeys.end(), key(i, j, k));
+            // ids are sorted within a bin, so the first match is the lowest.
+            for (auto iter = range.first; iter != range.second; ++iter)
+            {
+              const vtkIdType other = order[iter - sortedKeys.begin()];
+              if (other >= best)
+              {
+                break;
+              }
+              const double* y = coords + 3 * other;
+              const double d2 = (x[0] - y[0]) * (x[0] - y[0]) + (x[1] - y[1]) * (x[1] - y[1]) +
+                (x[2] - y[2]) * (x[2] - y[2]);
+              if (d2 <= tol2)
+              {
+                best = other;
+                break;
+              }
+            }
+          }
+        }
+      }
+      candidates[cc] = best;
+    }
+  });
+
+  vtkSMPTools::For(0, num, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType cc = begin; cc < end; ++cc)
+    {
+      vtkIdType representative = candidates[cc];
+      while (candidates[representative] != representative)
+      {
+        representative = candidates[representative];
+      }
+      mergeMap[cc] = representative;
+    }
+  });
+}
+}
+
 vtkStandardNewMacro(vtkCleanUnstructuredGrid);
 
 //----------------------------------------------------------------------------
 vtkCleanUnstructuredGrid::vtkCleanUnstructuredGrid()
 {
   this->Locator = vtkMergePoints::New();
+  this->Tolerance = 0.0;
+  this->ThreadedMerge = false;
 }
 
 //----------------------------------------------------------------------------
@@ -45,6 +244,8 @@ vtkCleanUnstructuredGrid::~vtkCleanUnstructuredGrid()
 void vtkCleanUnstructuredGrid::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "Tolerance: " << this->Tolerance << endl;
+  os << indent << "ThreadedMerge: " << this->ThreadedMerge << endl;
 }
 
 //----------------------------------------------------------------------------
@@ -81,27 +282,41 @@ int vtkCleanUnstructuredGrid::RequestData(vtkInformation* vtkNotUsed(request),
   vtkIdType id;
   vtkIdType newId;
   vtkIdType* ptMap = new vtkIdType[num];
-  double pt[3];
-
-  this->Locator->InitPointInsertion(newPts, input->GetBounds(), num);
 
   vtkIdType progressStep = num / 100;
   if (progressStep == 0)
   {
     progressStep = 1;
   }
-  for (id = 0; id < num; ++id)
+  if (this->ThreadedMerge)
   {
-    if (id % progressStep == 0)
+    this->MergePointsThreaded(input, output, newPts, ptMap);
+  }
+  else
+  {
+    vtkSmartPointer<vtkPointLocator> locator = this->Locator;
+    if (this->Tolerance > 0.0)
     {
-      this->UpdateProgress(0.8 * ((float)id / num));
+      // vtkMergePoints only merges exactly coincident points.
+      locator = vtkSmartPointer<vtkPointLocator>::New();
+      locator->SetTolerance(this->Tolerance);
     }
-    input->GetPoint(id, pt);
-    if (this->Locator->InsertUniquePoint(pt, newId))
+    locator->InitPointInsertion(newPts, input->GetBounds(), num);
+
+    double pt[3];
+    for (id = 0; id < num; ++id)
     {
-      output->GetPointData()->CopyData(input->GetPointData(), id, newId);
+      if (id % progressStep == 0)
+      {
+        this->UpdateProgress(0.8 * ((float)id / num));
+      }
+      input->GetPoint(id, pt);
+      if (locator->InsertUniquePoint(pt, newId))
+      {
+        output->GetPointData()->CopyData(input->GetPointData(), id, newId);
+      }
+      ptMap[id] = newId;
     }
-    ptMap[id] = newId;
   }
   output->SetPoints(newPts);
   newPts->Delete();
@@ -142,6 +357,71 @@ int vtkCleanUnstructuredGrid::RequestData(vtkInformation* vtkNotUsed(request),
   return 1;
 }
 
+//----------------------------------------------------------------------------
+void vtkCleanUnstructuredGrid::MergePointsThreaded(
+  vtkDataSet* input, vtkUnstructuredGrid* output, vtkPoints* newPts, vtkIdType* ptMap)
+{
+  const vtkIdType num = input->GetNumberOfPoints();
+  std::vector<double> coords(3 * num);
+  vtkSMPTools::For(0, num, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType cc = begin; cc < end; ++cc)
+    {
+      input->GetPoint(cc, &coords[3 * cc]);
+    }
+  });
+  this->UpdateProgress(0.1);
+
+  // Map each point to the lowest id point it is merged with.
+  std::vector<vtkIdType> mergeMap(num);
+  if (this->Tolerance > 0.0)
+  {
+    vtkMergePointsWithinTolerance(coords.data(), num, this->Tolerance, mergeMap.data());
+  }
+  else
+  {
+    vtkMergeCoincidentPoints(coords.data(), num, mergeMap.data());
+  }
+  this->UpdateProgress(0.6);
+
+  // Number the kept points in increasing input id order, i.e. in the order in
+  // which the locator would have inserted them.
+  std::vector<vtkIdType> newIds(num, -1);
+  vtkNew<vtkIdList> fromIds;
+  vtkIdType numNewPts = 0;
+  for (vtkIdType cc = 0; cc < num; ++cc)
+  {
+    if (mergeMap[cc] == cc)
+    {
+      newIds[cc] = numNewPts++;
+    }
+  }
+  fromIds->SetNumberOfIds(numNewPts);
+  newPts->SetNumberOfPoints(numNewPts);
+  vtkSMPTools::For(0, num, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType cc = begin; cc < end; ++cc)
+    {
+      const vtkIdType newId = newIds[mergeMap[cc]];
+      ptMap[cc] = newId;
+      if (mergeMap[cc] == cc)
+      {
+        newPts->SetPoint(newId, &coords[3 * cc]);
+        fromIds->SetId(newId, cc);
+      }
+    }
+  });
+  this->UpdateProgress(0.7);
+
+  vtkNew<vtkIdList> toIds;
+  toIds->SetNumberOfIds(numNewPts);
+  for (vtkIdType cc = 0; cc < numNewPts; ++cc)
+  {
+    toIds->SetId(cc, cc);
+  }
+  output->GetPointData()->CopyData(input->GetPointData(), fromIds.GetPointer(), toIds.GetPointer());
+  this->UpdateProgress(0.8);
+}
+
+//----------------------------------------------------------------------------
 int vtkCleanUnstructuredGrid::FillInputPortInformation(int vtkNotUsed(port), vtkInformation* info)
 {
   info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkDataSet");
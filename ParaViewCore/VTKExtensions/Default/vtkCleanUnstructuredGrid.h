@@ -20,8 +20,17 @@
  *
  * vtkCleanUnstructuredGrid is a filter that takes unstructured grid data as
  * input and generates unstructured grid data as output. vtkCleanUnstructuredGrid can
- * merge duplicate points (with coincident coordinates) using the vtkMergePoints object
- * to merge points.
+ * merge duplicate points (with coincident coordinates, or within a Tolerance).
+ *
+ * By default, points are inserted one at a time in a point locator
+ * (vtkMergePoints when Tolerance is 0). When ThreadedMerge is on, they are
+ * merged with a multithreaded algorithm that sorts the points by their
+ * (quantized) coordinates instead. Each point is merged with the lowest id
+ * point it coincides with (or, when Tolerance is set, the lowest id point
+ * within Tolerance in its neighborhood), and the output points are numbered
+ * in the order of their first occurrence in the input. For exactly
+ * coincident points, the output is thus identical to the one of the locator;
+ * within a tolerance, the points merged and their order may differ.
  *
  * @sa
  * vtkCleanPolyData
@@ -34,6 +43,7 @@
 #include "vtkUnstructuredGridAlgorithm.h"
 
 class vtkPointLocator;
+class vtkPoints;
 
 class VTKPVVTKEXTENSIONSDEFAULT_EXPORT vtkCleanUnstructuredGrid
   : public vtkUnstructuredGridAlgorithm
@@ -45,11 +55,35 @@ public:
 
   void PrintSelf(ostream& os, vtkIndent indent) override;
 
+  //@{
+  /**
+   * Set/Get the absolute distance below which points are merged. The default
+   * value of 0 merges exactly coincident points only.
+   */
+  vtkSetClampMacro(Tolerance, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(Tolerance, double);
+  //@}
+
+  //@{
+  /**
+   * Set/Get whether points are merged using the multithreaded algorithm
+   * rather than serially inserting them in a point locator. Default is false.
+   */
+  vtkSetMacro(ThreadedMerge, bool);
+  vtkGetMacro(ThreadedMerge, bool);
+  vtkBooleanMacro(ThreadedMerge, bool);
+  //@}
+
 protected:
   vtkCleanUnstructuredGrid();
   ~vtkCleanUnstructuredGrid() override;
 
   vtkPointLocator* Locator;
+  double Tolerance;
+  bool ThreadedMerge;
+
+  void MergePointsThreaded(
+    vtkDataSet* input, vtkUnstructuredGrid* output, vtkPoints* newPts, vtkIdType* ptMap);
 
   int RequestData(vtkInformation*, vtkInformationVector**, vtkInformationVector*) override;
   int FillInputPortInformation(int port, vtkInformation* info) override;
@@ -17,6 +17,7 @@
 #include "vtkCellData.h"
 #include "vtkCompositeDataIterator.h"
 #include "vtkCompositeDataSet.h"
+#include "vtkDataArray.h"
 #include "vtkDataObject.h"
 #include "vtkDataSet.h"
 #include "vtkFunctionParser.h"
@@ -26,13 +27,24 @@
 #include "vtkObjectFactory.h"
 #include "vtkPVPostFilter.h"
 #include "vtkPointData.h"
+#include "vtkPointSet.h"
+#include "vtkPoints.h"
+#include "vtkSMPTools.h"
+#include "vtkSmartPointer.h"
 #include "vtkTable.h"
 
 #include <algorithm>
 #include <assert.h>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
 #include <set>
 #include <sstream>
 #include <string>
+#include <vector>
 
 namespace
 {
@@ -69,6 +81,868 @@ public:
     this->Calc->AddScalarVariable(name.c_str(), this->ArrayName, this->Component);
   }
 };
+
+//----------------------------------------------------------------------------
+// Compiled backend.
+//
+// The function is compiled into a program of operations on registers, each
+// register holding one component of a chunk of tuples, so that every
+// operation is a simple loop over the chunk. Vector values use three
+// registers. Chunks are evaluated in parallel. Precedence and associativity
+// follow vtkFunctionParser, which splits a function at the rightmost
+// operator of lowest priority, the priorities being (lowest first)
+// + - . * / ^, and a unary minus applies to the operand that follows it.
+// Everything is computed in double precision, like the parser does.
+
+// Number of tuples evaluated at once by each thread.
+const vtkIdType vtkCalculatorChunkSize = 512;
+
+enum vtkCalculatorOperation
+{
+  OP_LOAD,
+  OP_CONSTANT,
+  OP_NEGATE,
+  OP_ADD,
+  OP_SUBTRACT,
+  OP_MULTIPLY,
+  OP_DIVIDE,
+  OP_POWER,
+  OP_MIN,
+  OP_MAX,
+  OP_ABS,
+  OP_EXP,
+  OP_CEIL,
+  OP_FLOOR,
+  OP_LN,
+  OP_LOG10,
+  OP_SQRT,
+  OP_SIN,
+  OP_COS,
+  OP_TAN,
+  OP_ASIN,
+  OP_ACOS,
+  OP_ATAN,
+  OP_SINH,
+  OP_COSH,
+  OP_TANH,
+  OP_SIGN
+};
+
+struct vtkCalculatorInstruction
+{
+  int Operation;
+  int Result;
+  int Left; // input index for OP_LOAD
+  int Right;
+  double Constant;
+};
+
+// A variable registered with the superclass.
+struct vtkCalculatorVariable
+{
+  bool Coordinates; // point coordinates instead of ArrayName
+  std::string ArrayName;
+  int NumberOfComponents; // 1 or 3
+  int Components[3];
+  bool Ambiguous; // registered several times with different meanings
+};
+
+typedef std::map<std::string, vtkCalculatorVariable> vtkCalculatorVariables;
+
+void vtkCalculatorAddVariable(vtkCalculatorVariables& variables, const std::string& name,
+  bool coordinates, const std::string& arrayName, int numComps, const int* comps)
+{
+  vtkCalculatorVariable variable;
+  variable.Coordinates = coordinates;
+  variable.ArrayName = arrayName;
+  variable.NumberOfComponents = numComps;
+  variable.Ambiguous = false;
+  for (int c = 0; c < 3; ++c)
+  {
+    variable.Components[c] = c < numComps ? comps[c] : 0;
+  }
+
+  auto iter = variables.find(name);
+  if (iter == variables.end())
+  {
+    variables[name] = variable;
+    return;
+  }
+  vtkCalculatorVariable& existing = iter->second;
+  bool same = existing.Coordinates == coordinates && existing.ArrayName == arrayName &&
+    existing.NumberOfComponents == numComps;
+  for (int c = 0; same && c < numComps; ++c)
+  {
+    same = existing.Components[c] == variable.Components[c];
+  }
+  existing.Ambiguous = existing.Ambiguous || !same;
+}
+
+// A component read by a program.
+struct vtkCalculatorInput
+{
+  bool Coordinates;
+  std::string ArrayName;
+  int Component;
+};
+
+// Where the values of an input are read from for a given dataset.
+struct vtkCalculatorColumn
+{
+  vtkDataArray* Array;
+  void* Pointer;     // values of Array when it has the standard memory layout
+  vtkDataSet* Input; // point coordinates are read from it when Array is null
+  int DataType;
+  int NumberOfComponents;
+  int Component;
+};
+
+template <class T>
+void vtkCalculatorLoad(
+  const T* values, int numComps, int comp, vtkIdType begin, vtkIdType n, double* out)
+{
+  values += begin * numComps + comp;
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    out[i] = static_cast<double>(values[i * numComps]);
+  }
+}
+
+template <class T>
+void vtkCalculatorStore(
+  T* values, int numComps, vtkIdType begin, vtkIdType n, const double* const* comps)
+{
+  values += begin * numComps;
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    for (int c = 0; c < numComps; ++c)
+    {
+      values[i * numComps + c] = static_cast<T>(comps[c][i]);
+    }
+  }
+}
+
+template <class F>
+void vtkCalculatorUnary(double* r, const double* a, vtkIdType n, F f)
+{
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    r[i] = f(a[i]);
+  }
+}
+
+template <class F>
+void vtkCalculatorBinary(double* r, const double* a, const double* b, vtkIdType n, F f)
+{
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    r[i] = f(a[i], b[i]);
+  }
+}
+
+class vtkCalculatorProgram
+{
+public:
+  vtkCalculatorProgram()
+    : NumberOfRegisters(0)
+    , NumberOfResultComponents(0)
+  {
+  }
+
+  std::vector<vtkCalculatorInstruction> Instructions;
+  std::vector<vtkCalculatorInput> Inputs;
+  int NumberOfRegisters;
+  int NumberOfResultComponents;
+  int ResultRegisters[3];
+
+  /**
+   * Finds where the inputs are read from in `input`. Returns false if an
+   * array is missing or does not have enough tuples or components.
+   */
+  bool Bind(vtkDataSet* input, vtkDataSetAttributes* attributes, vtkIdType numTuples,
+    std::vector<vtkCalculatorColumn>& columns) const
+  {
+    columns.resize(this->Inputs.size());
+    for (size_t cc = 0; cc < this->Inputs.size(); ++cc)
+    {
+      const vtkCalculatorInput& in = this->Inputs[cc];
+      vtkCalculatorColumn& column = columns[cc];
+      column.Array = nullptr;
+      column.Pointer = nullptr;
+      column.Input = input;
+      column.Component = in.Component;
+      if (in.Coordinates)
+      {
+        vtkPointSet* pointSet = vtkPointSet::SafeDownCast(input);
+        if (pointSet && !pointSet->GetPoints())
+        {
+          return false;
+        }
+        column.Array = pointSet ? pointSet->GetPoints()->GetData() : nullptr;
+      }
+      else
+      {
+        column.Array = attributes->GetArray(in.ArrayName.c_str());
+        if (!column.Array)
+        {
+          return false;
+        }
+      }
+      if (column.Array)
+      {
+        column.DataType = column.Array->GetDataType();
+        column.NumberOfComponents = column.Array->GetNumberOfComponents();
+        if (column.Array->GetNumberOfTuples() < numTuples ||
+          column.Component >= column.NumberOfComponents)
+        {
+          return false;
+        }
+        if (column.Array->HasStandardMemoryLayout() && column.DataType != VTK_BIT)
+        {
+          column.Pointer = column.Array->GetVoidPointer(0);
+        }
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Evaluates the program on `numTuples` tuples and returns the result, or
+   * null when an invalid value was hit (the parser must then be used to
+   * handle it the way it is configured to).
+   */
+  vtkSmartPointer<vtkDataArray> Execute(
+    const std::vector<vtkCalculatorColumn>& columns, vtkIdType numTuples, int resultType) const
+  {
+    vtkSmartPointer<vtkDataArray> result;
+    result.TakeReference(vtkDataArray::CreateDataArray(resultType));
+    if (!result || !result->HasStandardMemoryLayout() || result->GetDataType() == VTK_BIT)
+    {
+      return nullptr;
+    }
+    const int numComps = this->NumberOfResultComponents;
+    result->SetNumberOfComponents(numComps);
+    result->SetNumberOfTuples(numTuples);
+    void* out = result->GetVoidPointer(0);
+
+    std::atomic<bool> invalid(false);
+    const vtkIdType numChunks = (numTuples + vtkCalculatorChunkSize - 1) / vtkCalculatorChunkSize;
+    vtkSMPTools::For(0, numChunks, [&](vtkIdType firstChunk, vtkIdType lastChunk) {
+      std::vector<double> registers(this->NumberOfRegisters * vtkCalculatorChunkSize);
+      const double* comps[3];
+      for (int c = 0; c < numComps; ++c)
+      {
+        comps[c] = &registers[this->ResultRegisters[c] * vtkCalculatorChunkSize];
+      }
+      for (vtkIdType chunk = firstChunk; chunk < lastChunk && !invalid; ++chunk)
+      {
+        const vtkIdType begin = chunk * vtkCalculatorChunkSize;
+        const vtkIdType n = std::min(vtkCalculatorChunkSize, numTuples - begin);
+        if (!this->Evaluate(columns, begin, n, &registers[0]))
+        {
+          invalid = true;
+          return;
+        }
+        switch (result->GetDataType())
+        {
+          vtkTemplateMacro(
+            vtkCalculatorStore(static_cast<VTK_TT*>(out), numComps, begin, n, comps));
+        }
+      }
+    });
+    if (invalid)
+    {
+      return nullptr;
+    }
+    return result;
+  }
+
+private:
+  /**
+   * Evaluates the program on the `n` tuples starting at `begin`. Returns
+   * false if an invalid value was hit.
+   */
+  bool Evaluate(const std::vector<vtkCalculatorColumn>& columns, vtkIdType begin, vtkIdType n,
+    double* registers) const
+  {
+    bool invalid = false;
+    for (const vtkCalculatorInstruction& inst : this->Instructions)
+    {
+      double* r = registers + inst.Result * vtkCalculatorChunkSize;
+      const double* a =
+        inst.Left >= 0 && inst.Operation != OP_LOAD ? registers + inst.Left * vtkCalculatorChunkSize
+                                                    : nullptr;
+      const double* b = inst.Right >= 0 ? registers + inst.Right * vtkCalculatorChunkSize : nullptr;
+      switch (inst.Operation)
+      {
+        case OP_LOAD:
+          this->Load(columns[inst.Left], begin, n, r);
+          break;
+        case OP_CONSTANT:
+          std::fill(r, r + n, inst.Constant);
+          break;
+        case OP_NEGATE:
+          vtkCalculatorUnary(r, a, n, [](double x) { return -x; });
+          break;
+        case OP_ADD:
+          vtkCalculatorBinary(r, a, b, n, [](double x, double y) { return x + y; });
+          break;
+        case OP_SUBTRACT:
+          vtkCalculatorBinary(r, a, b, n, [](double x, double y) { return x - y; });
+          break;
+        case OP_MULTIPLY:
+          vtkCalculatorBinary(r, a, b, n, [](double x, double y) { return x * y; });
+          break;
+        case OP_DIVIDE:
+          for (vtkIdType i = 0; i < n; ++i)
+          {
+            invalid |= b[i] == 0.0;
+          }
+          vtkCalculatorBinary(r, a, b, n, [](double x, double y) { return x / y; });
+          break;
+        case OP_POWER:
+          for (vtkIdType i = 0; i < n; ++i)
+          {
+            invalid |= (a[i] < 0.0 && std::floor(b[i]) != b[i]) || (a[i] == 0.0 && b[i] < 0.0);
+          }
+          vtkCalculatorBinary(r, a, b, n, [](double x, double y) { return std::pow(x, y); });
+          break;
+        case OP_MIN:
+          vtkCalculatorBinary(r, a, b, n, [](double x, double y) { return x < y ? x : y; });
+          break;
+        case OP_MAX:
+          vtkCalculatorBinary(r, a, b, n, [](double x, double y) { return x > y ? x : y; });
+          break;
+        case OP_ABS:
+          vtkCalculatorUnary(r, a, n, [](double x) { return std::fabs(x); });
+          break;
+        case OP_EXP:
+          vtkCalculatorUnary(r, a, n, [](double x) { return std::exp(x); });
+          break;
+        case OP_CEIL:
+          vtkCalculatorUnary(r, a, n, [](double x) { return std::ceil(x); });
+          break;
+        case OP_FLOOR:
+          vtkCalculatorUnary(r, a, n, [](double x) { return std::floor(x); });
+          break;
+        case OP_LN:
+        case OP_LOG10:
+          for (vtkIdType i = 0; i < n; ++i)
+          {
+            invalid |= a[i] <= 0.0;
+          }
+          if (inst.Operation == OP_LN)
+          {
+            vtkCalculatorUnary(r, a, n, [](double x) { return std::log(x); });
+          }
+          else
+          {
+            vtkCalculatorUnary(r, a, n, [](double x) { return std::log10(x); });
+          }
+          break;
+        case OP_SQRT:
+          for (vtkIdType i = 0; i < n; ++i)
+          {
+            invalid |= a[i] < 0.0;
+          }
+          vtkCalculatorUnary(r, a, n, [](double x) { return std::sqrt(x); });
+          break;
+        case OP_SIN:
+          vtkCalculatorUnary(r, a, n, [](double x) { return std::sin(x); });
+          break;
+        case OP_COS:
+          vtkCalculatorUnary(r, a, n, [](double x) { return std::cos(x); });
+          break;
+        case OP_TAN:
+          vtkCalculatorUnary(r, a, n, [](double x) { return std::tan(x); });
+          break;
+        case OP_ASIN:
+        case OP_ACOS:
+          for (vtkIdType i = 0; i < n; ++i)
+          {
+            invalid |= a[i] < -1.0 || a[i] > 1.0;
+          }
+          if (inst.Operation == OP_ASIN)
+          {
+            vtkCalculatorUnary(r, a, n, [](double x) { return std::asin(x); });
+          }
+          else
+          {
+            vtkCalculatorUnary(r, a, n, [](double x) { return std::acos(x); });
+          }
+          break;
+        case OP_ATAN:
+          vtkCalculatorUnary(r, a, n, [](double x) { return std::atan(x); });
+          break;
+        case OP_SINH:
+          vtkCalculatorUnary(r, a, n, [](double x) { return std::sinh(x); });
+          break;
+        case OP_COSH:
+          vtkCalculatorUnary(r, a, n, [](double x) { return std::cosh(x); });
+          break;
+        case OP_TANH:
+          vtkCalculatorUnary(r, a, n, [](double x) { return std::tanh(x); });
+          break;
+        case OP_SIGN:
+          vtkCalculatorUnary(
+            r, a, n, [](double x) { return x < 0.0 ? -1.0 : (x == 0.0 ? 0.0 : 1.0); });
+          break;
+      }
+      if (invalid)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static void Load(const vtkCalculatorColumn& column, vtkIdType begin, vtkIdType n, double* r)
+  {
+    if (column.Pointer)
+    {
+      switch (column.DataType)
+      {
+        vtkTemplateMacro(vtkCalculatorLoad(static_cast<const VTK_TT*>(column.Pointer),
+          column.NumberOfComponents, column.Component, begin, n, r));
+      }
+    }
+    else if (column.Array)
+    {
+      for (vtkIdType i = 0; i < n; ++i)
+      {
+        r[i] = column.Array->GetComponent(begin + i, column.Component);
+      }
+    }
+    else
+    {
+      double x[3];
+      for (vtkIdType i = 0; i < n; ++i)
+      {
+        column.Input->GetPoint(begin + i, x);
+        r[i] = x[column.Component];
+      }
+    }
+  }
+};
+
+// Parses a function and emits the program evaluating it. Only the subset of
+// the vtkFunctionParser syntax whose meaning is unambiguous is accepted;
+// anything else (conditionals, comparisons, names that could be read in
+// several ways...) makes Compile() fail so the parser is used instead.
+class vtkCalculatorCompiler
+{
+public:
+  vtkCalculatorCompiler(const std::string& function, const vtkCalculatorVariables& variables,
+    vtkCalculatorProgram& program)
+    : Function(function)
+    , Variables(variables)
+    , Program(program)
+    , Position(0)
+  {
+  }
+
+  bool Compile()
+  {
+    Value value;
+    if (!this->ParseOperation(0, value))
+    {
+      return false;
+    }
+    this->SkipSpaces();
+    if (this->Position != this->Function.size())
+    {
+      return false;
+    }
+    this->Program.NumberOfResultComponents = value.NumberOfComponents;
+    std::copy(value.Registers, value.Registers + 3, this->Program.ResultRegisters);
+    return true;
+  }
+
+private:
+  struct Value
+  {
+    int NumberOfComponents;
+    int Registers[3];
+  };
+
+  static bool IsNameCharacter(char c)
+  {
+    return isalnum(static_cast<unsigned char>(c)) || c == '_';
+  }
+
+  void SkipSpaces()
+  {
+    while (this->Position < this->Function.size() &&
+      isspace(static_cast<unsigned char>(this->Function[this->Position])))
+    {
+      ++this->Position;
+    }
+  }
+
+  bool Accept(char c)
+  {
+    this->SkipSpaces();
+    if (this->Position < this->Function.size() && this->Function[this->Position] == c)
+    {
+      ++this->Position;
+      return true;
+    }
+    return false;
+  }
+
+  bool StartsWith(const std::string& name) const
+  {
+    return this->Function.compare(this->Position, name.size(), name) == 0;
+  }
+
+  int Emit(int operation, int left, int right = -1, double constant = 0.0)
+  {
+    vtkCalculatorInstruction inst = { operation, this->Program.NumberOfRegisters++, left, right,
+      constant };
+    this->Program.Instructions.push_back(inst);
+    return inst.Result;
+  }
+
+  int EmitLoad(bool coordinates, const std::string& arrayName, int component)
+  {
+    int input = 0;
+    const int numInputs = static_cast<int>(this->Program.Inputs.size());
+    for (; input < numInputs; ++input)
+    {
+      const vtkCalculatorInput& in = this->Program.Inputs[input];
+      if (in.Coordinates == coordinates && in.ArrayName == arrayName && in.Component == component)
+      {
+        return this->LoadRegisters[input];
+      }
+    }
+    vtkCalculatorInput in = { coordinates, arrayName, component };
+    this->Program.Inputs.push_back(in);
+    this->LoadRegisters.push_back(this->Emit(OP_LOAD, input));
+    return this->LoadRegisters.back();
+  }
+
+  // Emits `operation` on each component, `a` or `b` being broadcast when
+  // they are scalars.
+  void EmitComponents(int operation, const Value& a, const Value& b, Value& result)
+  {
+    const int numComps = std::max(a.NumberOfComponents, b.NumberOfComponents);
+    Value value;
+    value.NumberOfComponents = numComps;
+    for (int c = 0; c < numComps; ++c)
+    {
+      value.Registers[c] = this->Emit(operation, a.Registers[a.NumberOfComponents == 1 ? 0 : c],
+        b.Registers[b.NumberOfComponents == 1 ? 0 : c]);
+    }
+    result = value;
+  }
+
+  Value EmitScalar(int reg)
+  {
+    Value value;
+    value.NumberOfComponents = 1;
+    value.Registers[0] = reg;
+    return value;
+  }
+
+  int EmitDot(const Value& a, const Value& b)
+  {
+    int sum = this->Emit(OP_MULTIPLY, a.Registers[0], b.Registers[0]);
+    sum = this->Emit(OP_ADD, sum, this->Emit(OP_MULTIPLY, a.Registers[1], b.Registers[1]));
+    return this->Emit(OP_ADD, sum, this->Emit(OP_MULTIPLY, a.Registers[2], b.Registers[2]));
+  }
+
+  bool EmitOperator(char op, const Value& a, const Value& b, Value& result)
+  {
+    const bool scalars = a.NumberOfComponents == 1 && b.NumberOfComponents == 1;
+    const bool vectors = a.NumberOfComponents == 3 && b.NumberOfComponents == 3;
+    switch (op)
+    {
+      case '+':
+      case '-':
+        if (!scalars && !vectors)
+        {
+          return false;
+        }
+        this->EmitComponents(op == '+' ? OP_ADD : OP_SUBTRACT, a, b, result);
+        return true;
+      case '.':
+        if (!vectors)
+        {
+          return false;
+        }
+        result = this->EmitScalar(this->EmitDot(a, b));
+        return true;
+      case '*':
+        if (vectors)
+        {
+          return false;
+        }
+        this->EmitComponents(OP_MULTIPLY, a, b, result);
+        return true;
+      case '/':
+      case '^':
+        if (!scalars)
+        {
+          return false;
+        }
+        this->EmitComponents(op == '/' ? OP_DIVIDE : OP_POWER, a, b, result);
+        return true;
+    }
+    return false;
+  }
+
+  // Parses operations of priority `level` and above.
+  bool ParseOperation(int level, Value& value)
+  {
+    static const char operators[] = "+-.*/^";
+    if (operators[level] == '\0')
+    {
+      return this->ParseOperand(value);
+    }
+    if (!this->ParseOperation(level + 1, value))
+    {
+      return false;
+    }
+    while (this->Accept(operators[level]))
+    {
+      Value right;
+      if (!this->ParseOperation(level + 1, right) ||
+        !this->EmitOperator(operators[level], value, right, value))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool ParseOperand(Value& value)
+  {
+    if (!this->Accept('-'))
+    {
+      return this->ParsePrimary(value);
+    }
+    Value operand;
+    if (!this->ParsePrimary(operand))
+    {
+      return false;
+    }
+    value.NumberOfComponents = operand.NumberOfComponents;
+    for (int c = 0; c < operand.NumberOfComponents; ++c)
+    {
+      value.Registers[c] = this->Emit(OP_NEGATE, operand.Registers[c]);
+    }
+    return true;
+  }
+
+  bool ParsePrimary(Value& value)
+  {
+    this->SkipSpaces();
+    if (this->Position >= this->Function.size())
+    {
+      return false;
+    }
+    const char c = this->Function[this->Position];
+    if (c == '(')
+    {
+      ++this->Position;
+      return this->ParseOperation(0, value) && this->Accept(')');
+    }
+    if (isdigit(static_cast<unsigned char>(c)) || c == '.')
+    {
+      return this->ParseNumber(value);
+    }
+    return this->ParseName(value);
+  }
+
+  bool ParseNumber(Value& value)
+  {
+    const size_t start = this->Position;
+    const std::string& f = this->Function;
+    while (this->Position < f.size() && isdigit(static_cast<unsigned char>(f[this->Position])))
+    {
+      ++this->Position;
+    }
+    if (this->Position < f.size() && f[this->Position] == '.')
+    {
+      ++this->Position;
+      while (this->Position < f.size() && isdigit(static_cast<unsigned char>(f[this->Position])))
+      {
+        ++this->Position;
+      }
+    }
+    // Exponents and numbers glued to names are left to the parser.
+    if (this->Position == start + 1 && f[start] == '.')
+    {
+      return false;
+    }
+    if (this->Position < f.size() &&
+      (IsNameCharacter(f[this->Position]) || f[this->Position] == '.'))
+    {
+      return false;
+    }
+    const std::string number = f.substr(start, this->Position - start);
+    value = this->EmitScalar(this->Emit(OP_CONSTANT, -1, -1, strtod(number.c_str(), nullptr)));
+    return true;
+  }
+
+  bool ParseName(Value& value)
+  {
+    // The functions and constants of vtkFunctionParser.
+    static const char* const reserved[] = { "abs", "acos", "asin", "atan", "ceil", "cos", "cosh",
+      "cross", "exp", "floor", "iHat", "if", "jHat", "kHat", "ln", "log", "log10", "mag", "max",
+      "min", "norm", "sign", "sin", "sinh", "sqrt", "tan", "tanh" };
+
+    const vtkCalculatorVariable* variable = nullptr;
+    size_t variableLength = 0;
+    for (const auto& item : this->Variables)
+    {
+      if (item.first.size() > variableLength && this->StartsWith(item.first))
+      {
+        variable = &item.second;
+        variableLength = item.first.size();
+      }
+    }
+    std::string name;
+    for (const char* candidate : reserved)
+    {
+      if (strlen(candidate) > name.size() && this->StartsWith(candidate))
+      {
+        name = candidate;
+      }
+    }
+
+    // Function calls take precedence over shorter variable names ("a" in
+    // "abs(a)"), any other overlap is left to the parser.
+    const std::string& f = this->Function;
+    size_t next = this->Position + name.size();
+    while (next < f.size() && isspace(static_cast<unsigned char>(f[next])))
+    {
+      ++next;
+    }
+    const bool call = next < f.size() && f[next] == '(';
+    if (variable && !name.empty())
+    {
+      if (!call || variableLength >= name.size())
+      {
+        return false;
+      }
+      variable = nullptr;
+    }
+
+    const size_t length = variable ? variableLength : name.size();
+    const size_t end = this->Position + length;
+    if (length == 0 ||
+      (end < this->Function.size() && IsNameCharacter(this->Function[end - 1]) &&
+        IsNameCharacter(this->Function[end])))
+    {
+      return false;
+    }
+    this->Position = end;
+
+    if (variable)
+    {
+      if (variable->Ambiguous)
+      {
+        return false;
+      }
+      value.NumberOfComponents = variable->NumberOfComponents;
+      for (int c = 0; c < variable->NumberOfComponents; ++c)
+      {
+        value.Registers[c] =
+          this->EmitLoad(variable->Coordinates, variable->ArrayName, variable->Components[c]);
+      }
+      return true;
+    }
+    if (name.size() == 4 && name.compare(1, 3, "Hat") == 0)
+    {
+      value.NumberOfComponents = 3;
+      for (int c = 0; c < 3; ++c)
+      {
+        value.Registers[c] = this->Emit(OP_CONSTANT, -1, -1, name[0] - 'i' == c ? 1.0 : 0.0);
+      }
+      return true;
+    }
+    return this->ParseFunction(name, value);
+  }
+
+  bool ParseFunction(const std::string& name, Value& value)
+  {
+    static const struct
+    {
+      const char* Name;
+      int Operation;
+    } scalarFunctions[] = { { "abs", OP_ABS }, { "acos", OP_ACOS }, { "asin", OP_ASIN },
+      { "atan", OP_ATAN }, { "ceil", OP_CEIL }, { "cos", OP_COS }, { "cosh", OP_COSH },
+      { "exp", OP_EXP }, { "floor", OP_FLOOR }, { "ln", OP_LN }, { "log10", OP_LOG10 },
+      { "max", OP_MAX }, { "min", OP_MIN }, { "sign", OP_SIGN }, { "sin", OP_SIN },
+      { "sinh", OP_SINH }, { "sqrt", OP_SQRT }, { "tan", OP_TAN }, { "tanh", OP_TANH } };
+
+    const bool binary = name == "min" || name == "max" || name == "cross";
+    Value a, b;
+    if (!this->Accept('(') || !this->ParseOperation(0, a) ||
+      (binary && (!this->Accept(',') || !this->ParseOperation(0, b))) || !this->Accept(')'))
+    {
+      return false;
+    }
+
+    if (name == "mag" || name == "norm")
+    {
+      if (a.NumberOfComponents != 3)
+      {
+        return false;
+      }
+      const int magnitude = this->Emit(OP_SQRT, this->EmitDot(a, a));
+      if (name == "mag")
+      {
+        value = this->EmitScalar(magnitude);
+      }
+      else
+      {
+        this->EmitComponents(OP_DIVIDE, a, this->EmitScalar(magnitude), value);
+      }
+      return true;
+    }
+    if (name == "cross")
+    {
+      if (a.NumberOfComponents != 3 || b.NumberOfComponents != 3)
+      {
+        return false;
+      }
+      const int* u = a.Registers;
+      const int* v = b.Registers;
+      value.NumberOfComponents = 3;
+      for (int c = 0; c < 3; ++c)
+      {
+        const int c1 = (c + 1) % 3;
+        const int c2 = (c + 2) % 3;
+        value.Registers[c] = this->Emit(OP_SUBTRACT, this->Emit(OP_MULTIPLY, u[c1], v[c2]),
+          this->Emit(OP_MULTIPLY, u[c2], v[c1]));
+      }
+      return true;
+    }
+    for (const auto& function : scalarFunctions)
+    {
+      if (name == function.Name)
+      {
+        if (a.NumberOfComponents != 1 || (binary && b.NumberOfComponents != 1))
+        {
+          return false;
+        }
+        value = this->EmitScalar(
+          this->Emit(function.Operation, a.Registers[0], binary ? b.Registers[0] : -1));
+        return true;
+      }
+    }
+    // "if", and the deprecated "log".
+    return false;
+  }
+
+  const std::string& Function;
+  const vtkCalculatorVariables& Variables;
+  vtkCalculatorProgram& Program;
+  size_t Position;
+  std::vector<int> LoadRegisters;
+};
 }
 
 vtkStandardNewMacro(vtkPVArrayCalculator);
@@ -78,6 +952,8 @@ vtkPVArrayCalculator::vtkPVArrayCalculator()
   // We'll tell the superclass about all arrays (partial and full) and have it
   // ignore missing arrays when evaluating the calculator.
   this->IgnoreMissingArrays = true;
+  this->Backend = PARSER_BACKEND;
+  this->UsedCompiledProgram = false;
 }
 
 // ----------------------------------------------------------------------------
@@ -241,11 +1117,154 @@ int vtkPVArrayCalculator::RequestData(
   assert(this->GetMTime() == mtime && "post: mtime cannot be changed in RequestData()");
   (void)mtime;
 
+  this->UsedCompiledProgram = this->Backend == COMPILED_BACKEND &&
+    this->RequestDataCompiled(input, vtkDataObject::GetData(outputVector, 0));
+  if (this->UsedCompiledProgram)
+  {
+    return 1;
+  }
   return this->Superclass::RequestData(request, inputVector, outputVector);
 }
 
+// ----------------------------------------------------------------------------
+bool vtkPVArrayCalculator::RequestDataCompiled(vtkDataObject* input, vtkDataObject* output)
+{
+  if (!this->Function || !*this->Function || !this->ResultArrayName ||
+    !*this->ResultArrayName || this->CoordinateResults || this->ResultNormals ||
+    this->ResultTCoords)
+  {
+    return false;
+  }
+
+  // Only datasets, all using the same attributes, are handled.
+  std::vector<vtkDataSet*> inputs;
+  vtkCompositeDataSet* inputCD = vtkCompositeDataSet::SafeDownCast(input);
+  vtkSmartPointer<vtkCompositeDataIterator> cdIter;
+  if (inputCD)
+  {
+    cdIter.TakeReference(inputCD->NewIterator());
+    cdIter->SkipEmptyNodesOn();
+    for (cdIter->InitTraversal(); !cdIter->IsDoneWithTraversal(); cdIter->GoToNextItem())
+    {
+      inputs.push_back(vtkDataSet::SafeDownCast(cdIter->GetCurrentDataObject()));
+    }
+  }
+  else
+  {
+    inputs.push_back(vtkDataSet::SafeDownCast(input));
+  }
+  if (inputs.empty() || std::find(inputs.begin(), inputs.end(), nullptr) != inputs.end())
+  {
+    return false;
+  }
+  const int attributeType = this->GetAttributeTypeFromInput(inputs[0]);
+  if (attributeType != vtkDataObject::POINT && attributeType != vtkDataObject::CELL)
+  {
+    return false;
+  }
+  for (vtkDataSet* ds : inputs)
+  {
+    if (this->GetAttributeTypeFromInput(ds) != attributeType)
+    {
+      return false;
+    }
+  }
+
+  // Compile the function with the variables registered in RequestData().
+  vtkCalculatorVariables variables;
+  for (int i = 0; i < this->GetNumberOfScalarArrays(); ++i)
+  {
+    const char* name = this->GetScalarVariableName(i);
+    const char* arrayName = this->GetScalarArrayName(i);
+    const int component = this->GetSelectedScalarComponent(i);
+    if (name && arrayName)
+    {
+      vtkCalculatorAddVariable(variables, name, false, arrayName, 1, &component);
+    }
+  }
+  for (int i = 0; i < this->GetNumberOfVectorArrays(); ++i)
+  {
+    const char* name = this->GetVectorVariableName(i);
+    const char* arrayName = this->GetVectorArrayName(i);
+    if (name && arrayName)
+    {
+      vtkCalculatorAddVariable(
+        variables, name, false, arrayName, 3, this->GetSelectedVectorComponents(i));
+    }
+  }
+  if (attributeType == vtkDataObject::POINT)
+  {
+    // See AddCoordinateVariableNames().
+    static const int xyz[3] = { 0, 1, 2 };
+    vtkCalculatorAddVariable(variables, "coordsX", true, std::string(), 1, xyz);
+    vtkCalculatorAddVariable(variables, "coordsY", true, std::string(), 1, xyz + 1);
+    vtkCalculatorAddVariable(variables, "coordsZ", true, std::string(), 1, xyz + 2);
+    vtkCalculatorAddVariable(variables, "coords", true, std::string(), 3, xyz);
+  }
+  vtkCalculatorProgram program;
+  const std::string function = this->Function;
+  vtkCalculatorCompiler compiler(function, variables, program);
+  if (!compiler.Compile())
+  {
+    return false;
+  }
+
+  // Evaluate it on every dataset before producing any output, so that the
+  // parser can still take over.
+  std::vector<vtkSmartPointer<vtkDataArray> > results(inputs.size());
+  for (size_t cc = 0; cc < inputs.size(); ++cc)
+  {
+    vtkDataSet* ds = inputs[cc];
+    const vtkIdType numTuples = attributeType == vtkDataObject::POINT ? ds->GetNumberOfPoints()
+                                                                      : ds->GetNumberOfCells();
+    std::vector<vtkCalculatorColumn> columns;
+    if (numTuples == 0 ||
+      !program.Bind(ds, ds->GetAttributes(attributeType), numTuples, columns))
+    {
+      return false;
+    }
+    results[cc] = program.Execute(columns, numTuples, this->ResultArrayType);
+    if (!results[cc])
+    {
+      return false;
+    }
+    results[cc]->SetName(this->ResultArrayName);
+  }
+
+  // Pass the inputs through with the results added.
+  auto addResult = [&](vtkDataSet* ds, vtkDataArray* result) {
+    vtkDataSetAttributes* attributes = ds->GetAttributes(attributeType);
+    const int idx = attributes->AddArray(result);
+    attributes->SetActiveAttribute(idx, result->GetNumberOfComponents() == 1
+        ? vtkDataSetAttributes::SCALARS
+        : vtkDataSetAttributes::VECTORS);
+  };
+  if (inputCD)
+  {
+    vtkCompositeDataSet* outputCD = vtkCompositeDataSet::SafeDownCast(output);
+    outputCD->CopyStructure(inputCD);
+    size_t cc = 0;
+    for (cdIter->InitTraversal(); !cdIter->IsDoneWithTraversal(); cdIter->GoToNextItem(), ++cc)
+    {
+      vtkSmartPointer<vtkDataSet> block;
+      block.TakeReference(inputs[cc]->NewInstance());
+      block->ShallowCopy(inputs[cc]);
+      addResult(block, results[cc]);
+      outputCD->SetDataSet(cdIter, block);
+    }
+  }
+  else
+  {
+    vtkDataSet* outputDS = vtkDataSet::SafeDownCast(output);
+    outputDS->ShallowCopy(inputs[0]);
+    addResult(outputDS, results[0]);
+  }
+  return true;
+}
+
 // ----------------------------------------------------------------------------
 void vtkPVArrayCalculator::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "Backend: " << this->Backend << endl;
 }
@@ -24,6 +24,15 @@
  *  their mapping with the input fields. We extend vtkArrayCalculator to
  *  automatically add scalar/vector fields mapping using the array available in
  *  the input.
+ *
+ *  By default the function is evaluated by vtkFunctionParser, one tuple at a
+ *  time. With the compiled backend, the function is instead compiled into a
+ *  small program that evaluates it on chunks of tuples, in parallel (see
+ *  vtkSMPTools). Functions the compiled backend does not handle (conditionals,
+ *  comparisons, coordinate results...) and inputs on which the function hits
+ *  an invalid value (division by zero, square root of a negative number...)
+ *  are still evaluated by the parser, so both backends produce the same
+ *  output.
  * @sa
  *  vtkArrayCalculator vtkFunctionParser
 */
@@ -45,6 +54,23 @@ public:
 
   static vtkPVArrayCalculator* New();
 
+  enum BackendTypes
+  {
+    PARSER_BACKEND = 0,
+    COMPILED_BACKEND = 1
+  };
+
+  //@{
+  /**
+   * Set/Get how the function is evaluated. PARSER_BACKEND (the default)
+   * evaluates it with vtkFunctionParser. COMPILED_BACKEND evaluates it with a
+   * compiled program run in parallel, falling back to the parser when the
+   * function or the input is not supported.
+   */
+  vtkSetClampMacro(Backend, int, PARSER_BACKEND, COMPILED_BACKEND);
+  vtkGetMacro(Backend, int);
+  //@}
+
 protected:
   vtkPVArrayCalculator();
   ~vtkPVArrayCalculator() override;
@@ -76,6 +102,22 @@ protected:
    */
   void AddArrayAndVariableNames(vtkDataObject* theInputObj, vtkDataSetAttributes* inDataAttrs);
 
+  /**
+   * Evaluates the function with the compiled backend. Returns false, leaving
+   * the output untouched, when the function or the input is not supported;
+   * the superclass then evaluates it. Must be called after the variables have
+   * been registered.
+   */
+  bool RequestDataCompiled(vtkDataObject* input, vtkDataObject* output);
+
+  int Backend;
+
+  /**
+   * True if the last execution was done by the compiled backend, false if the
+   * parser evaluated the function.
+   */
+  bool UsedCompiledProgram;
+
 private:
   vtkPVArrayCalculator(const vtkPVArrayCalculator&) = delete;
   void operator=(const vtkPVArrayCalculator&) = delete;
@@ -16,6 +16,7 @@
 
 // VTK includes
 #include "vtkBoundingBox.h"
+#include "vtkCellArray.h"
 #include "vtkCellCenters.h"
 #include "vtkCellData.h"
 #include "vtkCompositeDataIterator.h"
@@ -24,6 +25,7 @@
 #include "vtkDataSetTriangleFilter.h"
 #include "vtkFloatArray.h"
 #include "vtkIdFilter.h"
+#include "vtkIdTypeArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMinimalStandardRandomSequence.h"
@@ -34,6 +36,8 @@
 #include "vtkOctreePointLocator.h"
 #include "vtkPointData.h"
 #include "vtkPolyData.h"
+#include "vtkSMPThreadLocalObject.h"
+#include "vtkSMPTools.h"
 #include "vtkSmartPointer.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkTetra.h"
@@ -51,6 +55,7 @@
 #include <numeric>
 #include <random>
 #include <set>
+#include <utility>
 #include <vector>
 
 static const std::string IDS_ARRAY_NAME = "vtkPVGlyphFilter_Ids";
@@ -506,6 +511,7 @@ vtkPVGlyphFilter::vtkPVGlyphFilter()
   , Seed(1)
   , Stride(1)
   , Controller(0)
+  , OutputInstances(false)
   , Internals(new vtkPVGlyphFilter::vtkInternals())
 {
   this->SetController(vtkMultiProcessController::GetGlobalController());
@@ -832,9 +838,6 @@ bool vtkPVGlyphFilter::Execute(unsigned int index, vtkDataSet* input,
 
   vtkDebugMacro(<< "Generating glyphs");
 
-  auto pts = vtkSmartPointer<vtkIdList>::New();
-  pts->Allocate(VTK_CELL_SIZE);
-
   unsigned char* inGhostLevels = nullptr;
   vtkDataArray* temp = nullptr;
   auto pd = input->GetPointData();
@@ -858,12 +861,67 @@ bool vtkPVGlyphFilter::Execute(unsigned int index, vtkDataSet* input,
     return 1;
   }
 
+  // Masking pass: select the points to glyph before generating anything, so
+  // that the glyphs can then be generated independently of each other.
+  // IsPointVisible expects increasing point ids, so this pass stays serial.
+  vtkUniformGrid* inputUG = vtkUniformGrid::SafeDownCast(input);
+  std::vector<vtkIdType> glyphedPts;
+  glyphedPts.reserve(this->GlyphMode == ALL_POINTS ? numPts : 0);
+  for (vtkIdType inPtId = 0; inPtId < numPts; inPtId++)
+  {
+    if (!(inPtId % 100000))
+    {
+      this->UpdateProgress(0.1 * inPtId / numPts);
+      if (this->GetAbortExecute())
+      {
+        break;
+      }
+    }
+
+    // Check ghost points.
+    // If we are processing a piece, we do not want to duplicate
+    // glyphs on the borders.
+    if (inGhostLevels && inGhostLevels[inPtId] & vtkDataSetAttributes::DUPLICATEPOINT)
+    {
+      continue;
+    }
+
+    // this is used to respect blanking specified on uniform grids.
+    if (inputUG && !inputUG->IsPointVisible(inPtId))
+    {
+      continue;
+    }
+
+    if (!this->IsPointVisible(index, input, inPtId, cellCenters))
+    {
+      continue;
+    }
+    glyphedPts.push_back(inPtId);
+  }
+  const vtkIdType numGlyphs = static_cast<vtkIdType>(glyphedPts.size());
+
   // Allocate storage for output PolyData
   vtkPointData* outputPD = output->GetPointData();
   outputPD->CopyVectorsOff();
   outputPD->CopyNormalsOff();
   outputPD->CopyTCoordsOff();
 
+  auto newPts = vtkSmartPointer<vtkPoints>::New();
+
+  // Set the desired precision for the points in the output.
+  if (this->OutputPointsPrecision == vtkAlgorithm::DEFAULT_PRECISION)
+  {
+    newPts->SetDataType(VTK_FLOAT);
+  }
+  else if (this->OutputPointsPrecision == vtkAlgorithm::SINGLE_PRECISION)
+  {
+    newPts->SetDataType(VTK_FLOAT);
+  }
+  else if (this->OutputPointsPrecision == vtkAlgorithm::DOUBLE_PRECISION)
+  {
+    newPts->SetDataType(VTK_DOUBLE);
+  }
+
   vtkSmartPointer<vtkPolyData> source = this->GetSource(0, sourceVector);
   if (source == nullptr)
   {
@@ -881,237 +939,236 @@ bool vtkPVGlyphFilter::Execute(unsigned int index, vtkDataSet* input,
     source = defaultSource;
   }
 
-  auto sourcePts = source->GetPoints();
-  vtkIdType numSourcePts = sourcePts->GetNumberOfPoints();
-  vtkIdType numSourceCells = source->GetNumberOfCells();
-
-  vtkDataArray* sourceNormals = source->GetPointData()->GetNormals();
-
-  // Prepare to copy output.
-  pd = input->GetPointData();
-  outputPD->CopyAllocate(pd, numPts * numSourcePts);
-
-  vtkNew<vtkIdList> srcPointIdList;
-  srcPointIdList->SetNumberOfIds(numSourcePts);
-  vtkNew<vtkIdList> dstPointIdList;
-  dstPointIdList->SetNumberOfIds(numSourcePts);
-  vtkNew<vtkIdList> srcCellIdList;
-  srcCellIdList->SetNumberOfIds(numSourceCells);
-  vtkNew<vtkIdList> dstCellIdList;
-  dstCellIdList->SetNumberOfIds(numSourceCells);
-
-  auto newPts = vtkSmartPointer<vtkPoints>::New();
-
-  // Set the desired precision for the points in the output.
-  if (this->OutputPointsPrecision == vtkAlgorithm::DEFAULT_PRECISION)
-  {
-    newPts->SetDataType(VTK_FLOAT);
-  }
-  else if (this->OutputPointsPrecision == vtkAlgorithm::SINGLE_PRECISION)
+  // Apply the source transform once, it is the same for all glyphs.
+  vtkSmartPointer<vtkPoints> sourcePts = source->GetPoints();
+  if (this->SourceTransform && !this->OutputInstances)
   {
-    newPts->SetDataType(VTK_FLOAT);
-  }
-  else if (this->OutputPointsPrecision == vtkAlgorithm::DOUBLE_PRECISION)
-  {
-    newPts->SetDataType(VTK_DOUBLE);
+    auto transformedSourcePts = vtkSmartPointer<vtkPoints>::New();
+    transformedSourcePts->SetDataTypeToDouble();
+    transformedSourcePts->Allocate(sourcePts->GetNumberOfPoints());
+    this->SourceTransform->TransformPoints(sourcePts, transformedSourcePts);
+    sourcePts = transformedSourcePts;
   }
+  const vtkIdType numSourcePts = this->OutputInstances ? 1 : sourcePts->GetNumberOfPoints();
+  vtkDataArray* sourceNormals =
+    this->OutputInstances ? nullptr : source->GetPointData()->GetNormals();
 
-  newPts->Allocate(numPts * numSourcePts);
+  // Every glyph produces the same number of points and cells, so the output of
+  // glyph i starts at i * numSourcePts points and can be written directly.
+  const vtkIdType numOutPts = numGlyphs * numSourcePts;
+  newPts->SetNumberOfPoints(numOutPts);
 
   vtkSmartPointer<vtkFloatArray> newNormals;
   if (sourceNormals)
   {
     newNormals.TakeReference(vtkFloatArray::New());
     newNormals->SetNumberOfComponents(3);
-    newNormals->Allocate(3 * numPts * numSourcePts);
+    newNormals->SetNumberOfTuples(numOutPts);
     newNormals->SetName("Normals");
   }
 
-  // Setting up for calls to PolyData::InsertNextCell()
-  output->Allocate(source, 3 * numPts * numSourceCells, numPts * numSourceCells);
-
-  vtkSmartPointer<vtkPoints> transformedSourcePts = vtkSmartPointer<vtkPoints>::New();
-  transformedSourcePts->SetDataTypeToDouble();
-  transformedSourcePts->Allocate(numSourcePts);
+  vtkSmartPointer<vtkFloatArray> instanceOrientations;
+  vtkSmartPointer<vtkFloatArray> instanceScales;
+  if (this->OutputInstances)
+  {
+    instanceOrientations.TakeReference(vtkFloatArray::New());
+    instanceOrientations->SetNumberOfComponents(3);
+    instanceOrientations->SetNumberOfTuples(numGlyphs);
+    instanceOrientations->SetName("GlyphOrientation");
+    instanceScales.TakeReference(vtkFloatArray::New());
+    instanceScales->SetNumberOfComponents(3);
+    instanceScales->SetNumberOfTuples(numGlyphs);
+    instanceScales->SetName("GlyphScale");
+  }
 
-  // Traverse all Input points, transforming Source points and copying
-  // point attributes.
-  auto trans = vtkSmartPointer<vtkTransform>::New();
-  vtkNew<vtkIdList> pointIdList;
-  vtkIdType ptIncr = 0;
-  vtkIdType cellIncr = 0;
-  for (vtkIdType inPtId = 0; inPtId < numPts; inPtId++)
+  // Prepare to copy point data. Arrays are sized up front so that glyphs can
+  // fill their own range of tuples concurrently.
+  pd = input->GetPointData();
+  outputPD->CopyAllocate(pd, numOutPts);
+  std::vector<std::pair<vtkAbstractArray*, vtkAbstractArray*> > pointArrays;
+  for (int cc = outputPD->GetNumberOfArrays() - 1; cc >= 0; --cc)
   {
-    double scalex(1.0), scaley(1.0), scalez(1.0);
-    if (!(inPtId % 10000))
+    vtkAbstractArray* outArray = outputPD->GetAbstractArray(cc);
+    vtkAbstractArray* inArray =
+      outArray->GetName() ? pd->GetAbstractArray(outArray->GetName()) : nullptr;
+    // In certain cases, we can have a left over processing array, remove it.
+    if (!inArray || outArray->GetName() == IDS_ARRAY_NAME)
     {
-      this->UpdateProgress(static_cast<double>(inPtId) / numPts);
-      if (this->GetAbortExecute())
-      {
-        break;
-      }
+      outputPD->RemoveArray(cc);
+      continue;
     }
+    outArray->SetNumberOfTuples(numOutPts);
+    pointArrays.push_back(std::make_pair(inArray, outArray));
+  }
+
+  this->UpdateProgress(0.1);
 
-    // Get the scalar and vector data
-    if (scaleArray)
+  vtkSMPThreadLocalObject<vtkTransform> localTransform;
+  vtkSMPTools::For(0, numGlyphs, [&](vtkIdType begin, vtkIdType end) {
+    vtkTransform* trans = localTransform.Local();
+    double orient[3] = { 0.0 };
+    double scale[3];
+    double x[3];
+    double y[3];
+    for (vtkIdType glyph = begin; glyph < end; glyph++)
     {
-      if (scaleArray->GetNumberOfComponents() == 1)
-      {
-        scalex = scaley = scalez = scaleArray->GetComponent(inPtId, 0);
-      }
-      else
+      const vtkIdType inPtId = glyphedPts[glyph];
+      const vtkIdType outPtId = glyph * numSourcePts;
+
+      // Get the scalar and vector data
+      scale[0] = scale[1] = scale[2] = 1.0;
+      if (scaleArray)
       {
-        // Consider the vector scaling mode
-        if (scaleArray->GetNumberOfComponents() == 2)
+        const int numComps = scaleArray->GetNumberOfComponents();
+        if (numComps == 1)
         {
-          double* vec2 = scaleArray->GetTuple(inPtId);
-          if (this->VectorScaleMode == SCALE_BY_MAGNITUDE)
-          {
-            scalex = scaley = scalez = vtkMath::Norm2D(vec2);
-          }
-          else if (this->VectorScaleMode == SCALE_BY_COMPONENTS)
-          {
-            scalex = vec2[0];
-            scaley = vec2[1];
-            // leave scalez alone for 2D
-          }
+          scale[0] = scale[1] = scale[2] = scaleArray->GetComponent(inPtId, 0);
         }
-        else if (scaleArray->GetNumberOfComponents() == 3)
+        else if (numComps == 2 || numComps == 3)
         {
-          double* vec3 = scaleArray->GetTuple(inPtId);
+          double vec[3] = { 0.0 };
+          scaleArray->GetTuple(inPtId, vec);
+          // Consider the vector scaling mode
           if (this->VectorScaleMode == SCALE_BY_MAGNITUDE)
           {
-            scalex = scaley = scalez = vtkMath::Norm(vec3);
+            scale[0] = scale[1] = scale[2] =
+              numComps == 2 ? vtkMath::Norm2D(vec) : vtkMath::Norm(vec);
           }
-          else
+          else if (this->VectorScaleMode == SCALE_BY_COMPONENTS)
           {
-            scalex = vec3[0];
-            scaley = vec3[1];
-            scalez = vec3[2];
+            scale[0] = vec[0];
+            scale[1] = vec[1];
+            // leave z alone for 2D
+            scale[2] = numComps == 2 ? 1.0 : vec[2];
           }
         }
       }
-    }
-
-    // Apply scale factor
-    scalex *= this->ScaleFactor;
-    scaley *= this->ScaleFactor;
-    scalez *= this->ScaleFactor;
 
-    // Check ghost points.
-    // If we are processing a piece, we do not want to duplicate
-    // glyphs on the borders.
-    if (inGhostLevels && inGhostLevels[inPtId] & vtkDataSetAttributes::DUPLICATEPOINT)
-    {
-      continue;
-    }
-
-    // this is used to respect blanking specified on uniform grids.
-    vtkUniformGrid* inputUG = vtkUniformGrid::SafeDownCast(input);
-    if (inputUG && !inputUG->IsPointVisible(inPtId))
-    {
-      // input is a vtkUniformGrid and the current point is blanked. Don't glyph
-      // it.
-      continue;
-    }
-
-    if (!this->IsPointVisible(index, input, inPtId, cellCenters))
-    {
-      continue;
-    }
-
-    // Now begin copying/transforming glyph
-    trans->Identity();
-
-    // Copy all topology (transformation independent)
-    for (vtkIdType cellId = 0; cellId < numSourceCells; cellId++)
-    {
-      source->GetCellPoints(cellId, pointIdList);
-      int npts = pointIdList->GetNumberOfIds();
-      pts->Reset();
-      for (vtkIdType i = 0; i < npts; i++)
+      // Apply scale factor, and avoid degenerate glyphs.
+      for (int c = 0; c < 3; c++)
       {
-        pts->InsertId(i, pointIdList->GetId(i) + ptIncr);
+        scale[c] *= this->ScaleFactor;
+        if (scale[c] == 0.0)
+        {
+          scale[c] = 1.0e-10;
+        }
       }
-      output->InsertNextCell(source->GetCellType(cellId), pts);
-    }
 
-    // translate Source to Input point
-    double x[3];
-    input->GetPoint(inPtId, x);
-    trans->Translate(x[0], x[1], x[2]);
+      if (orientArray)
+      {
+        orientArray->GetTuple(inPtId, orient);
+      }
 
-    if (orientArray)
-    {
-      double v[3] = { 0.0 };
-      orientArray->GetTuple(inPtId, v);
-      double vMag = vtkMath::Norm(v);
-      if (vMag > 0.0)
+      input->GetPoint(inPtId, x);
+      if (this->OutputInstances)
       {
-        // if there is no y or z component
-        if (v[1] == 0.0 && v[2] == 0.0)
+        newPts->SetPoint(outPtId, x);
+        instanceOrientations->SetTuple(glyph, orient);
+        instanceScales->SetTuple(glyph, scale);
+      }
+      else
+      {
+        // translate Source to Input point
+        trans->Identity();
+        trans->Translate(x[0], x[1], x[2]);
+
+        double vMag = vtkMath::Norm(orient);
+        if (orientArray && vMag > 0.0)
         {
-          if (v[0] < 0) // just flip x if we need to
+          // if there is no y or z component
+          if (orient[1] == 0.0 && orient[2] == 0.0)
+          {
+            if (orient[0] < 0) // just flip x if we need to
+            {
+              trans->RotateWXYZ(180.0, 0, 1, 0);
+            }
+          }
+          else
           {
-            trans->RotateWXYZ(180.0, 0, 1, 0);
+            trans->RotateWXYZ(180.0, (orient[0] + vMag) / 2.0, orient[1] / 2.0, orient[2] / 2.0);
           }
         }
-        else
+        trans->Scale(scale[0], scale[1], scale[2]);
+
+        // multiply points and normals by resulting matrix
+        for (vtkIdType i = 0; i < numSourcePts; i++)
         {
-          double vNew[3];
-          vNew[0] = (v[0] + vMag) / 2.0;
-          vNew[1] = v[1] / 2.0;
-          vNew[2] = v[2] / 2.0;
-          trans->RotateWXYZ(180.0, vNew[0], vNew[1], vNew[2]);
+          sourcePts->GetPoint(i, y);
+          trans->TransformPoint(y, y);
+          newPts->SetPoint(outPtId + i, y);
+        }
+        if (newNormals)
+        {
+          for (vtkIdType i = 0; i < numSourcePts; i++)
+          {
+            sourceNormals->GetTuple(i, y);
+            trans->TransformNormal(y, y);
+            newNormals->SetTuple(outPtId + i, y);
+          }
         }
       }
-    }
 
-    // scale data if appropriate
-    if (scalex == 0.0)
-    {
-      scalex = 1.0e-10;
-    }
-    if (scaley == 0.0)
-    {
-      scaley = 1.0e-10;
-    }
-    if (scalez == 0.0)
-    {
-      scalez = 1.0e-10;
-    }
-    trans->Scale(scalex, scaley, scalez);
-
-    // multiply points and normals by resulting matrix
-    if (this->SourceTransform)
-    {
-      transformedSourcePts->Reset();
-      this->SourceTransform->TransformPoints(sourcePts, transformedSourcePts);
-      trans->TransformPoints(transformedSourcePts, newPts);
-    }
-    else
-    {
-      trans->TransformPoints(sourcePts, newPts);
+      // Copy point data from the glyphed point.
+      for (auto& arrays : pointArrays)
+      {
+        for (vtkIdType i = 0; i < numSourcePts; i++)
+        {
+          arrays.second->SetTuple(outPtId + i, inPtId, arrays.first);
+        }
+      }
     }
+  });
 
-    if (newNormals.GetPointer())
-    {
-      trans->TransformNormals(sourceNormals, newNormals);
-    }
+  this->UpdateProgress(0.9);
 
-    // Copy point data from source (if possible)
-    if (pd)
+  if (this->OutputInstances)
+  {
+    outputPD->AddArray(instanceOrientations);
+    outputPD->AddArray(instanceScales);
+  }
+  else
+  {
+    // Replicate the source cells for every glyph, offsetting their point ids.
+    vtkCellArray* sourceCells[4] = { source->GetVerts(), source->GetLines(), source->GetPolys(),
+      source->GetStrips() };
+    vtkSmartPointer<vtkCellArray> outputCells[4];
+    for (int type = 0; type < 4; type++)
     {
-      for (vtkIdType i = 0; i < numSourcePts; ++i)
+      if (!sourceCells[type] || sourceCells[type]->GetNumberOfCells() == 0)
       {
-        srcPointIdList->SetId(i, inPtId);
-        dstPointIdList->SetId(i, ptIncr + i);
+        continue;
       }
-      outputPD->CopyData(pd, srcPointIdList, dstPointIdList);
-    }
+      vtkIdTypeArray* sourceConn = sourceCells[type]->GetData();
+      const vtkIdType connSize = sourceConn->GetNumberOfValues();
+      const vtkIdType* sourceIds = sourceConn->GetPointer(0);
+
+      vtkNew<vtkIdTypeArray> conn;
+      conn->SetNumberOfValues(numGlyphs * connSize);
+      vtkIdType* ids = conn->GetPointer(0);
+      vtkSMPTools::For(0, numGlyphs, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType glyph = begin; glyph < end; glyph++)
+        {
+          const vtkIdType ptOffset = glyph * numSourcePts;
+          vtkIdType* out = ids + glyph * connSize;
+          for (vtkIdType i = 0; i < connSize;)
+          {
+            const vtkIdType npts = sourceIds[i];
+            out[i++] = npts;
+            for (vtkIdType j = 0; j < npts; j++, i++)
+            {
+              out[i] = sourceIds[i] + ptOffset;
+            }
+          }
+        }
+      });
 
-    ptIncr += numSourcePts;
-    cellIncr += numSourceCells;
+      outputCells[type] = vtkSmartPointer<vtkCellArray>::New();
+      outputCells[type]->SetCells(numGlyphs * sourceCells[type]->GetNumberOfCells(), conn);
+    }
+    output->SetVerts(outputCells[0]);
+    output->SetLines(outputCells[1]);
+    output->SetPolys(outputCells[2]);
+    output->SetStrips(outputCells[3]);
   }
 
   if (newNormals.GetPointer())
@@ -1119,13 +1176,9 @@ bool vtkPVGlyphFilter::Execute(unsigned int index, vtkDataSet* input,
     outputPD->SetNormals(newNormals);
   }
 
-  // In certain cases, we can have a left over processing array, remove it.
-  outputPD->RemoveArray(IDS_ARRAY_NAME.c_str());
-
   // Update ourselves and release memory
   //
   output->SetPoints(newPts);
-  output->Squeeze();
 
   return true;
 }
@@ -1164,4 +1217,5 @@ void vtkPVGlyphFilter::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Seed: " << this->Seed << endl;
   os << indent << "Stride: " << this->Stride << endl;
   os << indent << "Controller: " << this->Controller << endl;
+  os << indent << "OutputInstances: " << this->OutputInstances << endl;
 }
@@ -54,6 +54,11 @@
  * In parallel and with composite dataset, this filter ensures that each piece
  * samples only a representative number of points.
  * Note that the grid will be tetrahedralized first.
+ *
+ * The points to glyph are selected first, and the glyphs are then generated in
+ * parallel using vtkSMPTools. When \c OutputInstances is on, the glyph source is
+ * not replicated: the output has a single vertex per glyph with its orientation
+ * and scale so that it can be rendered with instancing (e.g. vtkGlyph3DMapper).
 */
 
 #ifndef vtkPVGlyphFilter_h
@@ -186,6 +191,20 @@ public:
   vtkGetMacro(MaximumNumberOfSamplePoints, int);
   //@}
 
+  //@{
+  /**
+   * When set, the output is a table of glyph instances instead of the glyph
+   * geometry: one point per glyph, located at the glyphed point, with a
+   * "GlyphOrientation" vector array and a "GlyphScale" 3-component array
+   * (ScaleFactor included) added to the copied point data. The source and
+   * \c SourceTransform are then left for the renderer to apply.
+   * Off by default.
+   */
+  vtkSetMacro(OutputInstances, bool);
+  vtkGetMacro(OutputInstances, bool);
+  vtkBooleanMacro(OutputInstances, bool);
+  //@}
+
   /**
    * Overridden to create output data of appropriate type.
    */
@@ -257,6 +276,7 @@ protected:
   int Stride;
   vtkMultiProcessController* Controller;
   int OutputPointsPrecision;
+  bool OutputInstances;
 
 private:
   vtkPVGlyphFilter(const vtkPVGlyphFilter&) = delete;
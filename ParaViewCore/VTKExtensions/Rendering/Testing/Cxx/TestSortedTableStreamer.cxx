@@ -0,0 +1,182 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestSortedTableStreamer.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Tests that the blocks produced by vtkSortedTableStreamer are correct after
+// the data is modified, i.e. that neither the sort, the cached global index
+// searches nor the table merged from a composite input are reused when stale.
+
+#include "vtkDataArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkDummyController.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkNew.h"
+#include "vtkSmartPointer.h"
+#include "vtkSortedTableStreamer.h"
+#include "vtkTable.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#define expect(x, msg)                                                                             \
+  if (!(x))                                                                                        \
+  {                                                                                                \
+    cerr << __LINE__ << ": " msg << endl;                                                          \
+    return EXIT_FAILURE;                                                                           \
+  }
+
+namespace
+{
+const vtkIdType NumberOfRows = 5000;
+const vtkIdType BlockSize = 100;
+
+typedef std::vector<std::pair<double, vtkIdType> > RowsType;
+
+// Creates a table with `numRows` rows with a "value" column and an "id"
+// column holding the id of the row in `rows`.
+vtkSmartPointer<vtkTable> NewTable(vtkIdType firstId, vtkIdType numRows)
+{
+  vtkNew<vtkDoubleArray> values;
+  values->SetName("value");
+  values->SetNumberOfTuples(numRows);
+  vtkNew<vtkIdTypeArray> ids;
+  ids->SetName("id");
+  ids->SetNumberOfTuples(numRows);
+  for (vtkIdType cc = 0; cc < numRows; ++cc)
+  {
+    ids->SetValue(cc, firstId + cc);
+  }
+  auto table = vtkSmartPointer<vtkTable>::New();
+  table->AddColumn(values);
+  table->AddColumn(ids);
+  return table;
+}
+
+// Fills the "value" column of `table` with f(id) and records the rows.
+void FillTable(vtkTable* table, double (*f)(vtkIdType), RowsType& rows)
+{
+  vtkDataArray* values = vtkDataArray::SafeDownCast(table->GetColumnByName("value"));
+  vtkIdTypeArray* ids = vtkIdTypeArray::SafeDownCast(table->GetColumnByName("id"));
+  for (vtkIdType cc = 0; cc < table->GetNumberOfRows(); ++cc)
+  {
+    const double value = f(ids->GetValue(cc));
+    values->SetTuple1(cc, value);
+    rows.push_back(std::make_pair(value, ids->GetValue(cc)));
+  }
+  values->Modified();
+}
+
+// Values are unique so that the sorted order of the rows is unique.
+double Scrambled(vtkIdType id)
+{
+  return static_cast<double>((id * 7919) % NumberOfRows);
+}
+
+double Doubled(vtkIdType id)
+{
+  return 2.0 * (NumberOfRows - id);
+}
+
+// Checks that `block` of the streamer output holds the expected rows.
+bool CheckBlock(vtkSortedTableStreamer* streamer, vtkIdType block, RowsType rows, bool ascending)
+{
+  std::sort(rows.begin(), rows.end());
+  if (!ascending)
+  {
+    std::reverse(rows.begin(), rows.end());
+  }
+
+  streamer->SetBlock(block);
+  streamer->Update();
+  vtkTable* output = streamer->GetOutput();
+  vtkDataArray* values = vtkDataArray::SafeDownCast(output->GetColumnByName("value"));
+  vtkDataArray* ids = vtkDataArray::SafeDownCast(output->GetColumnByName("id"));
+  if (!values || !ids || output->GetNumberOfRows() != BlockSize)
+  {
+    cerr << "Unexpected output for block " << block << endl;
+    return false;
+  }
+  for (vtkIdType cc = 0; cc < BlockSize; ++cc)
+  {
+    const auto& expected = rows[block * BlockSize + cc];
+    if (values->GetTuple1(cc) != expected.first ||
+      static_cast<vtkIdType>(ids->GetTuple1(cc)) != expected.second)
+    {
+      cerr << "Block " << block << " row " << cc << ": got (" << values->GetTuple1(cc) << ", "
+           << ids->GetTuple1(cc) << "), expected (" << expected.first << ", " << expected.second
+           << ")" << endl;
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+int TestSortedTableStreamer(int, char* [])
+{
+  vtkNew<vtkDummyController> controller;
+
+  vtkNew<vtkSortedTableStreamer> streamer;
+  streamer->SetController(controller);
+  streamer->SetBlockSize(BlockSize);
+  streamer->SetColumnNameToSort("value");
+
+  // Table input.
+  auto table = NewTable(0, NumberOfRows);
+  RowsType rows;
+  FillTable(table, Scrambled, rows);
+  streamer->SetInputData(table);
+
+  // Fetch some blocks twice, out of order, to fill the search cache.
+  expect(CheckBlock(streamer, 0, rows, false), "wrong first block.");
+  expect(CheckBlock(streamer, 7, rows, false), "wrong block.");
+  expect(CheckBlock(streamer, 8, rows, false), "wrong next block.");
+  expect(CheckBlock(streamer, 7, rows, false), "wrong cached block.");
+
+  // Modify the data in place: cached searches must not be reused.
+  rows.clear();
+  FillTable(table, Doubled, rows);
+  expect(CheckBlock(streamer, 7, rows, false), "stale block after modifying the data.");
+  expect(CheckBlock(streamer, 0, rows, false), "stale first block after modifying the data.");
+
+  // Inverting the order re-sorts.
+  streamer->SetInvertOrder(1);
+  expect(CheckBlock(streamer, 7, rows, true), "wrong block after inverting the order.");
+  streamer->SetInvertOrder(0);
+
+  // Composite input, merged into a single table.
+  vtkNew<vtkMultiBlockDataSet> mb;
+  auto table0 = NewTable(0, NumberOfRows / 2);
+  auto table1 = NewTable(NumberOfRows / 2, NumberOfRows - NumberOfRows / 2);
+  mb->SetBlock(0, table0);
+  mb->SetBlock(1, table1);
+  rows.clear();
+  FillTable(table0, Scrambled, rows);
+  FillTable(table1, Scrambled, rows);
+  streamer->SetInputData(mb);
+  expect(CheckBlock(streamer, 3, rows, false), "wrong block from composite input.");
+  expect(CheckBlock(streamer, 4, rows, false), "wrong next block from composite input.");
+
+  // Modify one block of the composite input only: the merged table must be
+  // rebuilt even though the multiblock itself is not modified.
+  rows.clear();
+  FillTable(table0, Scrambled, rows);
+  FillTable(table1, Doubled, rows);
+  expect(CheckBlock(streamer, 3, rows, false), "stale block after modifying a composite block.");
+  expect(CheckBlock(streamer, 0, rows, false), "stale first block from composite input.");
+
+  return EXIT_SUCCESS;
+}
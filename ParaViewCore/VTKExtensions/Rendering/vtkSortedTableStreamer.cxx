@@ -45,9 +45,11 @@
 #include "vtkMath.h"
 #include "vtkMultiBlockDataSet.h"
 #include "vtkMultiProcessController.h"
+#include "vtkSMPTools.h"
 #include "vtkUnsignedIntArray.h"
 
 #include <algorithm>
+#include <map>
 #include <set>
 #include <vector>
 
@@ -67,9 +69,9 @@ public:
   virtual void SetSelectedComponent(int newValue) = 0;
   virtual void InvalidateCache() = 0;
   virtual int Extract(
-    vtkTable* input, vtkTable* output, vtkIdType block, vtkIdType blockSize, bool revertOrder) = 0;
+    vtkTable* input, vtkTable* output, vtkIdType offset, vtkIdType blockSize, bool revertOrder) = 0;
   virtual int Compute(
-    vtkTable* input, vtkTable* output, vtkIdType block, vtkIdType blockSize, bool revertOrder) = 0;
+    vtkTable* input, vtkTable* output, vtkIdType offset, vtkIdType blockSize, bool revertOrder) = 0;
   virtual bool IsInvalid(vtkTable* input, vtkDataArray* dataToProcess) = 0;
   virtual bool IsSortable() = 0;
   virtual bool TestInternalClasses() = 0;
@@ -468,11 +470,14 @@ public:
       this->Array = new SortableArrayItem[this->ArraySize];
 
       // Fill the sortable array
-      for (vtkIdType i = 0; i < this->ArraySize; ++i)
-      {
-        this->Array[i].OriginalIndex = i;
-        this->Array[i].Value = 0;
-      }
+      SortableArrayItem* array = this->Array;
+      vtkSMPTools::For(0, this->ArraySize, [array](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; ++i)
+        {
+          array[i].OriginalIndex = i;
+          array[i].Value = 0;
+        }
+      });
     }
 
     void Update(T* dataPtr, vtkIdType numTuples, int numComponents, int selectedComponent,
@@ -493,39 +498,54 @@ public:
       this->ArraySize = numTuples;
       this->Array = new SortableArrayItem[this->ArraySize];
 
-      // Fill the sortable array
-      for (vtkIdType i = 0; i < this->ArraySize; ++i)
-      {
-        this->Array[i].OriginalIndex = i;
-        double value = 0;
-        double tmp;
-        if (selectedComponent < 0)
-        {
-          // Compute magnitude
-          for (int k = 0; k < numComponents; k++)
+      // Fill the sortable array. Only the sort key and the original index are
+      // stored so that the rows themselves are never copied while sorting.
+      SortableArrayItem* array = this->Array;
+      const double normalization = sqrt(static_cast<double>(numComponents));
+      vtkSMPTools::For(0, this->ArraySize,
+        [array, dataPtr, numComponents, selectedComponent, normalization](
+          vtkIdType begin, vtkIdType end) {
+          for (vtkIdType i = begin; i < end; ++i)
           {
-            tmp = static_cast<double>(dataPtr[k + i * numComponents]);
-            value += tmp * tmp;
+            array[i].OriginalIndex = i;
+            if (selectedComponent < 0)
+            {
+              // Compute magnitude
+              double value = 0;
+              for (int k = 0; k < numComponents; k++)
+              {
+                double tmp = static_cast<double>(dataPtr[k + i * numComponents]);
+                value += tmp * tmp;
+              }
+              array[i].Value = static_cast<T>(sqrt(value) / normalization);
+            }
+            else
+            {
+              array[i].Value = dataPtr[selectedComponent + i * numComponents];
+            }
           }
-          value = sqrt(value) / sqrt(static_cast<double>(numComponents));
-          this->Array[i].Value = static_cast<T>(value);
-        }
-        else
-        {
-          this->Array[i].Value = dataPtr[selectedComponent + i * numComponents];
-          value = static_cast<double>(this->Array[i].Value);
-        }
-        this->Histo->AddValue(value);
+        });
+
+      this->UpdateHistogramAndSort(reverseOrder);
+    }
+
+    // Builds the histogram from the filled array and sorts it.
+    void UpdateHistogramAndSort(bool reverseOrder)
+    {
+      for (vtkIdType i = 0; i < this->ArraySize; ++i)
+      {
+        this->Histo->AddValue(static_cast<double>(this->Array[i].Value));
       }
 
       // Sort it
       if (reverseOrder)
       {
-        std::sort(this->Array, this->Array + this->ArraySize, SortableArrayItem::Ascendent);
+        vtkSMPTools::Sort(this->Array, this->Array + this->ArraySize, SortableArrayItem::Ascendent);
       }
       else
       {
-        std::sort(this->Array, this->Array + this->ArraySize, SortableArrayItem::Descendent);
+        vtkSMPTools::Sort(
+          this->Array, this->Array + this->ArraySize, SortableArrayItem::Descendent);
       }
     }
 
@@ -543,23 +563,16 @@ public:
       this->Array = new SortableArrayItem[this->ArraySize];
 
       // Fill the sortable array
-      for (vtkIdType i = 0; i < this->ArraySize; ++i)
-      {
-        this->Array[i].OriginalIndex = i;
-        this->Array[i].Value = static_cast<T>(dataPtr[i]);
-        double value = static_cast<double>(this->Array[i].Value);
-        this->Histo->AddValue(value);
-      }
+      SortableArrayItem* array = this->Array;
+      vtkSMPTools::For(0, this->ArraySize, [array, dataPtr](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; ++i)
+        {
+          array[i].OriginalIndex = i;
+          array[i].Value = static_cast<T>(dataPtr[i]);
+        }
+      });
 
-      // Sort it
-      if (reverseOrder)
-      {
-        std::sort(this->Array, this->Array + this->ArraySize, SortableArrayItem::Ascendent);
-      }
-      else
-      {
-        std::sort(this->Array, this->Array + this->ArraySize, SortableArrayItem::Descendent);
-      }
+      this->UpdateHistogramAndSort(reverseOrder);
     }
   };
 
@@ -672,6 +685,7 @@ public:
   {
     // We are building the cache so no need to build it next time
     this->NeedToBuildCache = false;
+    this->SearchCache.clear();
 
     // Communication buffer
     vtkIdType* bufferHistogramValues = new vtkIdType[this->NumProcs * HISTOGRAM_SIZE];
@@ -727,7 +741,7 @@ public:
 
   // --------------------------------------------------------------------------
   // The sorting is based on processId and the current order
-  int Extract(vtkTable* input, vtkTable* output, vtkIdType block, vtkIdType blockSize,
+  int Extract(vtkTable* input, vtkTable* output, vtkIdType offset, vtkIdType blockSize,
     bool revertOrder) override
   {
     // ------------------------------------------------------------------------
@@ -750,7 +764,7 @@ public:
     this->MPI->AllGather(&nbElems, tableSizes, 1);
 
     // Get local idx based on the global one
-    vtkIdType localOffset = block * blockSize;
+    vtkIdType localOffset = offset;
     if (revertOrder)
     {
       for (int i = this->NumProcs - 1; this->Me < i; i--)
@@ -860,7 +874,7 @@ public:
     return 1;
   }
   // --------------------------------------------------------------------------
-  int Compute(vtkTable* input, vtkTable* output, vtkIdType block, vtkIdType blockSize,
+  int Compute(vtkTable* input, vtkTable* output, vtkIdType offset, vtkIdType blockSize,
     bool revertOrder) override
   {
     // ------------------------------------------------------------------------
@@ -879,7 +893,7 @@ public:
     vtkIdType nbElementsToRemoveFromHead = 0;
     vtkIdType localOffset = 0;
     vtkIdType nbElementsInBar = 0;
-    this->SearchGlobalIndexLocation((block * blockSize), this->LocalSorter->Histo,
+    this->SearchGlobalIndexLocation(offset, this->LocalSorter->Histo,
       this->GlobalHistogram, nbElementsToRemoveFromHead, localOffset, nbElementsInBar);
 
     // ------------------------------------------------------------------------
@@ -887,9 +901,9 @@ public:
     // ------------------------------------------------------------------------
     vtkIdType upperOffset = 0;
     vtkIdType globalUpperOffset = 0;
-    vtkIdType searchIdx = (this->GlobalHistogram->TotalValues < (block + 1) * blockSize)
+    vtkIdType searchIdx = (this->GlobalHistogram->TotalValues < offset + blockSize)
       ? this->GlobalHistogram->TotalValues
-      : ((block + 1) * blockSize);
+      : (offset + blockSize);
     searchIdx--; // It is not a size it is an index (so -1)
 
     this->SearchGlobalIndexLocation(searchIdx, this->LocalSorter->Histo, this->GlobalHistogram,
@@ -997,10 +1011,29 @@ public:
   // in the histogram bar where the searchedGlobalIndex has been found.
   // nbInLocalBar is used when you want to get an upper bound that
   // will include the searchedGlobalIndex.
+  //
+  // Results are cached until the local sort is rebuilt, so that fetching a
+  // block again (or the block next to the previous one, whose lower bound is
+  // the previous upper bound) does not redo the collective search. A cached
+  // result is only used when every process has it, so that they all take
+  // part in the search otherwise.
   void SearchGlobalIndexLocation(vtkIdType searchedGlobalIndex, Histogram* localHistogram,
     Histogram* globalHistogram, vtkIdType& nbGlobalToSkip, vtkIdType& localOffset,
     vtkIdType& nbInLocalBar)
   {
+    typename std::map<vtkIdType, SearchResult>::const_iterator cached =
+      this->SearchCache.find(searchedGlobalIndex);
+    int localHit = cached != this->SearchCache.end() ? 1 : 0;
+    int globalHit = localHit;
+    this->MPI->AllReduce(&localHit, &globalHit, 1, vtkCommunicator::MIN_OP);
+    if (globalHit)
+    {
+      nbGlobalToSkip = cached->second.NumberOfGlobalToSkip;
+      localOffset = cached->second.LocalOffset;
+      nbInLocalBar = cached->second.NumberInLocalBar;
+      return;
+    }
+
     // Communication buffer
     vtkIdType* bufferHistogramValues = new vtkIdType[this->NumProcs * HISTOGRAM_SIZE];
 
@@ -1053,6 +1086,11 @@ public:
     } while (nbGlobalToSkip > 0 && _globalHistogram.CanBeReduced());
 
     delete[] bufferHistogramValues;
+
+    SearchResult& result = this->SearchCache[searchedGlobalIndex];
+    result.NumberOfGlobalToSkip = nbGlobalToSkip;
+    result.LocalOffset = localOffset;
+    result.NumberInLocalBar = nbInLocalBar;
   }
 
   // --------------------------------------------------------------------------
@@ -1118,7 +1156,11 @@ public:
   }
 
   // --------------------------------------------------------------------------
-  void InvalidateCache() override { this->NeedToBuildCache = true; }
+  void InvalidateCache() override
+  {
+    this->NeedToBuildCache = true;
+    this->SearchCache.clear();
+  }
 
   // --------------------------------------------------------------------------
   bool IsInvalid(vtkTable* input, vtkDataArray* dataToProcess) override
@@ -1317,6 +1359,14 @@ public:
   }
   // --------------------------------------------------------------------------
 private:
+  struct SearchResult
+  {
+    vtkIdType NumberOfGlobalToSkip;
+    vtkIdType LocalOffset;
+    vtkIdType NumberInLocalBar;
+  };
+  std::map<vtkIdType, SearchResult> SearchCache; // Cached SearchGlobalIndexLocation results
+
   vtkMTimeType InputMTime;    // Keep the original input MTime
   vtkMTimeType DataMTime;     // Keep the original data MTime
   vtkDataArray* DataToSort;   // DataArray to sort
@@ -1342,6 +1392,7 @@ private:
 //****************************************************************************
 vtkStandardNewMacro(vtkSortedTableStreamer);
 vtkCxxSetObjectMacro(vtkSortedTableStreamer, Controller, vtkMultiProcessController);
+vtkCxxSetObjectMacro(vtkSortedTableStreamer, MergedInput, vtkTable);
 //----------------------------------------------------------------------------
 vtkSortedTableStreamer::vtkSortedTableStreamer()
 {
@@ -1352,8 +1403,11 @@ vtkSortedTableStreamer::vtkSortedTableStreamer()
   this->SetColumnToSort("");
   this->Block = 0;
   this->BlockSize = 1024;
+  this->NumberOfBlocks = 1;
   this->Internal = 0;
   this->SelectedComponent = 0;
+  this->MergedInput = nullptr;
+  this->MergedInputMTime = 0;
   this->SetController(vtkMultiProcessController::GetGlobalController());
 }
 
@@ -1362,6 +1416,7 @@ vtkSortedTableStreamer::~vtkSortedTableStreamer()
 {
   this->SetColumnToSort(0);
   this->SetController(0);
+  this->SetMergedInput(nullptr);
   if (this->Internal)
   {
     delete this->Internal;
@@ -1391,6 +1446,26 @@ int vtkSortedTableStreamer::RequestData(vtkInformation* vtkNotUsed(request),
 
   bool orderInverted = this->InvertOrder > 0;
 
+  // Reuse the table merged from a composite dataset on previous executions,
+  // as long as the input did not change. Otherwise, the new table would
+  // invalidate the internal sorting cache for every requested block. The
+  // MTime of a composite dataset does not account for changes to its blocks,
+  // hence these are checked too.
+  vtkMTimeType inputMTime = inputDO ? inputDO->GetMTime() : 0;
+  if (vtkCompositeDataSet* cds = input ? nullptr : vtkCompositeDataSet::SafeDownCast(inputDO))
+  {
+    vtkSmartPointer<vtkCompositeDataIterator> iter;
+    iter.TakeReference(cds->NewIterator());
+    for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
+    {
+      inputMTime = std::max(inputMTime, iter->GetCurrentDataObject()->GetMTime());
+    }
+  }
+  if (!input && this->MergedInput && inputDO && inputMTime == this->MergedInputMTime)
+  {
+    input = this->MergedInput;
+  }
+
   // Convert a composite dataset into a vtkTable input.
   if (!input)
   {
@@ -1470,6 +1545,13 @@ int vtkSortedTableStreamer::RequestData(vtkInformation* vtkNotUsed(request),
       }
     }
     iter->Delete();
+
+    this->SetMergedInput(input);
+    this->MergedInputMTime = inputMTime;
+  }
+  else if (input != this->MergedInput)
+  {
+    this->SetMergedInput(nullptr);
   }
 
   // Get input data
@@ -1498,15 +1580,19 @@ int vtkSortedTableStreamer::RequestData(vtkInformation* vtkNotUsed(request),
     (!arrayToProcess) ? 0 : this->GetSelectedComponent() % arrayToProcess->GetNumberOfComponents();
   this->Internal->SetSelectedComponent(realComponent);
 
+  // Produce NumberOfBlocks consecutive blocks starting at Block.
+  const vtkIdType offset = this->Block * this->BlockSize;
+  const vtkIdType size = this->BlockSize * this->NumberOfBlocks;
+
   // Manage custom case where sorting occur on a virtual array (process id)
   if (!this->Internal->IsSortable() ||
     (this->GetColumnToSort() && (strcmp("vtkOriginalProcessIds", this->GetColumnToSort()) == 0)))
   {
-    this->Internal->Extract(input, output, this->Block, this->BlockSize, orderInverted);
+    this->Internal->Extract(input, output, offset, size, orderInverted);
   }
   else
   {
-    this->Internal->Compute(input, output, this->Block, this->BlockSize, orderInverted);
+    this->Internal->Compute(input, output, offset, size, orderInverted);
   }
 
   return 1;
@@ -1516,6 +1602,7 @@ int vtkSortedTableStreamer::RequestData(vtkInformation* vtkNotUsed(request),
 void vtkSortedTableStreamer::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfBlocks: " << this->NumberOfBlocks << endl;
   os << indent << "Sorting column: " << (this->ColumnToSort ? this->ColumnToSort : "(none)")
      << endl;
 }
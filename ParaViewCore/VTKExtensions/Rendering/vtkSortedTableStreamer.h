@@ -20,6 +20,12 @@
  * This filter is used quickly get a sorted subset of a given vtkTable.
  * By sorted we mean a subset build from a global sort even if some optimisation
  * allow us to skip a global table sorting.
+ *
+ * Each process sorts a permutation of its local rows (using vtkSMPTools) once,
+ * and the processes then collectively locate the global bounds of the
+ * requested block using histograms. Both the local sort and the located
+ * bounds are cached and reused for subsequent blocks until the input, the
+ * column to sort, the component or the order changes.
 */
 
 #ifndef vtkSortedTableStreamer_h
@@ -73,6 +79,16 @@ public:
   vtkSetMacro(BlockSize, vtkIdType);
   //@}
 
+  //@{
+  /**
+   * Set the number of consecutive blocks, starting at Block, to produce in
+   * the output. This makes it possible to read ahead several blocks in a
+   * single execution. Default value is 1.
+   */
+  vtkGetMacro(NumberOfBlocks, vtkIdType);
+  vtkSetClampMacro(NumberOfBlocks, vtkIdType, 1, VTK_ID_MAX);
+  //@}
+
   //@{
   /**
    * Choose on which column the sort operation should occur
@@ -120,12 +136,19 @@ protected:
 
   vtkIdType Block;
   vtkIdType BlockSize;
+  vtkIdType NumberOfBlocks;
   vtkMultiProcessController* Controller;
 
   char* ColumnToSort;
   int SelectedComponent;
   int InvertOrder;
 
+  // Table built from a composite input, kept to avoid rebuilding it (and
+  // resorting it) for every block as long as the input is not modified.
+  void SetMergedInput(vtkTable*);
+  vtkTable* MergedInput;
+  vtkMTimeType MergedInputMTime;
+
 private:
   vtkSortedTableStreamer(const vtkSortedTableStreamer&) = delete;
   void operator=(const vtkSortedTableStreamer&) = delete;
@@ -164,6 +164,47 @@ int sortMagnitudeOnUnsignedCharVector()
   return EXIT_SUCCESS;
 }
 
+// ----------------------------------------------------------------------------
+int sortMultipleBlocks(bool debug)
+{
+  const int size = 10;
+  double dataArray[size] = { 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+  double sortedArray[size] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  vtkSmartPointer<vtkDoubleArray> dataToSort = vtkSmartPointer<vtkDoubleArray>::New();
+  fillArray(dataToSort.GetPointer(), dataArray, size, "data");
+
+  vtkSmartPointer<vtkTable> input = vtkSmartPointer<vtkTable>::New();
+  input->AddColumn(dataToSort);
+  vtkSmartPointer<vtkSortedTableStreamer> sortingfilter =
+    vtkSmartPointer<vtkSortedTableStreamer>::New();
+
+  sortingfilter->SetInputData(input.GetPointer());
+  sortingfilter->SetSelectedComponent(0);
+  sortingfilter->SetColumnNameToSort("data");
+
+  // blocks 1 and 2 (rows 3 to 8) in a single execution.
+  sortingfilter->SetBlock(1);
+  sortingfilter->SetBlockSize(3);
+  sortingfilter->SetNumberOfBlocks(2);
+  sortingfilter->Update();
+
+  if (!compareArray(sortingfilter->GetOutput(), "data", sortedArray + 3, 6, debug))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // the last blocks are truncated to the available rows.
+  sortingfilter->SetBlock(2);
+  sortingfilter->Update();
+  if (!compareArray(sortingfilter->GetOutput(), "data", sortedArray + 6, 4, debug))
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
 // ----------------------------------------------------------------------------
 int TestSortingTable(int vtkNotUsed(argc), char** vtkNotUsed(argv))
 {
@@ -183,6 +224,9 @@ int TestSortingTable(int vtkNotUsed(argc), char** vtkNotUsed(argv))
   cout << "Testing sorting with magnitude on unsigned char: "
        << ((result += sortMagnitudeOnUnsignedCharVector()) ? "FAILED" : "SUCCESS") << endl;
   // --------------------------------------------------------------------------
+  cout << "Testing sorting with multiple blocks: "
+       << ((result += sortMultipleBlocks(debug)) ? "FAILED" : "SUCCESS") << endl;
+  // --------------------------------------------------------------------------
   // --------------------------------------------------------------------------
 
   // Delete Fake MPI controller
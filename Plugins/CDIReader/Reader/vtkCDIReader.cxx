@@ -60,6 +60,7 @@
 #include "vtk_netcdf.h"
 
 #include <sstream>
+#include <thread>
 
 using namespace std;
 
@@ -92,6 +93,24 @@ struct PointWithIndex
   int i;
 };
 
+// What a variable array currently holds, so that it is only read again when
+// the time step, the vertical level or the layout of the output changes.
+struct LoadedVar
+{
+  int Timestep = -1;
+  int Level = -1;
+  bool Multilayer = false;
+  int Piece = -1;
+  int NumPieces = -1;
+
+  bool operator==(const LoadedVar& other) const
+  {
+    return this->Timestep == other.Timestep && this->Level == other.Level &&
+      this->Multilayer == other.Multilayer && this->Piece == other.Piece &&
+      this->NumPieces == other.NumPieces;
+  }
+};
+
 //----------------------------------------------------------------------------
 // Internal class to avoid name pollution
 //----------------------------------------------------------------------------
@@ -121,6 +140,14 @@ public:
   vtkSmartPointer<vtkIdTypeArray> PointsToSendToProcesses;
   vtkSmartPointer<vtkIdTypeArray> PointsToSendToProcessesLengths;
   vtkSmartPointer<vtkIdTypeArray> PointsToSendToProcessesOffsets;
+
+  // The grid (points, cells, coordinate and mask arrays) of the last update
+  // and the settings it was built with.
+  vtkSmartPointer<vtkUnstructuredGrid> Grid;
+  string GridKey;
+
+  LoadedVar LoadedCellVars[MAX_VARS];
+  LoadedVar LoadedPointVars[MAX_VARS];
 };
 
 namespace
@@ -790,16 +817,18 @@ int vtkCDIReader::RequestData(vtkInformation* vtkNotUsed(reqInfo),
   this->NumberLocalCells = this->GetPartitioning(this->Piece, this->NumPieces, this->NumberOfCells,
     this->PointsPerCell, this->BeginPoint, this->EndPoint, this->BeginCell, this->EndCell);
 
-  if (this->DataRequested)
-  {
-    this->DestroyData();
-  }
-
-  if (!this->ReadAndOutputGrid(true))
+  // The arrays of the variables are kept across updates and only re-read
+  // when stale, see LoadCellVarData and LoadPointVarData.
+  if (!this->ReadGrid())
   {
     return 0;
   }
 
+  // Building the vtk points and cells does not involve CDI, so it runs while
+  // the cell variables are read. CDI itself is not thread-safe, so all reads
+  // stay on this thread, and the output is only touched again after the join.
+  std::thread gridBuilder([this]() { this->OutputGrid(); });
+
   double requestedTimeStep = 0.;
 #ifndef NDEBUG
   int numRequestedTimeSteps = 0;
@@ -818,10 +847,6 @@ int vtkCDIReader::RequestData(vtkInformation* vtkNotUsed(reqInfo),
   vtkDebugMacro("Num Time steps requested: " << numRequestedTimeSteps << endl);
   this->DTime = requestedTimeStep;
   vtkDebugMacro("this->DTime: " << this->DTime << endl);
-  double dTimeTemp = this->DTime;
-  output->GetInformation()->Set(vtkDataObject::DATA_TIME_STEP(), dTimeTemp);
-  vtkDebugMacro("dTimeTemp: " << dTimeTemp << endl);
-  this->DTime = dTimeTemp;
 
   for (int var = 0; var < this->NumberOfCellVars; var++)
   {
@@ -829,16 +854,29 @@ int vtkCDIReader::RequestData(vtkInformation* vtkNotUsed(reqInfo),
     {
       vtkDebugMacro("Loading Cell Variable: " << this->Internals->CellVars[var].Name << endl);
       this->LoadCellVarData(var, this->DTime);
-      output->GetCellData()->AddArray(this->CellVarDataArray[var]);
+    }
+    else if (this->CellVarDataArray[var] != nullptr)
+    {
+      this->CellVarDataArray[var]->Delete();
+      this->CellVarDataArray[var] = nullptr;
     }
   }
+
+  // Point variables are laid out with the cell connectivity, which
+  // OutputCells may release, so they are only read once the grid is built.
+  gridBuilder.join();
+
   for (int var = 0; var < this->NumberOfPointVars; var++)
   {
     if (this->GetPointArrayStatus(this->Internals->PointVars[var].Name))
     {
       vtkDebugMacro("Loading Point Variable: " << var << endl);
       this->LoadPointVarData(var, this->DTime);
-      output->GetPointData()->AddArray(this->PointVarDataArray[var]);
+    }
+    else if (this->PointVarDataArray[var] != nullptr)
+    {
+      this->PointVarDataArray[var]->Delete();
+      this->PointVarDataArray[var] = nullptr;
     }
   }
 
@@ -849,6 +887,32 @@ int vtkCDIReader::RequestData(vtkInformation* vtkNotUsed(reqInfo),
       vtkDebugMacro(
         "Loading Domain Variable: " << this->Internals->DomainVars[var].c_str() << endl);
       this->LoadDomainVarData(var);
+    }
+  }
+
+  double dTimeTemp = this->DTime;
+  output->GetInformation()->Set(vtkDataObject::DATA_TIME_STEP(), dTimeTemp);
+  vtkDebugMacro("dTimeTemp: " << dTimeTemp << endl);
+  this->DTime = dTimeTemp;
+
+  for (int var = 0; var < this->NumberOfCellVars; var++)
+  {
+    if (this->CellVarDataArray[var] != nullptr)
+    {
+      output->GetCellData()->AddArray(this->CellVarDataArray[var]);
+    }
+  }
+  for (int var = 0; var < this->NumberOfPointVars; var++)
+  {
+    if (this->PointVarDataArray[var] != nullptr)
+    {
+      output->GetPointData()->AddArray(this->PointVarDataArray[var]);
+    }
+  }
+  for (int var = 0; var < this->NumberOfDomainVars; var++)
+  {
+    if (this->GetDomainArrayStatus(this->Internals->DomainVars[var].c_str()))
+    {
       output->GetFieldData()->AddArray(this->DomainVarDataArray[var]);
     }
   }
@@ -1023,6 +1087,7 @@ void vtkCDIReader::SetDefaults()
   this->FilenameSet = false;
 
   this->GridReconstructed = false;
+  this->GridCached = false;
   this->MaskingValue = 0.0;
   this->InvertedTopography = false;
   this->IncludeTopography = false;
@@ -1539,52 +1604,133 @@ int vtkCDIReader::BuildVarArrays()
 //  Read the data from the ncfile, allocate the geometry and create the
 //  vtk data structures for points and cells.
 //----------------------------------------------------------------------------
-int vtkCDIReader::ReadAndOutputGrid(bool init)
+int vtkCDIReader::ReadAndOutputGrid(bool vtkNotUsed(init))
 {
   vtkDebugMacro("In vtkCDIReader::ReadAndOutputGrid" << endl);
 
-  if (this->ProjectionMode == 0)
+  if (!this->ReadGrid())
+  {
+    return 0;
+  }
+  this->OutputGrid();
+
+  vtkDebugMacro("Leaving vtkCDIReader::ReadAndOutputGrid" << endl);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+//  Describe the settings the output grid depends on. The vertical level
+//  only matters for the single layer view, where it sets the radius of the
+//  sphere and which level of the land/sea mask is used.
+//----------------------------------------------------------------------------
+std::string vtkCDIReader::GetGridCacheKey()
+{
+  stringstream key;
+  key << this->FileNameGrid << ":" << this->NumberOfCells << ":" << this->Piece << "/"
+      << this->NumPieces << ":" << this->ProjectionMode << ":" << this->ShowMultilayerView << ":"
+      << this->LayerThickness << ":" << this->InvertZAxis << ":" << this->IncludeTopography << ":"
+      << this->MaskingValue;
+  if (!this->ShowMultilayerView && (this->ProjectionMode == 0 || this->GotMask))
+  {
+    key << ":" << this->VerticalLevelSelected;
+  }
+  return key.str();
+}
+
+//----------------------------------------------------------------------------
+//  Read what is needed from the ncfile to build the grid. When the grid of
+//  the previous update still applies, only the sizes are computed.
+//----------------------------------------------------------------------------
+int vtkCDIReader::ReadGrid()
+{
+  vtkDebugMacro("In vtkCDIReader::ReadGrid" << endl);
+
+  std::string key = this->GetGridCacheKey();
+  this->GridCached = !this->ReconstructNew && this->GridReconstructed &&
+    this->Internals->Grid != nullptr && key == this->Internals->GridKey;
+
+  if (this->GridCached)
   {
-    if (!this->AllocSphereGeometry())
+    vtkDebugMacro("Reusing the grid of the previous update" << endl);
+    if (this->ShowMultilayerView)
     {
-      return 0;
+      this->MaximumCells = this->NumberLocalCells * this->MaximumNVertLevels;
+      this->MaximumPoints = this->NumberLocalPoints * (this->MaximumNVertLevels + 1);
+    }
+    else
+    {
+      this->MaximumCells = this->NumberLocalCells;
+      this->MaximumPoints = this->NumberLocalPoints;
     }
   }
   else
   {
-    if (!this->AllocLatLonGeometry())
-    {
-      return 0;
-    }
-
-    if (this->ProjectionMode == 2)
+    if (this->ProjectionMode == 0)
     {
-      if (!this->EliminateYWrap())
+      if (!this->AllocSphereGeometry())
       {
         return 0;
       }
     }
     else
     {
-      if (!this->EliminateXWrap())
+      if (!this->AllocLatLonGeometry())
       {
         return 0;
       }
+
+      if (this->ProjectionMode == 2)
+      {
+        if (!this->EliminateYWrap())
+        {
+          return 0;
+        }
+      }
+      else
+      {
+        if (!this->EliminateXWrap())
+        {
+          return 0;
+        }
+      }
     }
-  }
 
-  this->OutputPoints(init);
-  this->OutputCells(init);
+    // the mask is only known once read, recompute the key for it
+    this->Internals->GridKey = this->GetGridCacheKey();
+  }
 
   // Allocate the data arrays which will hold the NetCDF var data
   vtkDebugMacro("pointVarData: Alloc " << this->MaximumPoints << " doubles" << endl);
   delete[] this->PointVarData;
   this->PointVarData = new double[this->MaximumPoints];
-  vtkDebugMacro("Leaving vtkCDIReader::ReadAndOutputGrid" << endl);
+  vtkDebugMacro("Leaving vtkCDIReader::ReadGrid" << endl);
 
   return 1;
 }
 
+//----------------------------------------------------------------------------
+//  Create the vtk points and cells of the output, or reuse those of the
+//  previous update. Does not call into CDI.
+//----------------------------------------------------------------------------
+void vtkCDIReader::OutputGrid()
+{
+  vtkUnstructuredGrid* output = this->Output;
+
+  if (!this->GridCached)
+  {
+    output->Initialize();
+    this->OutputPoints(true);
+    this->OutputCells(true);
+
+    this->Internals->Grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+    this->Internals->Grid->ShallowCopy(output);
+  }
+  else
+  {
+    output->ShallowCopy(this->Internals->Grid);
+  }
+}
+
 //----------------------------------------------------------------------------
 // Mirrors the triangle mesh in z direction
 //----------------------------------------------------------------------------
@@ -1877,6 +2023,7 @@ int vtkCDIReader::AllocLatLonGeometry()
     this->ConstructGridGeometry();
   }
 
+  delete[] this->ModConnections;
   this->ModConnections = new int[this->NumberLocalCells * this->PointsPerCell];
   CHECK_NEW(this->ModConnections);
 
@@ -2455,6 +2602,16 @@ void vtkCDIReader::OutputCells(bool init)
   vtkDebugMacro("Leaving OutputCells..." << endl);
 }
 
+//----------------------------------------------------------------------------
+//  Time step within the current file of the requested time.
+//----------------------------------------------------------------------------
+int vtkCDIReader::GetLocalTimeStep(double dTime)
+{
+  int global_timestep = dTime / this->TStepDistance;
+  int local_timestep = global_timestep - (this->NumberOfTimeSteps * this->FileSeriesNumber);
+  return min(local_timestep, this->NumberOfTimeSteps - 1);
+}
+
 //----------------------------------------------------------------------------
 //  Load the data for a Point variable specified.
 //----------------------------------------------------------------------------
@@ -2462,7 +2619,33 @@ int vtkCDIReader::LoadPointVarData(int variableIndex, double dTimeStep)
 {
   this->PointDataSelected = variableIndex;
 
+  // 2D variables do not depend on the selected level, and in the multilayer
+  // view all levels are read at once.
+  LoadedVar loaded;
+  loaded.Timestep = this->GetLocalTimeStep(dTimeStep);
+  loaded.Level = (this->Internals->PointVars[variableIndex].Type == 3 && !this->ShowMultilayerView)
+    ? this->VerticalLevelSelected
+    : 0;
+  loaded.Multilayer = this->ShowMultilayerView;
+  loaded.Piece = this->Piece;
+  loaded.NumPieces = this->NumPieces;
+
   vtkDataArray* dataArray = this->PointVarDataArray[variableIndex];
+  if (dataArray != nullptr && this->Internals->LoadedPointVars[variableIndex] == loaded)
+  {
+    vtkDebugMacro(
+      "Point var already loaded: " << this->Internals->PointVars[variableIndex].Name << endl);
+    return 1;
+  }
+
+  // A stale array may still be referenced by a previous output, so it is
+  // released rather than overwritten.
+  if (dataArray != nullptr)
+  {
+    dataArray->Delete();
+    dataArray = nullptr;
+    this->PointVarDataArray[variableIndex] = nullptr;
+  }
 
   // Allocate data array for this variable
   if (dataArray == nullptr)
@@ -2490,6 +2673,7 @@ int vtkCDIReader::LoadPointVarData(int variableIndex, double dTimeStep)
     vtkICONTemplateDispatch(VTK_FLOAT, success = this->LoadPointVarDataTemplate<VTK_TT>(
                                          variableIndex, dTimeStep, dataArray););
   }
+  this->Internals->LoadedPointVars[variableIndex] = success ? loaded : LoadedVar();
 
   return success;
 }
@@ -2501,7 +2685,34 @@ int vtkCDIReader::LoadCellVarData(int variableIndex, double dTimeStep)
 {
   this->CellDataSelected = variableIndex;
 
+  // 2D variables do not depend on the selected level, and in the multilayer
+  // view all levels are read at once.
+  LoadedVar loaded;
+  loaded.Timestep = this->GetLocalTimeStep(dTimeStep);
+  loaded.Level = (this->Internals->CellVars[variableIndex].Type == 3 && !this->ShowMultilayerView)
+    ? this->VerticalLevelSelected
+    : 0;
+  loaded.Multilayer = this->ShowMultilayerView;
+  loaded.Piece = this->Piece;
+  loaded.NumPieces = this->NumPieces;
+
   vtkDataArray* dataArray = this->CellVarDataArray[variableIndex];
+  if (dataArray != nullptr && this->Internals->LoadedCellVars[variableIndex] == loaded)
+  {
+    vtkDebugMacro(
+      "Cell var already loaded: " << this->Internals->CellVars[variableIndex].Name << endl);
+    return 1;
+  }
+
+  // A stale array may still be referenced by a previous output, so it is
+  // released rather than overwritten.
+  if (dataArray != nullptr)
+  {
+    dataArray->Delete();
+    dataArray = nullptr;
+    this->CellVarDataArray[variableIndex] = nullptr;
+  }
+
   // Allocate data array for this variable
   if (dataArray == nullptr)
   {
@@ -2528,6 +2739,7 @@ int vtkCDIReader::LoadCellVarData(int variableIndex, double dTimeStep)
     vtkICONTemplateDispatch(VTK_FLOAT, success = this->LoadCellVarDataTemplate<VTK_TT>(
                                          variableIndex, dTimeStep, dataArray););
   }
+  this->Internals->LoadedCellVars[variableIndex] = success ? loaded : LoadedVar();
 
   return success;
 }
@@ -2544,9 +2756,7 @@ int vtkCDIReader::LoadCellVarDataTemplate(
   CDIVar* cdiVar = &(this->Internals->CellVars[variableIndex]);
   int varType = cdiVar->Type;
 
-  int global_timestep = dTimeStep / this->TStepDistance;
-  int local_timestep = global_timestep - (this->NumberOfTimeSteps * this->FileSeriesNumber);
-  int Timestep = min(local_timestep, this->NumberOfTimeSteps - 1);
+  int Timestep = this->GetLocalTimeStep(dTimeStep);
   vtkDebugMacro("Time: " << Timestep << endl);
   vtkDebugMacro("Dimensions: " << varType << endl);
 
@@ -2636,9 +2846,7 @@ int vtkCDIReader::LoadPointVarDataTemplate(
     dataTmp = new ValueType[this->NumberLocalPoints];
   }
 
-  int global_timestep = dTimeStep / this->TStepDistance;
-  int local_timestep = global_timestep - (this->NumberOfTimeSteps * this->FileSeriesNumber);
-  int Timestep = min(local_timestep, this->NumberOfTimeSteps - 1);
+  int Timestep = this->GetLocalTimeStep(dTimeStep);
   vtkDebugMacro("Time: " << Timestep << endl);
   vtkDebugMacro("dTimeStep requested: " << dTimeStep << endl);
 
@@ -3052,39 +3260,14 @@ void vtkCDIReader::SetFileName(const char* val)
 //----------------------------------------------------------------------------
 void vtkCDIReader::SetVerticalLevel(int level)
 {
+  // The variables of the new level are read lazily by the next RequestData,
+  // where 2D variables and the cached grid are reused when possible.
   if (this->VerticalLevelSelected != level)
   {
     this->VerticalLevelSelected = level;
     this->Modified();
     vtkDebugMacro("Set VerticalLevelSelected to: " << level);
   }
-  vtkDebugMacro("InfoRequested?: " << this->InfoRequested);
-
-  if (!this->InfoRequested || !this->DataRequested)
-  {
-    return;
-  }
-
-  for (int var = 0; var < this->NumberOfPointVars; var++)
-  {
-    if (this->PointDataArraySelection->GetArraySetting(var))
-    {
-      vtkDebugMacro("Loading Point Variable: " << this->Internals->PointVars[var].Name << endl);
-      this->LoadPointVarData(var, this->DTime);
-    }
-  }
-
-  for (int var = 0; var < this->NumberOfCellVars; var++)
-  {
-    if (this->CellDataArraySelection->GetArraySetting(var))
-    {
-      vtkDebugMacro("Loading Cell Variable: " << this->Internals->CellVars[var].Name << endl);
-      this->LoadCellVarData(var, this->DTime);
-    }
-  }
-
-  this->PointDataArraySelection->Modified();
-  this->CellDataArraySelection->Modified();
 }
 
 //----------------------------------------------------------------------------
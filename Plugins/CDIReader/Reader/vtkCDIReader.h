@@ -33,6 +33,14 @@
 // .SECTION Thanks
 // Thanks to Uwe Schulzweida for the CDI code (uwe.schulzweida@mpimet.mpg.de)
 // Thanks to Moritz Hanke for the sorting code (hanke@dkrz.de)
+//
+// The unstructured grid built from the horizontal and vertical grids is
+// cached and reused across time steps as long as none of the settings that
+// shape it (projection, multilayer view, layer thickness, topography, piece)
+// change. Variables are read lazily: an array is only read again when its
+// time step, vertical level or layout differs from the one already loaded,
+// and while a new grid is being built, the selected variables are read
+// concurrently.
 
 #ifndef vtkCDIReader_h
 #define vtkCDIReader_h
@@ -155,6 +163,10 @@ protected:
   int CheckForMaskData();
   int GetVars();
   int ReadAndOutputGrid(bool init);
+  int ReadGrid();
+  void OutputGrid();
+  std::string GetGridCacheKey();
+  int GetLocalTimeStep(double dTime);
   int ReadAndOutputVariableData();
   int ReadTimeUnits(const char* Name);
   int BuildVarArrays();
@@ -292,6 +304,7 @@ protected:
   int NumberOfDomainVars;
   double* PointVarData;
   bool GridReconstructed;
+  bool GridCached;
 
   int StreamID;
   int VListID;
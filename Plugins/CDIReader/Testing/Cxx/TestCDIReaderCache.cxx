@@ -0,0 +1,173 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestCDIReaderCache.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Tests that the CDI reader reuses the grid and the variables of the previous
+// update while they still apply, and builds or reads them again otherwise. The
+// data is an octahedron of 8 triangular cells, written as an ICON grid.
+
+#include "vtkCDIReader.h"
+#include "vtkCellData.h"
+#include "vtkDataArray.h"
+#include "vtkNew.h"
+#include "vtkPoints.h"
+#include "vtkUnstructuredGrid.h"
+
+#include "vtk_netcdf.h"
+#include <vtksys/SystemTools.hxx>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#define TASSERT(x)                                                                                 \
+  if (!(x))                                                                                        \
+  {                                                                                                \
+    std::cerr << "ERROR: failed at " << __LINE__ << "!" << std::endl;                              \
+    return EXIT_FAILURE;                                                                           \
+  }
+
+#define NCCHECK(x)                                                                                 \
+  if ((x) != NC_NOERR)                                                                             \
+  {                                                                                                \
+    std::cerr << "ERROR: netCDF call failed at " << __LINE__ << "!" << std::endl;                  \
+    return false;                                                                                  \
+  }
+
+namespace
+{
+const int NumberOfCells = 8;
+
+bool PutText(int ncid, int varid, const char* name, const std::string& value)
+{
+  return nc_put_att_text(ncid, varid, name, value.size(), value.c_str()) == NC_NOERR;
+}
+
+// Writes the octahedron with the cell variable "temp", whose value is the
+// index of the cell.
+bool WriteGrid(const std::string& filename)
+{
+  const double pi = 4. * std::atan(1.);
+  int ncid;
+  NCCHECK(nc_create(filename.c_str(), NC_CLOBBER, &ncid));
+  int cellDim, vertexDim;
+  NCCHECK(nc_def_dim(ncid, "ncells", NumberOfCells, &cellDim));
+  NCCHECK(nc_def_dim(ncid, "vertices", 3, &vertexDim));
+  const int boundsDims[2] = { cellDim, vertexDim };
+
+  int clon, clat, clonBounds, clatBounds, temp;
+  NCCHECK(nc_def_var(ncid, "clon", NC_DOUBLE, 1, &cellDim, &clon));
+  NCCHECK(nc_def_var(ncid, "clat", NC_DOUBLE, 1, &cellDim, &clat));
+  NCCHECK(nc_def_var(ncid, "clon_bnds", NC_DOUBLE, 2, boundsDims, &clonBounds));
+  NCCHECK(nc_def_var(ncid, "clat_bnds", NC_DOUBLE, 2, boundsDims, &clatBounds));
+  NCCHECK(nc_def_var(ncid, "temp", NC_DOUBLE, 1, &cellDim, &temp));
+  if (!PutText(ncid, clon, "standard_name", "longitude") ||
+    !PutText(ncid, clon, "units", "radian") || !PutText(ncid, clon, "bounds", "clon_bnds") ||
+    !PutText(ncid, clat, "standard_name", "latitude") || !PutText(ncid, clat, "units", "radian") ||
+    !PutText(ncid, clat, "bounds", "clat_bnds") || !PutText(ncid, temp, "coordinates", "clat clon"))
+  {
+    return false;
+  }
+  NCCHECK(nc_enddef(ncid));
+
+  // the 4 cells of each hemisphere share a pole and are bounded by the
+  // meridians at multiples of pi / 2.
+  double centerLon[NumberOfCells], centerLat[NumberOfCells];
+  double boundsLon[NumberOfCells * 3], boundsLat[NumberOfCells * 3];
+  double values[NumberOfCells];
+  for (int cc = 0; cc < NumberOfCells; ++cc)
+  {
+    const int quadrant = cc % 4;
+    const double pole = cc < 4 ? pi / 2 : -pi / 2;
+    centerLon[cc] = (quadrant + 0.5) * pi / 2;
+    centerLat[cc] = pole / 3;
+    boundsLon[3 * cc] = 0.;
+    boundsLat[3 * cc] = pole;
+    boundsLon[3 * cc + 1] = quadrant * pi / 2;
+    boundsLat[3 * cc + 1] = 0.;
+    boundsLon[3 * cc + 2] = ((quadrant + 1) % 4) * pi / 2;
+    boundsLat[3 * cc + 2] = 0.;
+    values[cc] = cc;
+  }
+  NCCHECK(nc_put_var_double(ncid, clon, centerLon));
+  NCCHECK(nc_put_var_double(ncid, clat, centerLat));
+  NCCHECK(nc_put_var_double(ncid, clonBounds, boundsLon));
+  NCCHECK(nc_put_var_double(ncid, clatBounds, boundsLat));
+  NCCHECK(nc_put_var_double(ncid, temp, values));
+  NCCHECK(nc_close(ncid));
+  return true;
+}
+
+// Checks that the output holds the cells [begin, end) and their values.
+bool CheckOutput(vtkUnstructuredGrid* output, int begin, int end)
+{
+  vtkDataArray* values = output->GetCellData()->GetArray("temp");
+  if (!values || output->GetNumberOfCells() != end - begin ||
+    values->GetNumberOfTuples() != end - begin)
+  {
+    return false;
+  }
+  for (int cc = begin; cc < end; ++cc)
+  {
+    if (values->GetTuple1(cc - begin) != cc)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+  const std::string directory = argc > 1 ? argv[1] : ".";
+  const std::string filename = directory + "/TestCDIReaderCache.nc";
+  TASSERT(WriteGrid(filename));
+
+  vtkNew<vtkCDIReader> reader;
+  reader->SetFileName(filename.c_str());
+  reader->UpdateInformation();
+  reader->SetCellArrayStatus("temp", 1);
+  reader->Update();
+  vtkUnstructuredGrid* output = reader->GetOutput();
+  TASSERT(CheckOutput(output, 0, NumberOfCells));
+  vtkPoints* points = output->GetPoints();
+  vtkDataArray* values = output->GetCellData()->GetArray("temp");
+  TASSERT(points != nullptr && points->GetNumberOfPoints() > 0);
+
+  // nothing changed: both the grid and the variable are reused.
+  reader->Modified();
+  reader->Update();
+  output = reader->GetOutput();
+  TASSERT(CheckOutput(output, 0, NumberOfCells));
+  TASSERT(output->GetPoints() == points);
+  TASSERT(output->GetCellData()->GetArray("temp") == values);
+
+  // another piece: the grid is built and the variable read again.
+  reader->UpdatePiece(1, 2, 0);
+  output = reader->GetOutput();
+  TASSERT(CheckOutput(output, NumberOfCells / 2, NumberOfCells));
+  TASSERT(output->GetPoints() != points);
+  TASSERT(output->GetCellData()->GetArray("temp") != values);
+  values = output->GetCellData()->GetArray("temp");
+
+  // back to the whole grid.
+  reader->UpdatePiece(0, 1, 0);
+  output = reader->GetOutput();
+  TASSERT(CheckOutput(output, 0, NumberOfCells));
+  TASSERT(output->GetCellData()->GetArray("temp") != values);
+
+  vtksys::SystemTools::RemoveFile(filename);
+  return EXIT_SUCCESS;
+}
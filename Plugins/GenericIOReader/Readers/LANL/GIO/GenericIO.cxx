@@ -1160,7 +1160,9 @@ void GenericIO::openAndReadHeader(MismatchBehavior MB, int EffRank, bool CheckPa
   if (!DisableCollErrChecking)
     MPI_Barrier(Comm);
 
-  if (FileIOType == FileIOMPI)
+  if (FileIOFactory && RankMap.empty())
+    FH.get() = FileIOFactory();
+  else if (FileIOType == FileIOMPI)
     FH.get() = new GenericFileIO_MPI(SplitComm);
   else if (FileIOType == FileIOMPICollective)
     FH.get() = new GenericFileIO_MPICollective(SplitComm);
@@ -1188,6 +1190,14 @@ void GenericIO::openAndReadHeader(MismatchBehavior MB, int EffRank, bool CheckPa
     ss << TotOpenErr << " ranks failed to open file: " << LocalFileName;
     throw runtime_error(ss.str());
   }
+#else
+  // The header was read with POSIX I/O; reopen the file for the data.
+  if (FileIOFactory && RankMap.empty())
+  {
+    delete FH.get();
+    FH.get() = FileIOFactory();
+    FH.get()->open(LocalFileName, true);
+  }
 #endif
 }
 
@@ -1417,17 +1427,24 @@ size_t GenericIO::readNumElems(int EffRank)
   return (size_t)RH->NElems;
 }
 
-void GenericIO::readDataSection(size_t readOffset, size_t readNumRows, int EffRank,
+void GenericIO::readDataSections(const vector<pair<size_t, size_t> >& Sections, int EffRank,
   size_t RowOffset, int Rank, uint64_t& TotalReadSize, int NErrs[3])
 {
   if (FH.isBigEndian())
-    readDataSection<true>(readOffset, readNumRows, EffRank, RowOffset, Rank, TotalReadSize, NErrs);
+    readDataSections<true>(Sections, EffRank, RowOffset, Rank, TotalReadSize, NErrs);
   else
-    readDataSection<false>(readOffset, readNumRows, EffRank, RowOffset, Rank, TotalReadSize, NErrs);
+    readDataSections<false>(Sections, EffRank, RowOffset, Rank, TotalReadSize, NErrs);
 }
 
 void GenericIO::readDataSection(
   size_t readOffset, size_t readNumRows, int EffRank, bool PrintStats, bool CollStats)
+{
+  vector<pair<size_t, size_t> > Sections(1, make_pair(readOffset, readNumRows));
+  readDataSections(Sections, EffRank, PrintStats, CollStats);
+}
+
+void GenericIO::readDataSections(
+  const vector<pair<size_t, size_t> >& Sections, int EffRank, bool PrintStats, bool CollStats)
 {
   (void)CollStats; // may be unused depending on preprocessor config.
   int Rank;
@@ -1450,19 +1467,22 @@ void GenericIO::readDataSection(
   {
     DisableCollErrChecking = true;
 
+    size_t SectionsNumRows = 0;
+    for (size_t s = 0; s < Sections.size(); ++s)
+      SectionsNumRows += Sections[s].second;
+
     size_t RowOffset = 0;
     for (size_t i = 0, ie = SourceRanks.size(); i != ie; ++i)
     {
-      readDataSection(
-        readOffset, readNumRows, SourceRanks[i], RowOffset, Rank, TotalReadSize, NErrs);
-      RowOffset += readNumElems(SourceRanks[i]);
+      readDataSections(Sections, SourceRanks[i], RowOffset, Rank, TotalReadSize, NErrs);
+      RowOffset += SectionsNumRows;
     }
 
     DisableCollErrChecking = false;
   }
   else
   {
-    readDataSection(readOffset, readNumRows, EffRank, 0, Rank, TotalReadSize, NErrs);
+    readDataSections(Sections, EffRank, 0, Rank, TotalReadSize, NErrs);
   }
 
   int AllNErrs[3];
@@ -1521,7 +1541,7 @@ void GenericIO::readDataSection(
 // Note: Errors from this function should be recoverable. This means that if
 // one rank throws an exception, then all ranks should.
 template <bool IsBigEndian>
-void GenericIO::readDataSection(size_t readOffset, size_t readNumRows, int EffRank,
+void GenericIO::readDataSections(const vector<pair<size_t, size_t> >& Sections, int EffRank,
   size_t RowOffset, int Rank, uint64_t& TotalReadSize, int NErrs[3])
 {
   openAndReadHeader(Redistributing ? MismatchRedistribute : MismatchAllowed, EffRank, false);
@@ -1632,15 +1652,24 @@ void GenericIO::readDataSection(size_t readOffset, size_t readNumRows, int EffRa
         if (EnvStr)
           RetrySleep = atoi(EnvStr);
 
+        // The other ranks would not join a retried collective read
+        if (FH.get()->isCollective())
+          RetryCount = 1;
+
         for (; Retry < RetryCount; ++Retry)
         {
           try
           {
             //
-            // Read section
-            ReadSize = readNumRows * VH->Size;
-            Offset = Offset + readOffset * VH->Size;
-            FH.get()->read(Data, ReadSize, static_cast<off_t>(Offset), Vars[i].Name);
+            // Read the sections one after the other
+            ReadSize = 0;
+            for (size_t s = 0; s < Sections.size(); ++s)
+            {
+              uint64_t SectionSize = Sections[s].second * VH->Size;
+              FH.get()->read(((char*)Data) + ReadSize, SectionSize,
+                static_cast<off_t>(Offset + Sections[s].first * VH->Size), Vars[i].Name);
+              ReadSize += SectionSize;
+            }
 
             break;
           }
@@ -1685,7 +1714,7 @@ void GenericIO::readDataSection(size_t readOffset, size_t readNumRows, int EffRa
 
       // Byte swap the data if necessary.
       if (IsBigEndian != isBigEndian())
-        for (size_t k = 0; k < RH->NElems; ++k)
+        for (size_t k = 0; k < ReadSize / Vars[i].Size; ++k)
         {
           char* OffsetTmp = ((char*)VarData) + k * Vars[i].Size;
           bswap(OffsetTmp, Vars[i].Size);
@@ -1958,6 +1987,10 @@ void GenericIO::readData(
         if (EnvStr)
           RetrySleep = atoi(EnvStr);
 
+        // The other ranks would not join a retried collective read
+        if (FH.get()->isCollective())
+          RetryCount = 1;
+
         for (; Retry < RetryCount; ++Retry)
         {
           try
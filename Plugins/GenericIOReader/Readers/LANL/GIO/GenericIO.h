@@ -43,10 +43,12 @@
 #define GENERICIO_H
 
 #include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <stdint.h>
 #include <string>
+#include <utility>
 #include <vector>
 
 #ifndef LANL_GENERICIO_NO_MPI
@@ -76,6 +78,10 @@ public:
   virtual void read(void* buf, size_t count, off_t offset, const std::string& D) = 0;
   virtual void write(const void* buf, size_t count, off_t offset, const std::string& D) = 0;
 
+  // Collective reads must be issued by all the ranks of the communicator, so
+  // a failed read cannot be retried by a single rank.
+  virtual bool isCollective() const { return false; }
+
 protected:
   std::string FileName;
 };
@@ -113,6 +119,7 @@ public:
 public:
   void read(void* buf, size_t count, off_t offset, const std::string& D);
   void write(const void* buf, size_t count, off_t offset, const std::string& D);
+  bool isCollective() const { return true; }
 };
 #endif
 
@@ -350,6 +357,13 @@ public:
   void readDataSection(size_t readOffset, size_t readNumRows, int EffRank = -1,
     bool PrintStats = true, bool CollStats = true);
 
+  // Reads the sections of rows, given as (row offset, number of rows) pairs,
+  // one after the other into the variables, so that only these rows are read
+  // from the file. Empty sections are allowed and still issue a (zero-size)
+  // read, which keeps collective file handles in step across ranks.
+  void readDataSections(const std::vector<std::pair<size_t, size_t> >& Sections,
+    int EffRank = -1, bool PrintStats = true, bool CollStats = true);
+
   void getSourceRanks(std::vector<int>& SR);
 
   template <typename T>
@@ -365,6 +379,12 @@ public:
 
   static void setDefaultFileIOType(unsigned FIOT) { DefaultFileIOType = FIOT; }
 
+  // When set, the data of non-partitioned files is read through the file
+  // handles created by this function instead of the POSIX ones, e.g. to use
+  // collective MPI-IO. Partitioned files are always read with POSIX I/O as
+  // each rank may read a different file.
+  void setFileIOFactory(const std::function<GenericFileIO*()>& F) { FileIOFactory = F; }
+
   static void setDefaultPartition(int P) { DefaultPartition = P; }
 
   static void setNaturalDefaultPartition();
@@ -423,11 +443,11 @@ private:
   void readData(int EffRank, size_t RowOffset, int Rank, uint64_t& TotalReadSize, int NErrs[3]);
 
   template <bool IsBigEndian>
-  void readDataSection(size_t readOffset, size_t readNumRows, int EffRank, size_t RowOffset,
-    int Rank, uint64_t& TotalReadSize, int NErrs[3]);
+  void readDataSections(const std::vector<std::pair<size_t, size_t> >& Sections, int EffRank,
+    size_t RowOffset, int Rank, uint64_t& TotalReadSize, int NErrs[3]);
 
-  void readDataSection(size_t readOffset, size_t readNumRows, int EffRank, size_t RowOffset,
-    int Rank, uint64_t& TotalReadSize, int NErrs[3]);
+  void readDataSections(const std::vector<std::pair<size_t, size_t> >& Sections, int EffRank,
+    size_t RowOffset, int Rank, uint64_t& TotalReadSize, int NErrs[3]);
 
   template <bool IsBigEndian>
   void getVariableInfo(std::vector<VariableInfo>& VI);
@@ -444,6 +464,7 @@ protected:
   MPI_Comm Comm;
 #endif
   std::string FileName;
+  std::function<GenericFileIO*()> FileIOFactory;
 
   static unsigned DefaultFileIOType;
   static int DefaultPartition;
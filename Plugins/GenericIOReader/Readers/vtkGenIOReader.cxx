@@ -44,12 +44,15 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "vtkGenIOReader.h"
 
+#include "vtkCommunicator.h"
 #include "vtkDataArray.h"
 #include "vtkDataObject.h"
 #include "vtkDoubleArray.h"
 #include "vtkFloatArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMPI.h"
+#include "vtkMPICommunicator.h"
 #include "vtkMultiProcessController.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
@@ -67,8 +70,10 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "utils/timer.h"
 
 #include <algorithm>
+#include <climits>
 #include <numeric>
 #include <random>
+#include <stdexcept>
 #include <thread>
 
 /*
@@ -133,6 +138,81 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "LANL/utils/timer.h"
 */
 
+namespace
+{
+//
+// Reads a GenericIO file with collective MPI-IO on all the ranks of a
+// communicator. Every rank must issue the same reads, possibly empty ones.
+class vtkGenIOCollectiveFileIO : public lanl::gio::GenericFileIO
+{
+public:
+  vtkGenIOCollectiveFileIO(MPI_Comm comm)
+    : FH(MPI_FILE_NULL)
+    , Comm(comm)
+  {
+  }
+
+  ~vtkGenIOCollectiveFileIO() override
+  {
+    if (FH != MPI_FILE_NULL)
+      MPI_File_close(&FH);
+  }
+
+  void open(const std::string& FN, bool ForReading = false) override
+  {
+    FileName = FN;
+    if (!ForReading ||
+      MPI_File_open(Comm, const_cast<char*>(FileName.c_str()), MPI_MODE_RDONLY, MPI_INFO_NULL,
+        &FH) != MPI_SUCCESS)
+      throw std::runtime_error("Unable to open the file: " + FileName);
+  }
+
+  void setSize(size_t) override
+  {
+    throw std::runtime_error("Unable to set size for read only file: " + FileName);
+  }
+
+  void read(void* buf, size_t count, off_t offset, const std::string& D) override
+  {
+    long long Continue[2] = { 0, 0 };
+    do
+    {
+      // MPI counts are ints, so large reads are done in several calls
+      int chunk = static_cast<int>(std::min(count, static_cast<size_t>(INT_MAX)));
+
+      MPI_Status status;
+      if (MPI_File_read_at_all(FH, offset, buf, chunk, MPI_BYTE, &status) != MPI_SUCCESS)
+        throw std::runtime_error("Unable to read " + D + " from file: " + FileName);
+
+      int scount;
+      (void)MPI_Get_count(&status, MPI_BYTE, &scount);
+
+      count -= scount;
+      buf = ((char*)buf) + scount;
+      offset += scount;
+
+      // Ranks still needing data and bytes read by all the ranks: reading at
+      // the end of the file returns nothing, so stop when no rank progresses
+      long long NeedContinue[2] = { count > 0 ? 1 : 0, scount };
+      MPI_Allreduce(NeedContinue, Continue, 2, MPI_LONG_LONG, MPI_SUM, Comm);
+      if (Continue[0] > 0 && Continue[1] == 0)
+        throw std::runtime_error("Unexpected end of file reading " + D + " from: " + FileName);
+    } while (Continue[0] > 0);
+  }
+
+  bool isCollective() const override { return true; }
+
+  void write(const void*, size_t, off_t, const std::string& D) override
+  {
+    throw std::runtime_error("Unable to write " + D + " to read only file: " + FileName);
+  }
+
+protected:
+  MPI_File FH;
+  MPI_Comm Comm;
+};
+}
+
 vtkStandardNewMacro(vtkGenIOReader)
 
   vtkGenIOReader::vtkGenIOReader()
@@ -155,6 +235,10 @@ vtkStandardNewMacro(vtkGenIOReader)
   // % loading
   dataPercentage = 0.1;
   percentageType = 1; // 0:normal, 1:power cube
+  sampleBlockSize = 0; // sample rows uniformly after reading
+
+  // I/O
+  collectiveIO = false;
 
   // Selections
   selectionChanged = false;
@@ -231,6 +315,25 @@ void vtkGenIOReader::SetPercentageType(int _type)
   }
 }
 
+void vtkGenIOReader::SetSampleBlockSize(int _size)
+{
+  if (sampleBlockSize != _size)
+  {
+    sampleBlockSize = std::max(0, _size);
+    this->Modified();
+  }
+}
+
+void vtkGenIOReader::SetCollectiveIO(int _collective)
+{
+  if (collectiveIO != (_collective != 0))
+  {
+    collectiveIO = _collective != 0;
+    currentFilename.clear(); // signal to re-open the file
+    this->Modified();
+  }
+}
+
 void vtkGenIOReader::SetResetSelection(int /* _x */)
 {
   selections.clear();
@@ -410,6 +513,135 @@ bool vtkGenIOReader::doMPIDataSplitting(int numDataRanksTmp, int numMPIranks, in
   return splitReading;
 }
 
+size_t vtkGenIOReader::computeNumRowsToSample(size_t numRows)
+{
+  size_t numRowsToSample = numRows;
+  if (percentageType == 0) // normal
+    numRowsToSample = round(numRows * dataPercentage);
+  else
+    numRowsToSample = round(numRows * (dataPercentage * dataPercentage * dataPercentage));
+
+  return std::min(numRowsToSample, numRows);
+}
+
+void vtkGenIOReader::computeReadSections(size_t startRow, size_t numRows, size_t numRowsToSample,
+  size_t blockSize, unsigned seed, std::vector<std::pair<size_t, size_t> >& sections)
+{
+  sections.clear();
+
+  if (blockSize == 0 || numRowsToSample >= numRows)
+  {
+    if (numRows > 0)
+      sections.push_back(std::make_pair(startRow, numRows));
+    return;
+  }
+
+  // Pick enough random blocks of rows to hold the sample, always the same ones
+  // for a given seed, and read them in file order merging the contiguous ones
+  size_t numBlocks = (numRows + blockSize - 1) / blockSize;
+  size_t numBlocksToRead = std::min(numBlocks, (numRowsToSample + blockSize - 1) / blockSize);
+
+  std::vector<size_t> blocks(numBlocks);
+  std::iota(blocks.begin(), blocks.end(), 0);
+  shuffle(blocks.begin(), blocks.end(), std::default_random_engine(seed));
+  blocks.resize(numBlocksToRead);
+  std::sort(blocks.begin(), blocks.end());
+
+  size_t numRowsRead = 0;
+  for (size_t b : blocks)
+  {
+    size_t offset = startRow + b * blockSize;
+    size_t rows = std::min(blockSize, numRows - b * blockSize);
+    if (!sections.empty() && sections.back().first + sections.back().second == offset)
+      sections.back().second += rows;
+    else
+      sections.push_back(std::make_pair(offset, rows));
+    numRowsRead += rows;
+  }
+
+  // Trim the last blocks so that only the sample is read
+  while (numRowsRead > numRowsToSample)
+  {
+    size_t excess = numRowsRead - numRowsToSample;
+    if (sections.back().second > excess)
+    {
+      sections.back().second -= excess;
+      numRowsRead -= excess;
+    }
+    else
+    {
+      numRowsRead -= sections.back().second;
+      sections.pop_back();
+    }
+  }
+}
+
+void vtkGenIOReader::addVariablesToRead(size_t numRows)
+{
+  // Specify location where to store each var read in
+  for (size_t j = 0; j < readInData.size(); j++)
+  {
+    if (paraviewData[j].load)
+    {
+      readInData[j].setNumElements(numRows);
+      readInData[j].allocateMem(1);
+
+      if (readInData[j].dataType == "float")
+        gioReader->addVariable((readInData[j].name).c_str(), (float*)readInData[j].data, true);
+      else if (readInData[j].dataType == "double")
+        gioReader->addVariable((readInData[j].name).c_str(), (double*)readInData[j].data, true);
+      else if (readInData[j].dataType == "int8_t")
+        gioReader->addVariable((readInData[j].name).c_str(), (int8_t*)readInData[j].data, true);
+      else if (readInData[j].dataType == "int16_t")
+        gioReader->addVariable((readInData[j].name).c_str(), (int16_t*)readInData[j].data, true);
+      else if (readInData[j].dataType == "int32_t")
+        gioReader->addVariable((readInData[j].name).c_str(), (int32_t*)readInData[j].data, true);
+      else if (readInData[j].dataType == "int64_t")
+        gioReader->addVariable((readInData[j].name).c_str(), (int64_t*)readInData[j].data, true);
+      else if (readInData[j].dataType == "uint8_t")
+        gioReader->addVariable((readInData[j].name).c_str(), (uint8_t*)readInData[j].data, true);
+      else if (readInData[j].dataType == "uint16_t")
+        gioReader->addVariable(
+          (readInData[j].name).c_str(), (uint16_t*)readInData[j].data, true);
+      else if (readInData[j].dataType == "uint32_t")
+        gioReader->addVariable(
+          (readInData[j].name).c_str(), (uint32_t*)readInData[j].data, true);
+      else if (readInData[j].dataType == "uint64_t")
+        gioReader->addVariable(
+          (readInData[j].name).c_str(), (uint64_t*)readInData[j].data, true);
+      else
+        msgLog << readInData[j].dataType << " = data type undefined!!!";
+    }
+  }
+}
+
+size_t vtkGenIOReader::readDataRank(
+  int dataRank, size_t startRow, size_t numRows, size_t numRowsToSample)
+{
+  std::vector<std::pair<size_t, size_t> > sections;
+  computeReadSections(startRow, numRows, numRowsToSample, static_cast<size_t>(sampleBlockSize),
+    randomSeed + dataRank, sections);
+
+  size_t numRowsRead = 0;
+  for (size_t s = 0; s < sections.size(); s++)
+    numRowsRead += sections[s].second;
+
+  // Collective reads must be issued by all the ranks, pad with empty ones
+  if (collectiveIO)
+  {
+    vtkIdType numSections = static_cast<vtkIdType>(sections.size()), maxNumSections;
+    this->Controller->AllReduce(&numSections, &maxNumSections, 1, vtkCommunicator::MAX_OP);
+    sections.resize(maxNumSections, std::make_pair(size_t(0), size_t(0)));
+  }
+
+  addVariablesToRead(numRowsRead);
+  gioReader->readDataSections(sections, dataRank, false);
+
+  msgLog << "Data rank: " << dataRank << ", rows: " << startRow << " - " << startRow + numRows
+         << ", # sections read: " << sections.size() << ", # rows read: " << numRowsRead << "\n";
+  return numRowsRead;
+}
+
 void vtkGenIOReader::theadedParsing(int threadId, int numThreads, size_t numRowsToSample,
   size_t numLoadingRows, vtkSmartPointer<vtkCellArray> cells, vtkSmartPointer<vtkPoints> pnts,
   int numSelections)
@@ -433,8 +665,9 @@ void vtkGenIOReader::theadedParsing(int threadId, int numThreads, size_t numRows
   double pnt[3];
   for (size_t j = startRow; j < (startRow + numRowsToSamplePerThread); ++j)
   {
-    // Choose random element to load
-    size_t _j = _num[j];
+    // Choose random element to load, unless all of them are (e.g. when the
+    // sampling was done while reading)
+    size_t _j = numRowsToSample < numLoadingRows ? _num[j] : j;
     while (_j >= numLoadingRows)
     {
       mtx.lock();
@@ -600,6 +833,16 @@ int vtkGenIOReader::RequestInformation(vtkInformation* /*rqst*/,
 
   if (!metaDataBuilt)
   {
+    // Collective reads need the MPI communicator of the ranks
+    vtkMPICommunicator* communicator =
+      vtkMPICommunicator::SafeDownCast(this->Controller->GetCommunicator());
+    if (collectiveIO && communicator)
+    {
+      MPI_Comm comm = *communicator->GetMPIComm()->GetHandle();
+      gioReader->setFileIOFactory([comm]() { return new vtkGenIOCollectiveFileIO(comm); });
+      msgLog << "Reading with collective MPI-IO\n";
+    }
+
     gioReader->openAndReadHeader(lanl::gio::GenericIO::MismatchRedistribute);
     msgLog << "header opened ... reading vars ... \n";
 
@@ -834,10 +1077,15 @@ int vtkGenIOReader::RequestData(
     paraviewData[i].show = _status != 0;
     paraviewData[i].load = _status != 0;
 
-    // override above if it's a position scalar
+    // override above if it's a position scalar or a selected one
     if (paraviewData[i].position)
       paraviewData[i].load = 1;
 
+    if (sampleType == 3)
+      for (size_t j = 0; j < selections.size(); j++)
+        if (selections[j].selectedScalar == paraviewData[i].name)
+          paraviewData[i].load = 1;
+
     msgLog << "Var: " + std::string(_name) << " ~ show: " << paraviewData[i].show
            << " ~ load: " << paraviewData[i].load << "\n";
   }
@@ -947,6 +1195,17 @@ int vtkGenIOReader::RequestData(
   msgLog << "\nReading now: " << numActiveTuples << " ... \n";
   debugLog.writeLogToDisk(msgLog);
 
+  //
+  // With collective I/O every rank must issue the same reads, the ranks having
+  // fewer data ranks to load do empty reads for the missing ones
+  int numDataRanksToRead = ranksRangeToLoad[1] - ranksRangeToLoad[0] + 1;
+  if (collectiveIO)
+  {
+    int localNumDataRanksToRead = numDataRanksToRead;
+    this->Controller->AllReduce(
+      &localNumDataRanksToRead, &numDataRanksToRead, 1, vtkCommunicator::MAX_OP);
+  }
+
   totalPoints = 0;
   size_t totalPointsProcessed = 0;
   populatingClock.start();
@@ -956,93 +1215,42 @@ int vtkGenIOReader::RequestData(
     {
       msgLog << "\nShow all sampled; sample type = " << std::to_string(this->sampleType) << "\n";
 
-      for (int i = ranksRangeToLoad[0]; i <= ranksRangeToLoad[1]; ++i)
+      for (int r = 0; r < numDataRanksToRead; ++r)
       {
+        int i = ranksRangeToLoad[0] + r;
+        if (i > ranksRangeToLoad[1])
+        {
+          readDataRank(ranksRangeToLoad[0], 0, 0, 0);
+          for (size_t j = 0; j < readInData.size(); j++)
+            readInData[j].deAllocateMem();
+          gioReader->clearVariables();
+          continue;
+        }
+
         size_t Np = gioReader->readNumElems(i);
         totalPointsProcessed += Np;
 
         int Coords[3];
         gioReader->readCoords(Coords, i);
 
-        _clock.start();
-
-        // Specify location where to store each var read in
-        for (size_t j = 0; j < readInData.size(); j++)
-        {
-          if (paraviewData[j].load)
-          {
-            readInData[j].setNumElements(Np);
-            readInData[j].allocateMem(1);
-
-            if (readInData[j].dataType == "float")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (float*)readInData[j].data, true);
-            else if (readInData[j].dataType == "double")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (double*)readInData[j].data, true);
-            else if (readInData[j].dataType == "int8_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (int8_t*)readInData[j].data, true);
-            else if (readInData[j].dataType == "int16_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (int16_t*)readInData[j].data, true);
-            else if (readInData[j].dataType == "int32_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (int32_t*)readInData[j].data, true);
-            else if (readInData[j].dataType == "int64_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (int64_t*)readInData[j].data, true);
-            else if (readInData[j].dataType == "uint8_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (uint8_t*)readInData[j].data, true);
-            else if (readInData[j].dataType == "uint16_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (uint16_t*)readInData[j].data, true);
-            else if (readInData[j].dataType == "uint32_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (uint32_t*)readInData[j].data, true);
-            else if (readInData[j].dataType == "uint64_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (uint64_t*)readInData[j].data, true);
-            else
-              msgLog << readInData[j].dataType << " = data type undefined!!!";
-          }
-        }
-        _clock.stop();
-        msgLog << "\n\nInput read rank: " << i << ", paraviewData.size(): " << paraviewData.size()
-               << ", time to create structures: " << _clock.getDuration() << " s.\n";
-
         loadClock.start();
 
-        // Load data
-        size_t numLoadingRows;
-        if (!splitReading)
+        // Rows of the data rank to load
+        size_t startRow = 0, numRows = Np;
+        if (splitReading)
         {
-          gioReader->readDataSection(0, Np, i, false); // reading the whole file
-          numLoadingRows = Np;
-        }
-        else
-        {
-          gioReader->readDataSection(readRowsInfo[splitReadingCount * 3 + 1],
-            readRowsInfo[splitReadingCount * 3 + 2], i, false);
-          numLoadingRows = readRowsInfo[splitReadingCount * 3 + 2];
+          startRow = readRowsInfo[splitReadingCount * 3 + 1];
+          numRows = readRowsInfo[splitReadingCount * 3 + 2];
           splitReadingCount++;
         }
 
-        // Find the number of rows after sampling
-        size_t numRowsToSample = numLoadingRows;
-        if (percentageType == 0) // normal
-          numRowsToSample = round(numLoadingRows * dataPercentage);
-        else
-          numRowsToSample =
-            round(numLoadingRows * (dataPercentage * dataPercentage * dataPercentage));
-
-        if (numRowsToSample > numLoadingRows)
-          numRowsToSample = numLoadingRows;
+        // Find the number of rows after sampling and load data
+        size_t numRowsToSample = computeNumRowsToSample(numRows);
+        size_t numLoadingRows = readDataRank(i, startRow, numRows, numRowsToSample);
+        numRowsToSample = std::min(numRowsToSample, numLoadingRows);
 
         msgLog << "Rank (i): " + std::to_string(i) << ", Np/numLoadingRows: " << numLoadingRows
-               << ", # rows in rank: " << gioReader->readNumElems(i)
-               << ", dataPercentage: " << dataPercentage
+               << ", # rows in rank: " << Np << ", dataPercentage: " << dataPercentage
                << ", dataPercentage^3: " << dataPercentage * dataPercentage * dataPercentage
                << ", numRowsToSample: " << numRowsToSample << "\n";
         loadClock.stop();
@@ -1104,91 +1312,43 @@ int vtkGenIOReader::RequestData(
         break;
       }
 
-      for (int i = ranksRangeToLoad[0]; i <= ranksRangeToLoad[1]; ++i)
+      for (int r = 0; r < numDataRanksToRead; ++r)
       {
+        int i = ranksRangeToLoad[0] + r;
+        if (i > ranksRangeToLoad[1])
+        {
+          readDataRank(ranksRangeToLoad[0], 0, 0, 0);
+          for (size_t j = 0; j < readInData.size(); j++)
+            readInData[j].deAllocateMem();
+          gioReader->clearVariables();
+          continue;
+        }
+
         size_t Np = gioReader->readNumElems(i);
         totalPointsProcessed += Np;
 
         int Coords[3];
         gioReader->readCoords(Coords, i);
 
-        _clock.start();
-        for (size_t j = 0; j < readInData.size(); j++)
-        {
-          if (paraviewData[j].load)
-          {
-            readInData[j].setNumElements(Np);
-            readInData[j].allocateMem(1);
-
-            if (readInData[j].dataType == "float")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (float*)readInData[j].data, true);
-            else if (readInData[j].dataType == "double")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (double*)readInData[j].data, true);
-            else if (readInData[j].dataType == "int8_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (int8_t*)readInData[j].data, true);
-            else if (readInData[j].dataType == "int16_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (int16_t*)readInData[j].data, true);
-            else if (readInData[j].dataType == "int32_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (int32_t*)readInData[j].data, true);
-            else if (readInData[j].dataType == "int64_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (int64_t*)readInData[j].data, true);
-            else if (readInData[j].dataType == "uint8_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (uint8_t*)readInData[j].data, true);
-            else if (readInData[j].dataType == "uint16_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (uint16_t*)readInData[j].data, true);
-            else if (readInData[j].dataType == "uint32_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (uint32_t*)readInData[j].data, true);
-            else if (readInData[j].dataType == "uint64_t")
-              gioReader->addVariable(
-                (readInData[j].name).c_str(), (uint64_t*)readInData[j].data, true);
-            else
-              msgLog << readInData[j].dataType << " = data type undefined!!!";
-          }
-        }
-        _clock.stop();
-        msgLog << "Input read rank: " << i << ", paraviewData.size(): " << paraviewData.size()
-               << ", time to create structures: " << _clock.getDuration() << " s.\n";
-
         loadClock.start();
 
-        // Find the number of rows to read
-        size_t numLoadingRows;
-        if (!splitReading)
-        {
-          gioReader->readDataSection(0, Np, i, false); // reading the whole file
-          numLoadingRows = Np;
-        }
-        else
+        // Rows of the data rank to load
+        size_t startRow = 0, numRows = Np;
+        if (splitReading)
         {
-          gioReader->readDataSection(readRowsInfo[splitReadingCount * 3 + 1],
-            readRowsInfo[splitReadingCount * 3 + 2], i, false);
-          numLoadingRows = readRowsInfo[splitReadingCount * 3 + 2];
+          startRow = readRowsInfo[splitReadingCount * 3 + 1];
+          numRows = readRowsInfo[splitReadingCount * 3 + 2];
           splitReadingCount++;
         }
-        msgLog << "numLoadingRows: " << numLoadingRows << "\n";
 
-        // Find the number of rows after sampling
-        size_t numRowsToSample = numLoadingRows;
-        if (percentageType == 0) // normal
-          numRowsToSample = round(numLoadingRows * dataPercentage);
-        else
-          numRowsToSample =
-            round(numLoadingRows * (dataPercentage * dataPercentage * dataPercentage));
+        // Find the number of rows after sampling and load data
+        size_t numRowsToSample = computeNumRowsToSample(numRows);
+        size_t numLoadingRows = readDataRank(i, startRow, numRows, numRowsToSample);
+        numRowsToSample = std::min(numRowsToSample, numLoadingRows);
+        msgLog << "numLoadingRows: " << numLoadingRows << "\n";
 
-        if (numRowsToSample > numLoadingRows)
-          numRowsToSample = numLoadingRows;
         msgLog << "\ni: " + std::to_string(i) << ", Np: " << numLoadingRows
-               << ", # rows in rank: " << gioReader->readNumElems(i)
-               << ", dataPercentage: " << dataPercentage
+               << ", # rows in rank: " << Np << ", dataPercentage: " << dataPercentage
                << ", dataPercentage^3: " << dataPercentage * dataPercentage * dataPercentage
                << ", numRowsToSample: " << numRowsToSample;
         loadClock.stop();
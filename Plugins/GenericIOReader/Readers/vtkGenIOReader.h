@@ -58,6 +58,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 class vtkDataArray;
@@ -126,6 +127,8 @@ public:
   void SetSampleType(int s);
   void SetDataPercentToShow(double t);
   void SetPercentageType(int _type);
+  void SetSampleBlockSize(int _size);
+  void SetCollectiveIO(int _collective);
 
   void SetResetSelection(int _x);
   void SelectScalar(const char* selectedScalar);
@@ -144,6 +147,14 @@ public:
   int GetCellArrayStatus(const char* name) { return CellDataArraySelection->ArrayIsEnabled(name); }
   void SetCellArrayStatus(const char* name, int status);
 
+  //
+  // Sections (first row, number of rows) read from the numRows rows of a data
+  // rank starting at startRow to sample numRowsToSample of them: random
+  // blocks of blockSize rows picked with seed, in file order, contiguous ones
+  // merged. All the rows are read if blockSize is 0.
+  static void computeReadSections(size_t startRow, size_t numRows, size_t numRowsToSample,
+    size_t blockSize, unsigned seed, std::vector<std::pair<size_t, size_t> >& sections);
+
 protected:
   vtkGenIOReader();
   ~vtkGenIOReader();
@@ -154,6 +165,10 @@ protected:
     vtkInformationVector* outputVector) override;
   int RequestData(vtkInformation*, vtkInformationVector**, vtkInformationVector*) override;
 
+  size_t computeNumRowsToSample(size_t numRows);
+  void addVariablesToRead(size_t numRows);
+  size_t readDataRank(int dataRank, size_t startRow, size_t numRows, size_t numRowsToSample);
+
   void theadedParsing(int threadId, int numThreads, size_t numRowsToSample, size_t Np,
     vtkSmartPointer<vtkCellArray> cells, vtkSmartPointer<vtkPoints> pnts, int numSelections = -1);
 
@@ -176,6 +191,10 @@ private:
   double dataPercentage;
   size_t dataNumShowElements;
   unsigned randomSeed;
+  int sampleBlockSize; // rows per block sampled from the file, 0: sample after reading
+
+  // I/O
+  bool collectiveIO; // collective MPI-IO instead of POSIX reads
 
   // Selection
   bool selectionChanged;
@@ -0,0 +1,97 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestGenIOReadSections.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Tests the sections of rows read by the GenericIO reader to sample a data
+// rank.
+
+#include "vtkGenIOReader.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#define TASSERT(x)                                                                                 \
+  if (!(x))                                                                                        \
+  {                                                                                                \
+    std::cerr << "ERROR: failed at " << __LINE__ << "!" << std::endl;                              \
+    return EXIT_FAILURE;                                                                           \
+  }
+
+namespace
+{
+typedef std::vector<std::pair<size_t, size_t> > SectionsType;
+
+SectionsType Compute(
+  size_t startRow, size_t numRows, size_t numRowsToSample, size_t blockSize, unsigned seed)
+{
+  SectionsType sections;
+  vtkGenIOReader::computeReadSections(
+    startRow, numRows, numRowsToSample, blockSize, seed, sections);
+  return sections;
+}
+
+// Checks that the sections are in file order, within the rows of the data
+// rank, start on a block, are merged when contiguous and hold the sample.
+bool IsValid(const SectionsType& sections, size_t startRow, size_t numRows,
+  size_t numRowsToSample, size_t blockSize)
+{
+  size_t total = 0;
+  for (size_t cc = 0; cc < sections.size(); ++cc)
+  {
+    const size_t first = sections[cc].first;
+    const size_t count = sections[cc].second;
+    if (count == 0 || first < startRow || first + count > startRow + numRows ||
+      (first - startRow) % blockSize != 0)
+    {
+      return false;
+    }
+    if (cc > 0 && sections[cc - 1].first + sections[cc - 1].second >= first)
+    {
+      return false;
+    }
+    total += count;
+  }
+  return total == numRowsToSample;
+}
+}
+
+int main(int, char* [])
+{
+  // Without blocks, or when sampling everything, the whole data rank is read.
+  TASSERT(Compute(500, 10000, 1000, 0, 1) == SectionsType(1, std::make_pair(500, 10000)));
+  TASSERT(Compute(500, 10000, 10000, 100, 1) == SectionsType(1, std::make_pair(500, 10000)));
+  TASSERT(Compute(500, 10000, 20000, 100, 1) == SectionsType(1, std::make_pair(500, 10000)));
+  TASSERT(Compute(500, 0, 0, 0, 1).empty());
+  TASSERT(Compute(500, 0, 0, 100, 1).empty());
+
+  // Blocks holding exactly the sample.
+  SectionsType sections = Compute(500, 10000, 1000, 100, 1);
+  TASSERT(IsValid(sections, 500, 10000, 1000, 100));
+  TASSERT(sections.size() > 1);
+
+  // The last block is trimmed when the sample is not a number of blocks, and
+  // the last block of the data rank may be partial.
+  TASSERT(IsValid(Compute(500, 10000, 333, 100, 1), 500, 10000, 333, 100));
+  TASSERT(IsValid(Compute(0, 1050, 1049, 100, 1), 0, 1050, 1049, 100));
+  TASSERT(IsValid(Compute(0, 250, 240, 100, 1), 0, 250, 240, 100));
+  TASSERT(IsValid(Compute(0, 10000, 1, 4096, 1), 0, 10000, 1, 4096));
+  TASSERT(IsValid(Compute(0, 10, 5, 4096, 1), 0, 10, 5, 4096));
+
+  // The same seed always picks the same blocks, another one picks others.
+  TASSERT(Compute(500, 10000, 1000, 100, 1) == sections);
+  TASSERT(Compute(500, 10000, 1000, 100, 2) != sections);
+
+  return EXIT_SUCCESS;
+}
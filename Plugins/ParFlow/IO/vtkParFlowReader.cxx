@@ -5,16 +5,37 @@
 #include "vtkCellData.h"
 #include "vtkDoubleArray.h"
 #include "vtkImageData.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
 #include "vtkMultiBlockDataSet.h"
 #include "vtkMultiProcessController.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
+#include "vtkSMPTools.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkVector.h"
 #include "vtkVectorOperators.h"
 
+#include "vtksys/SystemTools.hxx"
+
+#include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <sstream>
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 static constexpr std::streamoff headerSize = 6 * sizeof(double) + 4 * sizeof(int);
 static constexpr std::streamoff subgridHeaderSize = 9 * sizeof(int);
 static constexpr std::streamoff pfbEntrySize = sizeof(double);
@@ -42,6 +63,104 @@ static std::streamoff computeEntrySize(bool isCLM, int nz)
   return sz;
 }
 
+namespace
+{
+/// A read-only memory mapping of a whole file.
+///
+/// Data is null when the file cannot be mapped, in which case
+/// the reader falls back to reading through a stream.
+class vtkParFlowMappedFile
+{
+public:
+  vtkParFlowMappedFile(const char* filename)
+    : Data(nullptr)
+    , Size(0)
+  {
+#ifdef _WIN32
+    this->File = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL, nullptr);
+    this->Mapping = nullptr;
+    LARGE_INTEGER size;
+    if (this->File == INVALID_HANDLE_VALUE || !GetFileSizeEx(this->File, &size) ||
+      size.QuadPart <= 0)
+    {
+      return;
+    }
+    this->Mapping = CreateFileMappingA(this->File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (this->Mapping)
+    {
+      this->Data = static_cast<const char*>(MapViewOfFile(this->Mapping, FILE_MAP_READ, 0, 0, 0));
+      this->Size = this->Data ? static_cast<std::streamoff>(size.QuadPart) : 0;
+    }
+#else
+    int fd = open(filename, O_RDONLY);
+    struct stat info;
+    if (fd >= 0 && fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+      void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED)
+      {
+        this->Data = static_cast<const char*>(data);
+        this->Size = static_cast<std::streamoff>(info.st_size);
+      }
+    }
+    if (fd >= 0)
+    {
+      close(fd); // The mapping stays valid.
+    }
+#endif
+  }
+
+  ~vtkParFlowMappedFile()
+  {
+#ifdef _WIN32
+    if (this->Data)
+    {
+      UnmapViewOfFile(this->Data);
+    }
+    if (this->Mapping)
+    {
+      CloseHandle(this->Mapping);
+    }
+    if (this->File != INVALID_HANDLE_VALUE)
+    {
+      CloseHandle(this->File);
+    }
+#else
+    if (this->Data)
+    {
+      munmap(const_cast<char*>(this->Data), static_cast<size_t>(this->Size));
+    }
+#endif
+  }
+
+  const char* Data;
+  std::streamoff Size;
+
+private:
+  vtkParFlowMappedFile(const vtkParFlowMappedFile&) = delete;
+  void operator=(const vtkParFlowMappedFile&) = delete;
+
+#ifdef _WIN32
+  HANDLE File;
+  HANDLE Mapping;
+#endif
+};
+}
+
+/// Copy (unless \a src and \a dst are the same) big-endian doubles and convert them to
+/// native order using multiple threads.
+static void convertBigEndian(const char* src, double* dst, vtkIdType numValues)
+{
+  vtkSMPTools::For(0, numValues, [&](vtkIdType begin, vtkIdType end) {
+    if (src != reinterpret_cast<const char*>(dst))
+    {
+      std::memcpy(dst + begin, src + begin * sizeof(double), (end - begin) * sizeof(double));
+    }
+    vtkByteSwap::SwapBERange(dst + begin, end - begin);
+  });
+}
+
 vtkStandardNewMacro(vtkParFlowReader);
 
 vtkParFlowReader::vtkParFlowReader()
@@ -50,6 +169,8 @@ vtkParFlowReader::vtkParFlowReader()
   , CLMIrrType(0)
   , NZ(0)
   , InferredAsCLM(-1)
+  , MappedData(nullptr)
+  , MappedSize(0)
 {
   this->SetNumberOfInputPorts(0);
 }
@@ -86,6 +207,13 @@ static bool is_number(const std::string& s)
     std::find_if(s.begin(), s.end(), [](char c) { return !std::isdigit(c); }) == s.end();
 }
 
+int vtkParFlowReader::RequestInformation(vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** vtkNotUsed(inInfo), vtkInformationVector* outInfo)
+{
+  outInfo->GetInformationObject(0)->Set(CAN_HANDLE_PIECE_REQUEST(), 1);
+  return 1;
+}
+
 int vtkParFlowReader::RequestData(vtkInformation* vtkNotUsed(request),
   vtkInformationVector** vtkNotUsed(inInfo), vtkInformationVector* outInfo)
 {
@@ -145,11 +273,17 @@ int vtkParFlowReader::RequestData(vtkInformation* vtkNotUsed(request),
   }
 
   // When run in parallel, we choose a range of blocks
-  // to load from those available.
-  int rank = 1;
+  // to load from those available for the requested piece.
+  int rank = 0;
   int jbsz = 1;
+  auto info = outInfo->GetInformationObject(0);
   auto mpc = vtkMultiProcessController::GetGlobalController();
-  if (mpc)
+  if (info->Has(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_PIECES()))
+  {
+    rank = info->Get(vtkStreamingDemandDrivenPipeline::UPDATE_PIECE_NUMBER());
+    jbsz = info->Get(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_PIECES());
+  }
+  else if (mpc)
   {
     rank = mpc->GetLocalProcessId();
     jbsz = mpc->GetNumberOfProcesses();
@@ -190,15 +324,38 @@ int vtkParFlowReader::RequestData(vtkInformation* vtkNotUsed(request),
     << "  subgrids   " << numSubGrids << "\n";
 #endif
 
-  // Update {I,J,K}Divs on rank 0 by reading file:
-  this->ScanBlocks(pfb, numSubGrids);
-  // Update {I,J,K}Divs on ranks > 0 via network:
-  this->BroadcastBlocks();
+  // Only scan the subgrids when the file (or how it is interpreted) changed;
+  // a file rewritten with the same size is detected by its modification time.
+  // Ranks may see different file metadata (e.g. with the attribute caches of
+  // network file systems), so rank 0, which scans the file, decides for all
+  // of them before the collective broadcast.
+  std::ostringstream divsKey;
+  divsKey << filename << ":" << vtksys::SystemTools::FileLength(filename) << ":"
+          << vtksys::SystemTools::ModifiedTime(filename) << ":" << this->InferredAsCLM << ":"
+          << numSubGrids << ":" << nn[0] << "x" << nn[1] << "x" << nn[2];
+  int rescan = divsKey.str() != this->IJKDivsKey ? 1 : 0;
+  if (mpc && mpc->GetNumberOfProcesses() > 1)
+  {
+    mpc->Broadcast(&rescan, 1, 0);
+  }
+  if (rescan)
+  {
+    // Update {I,J,K}Divs on rank 0 by reading file:
+    this->ScanBlocks(pfb, numSubGrids);
+    // Update {I,J,K}Divs on ranks > 0 via network:
+    this->BroadcastBlocks();
+    this->IJKDivsKey = divsKey.str();
+  }
 
   int gridLo = (rank * numSubGrids) / jbsz;
   int gridHi = ((rank + 1) * numSubGrids) / jbsz;
   // std::cout << "Rank " << rank << " owns subgrids " << gridLo << " -- " << gridHi << "\n";
 
+  // Map the file so only the pages of our subgrids are touched:
+  vtkParFlowMappedFile mapped(this->FileName);
+  this->MappedData = mapped.Data;
+  this->MappedSize = mapped.Size;
+
   output->SetNumberOfBlocks(numSubGrids);
   for (int ni = gridLo; ni < gridHi; ++ni)
   {
@@ -208,6 +365,8 @@ int vtkParFlowReader::RequestData(vtkInformation* vtkNotUsed(request),
   // Prevent accidents; don't preserve across calls to RequestData:
   this->NZ = 0;
   this->InferredAsCLM = -1;
+  this->MappedData = nullptr;
+  this->MappedSize = 0;
 
   return 1;
 }
@@ -227,6 +386,19 @@ bool vtkParFlowReader::ReadSubgridHeader(
   return pfb.good() && !pfb.eof();
 }
 
+void vtkParFlowReader::ReadSubgridHeader(
+  const char* data, vtkVector3i& si, vtkVector3i& sn, vtkVector3i& sr)
+{
+  std::memcpy(si.GetData(), data, 3 * sizeof(int));
+  std::memcpy(sn.GetData(), data + 3 * sizeof(int), 3 * sizeof(int));
+  std::memcpy(sr.GetData(), data + 6 * sizeof(int), 3 * sizeof(int));
+
+  // Swap bytes as required knowing that we started with big-endian data:
+  vtkByteSwap::SwapBERange(si.GetData(), 3);
+  vtkByteSwap::SwapBERange(sn.GetData(), 3);
+  vtkByteSwap::SwapBERange(sr.GetData(), 3);
+}
+
 void vtkParFlowReader::ScanBlocks(std::ifstream& pfb, int vtkNotUsed(numSubGrids))
 {
   auto mpc = vtkMultiProcessController::GetGlobalController();
@@ -354,75 +526,115 @@ void vtkParFlowReader::ReadBlock(std::ifstream& pfb, vtkMultiBlockDataSet* outpu
   vtkVector3i sn;
   vtkVector3i sr;
 
-  // Move file cursor to start of block.
+  // Move file cursor (or pointer into the mapped file) to start of block.
   std::streamoff blockOffset = this->GetBlockOffset(blockId);
-  pfb.seekg(blockOffset);
+  const char* data = nullptr;
+  if (this->MappedData)
+  {
+    if (blockOffset + subgridHeaderSize > this->MappedSize)
+    {
+      vtkErrorMacro("Subgrid " << blockId << " lies past the end of the file.");
+      return;
+    }
+    data = this->MappedData + blockOffset;
+    this->ReadSubgridHeader(data, si, sn, sr);
+    data += subgridHeaderSize;
+  }
+  else
+  {
+    pfb.seekg(blockOffset);
+    if (!this->ReadSubgridHeader(pfb, si, sn, sr))
+    {
+      return;
+    }
+  }
 
-  if (this->ReadSubgridHeader(pfb, si, sn, sr))
+  vtkIdType numValues = static_cast<vtkIdType>(sn[0]) * sn[1] * sn[2];
+  if (this->InferredAsCLM)
+  {
+    const int numCLMVars = sn[2] - si[2];
+    const int numIrrVars = this->CLMIrrType == 1 || this->CLMIrrType == 3 ? 1 : 0;
+    numValues = static_cast<vtkIdType>(sn[0]) * sn[1] *
+      std::max(numCLMVars, std::min(clmBaseComponents, numCLMVars) + numIrrVars);
+  }
+  if (data &&
+    blockOffset + subgridHeaderSize + numValues * pfbEntrySize > this->MappedSize)
   {
-    vtkNew<vtkImageData> image;
-    image->SetOrigin(origin.GetData());
-    image->SetSpacing(spacing.GetData());
+    vtkErrorMacro("Subgrid " << blockId << " extends past the end of the file.");
+    return;
+  }
 
-    if (this->InferredAsCLM)
+  vtkNew<vtkImageData> image;
+  image->SetOrigin(origin.GetData());
+  image->SetSpacing(spacing.GetData());
+  auto readArray = [&](vtkDoubleArray* field) {
+    if (data)
     {
-      // The CLM files have the full simulation extent listed but only
-      // provide data on the top 2-d surface:
-      image->SetExtent(si[0], si[0] + sn[0], si[1], si[1] + sn[1], si[2], si[2]);
+      this->ReadBlockIntoArray(data, image, field);
+    }
+    else
+    {
+      this->ReadBlockIntoArray(pfb, image, field);
+    }
+  };
 
-      const int numCLMVars = sn[2] - si[2];
-      int numComponents = 0;
-      for (int cc = 0; cc < clmBaseComponents && cc < numCLMVars; ++cc, ++numComponents)
+  if (this->InferredAsCLM)
+  {
+    // The CLM files have the full simulation extent listed but only
+    // provide data on the top 2-d surface:
+    image->SetExtent(si[0], si[0] + sn[0], si[1], si[1] + sn[1], si[2], si[2]);
+
+    const int numCLMVars = sn[2] - si[2];
+    int numComponents = 0;
+    for (int cc = 0; cc < clmBaseComponents && cc < numCLMVars; ++cc, ++numComponents)
+    {
+      vtkNew<vtkDoubleArray> field;
+      field->SetName(clmBaseComponentNames[cc]);
+      readArray(field);
+    }
+    switch (this->CLMIrrType)
+    {
+      case 1:
       {
         vtkNew<vtkDoubleArray> field;
-        field->SetName(clmBaseComponentNames[cc]);
-        this->ReadBlockIntoArray(pfb, image, field);
+        field->SetName("qflx_qirr");
+        readArray(field);
+        ++numComponents;
       }
-      switch (this->CLMIrrType)
-      {
-        case 1:
-        {
-          vtkNew<vtkDoubleArray> field;
-          field->SetName("qflx_qirr");
-          this->ReadBlockIntoArray(pfb, image, field);
-          ++numComponents;
-        }
-        break;
-        case 3:
-        {
-          vtkNew<vtkDoubleArray> field;
-          field->SetName("qflx_qirr_inst");
-          this->ReadBlockIntoArray(pfb, image, field);
-          ++numComponents;
-        }
-        break;
-        default:
-          break;
-      }
-      for (int cz = 0; numComponents < numCLMVars; ++cz, ++numComponents)
+      break;
+      case 3:
       {
         vtkNew<vtkDoubleArray> field;
-        std::ostringstream name;
-        name << "tsoil_" << cz;
-        field->SetName(name.str().c_str());
-        this->ReadBlockIntoArray(pfb, image, field);
+        field->SetName("qflx_qirr_inst");
+        readArray(field);
+        ++numComponents;
       }
+      break;
+      default:
+        break;
     }
-    else
+    for (int cz = 0; numComponents < numCLMVars; ++cz, ++numComponents)
     {
-      // Read a single PFB state variable:
       vtkNew<vtkDoubleArray> field;
-      image->SetExtent(si[0], si[0] + sn[0], si[1], si[1] + sn[1], si[2], si[2] + sn[2]);
-      field->SetName(arrayName.c_str());
-      this->ReadBlockIntoArray(pfb, image, field);
+      std::ostringstream name;
+      name << "tsoil_" << cz;
+      field->SetName(name.str().c_str());
+      readArray(field);
     }
-
-    output->SetBlock(blockId, image);
   }
+  else
+  {
+    // Read a single PFB state variable:
+    vtkNew<vtkDoubleArray> field;
+    image->SetExtent(si[0], si[0] + sn[0], si[1], si[1] + sn[1], si[2], si[2] + sn[2]);
+    field->SetName(arrayName.c_str());
+    readArray(field);
+  }
+
+  output->SetBlock(blockId, image);
 }
 
-void vtkParFlowReader::ReadBlockIntoArray(
-  std::ifstream& file, vtkImageData* img, vtkDoubleArray* arr)
+static void addBlockArray(vtkImageData* img, vtkDoubleArray* arr)
 {
   arr->SetNumberOfTuples(img->GetNumberOfCells());
   auto cellData = img->GetCellData();
@@ -433,10 +645,27 @@ void vtkParFlowReader::ReadBlockIntoArray(
   {
     cellData->SetScalars(arr);
   }
+}
+
+void vtkParFlowReader::ReadBlockIntoArray(
+  std::ifstream& file, vtkImageData* img, vtkDoubleArray* arr)
+{
+  addBlockArray(img, arr);
 
   vtkIdType numValues = arr->GetNumberOfTuples() * arr->GetNumberOfComponents();
-  file.read(reinterpret_cast<char*>(arr->GetVoidPointer(0)), sizeof(double) * numValues);
-  vtkByteSwap::SwapBERange(reinterpret_cast<double*>(arr->GetVoidPointer(0)), numValues);
+  double* values = arr->GetPointer(0);
+  file.read(reinterpret_cast<char*>(values), sizeof(double) * numValues);
+  convertBigEndian(reinterpret_cast<const char*>(values), values, numValues);
   // std::cout << arr->GetNumberOfComponents() << " " << numValues << "Read to byte " << pfb.tellg()
   // << "\n";
 }
+
+void vtkParFlowReader::ReadBlockIntoArray(
+  const char*& data, vtkImageData* img, vtkDoubleArray* arr)
+{
+  addBlockArray(img, arr);
+
+  vtkIdType numValues = arr->GetNumberOfTuples() * arr->GetNumberOfComponents();
+  convertBigEndian(data, arr->GetPointer(0), numValues);
+  data += sizeof(double) * numValues;
+}
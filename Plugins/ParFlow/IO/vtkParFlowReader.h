@@ -8,6 +8,7 @@
 #include "vtkVector.h"
 
 #include <fstream>
+#include <string>
 #include <vector>
 
 class vtkDoubleArray;
@@ -19,8 +20,8 @@ class vtkMultiBlockDataSet;
   * Data is output as a multiblock of image data.
   *
   * This reader will work in parallel settings by
-  * splitting existing blocks among ranks.
-  * If there are fewer blocks than ranks, some processes will do no work.
+  * splitting existing blocks among the requested pieces.
+  * If there are fewer blocks than pieces, some processes will do no work.
   * You may use "pftools dist" to repartition the data into a different
   * number of blocks (known in ParFlow as subgrids).
   *
@@ -30,6 +31,11 @@ class vtkMultiBlockDataSet;
   * stores a sequence of 2-d images, one per CLM state variable); the k-index
   * extent of the PFB file corresponds to the number of CLM state variables
   * per cell.
+  *
+  * The subgrid layout found by scanning the file is cached until the file
+  * changes. Whenever possible the file is memory-mapped and each rank only
+  * touches the pages of its own subgrids, which are converted from big-endian
+  * to native order using multiple threads.
   */
 class VTKPARFLOWIO_EXPORT vtkParFlowReader : public vtkMultiBlockDataSetAlgorithm
 {
@@ -66,6 +72,10 @@ protected:
   vtkParFlowReader();
   virtual ~vtkParFlowReader();
 
+  /// Advertise that the reader can split its subgrids among pieces.
+  int RequestInformation(
+    vtkInformation* request, vtkInformationVector** inInfo, vtkInformationVector* outInfo) override;
+
   /// Update the reader's output.
   int RequestData(
     vtkInformation* request, vtkInformationVector** inInfo, vtkInformationVector* outInfo) override;
@@ -94,6 +104,8 @@ protected:
   std::streamoff GetEndOffset() const;
 
   static bool ReadSubgridHeader(ifstream& pfb, vtkVector3i& si, vtkVector3i& sn, vtkVector3i& sr);
+  static void ReadSubgridHeader(
+    const char* data, vtkVector3i& si, vtkVector3i& sn, vtkVector3i& sr);
 
   /// Read a single block from the file
   void ReadBlock(std::ifstream& file, vtkMultiBlockDataSet* output, vtkVector3d& origin,
@@ -105,16 +117,22 @@ protected:
     const vtkVector3i& blockIJKIn, vtkVector3i& blockExtentMinOut, vtkVector3i& blockExtentMaxOut);
 
   static void ReadBlockIntoArray(std::ifstream& file, vtkImageData* img, vtkDoubleArray* arr);
+  /// Read from memory (e.g., a memory-mapped file), advancing \a data past the values read.
+  static void ReadBlockIntoArray(const char*& data, vtkImageData* img, vtkDoubleArray* arr);
 
   /// The filename, which must be a valid path before RequestData is called.
   char* FileName;
   int IsCLMFile;
   int CLMIrrType;
-  /// IJKDivs, NZ, and InferredAsCLM are only valid inside RequestData; used to compute subgrid
-  /// offsets.
+  /// NZ, InferredAsCLM, and the mapped file are only valid inside RequestData; along with
+  /// IJKDivs they are used to compute subgrid offsets.
   std::vector<int> IJKDivs[3];
   int NZ;
   int InferredAsCLM;
+  const char* MappedData;
+  std::streamoff MappedSize;
+  /// Identifies the file (name, size, and CLM layout) IJKDivs was scanned from.
+  std::string IJKDivsKey;
 };
 
 #endif // vtkParflowReader_h
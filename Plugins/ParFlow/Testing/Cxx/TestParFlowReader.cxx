@@ -0,0 +1,194 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestParFlowReader.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Tests the ParFlow reader on small PFB files: the values of the subgrids read
+// from the mapped file, the subgrids read for each piece, and the subgrid
+// layout scanned again when the file is rewritten with another one.
+
+#include "vtkByteSwap.h"
+#include "vtkCellData.h"
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkNew.h"
+#include "vtkParFlowReader.h"
+
+#include <vtksys/FStream.hxx>
+#include <vtksys/SystemTools.hxx>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#define TASSERT(x)                                                                                 \
+  if (!(x))                                                                                        \
+  {                                                                                                \
+    std::cerr << "ERROR: failed at " << __LINE__ << "!" << std::endl;                              \
+    return EXIT_FAILURE;                                                                           \
+  }
+
+namespace
+{
+// Dimensions of the grid, in cells.
+const int Dims[3] = { 4, 2, 1 };
+
+// Value of the cell (i, j, k) of the grid.
+double CellValue(int i, int j, int k)
+{
+  return i + 10. * j + 100. * k;
+}
+
+template <typename T>
+void WriteBE(vtksys::ofstream& file, T value)
+{
+  vtkByteSwap::SwapBE(&value);
+  file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Writes a PFB file of the grid split in `split[0] x split[1]` subgrids.
+bool WritePFB(const std::string& filename, const int split[2])
+{
+  vtksys::ofstream file(filename.c_str(), std::ios::binary);
+  for (int ii = 0; ii < 3; ++ii)
+  {
+    WriteBE(file, 0.); // origin
+  }
+  for (int ii = 0; ii < 3; ++ii)
+  {
+    WriteBE(file, Dims[ii]);
+  }
+  for (int ii = 0; ii < 3; ++ii)
+  {
+    WriteBE(file, 1.); // spacing
+  }
+  WriteBE(file, split[0] * split[1]);
+
+  const int sn[3] = { Dims[0] / split[0], Dims[1] / split[1], Dims[2] };
+  for (int bj = 0; bj < split[1]; ++bj)
+  {
+    for (int bi = 0; bi < split[0]; ++bi)
+    {
+      const int si[3] = { bi * sn[0], bj * sn[1], 0 };
+      for (int ii = 0; ii < 3; ++ii)
+      {
+        WriteBE(file, si[ii]);
+      }
+      for (int ii = 0; ii < 3; ++ii)
+      {
+        WriteBE(file, sn[ii]);
+      }
+      for (int ii = 0; ii < 3; ++ii)
+      {
+        WriteBE(file, 1); // refinement
+      }
+      for (int k = si[2]; k < si[2] + sn[2]; ++k)
+      {
+        for (int j = si[1]; j < si[1] + sn[1]; ++j)
+        {
+          for (int i = si[0]; i < si[0] + sn[0]; ++i)
+          {
+            WriteBE(file, CellValue(i, j, k));
+          }
+        }
+      }
+    }
+  }
+  file.close();
+  return !file.fail();
+}
+
+// Checks that the block holds the values of the cells of its extent.
+bool CheckBlock(vtkImageData* image)
+{
+  vtkDataArray* values = image ? image->GetCellData()->GetScalars() : nullptr;
+  if (!values)
+  {
+    return false;
+  }
+  int extent[6];
+  image->GetExtent(extent);
+  vtkIdType cc = 0;
+  for (int k = extent[4]; k < extent[5]; ++k)
+  {
+    for (int j = extent[2]; j < extent[3]; ++j)
+    {
+      for (int i = extent[0]; i < extent[1]; ++i, ++cc)
+      {
+        if (cc >= values->GetNumberOfTuples() || values->GetTuple1(cc) != CellValue(i, j, k))
+        {
+          return false;
+        }
+      }
+    }
+  }
+  return cc == values->GetNumberOfTuples();
+}
+}
+
+int main(int argc, char* argv[])
+{
+  const std::string directory = argc > 1 ? argv[1] : ".";
+  const std::string filename = directory + "/TestParFlowReader.press.00000.pfb";
+
+  // subgrids side by side along i.
+  const int alongI[2] = { 2, 1 };
+  TASSERT(WritePFB(filename, alongI));
+  vtkNew<vtkParFlowReader> reader;
+  reader->SetFileName(filename.c_str());
+  reader->Update();
+  vtkMultiBlockDataSet* output = reader->GetOutput();
+  TASSERT(output->GetNumberOfBlocks() == 2);
+  for (unsigned int cc = 0; cc < 2; ++cc)
+  {
+    vtkImageData* image = vtkImageData::SafeDownCast(output->GetBlock(cc));
+    TASSERT(CheckBlock(image));
+    int extent[6];
+    image->GetExtent(extent);
+    TASSERT(extent[0] == static_cast<int>(2 * cc) && extent[1] == static_cast<int>(2 * cc + 2));
+    TASSERT(extent[2] == 0 && extent[3] == 2);
+  }
+
+  // the same file rewritten with 2 x 2 subgrids: the layout is scanned again.
+  const int alongIJ[2] = { 2, 2 };
+  TASSERT(WritePFB(filename, alongIJ));
+  reader->Modified();
+  reader->Update();
+  output = reader->GetOutput();
+  TASSERT(output->GetNumberOfBlocks() == 4);
+  for (unsigned int cc = 0; cc < 4; ++cc)
+  {
+    vtkImageData* image = vtkImageData::SafeDownCast(output->GetBlock(cc));
+    TASSERT(CheckBlock(image));
+    int extent[6];
+    image->GetExtent(extent);
+    TASSERT(extent[0] == static_cast<int>(2 * (cc % 2)) && extent[2] == static_cast<int>(cc / 2));
+    TASSERT(extent[3] - extent[2] == 1);
+  }
+
+  // each piece only reads its share of the subgrids.
+  reader->UpdatePiece(1, 3, 0);
+  output = reader->GetOutput();
+  TASSERT(output->GetNumberOfBlocks() == 4);
+  TASSERT(output->GetBlock(0) == nullptr && output->GetBlock(2) == nullptr);
+  TASSERT(CheckBlock(vtkImageData::SafeDownCast(output->GetBlock(1))));
+
+  reader->UpdatePiece(2, 3, 0);
+  output = reader->GetOutput();
+  TASSERT(output->GetBlock(0) == nullptr && output->GetBlock(1) == nullptr);
+  TASSERT(CheckBlock(vtkImageData::SafeDownCast(output->GetBlock(2))));
+  TASSERT(CheckBlock(vtkImageData::SafeDownCast(output->GetBlock(3))));
+
+  vtksys::SystemTools::RemoveFile(filename);
+  return EXIT_SUCCESS;
+}
@@ -33,13 +33,17 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "pqActiveObjects.h"
 #include "pqApplicationCore.h"
+#include "pqCoreUtilities.h"
 #include "pqServerManagerModel.h"
 #include "pqUndoStack.h"
 #include "pqUndoStackBuilder.h"
 
+#include "vtkCommand.h"
+#include "vtkPVGeneralSettings.h"
 #include "vtkSMProxyManager.h"
 #include "vtkSMSession.h"
 #include "vtkSMSessionProxyManager.h"
+#include "vtkSMUndoStack.h"
 
 #include <QDebug>
 
@@ -70,4 +74,20 @@ pqUndoRedoBehavior::pqUndoRedoBehavior(QObject* parentObject)
     core->getServerManagerModel(), SIGNAL(serverAdded(pqServer*)), stack, SLOT(clear()));
   QObject::connect(
     core->getServerManagerModel(), SIGNAL(finishedRemovingServer()), stack, SLOT(clear()));
+
+  this->generalSettingsChanged();
+  pqCoreUtilities::connect(vtkPVGeneralSettings::GetInstance(), vtkCommand::ModifiedEvent, this,
+    SLOT(generalSettingsChanged()));
+}
+
+//-----------------------------------------------------------------------------
+void pqUndoRedoBehavior::generalSettingsChanged()
+{
+  pqUndoStack* stack = pqApplicationCore::instance()->getUndoStack();
+  vtkSMUndoStack* undoStack = stack ? stack->GetUndoStackBuilder()->GetUndoStack() : NULL;
+  if (undoStack)
+  {
+    const int limit = vtkPVGeneralSettings::GetInstance()->GetUndoStackMemoryLimit();
+    undoStack->SetMaximumMemorySize(static_cast<size_t>(limit) * 1024 * 1024);
+  }
 }
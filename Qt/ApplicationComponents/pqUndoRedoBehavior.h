@@ -47,7 +47,12 @@ class PQAPPLICATIONCOMPONENTS_EXPORT pqUndoRedoBehavior : public QObject
 public:
   pqUndoRedoBehavior(QObject* parent = 0);
 
-protected:
+protected slots:
+  /**
+  * Applies the undo stack memory limit of the general settings.
+  */
+  void generalSettingsChanged();
+
 private:
   Q_DISABLE_COPY(pqUndoRedoBehavior)
 };
@@ -41,6 +41,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "pqPipelineSource.h"
 #include "pqProxyWidget.h"
 #include "pqSearchBox.h"
+#include "pqServer.h"
 #include "pqServerManagerModel.h"
 #include "pqSettings.h"
 #include "pqTimer.h"
@@ -53,6 +54,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "vtkPVLogger.h"
 #include "vtkSMProperty.h"
 #include "vtkSMProxyClipboard.h"
+#include "vtkSMSession.h"
+#include "vtkSMSessionPushStateBatchScope.h"
 #include "vtkSMSourceProxy.h"
 #include "vtkSMViewProxy.h"
 #include "vtkTimerLog.h"
@@ -823,22 +826,28 @@ void pqPropertiesPanel::apply()
   // they need to do when they lose focus. Workaround for macOS bug #18626.
   this->Internals->Ui.Accept->setFocus();
 
-  if (onlyApplyCurrentPanel)
   {
-    pqProxyWidgets* widgets =
-      this->Internals->Source ? this->Internals->SourceWidgets[this->Internals->Source] : NULL;
-    if (widgets)
+    // Send all property changes to the server together instead of one
+    // message per proxy.
+    pqServer* server = pqActiveObjects::instance().activeServer();
+    vtkSMSessionPushStateBatchScope batch(server ? server->session() : nullptr);
+    if (onlyApplyCurrentPanel)
     {
-      widgets->apply(this->view());
-      emit this->applied(widgets->Proxy);
+      pqProxyWidgets* widgets =
+        this->Internals->Source ? this->Internals->SourceWidgets[this->Internals->Source] : NULL;
+      if (widgets)
+      {
+        widgets->apply(this->view());
+        emit this->applied(widgets->Proxy);
+      }
     }
-  }
-  else
-  {
-    foreach (pqProxyWidgets* widgets, this->Internals->SourceWidgets)
+    else
     {
-      widgets->apply(this->view());
-      emit this->applied(widgets->Proxy);
+      foreach (pqProxyWidgets* widgets, this->Internals->SourceWidgets)
+      {
+        widgets->apply(this->view());
+        emit this->applied(widgets->Proxy);
+      }
     }
   }
 
@@ -47,6 +47,8 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <cmath>
 #include <cstdlib>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 
 #include "CosmoHaloFinder.h"
 
@@ -58,11 +60,64 @@ using namespace std;
 
 namespace cosmotk {
 
+namespace {
+
+/****************************************************************************/
+// Runs f(t) for t in [0, nthreads) with the calling thread taking t == 0
+template <typename F>
+void RunThreads(int nthreads, F f)
+{
+  vector<thread> workers;
+  for (int t = 1; t < nthreads; t++)
+    workers.push_back(thread(f, t));
+  f(0);
+  for (size_t t = 0; t < workers.size(); t++)
+    workers[t].join();
+}
+
+/****************************************************************************/
+// Returns the root of particle i, halving the path on the way.  Parents are
+// never larger than their children so the root is the lowest particle of the
+// set and compressing the path concurrently with other finds is harmless.
+inline int FindRoot(atomic<int>* parent, int i)
+{
+  while (true) {
+    int p = parent[i].load(memory_order_relaxed);
+    if (p == i)
+      return i;
+    int gp = parent[p].load(memory_order_relaxed);
+    if (gp != p)
+      parent[i].compare_exchange_weak(p, gp, memory_order_relaxed);
+    i = gp;
+  }
+}
+
+/****************************************************************************/
+// Unites the sets of particles i and j by hanging the larger root below the
+// smaller one, retrying if another thread moved either root in between
+inline void UniteRoots(atomic<int>* parent, int i, int j)
+{
+  while (true) {
+    i = FindRoot(parent, i);
+    j = FindRoot(parent, j);
+    if (i == j)
+      return;
+    if (i > j)
+      swap(i, j);
+    int expected = j;
+    if (parent[j].compare_exchange_strong(expected, i))
+      return;
+  }
+}
+
+} // END anonymous namespace
+
 /****************************************************************************/
 CosmoHaloFinder::CosmoHaloFinder()
 {
 
   nmin = 1;
+  numThreads = 1;
 }
 
 /****************************************************************************/
@@ -290,6 +345,19 @@ void CosmoHaloFinder::Writing()
 /****************************************************************************/
 void CosmoHaloFinder::Finding()
 {
+  int nthreads = numThreads;
+  if (nthreads <= 0)
+    nthreads = max(1, (int)thread::hardware_concurrency());
+
+  // The threaded path only links pairs and does not count neighbors, and the
+  // cell list is not wrapped around, so nmin > 1 and periodic boxes stay on
+  // the k-d tree.
+  if (nthreads > 1 && nmin < 2 && !periodic && npart > 1) {
+    ThreadedFOF(nthreads);
+    BuildHaloLists();
+    return;
+  }
+
   //
   // REORDER particles based on spatial locality
   //
@@ -345,6 +413,7 @@ void CosmoHaloFinder::Finding()
   }
 
   myFOF(0, npart, dataX);
+  BuildHaloLists();
 
 #ifdef DEBUG
   gettimeofday(&tim, NULL);
@@ -622,4 +691,163 @@ void CosmoHaloFinder::Merge(
   return;
 }
 
+/****************************************************************************/
+void CosmoHaloFinder::ThreadedFOF(int nthreads)
+{
+  //
+  // BIN particles into cells at least bb wide
+  //
+  double lo[numDataDims], hi[numDataDims];
+  for (int d = 0; d < numDataDims; d++) {
+    lo[d] = hi[d] = data[d][0];
+    for (int i = 1; i < npart; i++) {
+      lo[d] = min(lo[d], (double)data[d][i]);
+      hi[d] = max(hi[d], (double)data[d][i]);
+    }
+  }
+
+  // Friends are strictly closer than bb on every axis, the slack keeps the
+  // cell index computation from splitting them further than one cell apart.
+  // Cells grow when bb is small compared to the extent so that the mesh
+  // never has many more cells than particles.
+  double cellSize = max((double)bb * (1.0 + 1.0e-5), 1.0e-30);
+  double maxCells = min(2.0 * npart + 27.0, 1073741824.0);
+  long ncell[numDataDims];
+  while (true) {
+    double total = 1.0;
+    for (int d = 0; d < numDataDims; d++)
+      total *= floor((hi[d] - lo[d]) / cellSize) + 1.0;
+    if (total <= maxCells)
+      break;
+    cellSize *= 1.26;
+  }
+  for (int d = 0; d < numDataDims; d++)
+    ncell[d] = (long)((hi[d] - lo[d]) / cellSize) + 1;
+  long numCells = ncell[dataX] * ncell[dataY] * ncell[dataZ];
+
+  vector<long> cellOf(npart);
+  RunThreads(nthreads, [&](int t) {
+    int first = (int)((long long)npart * t / nthreads);
+    int last = (int)((long long)npart * (t + 1) / nthreads);
+    for (int i = first; i < last; i++) {
+      long c[numDataDims];
+      for (int d = 0; d < numDataDims; d++)
+        c[d] = min(ncell[d] - 1, (long)((data[d][i] - lo[d]) / cellSize));
+      cellOf[i] = (c[dataZ] * ncell[dataY] + c[dataY]) * ncell[dataX] + c[dataX];
+    }
+  });
+
+  // Counting sort keeps the particles of each cell in increasing order
+  vector<int> cellStart(numCells + 1, 0);
+  for (int i = 0; i < npart; i++)
+    cellStart[cellOf[i] + 1]++;
+  for (long c = 0; c < numCells; c++)
+    cellStart[c + 1] += cellStart[c];
+  vector<int> cellParticles(npart);
+  {
+    vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (int i = 0; i < npart; i++)
+      cellParticles[fill[cellOf[i]]++] = i;
+  }
+  cellOf.clear();
+  cellOf.shrink_to_fit();
+
+  //
+  // LINK friends, each cell pairing with itself and half of its neighbors
+  //
+  int offsets[13][numDataDims];
+  int noffsets = 0;
+  for (int dz = -1; dz <= 1; dz++)
+  for (int dy = -1; dy <= 1; dy++)
+  for (int dx = -1; dx <= 1; dx++) {
+    if (dz > 0 || (dz == 0 && (dy > 0 || (dy == 0 && dx > 0)))) {
+      offsets[noffsets][dataX] = dx;
+      offsets[noffsets][dataY] = dy;
+      offsets[noffsets][dataZ] = dz;
+      noffsets++;
+    }
+  }
+
+  vector<atomic<int> > parent(npart);
+  for (int i = 0; i < npart; i++)
+    parent[i].store(i, memory_order_relaxed);
+  atomic<int>* root = &parent[0];
+
+  // Same test as Merge() so that both paths link exactly the same pairs
+  POSVEL_T bb2 = bb*bb;
+  auto link = [&](int ii, int jj) {
+    if (FindRoot(root, ii) == FindRoot(root, jj))
+      return;
+
+    POSVEL_T xdist = fabs(data[dataX][jj] - data[dataX][ii]);
+    POSVEL_T ydist = fabs(data[dataY][jj] - data[dataY][ii]);
+    POSVEL_T zdist = fabs(data[dataZ][jj] - data[dataZ][ii]);
+
+    if ((xdist<bb) && (ydist<bb) && (zdist<bb)) {
+      POSVEL_T dist = xdist*xdist + ydist*ydist + zdist*zdist;
+      if (dist < bb2)
+        UniteRoots(root, ii, jj);
+    }
+  };
+
+  // Halos make the work per cell very uneven so cells are handed out in
+  // small batches
+  const long batch = 64;
+  atomic<long> nextCell(0);
+  RunThreads(nthreads, [&](int) {
+    long first;
+    while ((first = nextCell.fetch_add(batch)) < numCells) {
+      long last = min(first + batch, numCells);
+      for (long c = first; c < last; c++) {
+        long cx = c % ncell[dataX];
+        long cy = (c / ncell[dataX]) % ncell[dataY];
+        long cz = c / (ncell[dataX] * ncell[dataY]);
+
+        for (int a = cellStart[c]; a < cellStart[c + 1]; a++) {
+          int ii = cellParticles[a];
+          for (int b = a + 1; b < cellStart[c + 1]; b++)
+            link(ii, cellParticles[b]);
+        }
+
+        for (int o = 0; o < noffsets; o++) {
+          long nx = cx + offsets[o][dataX];
+          long ny = cy + offsets[o][dataY];
+          long nz = cz + offsets[o][dataZ];
+          if (nx < 0 || nx >= ncell[dataX] ||
+              ny < 0 || ny >= ncell[dataY] ||
+              nz < 0 || nz >= ncell[dataZ])
+            continue;
+          long n = (nz * ncell[dataY] + ny) * ncell[dataX] + nx;
+          for (int a = cellStart[c]; a < cellStart[c + 1]; a++) {
+            int ii = cellParticles[a];
+            for (int b = cellStart[n]; b < cellStart[n + 1]; b++)
+              link(ii, cellParticles[b]);
+          }
+        }
+      }
+    }
+  });
+
+  // The root of every set is its lowest particle which is the halo tag
+  RunThreads(nthreads, [&](int t) {
+    int first = (int)((long long)npart * t / nthreads);
+    int last = (int)((long long)npart * (t + 1) / nthreads);
+    for (int i = first; i < last; i++)
+      ht[i] = FindRoot(root, i);
+  });
+}
+
+/****************************************************************************/
+void CosmoHaloFinder::BuildHaloLists()
+{
+  // Walking backwards and pushing on the front leaves every list in
+  // increasing particle order starting at the halo tag
+  for (int i = 0; i < npart; i++)
+    halo[i] = -1;
+  for (int i = npart - 1; i >= 0; i--) {
+    nextp[i] = halo[ht[i]];
+    halo[ht[i]] = i;
+  }
+}
+
 } // END namespace cosmotk
@@ -102,6 +102,19 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // particle is constantly altered so that each particle knows what halo it
 // is part of, and that halo tag is the id of the lowest particle in the halo.
 //
+// When more than one thread is requested (see setNumberOfThreads()) and
+// neither periodic boundaries nor nmin > 1 are in use, the k-d tree walk is
+// replaced by a threaded friends-of-friends over a cell list.  Particles are
+// binned into cells at least bb wide so that friends are always found in the
+// 27 neighboring cells, and every thread links the pairs of the cells it owns
+// into a shared lock-free union-find.  Unions always hang the larger root
+// below the smaller one, so the root of each set is its lowest particle,
+// which is exactly the halo tag computed by the serial path.
+//
+// Either way the halo lists are rebuilt at the end in increasing particle
+// order, so halo[] and nextp[] do not depend on the order merges happened in
+// and both paths produce identical output.
+//
 
 #ifndef CosmoHaloFinder_h
 #define CosmoHaloFinder_h
@@ -177,6 +190,11 @@ public:
   void setNumberOfParticles(int n)      { npart = n; }
   void setMyProc(int r)                 { myProc = r; }
 
+  // Number of threads used to link particles, 0 uses all hardware threads
+  // and 1 runs the serial k-d tree halo finder
+  void setNumberOfThreads(int n)        { numThreads = n; }
+  int  getNumberOfThreads()             { return numThreads; }
+
   // For standalone serial halo finder
   POSVEL_T* getXLoc()                   { return xx; }
   POSVEL_T* getYLoc()                   { return yy; }
@@ -207,6 +225,7 @@ private:
   // internal state
   int npart, nhalo, nhalopart;
   int myProc;
+  int numThreads;
 
   // data[][] stores xx[], yy[], zz[].
   POSVEL_T *data[numDataDims];
@@ -232,6 +251,12 @@ private:
   // Recurses through the k-d tree merging particles to create halos
   void myFOF(int, int, int);
   void Merge(int, int, int, int, int);
+
+  // Links particles with a threaded union-find over a cell list
+  void ThreadedFOF(int nthreads);
+
+  // Rebuilds halo[] and nextp[] from ht[] in increasing particle order
+  void BuildHaloLists();
 };
 
 } // END cosmotk namespace
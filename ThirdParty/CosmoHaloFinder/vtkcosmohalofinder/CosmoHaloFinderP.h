@@ -107,6 +107,10 @@ public:
                                 // which define a single halo
         int nmin = 1);          // The minimum number of neighbors for linking
 
+  // Set the number of threads the serial halo finder links particles with,
+  // 0 uses all hardware threads
+  void setNumberOfThreads(int n)        { this->haloFinder.setNumberOfThreads(n); }
+
   // Execute the serial halo finder for this processor
   void executeHaloFinder();
 
@@ -0,0 +1,257 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestImageEncoderPool.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Tests the pool compressing the images of vtkPVWebApplication: the latest
+// image of a view replaces the one still queued, the images of a view are
+// compressed in order, stopping or resizing the pool compresses the queued
+// images first, and uncompressed and LZ4 payloads hold the pixels top row
+// first.
+#include "vtkPVWebApplicationInternal.h"
+
+#include <chrono>
+
+#define TASSERT(x)                                                                                 \
+  if (!(x))                                                                                        \
+  {                                                                                                \
+    cerr << "ERROR: failed at " << __LINE__ << "!" << endl;                                        \
+    return EXIT_FAILURE;                                                                           \
+  }
+
+using vtkPVWebApplication_detail::ImageEncoderPool;
+
+namespace
+{
+// Single pixel image identifying a frame.
+vtkSmartPointer<vtkImageData> MakeFrame(unsigned char id)
+{
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(1, 1, 1);
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+  unsigned char* pixel = static_cast<unsigned char*>(image->GetScalarPointer());
+  pixel[0] = pixel[1] = pixel[2] = id;
+  return image;
+}
+
+unsigned char GetFrameId(const ImageEncoderPool::Frame& frame)
+{
+  return frame.Data && frame.Data->GetNumberOfValues() == 1 ? frame.Data->GetValue(0) : 0;
+}
+
+// Compresses frames made by MakeFrame into their id, recording the frames
+// compressed. Frames can be blocked so that their compression only ends once
+// they are released.
+class FakeCompressor
+{
+public:
+  vtkSmartPointer<vtkUnsignedCharArray> Compress(vtkImageData* image)
+  {
+    const unsigned char id = static_cast<unsigned char*>(image->GetScalarPointer())[0];
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->Started.insert(id);
+    this->Changed.notify_all();
+    this->Changed.wait(lock, [&] { return this->Blocked.find(id) == this->Blocked.end(); });
+    this->Compressed.push_back(id);
+    vtkSmartPointer<vtkUnsignedCharArray> data = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    data->InsertNextValue(id);
+    return data;
+  }
+
+  std::vector<unsigned char> GetCompressed()
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    return this->Compressed;
+  }
+
+  bool HasStarted(unsigned char id)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    return this->Started.find(id) != this->Started.end();
+  }
+
+  void Block(unsigned char id)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Blocked.insert(id);
+  }
+
+  void Release(unsigned char id)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Blocked.erase(id);
+    this->Changed.notify_all();
+  }
+
+  void WaitForStart(unsigned char id)
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->Changed.wait(lock, [&] { return this->Started.find(id) != this->Started.end(); });
+  }
+
+private:
+  std::mutex Mutex;
+  std::condition_variable Changed;
+  std::vector<unsigned char> Compressed;
+  std::set<unsigned char> Started;
+  std::set<unsigned char> Blocked;
+};
+
+int TestPayloads()
+{
+  // pixel values identify the column, the row and the component.
+  const int dims[2] = { 4, 3 };
+  vtkNew<vtkImageData> image;
+  image->SetDimensions(dims[0], dims[1], 1);
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+  unsigned char* pixels = static_cast<unsigned char*>(image->GetScalarPointer());
+  for (int row = 0; row < dims[1]; ++row)
+  {
+    for (int col = 0; col < dims[0]; ++col)
+    {
+      for (int comp = 0; comp < 3; ++comp)
+      {
+        pixels[(row * dims[0] + col) * 3 + comp] =
+          static_cast<unsigned char>(row * 100 + col * 10 + comp);
+      }
+    }
+  }
+  const size_t size = static_cast<size_t>(dims[0] * dims[1] * 3);
+
+  // without threads, images are compressed in Push.
+  ImageEncoderPool pool;
+  TASSERT(pool.GetNumberOfThreads() == 0);
+  ImageEncoderPool::Frame frame;
+  pool.Push(1, image.GetPointer(), vtkPVWebApplication::COMPRESSION_NONE, 100, 0.5);
+  TASSERT(pool.GetLatestOutput(1, frame));
+  TASSERT(frame.CaptureTime == 0.5);
+  vtkSmartPointer<vtkUnsignedCharArray> raw = frame.Data;
+  TASSERT(raw != nullptr && raw->GetNumberOfValues() == static_cast<vtkIdType>(size));
+  for (int row = 0; row < dims[1]; ++row)
+  {
+    // top row first.
+    TASSERT(memcmp(raw->GetPointer(row * dims[0] * 3),
+              pixels + (dims[1] - 1 - row) * dims[0] * 3, dims[0] * 3) == 0);
+  }
+
+  pool.Push(1, image.GetPointer(), vtkPVWebApplication::COMPRESSION_LZ4, 100, 0.0);
+  TASSERT(pool.GetLatestOutput(1, frame));
+  TASSERT(frame.Data != nullptr && frame.Data != raw);
+  vtkNew<vtkLZ4DataCompressor> compressor;
+  vtkSmartPointer<vtkUnsignedCharArray> uncompressed;
+  uncompressed.TakeReference(compressor->Uncompress(
+    frame.Data->GetPointer(0), static_cast<size_t>(frame.Data->GetNumberOfValues()), size));
+  TASSERT(uncompressed != nullptr &&
+    uncompressed->GetNumberOfValues() == static_cast<vtkIdType>(size));
+  TASSERT(memcmp(uncompressed->GetPointer(0), raw->GetPointer(0), size) == 0);
+
+  const unsigned char pngSignature[4] = { 0x89, 'P', 'N', 'G' };
+  pool.Push(1, image.GetPointer(), vtkPVWebApplication::COMPRESSION_PNG, 100, 0.0);
+  TASSERT(pool.GetLatestOutput(1, frame));
+  TASSERT(frame.Data != nullptr && frame.Data->GetNumberOfValues() > 4);
+  TASSERT(memcmp(frame.Data->GetPointer(0), pngSignature, 4) == 0);
+
+  pool.Push(1, image.GetPointer(), vtkPVWebApplication::COMPRESSION_JPEG, 50, 0.0);
+  TASSERT(pool.GetLatestOutput(1, frame));
+  TASSERT(frame.Data != nullptr && frame.Data->GetNumberOfValues() > 2);
+  TASSERT(frame.Data->GetValue(0) == 0xFF && frame.Data->GetValue(1) == 0xD8);
+  return EXIT_SUCCESS;
+}
+
+int TestThreads()
+{
+  FakeCompressor compressor;
+  ImageEncoderPool pool(
+    [&](vtkImageData* image, int, int) { return compressor.Compress(image); });
+  pool.SetNumberOfThreads(2);
+  TASSERT(pool.GetNumberOfThreads() == 2);
+  ImageEncoderPool::Frame frame;
+
+  // the latest frame wins: frames pushed while one is compressed replace
+  // each other.
+  compressor.Block(1);
+  pool.Push(7, MakeFrame(1), vtkPVWebApplication::COMPRESSION_NONE, 100, 0.0);
+  compressor.WaitForStart(1);
+  pool.Push(7, MakeFrame(2), vtkPVWebApplication::COMPRESSION_NONE, 100, 0.0);
+  pool.Push(7, MakeFrame(3), vtkPVWebApplication::COMPRESSION_NONE, 100, 0.0);
+  pool.Push(7, MakeFrame(4), vtkPVWebApplication::COMPRESSION_NONE, 100, 0.0);
+  TASSERT(pool.GetNumberOfDroppedFrames(7) == 2);
+  TASSERT(!pool.GetLatestOutput(7, frame));
+  compressor.Release(1);
+  pool.Flush(7);
+  TASSERT(pool.GetLatestOutput(7, frame));
+  TASSERT(GetFrameId(frame) == 4);
+  TASSERT(compressor.GetCompressed() == std::vector<unsigned char>({ 1, 4 }));
+
+  // frames of a view are compressed one after the other, while the other
+  // views go on.
+  compressor.Block(11);
+  pool.Push(1, MakeFrame(11), vtkPVWebApplication::COMPRESSION_NONE, 100, 0.0);
+  compressor.WaitForStart(11);
+  pool.Push(1, MakeFrame(12), vtkPVWebApplication::COMPRESSION_NONE, 100, 0.0);
+  pool.Push(2, MakeFrame(21), vtkPVWebApplication::COMPRESSION_NONE, 100, 0.0);
+  pool.Flush(2);
+  TASSERT(pool.GetLatestOutput(2, frame));
+  TASSERT(GetFrameId(frame) == 21);
+  TASSERT(!compressor.HasStarted(12));
+  TASSERT(pool.GetNumberOfDroppedFrames(1) == 0);
+  compressor.Release(11);
+  pool.Flush(1);
+  TASSERT(pool.GetLatestOutput(1, frame));
+  TASSERT(GetFrameId(frame) == 12);
+  TASSERT(compressor.GetCompressed() == std::vector<unsigned char>({ 1, 4, 21, 11, 12 }));
+
+  // resizing the pool compresses the queued frames first.
+  compressor.Block(31);
+  pool.Push(3, MakeFrame(31), vtkPVWebApplication::COMPRESSION_NONE, 100, 0.0);
+  compressor.WaitForStart(31);
+  pool.Push(3, MakeFrame(32), vtkPVWebApplication::COMPRESSION_NONE, 100, 0.0);
+  pool.Push(4, MakeFrame(41), vtkPVWebApplication::COMPRESSION_NONE, 100, 0.0);
+  std::thread release([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    compressor.Release(31);
+  });
+  pool.SetNumberOfThreads(1);
+  release.join();
+  TASSERT(pool.GetNumberOfThreads() == 1);
+  TASSERT(pool.GetLatestOutput(3, frame));
+  TASSERT(GetFrameId(frame) == 32);
+  TASSERT(pool.GetLatestOutput(4, frame));
+  TASSERT(GetFrameId(frame) == 41);
+
+  // so does stopping it, after which frames are compressed in Push.
+  compressor.Block(51);
+  pool.Push(5, MakeFrame(51), vtkPVWebApplication::COMPRESSION_NONE, 100, 0.0);
+  compressor.WaitForStart(51);
+  pool.Push(5, MakeFrame(52), vtkPVWebApplication::COMPRESSION_NONE, 100, 0.0);
+  release = std::thread([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    compressor.Release(51);
+  });
+  pool.Stop();
+  release.join();
+  TASSERT(pool.GetNumberOfThreads() == 0);
+  TASSERT(pool.GetLatestOutput(5, frame));
+  TASSERT(GetFrameId(frame) == 52);
+  pool.Push(5, MakeFrame(53), vtkPVWebApplication::COMPRESSION_NONE, 100, 0.0);
+  TASSERT(pool.GetLatestOutput(5, frame));
+  TASSERT(GetFrameId(frame) == 53);
+  return EXIT_SUCCESS;
+}
+}
+
+int TestImageEncoderPool(int, char* [])
+{
+  TASSERT(TestPayloads() == EXIT_SUCCESS);
+  TASSERT(TestThreads() == EXIT_SUCCESS);
+  return EXIT_SUCCESS;
+}
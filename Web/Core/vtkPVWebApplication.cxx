@@ -17,14 +17,11 @@
 #include "vtkBase64Utilities.h"
 #include "vtkCamera.h"
 #include "vtkCommand.h"
-#include "vtkDataEncoder.h"
 #include "vtkImageData.h"
-#include "vtkJPEGWriter.h"
 #include "vtkNew.h"
 #include "vtkObjectFactory.h"
-#include "vtkPNGWriter.h"
 #include "vtkPVRenderView.h"
-#include "vtkPointData.h"
+#include "vtkPVWebApplicationInternal.h"
 #include "vtkRenderWindow.h"
 #include "vtkRenderWindowInteractor.h"
 #include "vtkRendererCollection.h"
@@ -39,17 +36,23 @@
 #include "vtkWebGLObject.h"
 #include "vtkWebInteractionEvent.h"
 
-#include <assert.h>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <map>
 
+using vtkPVWebApplication_detail::ImageEncoderPool;
+
 class vtkPVWebApplication::vtkInternals
 {
 public:
   struct ImageCacheValueType
   {
   public:
-    vtkSmartPointer<vtkUnsignedCharArray> Data;
+    ImageEncoderPool::Frame Frame;
+    // base64 encoding of Frame.Data, made when asked for
+    vtkSmartPointer<vtkUnsignedCharArray> Encoded;
+    vtkSmartPointer<vtkUnsignedCharArray> EncodedSource;
     bool NeedsRender;
     bool HasImagesBeingProcessed;
     vtkObject* ViewPointer;
@@ -100,7 +103,7 @@ public:
   typedef std::map<void*, unsigned int> ButtonStatesType;
   ButtonStatesType ButtonStates;
 
-  vtkNew<vtkDataEncoder> Encoder;
+  ImageEncoderPool Encoder;
 
   // WebGL related struct
   struct WebGLObjCacheValue
@@ -108,6 +111,7 @@ public:
   public:
     int ObjIndex;
     std::map<int, std::string> BinaryParts;
+    std::map<int, vtkSmartPointer<vtkUnsignedCharArray> > RawParts;
   };
   // map for <vtkWebGLExporter, <webgl-objID, WebGLObjCacheValue> >
   typedef std::map<std::string, WebGLObjCacheValue> WebGLObjId2IndexMap;
@@ -115,8 +119,91 @@ public:
   // map for <vtkSMViewProxy, vtkWebGLExporter>
   std::map<vtkSMViewProxy*, vtkSmartPointer<vtkWebGLExporter> > ViewWebGLMap;
   std::string LastAllWebGLBinaryObjects;
+
+  /**
+   * Renders a view, or reuses its last image when nothing changed, and returns
+   * the compressed image.
+   */
+  vtkUnsignedCharArray* Render(vtkPVWebApplication* self, vtkSMViewProxy* view, int quality);
+
+  /**
+   * Returns the cached WebGL object part, generating the scene metadata first
+   * if needed.
+   */
+  WebGLObjCacheValue* GetWebGLPart(
+    vtkPVWebApplication* self, vtkSMViewProxy* view, const char* id, int part);
 };
 
+//----------------------------------------------------------------------------
+vtkUnsignedCharArray* vtkPVWebApplication::vtkInternals::Render(
+  vtkPVWebApplication* self, vtkSMViewProxy* view, int quality)
+{
+  ImageCacheValueType& value = this->ImageCache[view];
+  value.SetListener(view);
+
+  const vtkTypeUInt32 key = view->GetGlobalID();
+  if (value.NeedsRender == false && value.Frame.Data != NULL && view->GetNeedsUpdate() == false)
+  {
+    // an image being compressed may have finished since.
+    value.HasImagesBeingProcessed = !this->Encoder.GetLatestOutput(key, value.Frame);
+    return value.Frame.Data;
+  }
+
+  const double start = vtkTimerLog::GetUniversalTime();
+  vtkSmartPointer<vtkImageData> image;
+  image.TakeReference(view->CaptureWindow(1));
+  if (!image)
+  {
+    vtkErrorWithObjectMacro(self, "Failed to capture view: " << view);
+    return value.Frame.Data;
+  }
+  image->GetDimensions(self->LastStillRenderImageSize);
+  this->Encoder.Push(
+    key, image, self->ImageCompression, quality, vtkTimerLog::GetUniversalTime() - start);
+  image = nullptr;
+
+  if (value.Frame.Data == NULL)
+  {
+    // we need to wait till output is processed.
+    this->Encoder.Flush(key);
+  }
+
+  value.HasImagesBeingProcessed = !this->Encoder.GetLatestOutput(key, value.Frame);
+  value.NeedsRender = false;
+  return value.Frame.Data;
+}
+
+//----------------------------------------------------------------------------
+vtkPVWebApplication::vtkInternals::WebGLObjCacheValue*
+vtkPVWebApplication::vtkInternals::GetWebGLPart(
+  vtkPVWebApplication* self, vtkSMViewProxy* view, const char* id, int part)
+{
+  if (this->ViewWebGLMap.find(view) == this->ViewWebGLMap.end())
+  {
+    if (self->GetWebGLSceneMetaData(view) == NULL)
+    {
+      vtkErrorWithObjectMacro(self, "Failed to generate WebGL MetaData for: " << view);
+      return NULL;
+    }
+  }
+
+  vtkWebGLExporter* webglExporter = this->ViewWebGLMap[view];
+  if (webglExporter == NULL)
+  {
+    vtkErrorWithObjectMacro(self, "There is no cached WebGL Exporter for: " << view);
+    return NULL;
+  }
+
+  WebGLObjId2IndexMap& objects = this->WebGLExporterObjIdMap[webglExporter];
+  auto iter = objects.find(id);
+  if (iter == objects.end() ||
+    iter->second.BinaryParts.find(part) == iter->second.BinaryParts.end())
+  {
+    return NULL;
+  }
+  return &iter->second;
+}
+
 vtkStandardNewMacro(vtkPVWebApplication);
 //----------------------------------------------------------------------------
 vtkPVWebApplication::vtkPVWebApplication()
@@ -124,6 +211,7 @@ vtkPVWebApplication::vtkPVWebApplication()
   , ImageCompression(COMPRESSION_JPEG)
   , Internals(new vtkPVWebApplication::vtkInternals())
 {
+  this->Internals->Encoder.SetNumberOfThreads(3);
 }
 
 //----------------------------------------------------------------------------
@@ -140,6 +228,47 @@ bool vtkPVWebApplication::GetHasImagesBeingProcessed(vtkSMViewProxy* view)
   return value.HasImagesBeingProcessed;
 }
 
+//----------------------------------------------------------------------------
+void vtkPVWebApplication::SetNumberOfEncoderThreads(int count)
+{
+  count = std::max(count, 0);
+  if (count != this->Internals->Encoder.GetNumberOfThreads())
+  {
+    this->Internals->Encoder.SetNumberOfThreads(count);
+    this->Modified();
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkPVWebApplication::GetNumberOfEncoderThreads()
+{
+  return this->Internals->Encoder.GetNumberOfThreads();
+}
+
+//----------------------------------------------------------------------------
+double vtkPVWebApplication::GetLastCaptureTime(vtkSMViewProxy* view)
+{
+  return this->Internals->ImageCache[view].Frame.CaptureTime;
+}
+
+//----------------------------------------------------------------------------
+double vtkPVWebApplication::GetLastQueueTime(vtkSMViewProxy* view)
+{
+  return this->Internals->ImageCache[view].Frame.QueueTime;
+}
+
+//----------------------------------------------------------------------------
+double vtkPVWebApplication::GetLastEncodeTime(vtkSMViewProxy* view)
+{
+  return this->Internals->ImageCache[view].Frame.EncodeTime;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkPVWebApplication::GetNumberOfDroppedFrames(vtkSMViewProxy* view)
+{
+  return view ? this->Internals->Encoder.GetNumberOfDroppedFrames(view->GetGlobalID()) : 0;
+}
+
 //----------------------------------------------------------------------------
 vtkUnsignedCharArray* vtkPVWebApplication::InteractiveRender(vtkSMViewProxy* view, int quality)
 {
@@ -161,71 +290,29 @@ vtkUnsignedCharArray* vtkPVWebApplication::StillRender(vtkSMViewProxy* view, int
     vtkErrorMacro("No view specified.");
     return NULL;
   }
-  // threading can be tricky to debug -
-  bool doThread = true;
 
-  vtkInternals::ImageCacheValueType& value = this->Internals->ImageCache[view];
-  value.SetListener(view);
-
-  if (value.NeedsRender == false && value.Data != NULL && view->GetNeedsUpdate() == false)
+  vtkUnsignedCharArray* data = this->Internals->Render(this, view, quality);
+  if (data == NULL || this->ImageEncoding != ENCODING_BASE64)
   {
-    // cout <<  "Reusing cache" << endl;
-    if (doThread)
-    {
-      bool latest = this->Internals->Encoder->GetLatestOutput(view->GetGlobalID(), value.Data);
-      value.HasImagesBeingProcessed = !latest;
-    }
-    else
-    {
-      value.HasImagesBeingProcessed = false;
-    }
-    return value.Data;
+    return data;
   }
 
-  // cout <<  "Regenerating " << endl;
-  // vtkTimerLog::ResetLog();
-  // vtkTimerLog::CleanupLog();
-  // vtkTimerLog::MarkStartEvent("StillRenderToString");
-  // vtkTimerLog::MarkStartEvent("CaptureWindow");
-
-  // TODO: We should add logic to check if a new rendering needs to be done and
-  // then alone do a new rendering otherwise use the cached image.
-  vtkImageData* image = view->CaptureWindow(1);
-  image->GetDimensions(this->LastStillRenderImageSize);
-  // vtkTimerLog::MarkEndEvent("CaptureWindow");
-
-  // vtkTimerLog::MarkEndEvent("StillRenderToString");
-  // vtkTimerLog::DumpLogWithIndents(&cout, 0.0);
-
-  if (doThread || this->ImageEncoding)
-  {
-    this->Internals->Encoder->PushAndTakeReference(
-      view->GetGlobalID(), image, quality, this->ImageEncoding);
-    assert(image == NULL);
-
-    if (value.Data == NULL)
-    {
-      // we need to wait till output is processed.
-      // cout << "Flushing" << endl;
-      this->Internals->Encoder->Flush(view->GetGlobalID());
-      // cout << "Done Flushing" << endl;
-    }
-
-    bool latest = this->Internals->Encoder->GetLatestOutput(view->GetGlobalID(), value.Data);
-    value.HasImagesBeingProcessed = !latest;
-  }
-  else
+  // base64 encode each image once, null terminated for StillRenderToString.
+  vtkInternals::ImageCacheValueType& value = this->Internals->ImageCache[view];
+  if (value.EncodedSource != data)
   {
-    vtkNew<vtkJPEGWriter> writer;
-    writer->WriteToMemoryOn();
-    writer->SetInputData(image);
-    writer->SetQuality(quality);
-    writer->Write();
-    // smart pointer does the right thing, even if Data was null
-    value.Data = writer->GetResult();
+    const vtkIdType size = data->GetNumberOfValues();
+    value.Encoded = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    value.Encoded->SetNumberOfValues(4 * ((size + 2) / 3) + 1);
+    vtkNew<vtkBase64Utilities> base64;
+    const unsigned long length =
+      base64->Encode(data->GetPointer(0), static_cast<unsigned long>(size),
+        value.Encoded->GetPointer(0), false);
+    value.Encoded->SetValue(length, 0);
+    value.Encoded->SetNumberOfValues(length + 1);
+    value.EncodedSource = data;
   }
-  value.NeedsRender = false;
-  return value.Data;
+  return value.Encoded;
 }
 
 //----------------------------------------------------------------------------
@@ -246,7 +333,12 @@ const char* vtkPVWebApplication::StillRenderToString(
 vtkUnsignedCharArray* vtkPVWebApplication::StillRenderToBuffer(
   vtkSMViewProxy* view, unsigned long time, int quality)
 {
-  vtkUnsignedCharArray* array = this->StillRender(view, quality);
+  if (!view)
+  {
+    vtkErrorMacro("No view specified.");
+    return NULL;
+  }
+  vtkUnsignedCharArray* array = this->Internals->Render(this, view, quality);
   if (array && array->GetMTime() != time)
   {
     this->LastStillRenderToMTime = array->GetMTime();
@@ -386,54 +478,67 @@ const char* vtkPVWebApplication::GetWebGLBinaryData(vtkSMViewProxy* view, const
     vtkErrorMacro("No view specified.");
     return NULL;
   }
-  if (this->Internals->ViewWebGLMap.find(view) == this->Internals->ViewWebGLMap.end())
+
+  vtkInternals::WebGLObjCacheValue* cachedVal =
+    this->Internals->GetWebGLPart(this, view, id, part);
+  if (cachedVal == NULL)
+  {
+    return NULL;
+  }
+  if (cachedVal->BinaryParts[part].empty())
   {
-    if (this->GetWebGLSceneMetaData(view) == NULL)
+    vtkWebGLExporter* webglExporter = this->Internals->ViewWebGLMap[view];
+    vtkWebGLObject* obj = webglExporter->GetWebGLObject(cachedVal->ObjIndex);
+    if (obj && obj->isVisible())
     {
-      vtkErrorMacro("Failed to generate WebGL MetaData for: " << view);
-      return NULL;
+      // Manage Base64
+      vtkNew<vtkBase64Utilities> base64;
+      unsigned char* output = new unsigned char[obj->GetBinarySize(part) * 2];
+      int size = base64->Encode(obj->GetBinaryData(part), obj->GetBinarySize(part), output, false);
+      cachedVal->BinaryParts[part] = std::string((const char*)output, size);
+      delete[] output;
     }
   }
+  return cachedVal->BinaryParts[part].c_str();
+}
 
-  vtkWebGLExporter* webglExporter = this->Internals->ViewWebGLMap[view];
-  if (webglExporter == NULL)
+//----------------------------------------------------------------------------
+vtkUnsignedCharArray* vtkPVWebApplication::GetWebGLBinaryBuffer(
+  vtkSMViewProxy* view, const char* id, int part)
+{
+  if (!view)
   {
-    vtkErrorMacro("There is no cached WebGL Exporter for: " << view);
+    vtkErrorMacro("No view specified.");
     return NULL;
   }
 
-  if (this->Internals->WebGLExporterObjIdMap[webglExporter].size() > 0 &&
-    this->Internals->WebGLExporterObjIdMap[webglExporter].find(id) !=
-      this->Internals->WebGLExporterObjIdMap[webglExporter].end())
+  vtkInternals::WebGLObjCacheValue* cachedVal =
+    this->Internals->GetWebGLPart(this, view, id, part);
+  if (cachedVal == NULL)
   {
-    vtkInternals::WebGLObjCacheValue* cachedVal =
-      &(this->Internals->WebGLExporterObjIdMap[webglExporter][id]);
-    if (cachedVal->BinaryParts.find(part) != cachedVal->BinaryParts.end())
+    return NULL;
+  }
+  vtkSmartPointer<vtkUnsignedCharArray>& buffer = cachedVal->RawParts[part];
+  if (buffer == NULL)
+  {
+    vtkWebGLExporter* webglExporter = this->Internals->ViewWebGLMap[view];
+    vtkWebGLObject* obj = webglExporter->GetWebGLObject(cachedVal->ObjIndex);
+    if (obj && obj->isVisible())
     {
-      if (cachedVal->BinaryParts[part].empty())
-      {
-        vtkWebGLObject* obj = webglExporter->GetWebGLObject(cachedVal->ObjIndex);
-        if (obj && obj->isVisible())
-        {
-          // Manage Base64
-          vtkNew<vtkBase64Utilities> base64;
-          unsigned char* output = new unsigned char[obj->GetBinarySize(part) * 2];
-          int size =
-            base64->Encode(obj->GetBinaryData(part), obj->GetBinarySize(part), output, false);
-          cachedVal->BinaryParts[part] = std::string((const char*)output, size);
-          delete[] output;
-        }
-      }
-      return cachedVal->BinaryParts[part].c_str();
+      buffer = vtkSmartPointer<vtkUnsignedCharArray>::New();
+      buffer->SetNumberOfValues(obj->GetBinarySize(part));
+      memcpy(buffer->GetPointer(0), obj->GetBinaryData(part), obj->GetBinarySize(part));
     }
   }
-
-  return NULL;
+  return buffer;
 }
+
 //----------------------------------------------------------------------------
 void vtkPVWebApplication::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
   os << indent << "ImageEncoding: " << this->ImageEncoding << endl;
   os << indent << "ImageCompression: " << this->ImageCompression << endl;
+  os << indent << "NumberOfEncoderThreads: " << this->Internals->Encoder.GetNumberOfThreads()
+     << endl;
 }
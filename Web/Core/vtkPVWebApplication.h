@@ -19,6 +19,14 @@
  * vtkPVWebApplication defines the core interface for a ParaViewWeb application.
  * This exposes methods that make it easier to manage views and rendered images
  * from views.
+ *
+ * Rendered images are compressed by a pool of threads (see
+ * SetNumberOfEncoderThreads) while the application goes on. Only the latest
+ * image of a view waits to be compressed: a new image replaces the one still
+ * queued for that view, so slow compression drops frames instead of delaying
+ * them. StillRenderToBuffer() and GetWebGLBinaryBuffer() return raw binary
+ * data for delivery as binary WebSocket messages, while StillRenderToString()
+ * and GetWebGLBinaryData() return base64 text.
 */
 
 #ifndef vtkPVWebApplication_h
@@ -59,15 +67,30 @@ public:
   {
     COMPRESSION_NONE = 0,
     COMPRESSION_PNG = 1,
-    COMPRESSION_JPEG = 2
+    COMPRESSION_JPEG = 2,
+    COMPRESSION_LZ4 = 3
   };
-  vtkSetClampMacro(ImageCompression, int, COMPRESSION_NONE, COMPRESSION_JPEG);
+  vtkSetClampMacro(ImageCompression, int, COMPRESSION_NONE, COMPRESSION_LZ4);
   vtkGetMacro(ImageCompression, int);
   //@}
 
   //@{
   /**
-   * Render a view and obtain the rendered image.
+   * Set the number of threads compressing rendered images. With 0, images are
+   * compressed by the thread rendering them. Default is 3.
+   */
+  void SetNumberOfEncoderThreads(int);
+  int GetNumberOfEncoderThreads();
+  //@}
+
+  //@{
+  /**
+   * Render a view and obtain the rendered image. Images are compressed as set
+   * by ImageCompression: COMPRESSION_JPEG uses `quality`, COMPRESSION_NONE
+   * gives the RGB pixels with the top row first and COMPRESSION_LZ4 gives the
+   * same pixels compressed as an LZ4 block. StillRender() and
+   * StillRenderToString() then apply ImageEncoding while StillRenderToBuffer()
+   * always returns the compressed image, without base64 encoding.
    */
   vtkUnsignedCharArray* StillRender(vtkSMViewProxy* view, int quality = 100);
   vtkUnsignedCharArray* InteractiveRender(vtkSMViewProxy* view, int quality = 50);
@@ -83,6 +106,23 @@ public:
    */
   bool GetHasImagesBeingProcessed(vtkSMViewProxy*);
 
+  //@{
+  /**
+   * Timings, in seconds, of the image last returned for a view: the time taken
+   * to render and capture it, the time it waited for an encoder thread and the
+   * time taken to compress it.
+   */
+  double GetLastCaptureTime(vtkSMViewProxy* view);
+  double GetLastQueueTime(vtkSMViewProxy* view);
+  double GetLastEncodeTime(vtkSMViewProxy* view);
+  //@}
+
+  /**
+   * Number of images of a view that were replaced by a newer one before being
+   * compressed.
+   */
+  vtkIdType GetNumberOfDroppedFrames(vtkSMViewProxy* view);
+
   /**
    * Communicate mouse interaction to a view.
    * Returns true if the interaction changed the view state, otherwise returns false.
@@ -114,6 +154,12 @@ public:
    */
   const char* GetWebGLBinaryData(vtkSMViewProxy* view, const char* id, int partIndex);
 
+  /**
+   * Same as GetWebGLBinaryData() but returns the binary data itself, without
+   * base64 encoding.
+   */
+  vtkUnsignedCharArray* GetWebGLBinaryBuffer(vtkSMViewProxy* view, const char* id, int partIndex);
+
   //@{
   /**
    * Return the size of the last image exported.
@@ -0,0 +1,294 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVWebApplicationInternal.h
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Image compression pool of vtkPVWebApplication. This header is private; it is
+// only included by vtkPVWebApplication.cxx and its tests.
+#ifndef vtkPVWebApplicationInternal_h
+#define vtkPVWebApplicationInternal_h
+
+#include "vtkImageData.h"
+#include "vtkJPEGWriter.h"
+#include "vtkLZ4DataCompressor.h"
+#include "vtkNew.h"
+#include "vtkPNGWriter.h"
+#include "vtkPVWebApplication.h"
+#include "vtkPointData.h"
+#include "vtkSmartPointer.h"
+#include "vtkTimerLog.h"
+#include "vtkUnsignedCharArray.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace vtkPVWebApplication_detail
+{
+/**
+ * Compresses the images rendered for the views on a pool of threads. Only the
+ * latest image of each view waits to be compressed: pushing an image replaces
+ * the one still queued for the same view. Images of a view are compressed one
+ * at a time, so its output only moves forward. Without threads, images are
+ * compressed in Push.
+ *
+ * Images are compressed as requested by vtkPVWebApplication::ImageCompression
+ * unless another compression function is given, e.g. by tests.
+ */
+class ImageEncoderPool
+{
+public:
+  struct Frame
+  {
+    vtkSmartPointer<vtkUnsignedCharArray> Data;
+    double CaptureTime = 0.0;
+    double QueueTime = 0.0;
+    double EncodeTime = 0.0;
+  };
+
+  typedef std::function<vtkSmartPointer<vtkUnsignedCharArray>(vtkImageData*, int, int)>
+    CompressFunction;
+
+  ImageEncoderPool(const CompressFunction& compress = &ImageEncoderPool::Compress)
+    : Compressor(compress)
+  {
+  }
+  ~ImageEncoderPool() { this->Stop(); }
+
+  /**
+   * Restarts the pool with `count` threads, once the queued images are
+   * compressed.
+   */
+  void SetNumberOfThreads(int count)
+  {
+    this->Stop();
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Done = false;
+    for (int cc = 0; cc < count; ++cc)
+    {
+      this->Threads.push_back(std::thread(&ImageEncoderPool::Run, this));
+    }
+  }
+
+  int GetNumberOfThreads() const { return static_cast<int>(this->Threads.size()); }
+
+  void Push(vtkTypeUInt32 key, vtkSmartPointer<vtkImageData> image, int compression, int quality,
+    double captureTime)
+  {
+    Job job{ image, compression, quality, captureTime, vtkTimerLog::GetUniversalTime() };
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    if (this->Threads.empty())
+    {
+      lock.unlock();
+      Frame frame = this->Encode(job);
+      lock.lock();
+      this->Outputs[key] = frame;
+      return;
+    }
+    auto iter = this->Pending.find(key);
+    if (iter != this->Pending.end())
+    {
+      // latest frame wins
+      iter->second = job;
+      ++this->Dropped[key];
+    }
+    else
+    {
+      this->Pending[key] = job;
+      this->Order.push_back(key);
+    }
+    this->Work.notify_one();
+  }
+
+  /**
+   * Gets the last compressed image of a view. Returns false if a newer image
+   * is queued or being compressed.
+   */
+  bool GetLatestOutput(vtkTypeUInt32 key, Frame& frame)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    auto iter = this->Outputs.find(key);
+    if (iter != this->Outputs.end())
+    {
+      frame = iter->second;
+    }
+    return this->Pending.count(key) == 0 && this->Encoding.count(key) == 0;
+  }
+
+  /**
+   * Waits for the images queued for a view to be compressed.
+   */
+  void Flush(vtkTypeUInt32 key)
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->Idle.wait(lock,
+      [this, key] { return this->Pending.count(key) == 0 && this->Encoding.count(key) == 0; });
+  }
+
+  /**
+   * Waits for the queued images to be compressed and stops the threads. Images
+   * pushed afterwards are compressed in Push.
+   */
+  void Stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Done = true;
+    }
+    this->Work.notify_all();
+    for (auto& thread : this->Threads)
+    {
+      thread.join();
+    }
+    this->Threads.clear();
+  }
+
+  vtkIdType GetNumberOfDroppedFrames(vtkTypeUInt32 key)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    auto iter = this->Dropped.find(key);
+    return iter != this->Dropped.end() ? iter->second : 0;
+  }
+
+  /**
+   * Compresses an image as requested by vtkPVWebApplication::ImageCompression.
+   */
+  static vtkSmartPointer<vtkUnsignedCharArray> Compress(
+    vtkImageData* image, int compression, int quality)
+  {
+    if (compression == vtkPVWebApplication::COMPRESSION_JPEG)
+    {
+      vtkNew<vtkJPEGWriter> writer;
+      writer->WriteToMemoryOn();
+      writer->SetInputData(image);
+      writer->SetQuality(quality);
+      writer->Write();
+      return writer->GetResult();
+    }
+    if (compression == vtkPVWebApplication::COMPRESSION_PNG)
+    {
+      vtkNew<vtkPNGWriter> writer;
+      writer->WriteToMemoryOn();
+      writer->SetInputData(image);
+      writer->Write();
+      return writer->GetResult();
+    }
+
+    // RGB pixels, top row first as in the other formats
+    int dims[3];
+    image->GetDimensions(dims);
+    vtkUnsignedCharArray* scalars =
+      vtkUnsignedCharArray::SafeDownCast(image->GetPointData()->GetScalars());
+    if (!scalars)
+    {
+      return nullptr;
+    }
+    const int numComps = scalars->GetNumberOfComponents();
+    const size_t rowSize = static_cast<size_t>(dims[0]) * numComps;
+    vtkNew<vtkUnsignedCharArray> pixels;
+    pixels->SetNumberOfValues(static_cast<vtkIdType>(rowSize * dims[1]));
+    for (int row = 0; row < dims[1]; ++row)
+    {
+      memcpy(pixels->GetPointer(static_cast<vtkIdType>(rowSize * (dims[1] - 1 - row))),
+        scalars->GetPointer(static_cast<vtkIdType>(rowSize * row)), rowSize);
+    }
+    if (compression == vtkPVWebApplication::COMPRESSION_LZ4)
+    {
+      vtkNew<vtkLZ4DataCompressor> compressor;
+      vtkSmartPointer<vtkUnsignedCharArray> result;
+      result.TakeReference(compressor->Compress(
+        pixels->GetPointer(0), static_cast<size_t>(pixels->GetNumberOfValues())));
+      return result;
+    }
+    return pixels.GetPointer();
+  }
+
+private:
+  struct Job
+  {
+    vtkSmartPointer<vtkImageData> Image;
+    int Compression;
+    int Quality;
+    double CaptureTime;
+    double PushTime;
+  };
+
+  void Run()
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    while (true)
+    {
+      // take the oldest view that is not being compressed by another thread
+      auto iter = std::find_if(this->Order.begin(), this->Order.end(),
+        [this](vtkTypeUInt32 key) { return this->Encoding.count(key) == 0; });
+      if (iter == this->Order.end())
+      {
+        if (this->Done && this->Order.empty())
+        {
+          return;
+        }
+        this->Work.wait(lock);
+        continue;
+      }
+      const vtkTypeUInt32 key = *iter;
+      this->Order.erase(iter);
+      Job job = this->Pending[key];
+      this->Pending.erase(key);
+      this->Encoding.insert(key);
+
+      lock.unlock();
+      Frame frame = this->Encode(job);
+      job.Image = nullptr;
+      lock.lock();
+
+      this->Encoding.erase(key);
+      this->Outputs[key] = frame;
+      this->Idle.notify_all();
+      // another image of the same view may be waiting for this one
+      this->Work.notify_one();
+    }
+  }
+
+  Frame Encode(const Job& job) const
+  {
+    Frame frame;
+    frame.CaptureTime = job.CaptureTime;
+    const double start = vtkTimerLog::GetUniversalTime();
+    frame.QueueTime = start - job.PushTime;
+    frame.Data = this->Compressor(job.Image, job.Compression, job.Quality);
+    frame.EncodeTime = vtkTimerLog::GetUniversalTime() - start;
+    return frame;
+  }
+
+  CompressFunction Compressor;
+  std::mutex Mutex;
+  std::condition_variable Work;
+  std::condition_variable Idle;
+  std::vector<std::thread> Threads;
+  bool Done = false;
+  std::map<vtkTypeUInt32, Job> Pending;
+  std::deque<vtkTypeUInt32> Order;
+  std::set<vtkTypeUInt32> Encoding;
+  std::map<vtkTypeUInt32, Frame> Outputs;
+  std::map<vtkTypeUInt32, vtkIdType> Dropped;
+};
+}
+
+#endif
+// VTK-HeaderTest-Exclude: vtkPVWebApplicationInternal.h
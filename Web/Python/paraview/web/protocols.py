@@ -63,6 +63,24 @@ def sanitizeKeys(mapObj):
     return output
 
 
+def imageFormat(app):
+    """ Format of the images compressed by the vtkPVWebApplication. Raw
+        pixels are RGB, top row first. """
+    return { app.COMPRESSION_NONE: "rgb",
+             app.COMPRESSION_PNG: "png",
+             app.COMPRESSION_JPEG: "jpeg",
+             app.COMPRESSION_LZ4: "rgb;lz4" }[app.GetImageCompression()]
+
+
+def frameStatistics(app, view):
+    """ Timings in milliseconds of the last image of a view, to be added to
+        the reply sent with it. """
+    return { "captureTime": 1000 * app.GetLastCaptureTime(view.SMProxy),
+             "queueTime": 1000 * app.GetLastQueueTime(view.SMProxy),
+             "encodeTime": 1000 * app.GetLastEncodeTime(view.SMProxy),
+             "droppedFrames": app.GetNumberOfDroppedFrames(view.SMProxy) }
+
+
 # =============================================================================
 #
 # Base class for any ParaView based protocol
@@ -390,9 +408,12 @@ class ParaViewWebViewPortImageDelivery(ParaViewWebProtocol):
         localTime = 0
         if options and "localTime" in options:
             localTime = options["localTime"]
+        # binary replies carry the image as an attachment instead of base64
+        binary = options and options.get("binary", False)
         reply = {}
         app = self.getApplication()
-        reply["image"] = app.StillRenderToString(view.SMProxy, t, quality)
+        stillRender = app.StillRenderToBuffer if binary else app.StillRenderToString
+        image = stillRender(view.SMProxy, t, quality)
 
         # Check that we are getting image size we have set if not wait until we
         # do.
@@ -400,19 +421,25 @@ class ParaViewWebViewPortImageDelivery(ParaViewWebProtocol):
         while resize and list(app.GetLastStillRenderImageSize()) != size \
               and size != [0, 0] and tries > 0:
             app.InvalidateCache(view.SMProxy)
-            reply["image"] = app.StillRenderToString(view.SMProxy, t, quality)
+            image = stillRender(view.SMProxy, t, quality)
             tries -= 1
 
         if not resize and options and ("clearCache" in options) and options["clearCache"]:
             app.InvalidateCache(view.SMProxy)
-            reply["image"] = app.StillRenderToString(view.SMProxy, t, quality)
+            image = stillRender(view.SMProxy, t, quality)
 
+        if binary:
+            reply["image"] = self.addAttachment(memoryview(image).tobytes()) if image else None
+            reply["format"] = imageFormat(app)
+        else:
+            reply["image"] = image
+            reply["format"] = imageFormat(app) + ";base64"
         reply["stale"] = app.GetHasImagesBeingProcessed(view.SMProxy)
         reply["mtime"] = app.GetLastStillRenderToMTime()
         reply["size"] = view.ViewSize[0:2]
-        reply["format"] = "jpeg;base64"
         reply["global_id"] = view.GetGlobalIDAsString()
         reply["localTime"] = localTime
+        reply.update(frameStatistics(app, view))
 
         endTime = int(round(time.time() * 1000))
         reply["workTime"] = (endTime - beginTime)
@@ -426,13 +453,17 @@ class ParaViewWebViewPortImageDelivery(ParaViewWebProtocol):
 # =============================================================================
 
 class ParaViewWebPublishImageDelivery(ParaViewWebProtocol):
-    def __init__(self, decode=True, **kwargs):
+    def __init__(self, decode=None, **kwargs):
         ParaViewWebProtocol.__init__(self)
+        if decode is not None:
+            import warnings
+            warnings.warn("'decode' is deprecated and will be ignored, images "
+                          "are always sent as binary attachments.",
+                          DeprecationWarning)
         self.trackingViews = {}
         self.lastStaleTime = {}
         self.staleHandlerCount = {}
         self.deltaStaleTimeBeforeRender = 0.5 # 0.5s
-        self.decode = decode
         self.viewsInAnimations = []
         self.targetFrameRate = 30.0
         self.minFrameRate = 12.0
@@ -464,12 +495,7 @@ class ParaViewWebPublishImageDelivery(ParaViewWebProtocol):
         reply = self.stillRender({ "view": vId, "mtime": mtime, "quality": quality, "size": size })
         stale = reply["stale"]
         if reply["image"]:
-            # depending on whether the app has encoding enabled:
-            if self.decode:
-                reply["image"] = base64.standard_b64decode(reply["image"]);
-
             reply["image"] = self.addAttachment(reply["image"]);
-            reply["format"] = "jpeg"
             # save mtime for next call.
             self.trackingViews[vId]["mtime"] = reply["mtime"]
             # echo back real ID, instead of -1 for 'active'
@@ -608,10 +634,8 @@ class ParaViewWebPublishImageDelivery(ParaViewWebProtocol):
         app = self.getApplication()
         if t == 0:
             app.InvalidateCache(view.SMProxy)
-        if self.decode:
-            stillRender = app.StillRenderToString
-        else:
-            stillRender = app.StillRenderToBuffer
+        # The buffer is never base64 encoded
+        stillRender = app.StillRenderToBuffer
         reply_image = stillRender(view.SMProxy, t, quality)
 
         # Check that we are getting image size we have set if not wait until we
@@ -631,14 +655,12 @@ class ParaViewWebPublishImageDelivery(ParaViewWebProtocol):
         reply["mtime"] = app.GetLastStillRenderToMTime()
         reply["size"] = view.ViewSize[0:2]
         reply["memsize"] = reply_image.GetDataSize() if reply_image else 0
-        reply["format"] = "jpeg;base64" if self.decode else "jpeg"
+        reply["format"] = imageFormat(app)
         reply["global_id"] = view.GetGlobalIDAsString()
         reply["localTime"] = localTime
-        if self.decode:
-            reply["image"] = reply_image
-        else:
-            # Convert the vtkUnsignedCharArray into a bytes object, required by Autobahn websockets
-            reply["image"] = memoryview(reply_image).tobytes() if reply_image else None
+        reply.update(frameStatistics(app, view))
+        # Convert the vtkUnsignedCharArray into a bytes object, required by Autobahn websockets
+        reply["image"] = memoryview(reply_image).tobytes() if reply_image else None
 
         endTime = int(round(time.time() * 1000))
         reply["workTime"] = (endTime - beginTime)
@@ -821,8 +843,12 @@ class ParaViewWebViewPortGeometryDelivery(ParaViewWebProtocol):
 
     # RpcName: getWebGLData => viewport.webgl.data
     @exportRpc("viewport.webgl.data")
-    def getWebGLData(self, view_id, object_id, part):
+    def getWebGLData(self, view_id, object_id, part, binary=False):
         view  = self.getView(view_id)
+        if binary:
+            # the part as an attachment instead of base64
+            data = self.getApplication().GetWebGLBinaryBuffer(view.SMProxy, str(object_id), part-1)
+            return self.addAttachment(memoryview(data).tobytes()) if data else None
         data = self.getApplication().GetWebGLBinaryData(view.SMProxy, str(object_id), part-1)
         return data
 
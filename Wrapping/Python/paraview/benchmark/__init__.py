@@ -5,6 +5,8 @@ logbase contains core routines for collecting and gathering timing logs from
 all nodes.
 logparser contains additional routines for parsing the raw logs and
 calculating statistics across ranks and frames.
+harness contains the timing and command line helpers shared by the benchmarks
+comparing variants of an algorithm, such as largestate.
 
 manyspheres is a geometry rendering benchmark that generates a large number
 of spheres and moves the camera around the scene.  To run the benchmark,
@@ -0,0 +1,94 @@
+'''
+amrconnectivity is a benchmark for the fragment identification of the AMR
+Connectivity filter (see vtkAMRConnectivity). It generates non-overlapping AMR
+volumes with the hierarchical fractal source (see vtkHierarchicalFractal) at
+increasing refinement levels, and times labeling and resolving the fragments
+to show how the filter scales with the number of blocks. When run with
+pvbatch on several ranks, each rank generates and processes its share of the
+blocks.
+'''
+from __future__ import print_function
+from paraview.benchmark import harness
+
+
+def generate_volume(maximum_level, dimensions, two_dimensional):
+    '''Returns a vtkNonOverlappingAMR holding this rank's share of the blocks of
+    a hierarchical fractal refined up to `maximum_level`.'''
+    from paraview.modules.vtkPVVTKExtensionsDefault import vtkHierarchicalFractal
+    from vtkmodules.vtkCommonDataModel import vtkNonOverlappingAMR
+    from vtkmodules.vtkParallelCore import vtkMultiProcessController
+    controller = vtkMultiProcessController.GetGlobalController()
+    fractal = vtkHierarchicalFractal()
+    fractal.SetMaximumLevel(maximum_level)
+    fractal.SetDimensions(dimensions)
+    fractal.SetTwoDimensional(two_dimensional)
+    fractal.SetGhostLevels(1)
+    fractal.UpdatePiece(controller.GetLocalProcessId(),
+                        controller.GetNumberOfProcesses(), 0)
+    volume = vtkNonOverlappingAMR()
+    volume.ShallowCopy(fractal.GetOutputDataObject(0))
+    return volume
+
+
+def find_fragments(volume, surface_value):
+    '''Identifies the fragments of `volume` and returns the time taken in
+    seconds and the number of distinct fragments on this rank.'''
+    import numpy
+    from paraview.modules.vtkPVVTKExtensionsDefault import vtkAMRConnectivity
+    from vtkmodules.numpy_interface import dataset_adapter as dsa
+    connectivity = vtkAMRConnectivity()
+    connectivity.SetInputData(volume)
+    connectivity.AddInputVolumeArrayToProcess('Fractal Volume Fraction')
+    connectivity.SetVolumeFractionSurfaceValue(surface_value)
+    connectivity.SetResolveBlocks(True)
+    with harness.Timer() as timer:
+        connectivity.Update()
+
+    output = dsa.WrapDataObject(connectivity.GetOutputDataObject(0))
+    regions = output.CellData['RegionId-Fractal Volume Fraction']
+    fragments = set()
+    for block in regions.Arrays:
+        fragments.update(numpy.unique(block[block > 0]).tolist())
+    return timer.elapsed, len(fragments)
+
+
+def run(levels=(3, 4, 5, 6), dimensions=10, two_dimensional=False,
+        surface_value=0.5, num_iterations=3):
+    '''Runs the benchmark and returns a dictionary with the average time taken
+    to identify the fragments for each maximum refinement level.'''
+    results = {}
+    for level in levels:
+        volume = generate_volume(level, dimensions, two_dimensional)
+        num_blocks = volume.GetNumberOfDataSets(0)
+        for l in range(1, volume.GetNumberOfLevels()):
+            num_blocks += volume.GetNumberOfDataSets(l)
+        results[level], num_fragments = harness.average(
+            find_fragments, num_iterations, volume, surface_value)
+        print('level=%d: %f secs to find %d fragments in %d blocks '
+              '(%d cells)' % (level, results[level], num_fragments,
+                              num_blocks, volume.GetNumberOfCells()))
+    return results
+
+
+ARGUMENTS = [
+    (('-l', '--levels'), dict(dest='levels', default=[3, 4, 5, 6], type=int,
+                              nargs='+', help='Maximum refinement levels to run')),
+    (('-d', '--dimensions'), dict(dest='dimensions', default=10, type=int,
+                                  help='Number of cells along each side of a block')),
+    (('-2', '--two-dimensional'), dict(dest='two_dimensional', action='store_true',
+                                       help='Generate 2D blocks')),
+    (('-v', '--surface-value'), dict(dest='surface_value', default=0.5, type=float,
+                                     help='Volume fraction above which cells are '
+                                          'part of a fragment')),
+    (('-i', '--iterations'), dict(dest='num_iterations', default=3, type=int,
+                                  help='Number of times the fragments are identified')),
+]
+
+
+def main(argv):
+    harness.main(run, 'Benchmark fragment identification on AMR volumes',
+                 ARGUMENTS, argv)
+
+if __name__ == "__main__":
+    import sys
+    main(sys.argv[1:])
@@ -0,0 +1,112 @@
+'''
+amrdualcontour is a benchmark for the threaded processing of the AMR Dual
+Contour and AMR Dual Clip filters (see vtkAMRDualContour and vtkAMRDualClip).
+It generates a non-overlapping AMR volume with the hierarchical fractal source
+(see vtkHierarchicalFractal) and times contouring and clipping it with an
+increasing number of threads (see vtkSMPTools) to show how the filters scale
+with the number of blocks processed at once. It also checks that every run
+produces the same output as the run with one thread.
+'''
+from __future__ import print_function
+from paraview.benchmark import harness
+
+
+def generate_volume(maximum_level, dimensions):
+    '''Returns a vtkNonOverlappingAMR holding this rank's share of the blocks of
+    a hierarchical fractal refined up to `maximum_level`.'''
+    from paraview.modules.vtkPVVTKExtensionsDefault import vtkHierarchicalFractal
+    from vtkmodules.vtkCommonDataModel import vtkNonOverlappingAMR
+    from vtkmodules.vtkParallelCore import vtkMultiProcessController
+    controller = vtkMultiProcessController.GetGlobalController()
+    fractal = vtkHierarchicalFractal()
+    fractal.SetMaximumLevel(maximum_level)
+    fractal.SetDimensions(dimensions)
+    fractal.SetGhostLevels(1)
+    fractal.UpdatePiece(controller.GetLocalProcessId(),
+                        controller.GetNumberOfProcesses(), 0)
+    volume = vtkNonOverlappingAMR()
+    volume.ShallowCopy(fractal.GetOutputDataObject(0))
+    return volume
+
+
+def process(volume, filter_name, iso_value):
+    '''Runs the `filter_name` filter on `volume` and returns the time taken in
+    seconds, the output points and the output cell connectivity.'''
+    from paraview.modules import vtkPVVTKExtensionsDefault
+    from vtkmodules.numpy_interface import dataset_adapter as dsa
+    from vtkmodules.vtkCommonDataModel import vtkDataObject
+    dual = getattr(vtkPVVTKExtensionsDefault, filter_name)()
+    dual.SetInputData(volume)
+    dual.SetInputArrayToProcess(0, 0, 0, vtkDataObject.FIELD_ASSOCIATION_CELLS,
+                                'Fractal Volume Fraction')
+    dual.SetIsoValue(iso_value)
+    dual.SetEnableMergePoints(True)
+    with harness.Timer() as timer:
+        dual.Update()
+
+    mesh = dual.GetOutputDataObject(0).GetBlock(0).GetPiece(0)
+    if mesh is None or mesh.GetNumberOfPoints() == 0:
+        return timer.elapsed, None, None
+    output = dsa.WrapDataObject(mesh)
+    if filter_name == 'vtkAMRDualContour':
+        cells = dsa.vtkDataArrayToVTKArray(mesh.GetPolys().GetData())
+    else:
+        cells = dsa.vtkDataArrayToVTKArray(mesh.GetCells().GetData())
+    return timer.elapsed, output.Points, cells
+
+
+def run(level=5, dimensions=10, iso_value=0.5, threads=(1, 2, 4, 0),
+        num_iterations=3):
+    '''Runs the benchmark and returns a dictionary with, for each filter, the
+    average time taken for each number of threads (0 uses the default number
+    of threads).'''
+    from vtkmodules.vtkCommonCore import vtkSMPTools
+    volume = generate_volume(level, dimensions)
+    num_blocks = 0
+    for l in range(volume.GetNumberOfLevels()):
+        num_blocks += volume.GetNumberOfDataSets(l)
+
+    results = {}
+    for filter_name in ('vtkAMRDualContour', 'vtkAMRDualClip'):
+        results[filter_name] = {}
+        reference = None
+        for num_threads in threads:
+            vtkSMPTools.Initialize(num_threads)
+            results[filter_name][num_threads], (points, cells) = \
+                harness.average(process, num_iterations, volume, filter_name,
+                                iso_value)
+            num_points = 0 if points is None else len(points)
+            print('%s threads=%d: %f secs to produce %d points from %d '
+                  'blocks' % (filter_name, num_threads,
+                              results[filter_name][num_threads], num_points,
+                              num_blocks))
+            if reference is None:
+                reference = [points, cells]
+            else:
+                print('identical to the first run: %s' %
+                      harness.identical(reference, [points, cells]))
+    return results
+
+
+ARGUMENTS = [
+    (('-l', '--level'), dict(dest='level', default=5, type=int,
+                             help='Maximum refinement level of the volume')),
+    (('-d', '--dimensions'), dict(dest='dimensions', default=10, type=int,
+                                  help='Number of cells along each side of a block')),
+    (('-v', '--iso-value'), dict(dest='iso_value', default=0.5, type=float,
+                                 help='Volume fraction to contour and clip at')),
+    (('-t', '--threads'), dict(dest='threads', default=[1, 2, 4, 0], type=int,
+                               nargs='+', help='Numbers of threads to run with '
+                                               '(0 for the default)')),
+    (('-i', '--iterations'), dict(dest='num_iterations', default=3, type=int,
+                                  help='Number of times each filter is run')),
+]
+
+
+def main(argv):
+    harness.main(run, 'Benchmark threaded AMR dual contouring and clipping',
+                 ARGUMENTS, argv)
+
+if __name__ == "__main__":
+    import sys
+    main(sys.argv[1:])
@@ -0,0 +1,103 @@
+'''
+calculator is a benchmark for the evaluation backends of the Calculator filter
+(see vtkPVArrayCalculator). It generates a wavelet image with a vector array
+and times evaluating common expressions with the function parser backend and
+with the compiled backend. It also checks that both backends produce the
+same results.
+'''
+from __future__ import print_function
+from paraview.benchmark import harness
+
+EXPRESSIONS = [
+    'RTData*2+1',
+    'RTData^2/1000-3*RTData',
+    'sin(RTData)*cos(coordsX)+coordsY',
+    'sqrt(coordsX^2+coordsY^2+coordsZ^2)',
+    'mag(coords)',
+    'norm(V)*RTData',
+    'cross(V,coords)+iHat',
+    'V.coords/(abs(RTData)+1)',
+]
+
+
+def generate_image(dimension):
+    '''Returns a wavelet image of `dimension`^3 points with the RTData scalar
+    array and a V vector array.'''
+    from vtkmodules.vtkImagingCore import vtkRTAnalyticSource
+    from vtkmodules.vtkCommonDataModel import vtkImageData
+    from vtkmodules.numpy_interface import dataset_adapter as dsa
+    import numpy
+    half = dimension // 2
+    wavelet = vtkRTAnalyticSource()
+    wavelet.SetWholeExtent(-half, dimension - half - 1, -half,
+                           dimension - half - 1, -half, dimension - half - 1)
+    wavelet.Update()
+    image = vtkImageData()
+    image.ShallowCopy(wavelet.GetOutput())
+    output = dsa.WrapDataObject(image)
+    rt = output.PointData['RTData']
+    output.PointData.append(numpy.column_stack(
+        (numpy.sin(rt), numpy.cos(rt), rt / 100.0)), 'V')
+    return image
+
+
+def evaluate(image, expression, backend):
+    '''Evaluates `expression` on `image` with `backend` and returns the time
+    taken in seconds and the result array.'''
+    from paraview.modules.vtkPVVTKExtensionsDefault import vtkPVArrayCalculator
+    from vtkmodules.numpy_interface import dataset_adapter as dsa
+    calculator = vtkPVArrayCalculator()
+    calculator.SetInputData(image)
+    calculator.SetFunction(expression)
+    calculator.SetResultArrayName('Result')
+    calculator.SetBackend(backend)
+    with harness.Timer() as timer:
+        calculator.Update()
+    output = dsa.WrapDataObject(calculator.GetOutputDataObject(0))
+    return timer.elapsed, output.PointData['Result']
+
+
+def run(dimension=200, expressions=EXPRESSIONS, num_iterations=3):
+    '''Runs the benchmark and returns a dictionary with, for each expression,
+    the average time taken by each backend.'''
+    from paraview.modules.vtkPVVTKExtensionsDefault import vtkPVArrayCalculator
+    backends = (('parser', vtkPVArrayCalculator.PARSER_BACKEND),
+                ('compiled', vtkPVArrayCalculator.COMPILED_BACKEND))
+    image = generate_image(dimension)
+
+    results = {}
+    for expression in expressions:
+        results[expression] = {}
+        reference = None
+        for name, backend in backends:
+            results[expression][name], values = harness.average(
+                evaluate, num_iterations, image, expression, backend)
+            print('%s %s: %f secs for %d points' % \
+                  (expression, name, results[expression][name],
+                   image.GetNumberOfPoints()))
+            if reference is None:
+                reference = values
+            else:
+                print('identical to the parser: %s' % \
+                      harness.identical(reference, values))
+    return results
+
+
+ARGUMENTS = [
+    (('-d', '--dimension'), dict(dest='dimension', default=200, type=int,
+                                 help='Number of points along each side of the image')),
+    (('-e', '--expressions'), dict(dest='expressions', default=EXPRESSIONS,
+                                   type=str, nargs='+',
+                                   help='Expressions to evaluate')),
+    (('-i', '--iterations'), dict(dest='num_iterations', default=3, type=int,
+                                  help='Number of times each expression is evaluated')),
+]
+
+
+def main(argv):
+    harness.main(run, 'Benchmark the Calculator filter backends', ARGUMENTS,
+                 argv)
+
+if __name__ == "__main__":
+    import sys
+    main(sys.argv[1:])
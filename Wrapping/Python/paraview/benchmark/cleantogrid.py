@@ -0,0 +1,65 @@
+'''
+cleantogrid is a benchmark for merging coincident points with the Clean to
+Grid filter (see vtkCleanUnstructuredGrid). It shrinks each cell of a wavelet
+with a shrink factor of 1, which duplicates all the points shared by
+neighboring cells, and times merging them back with the threaded algorithm
+and with the point locator.
+'''
+from __future__ import print_function
+from paraview import servermanager
+from paraview.simple import *
+from paraview.benchmark import harness
+
+
+def merge(source, threaded, tolerance):
+    '''Merges the points of `source` and returns the time taken in seconds
+    and the number of output points.'''
+    clean = CleanUnstructuredGrid(Input=source)
+    clean.ThreadedMerge = threaded
+    clean.Tolerance = tolerance
+    with harness.Timer() as timer:
+        clean.UpdatePipeline()
+    num_points = clean.GetDataInformation().GetNumberOfPoints()
+    Delete(clean)
+    return timer.elapsed, num_points
+
+
+def run(dimension=100, tolerance=0.0, num_iterations=3):
+    '''Runs the benchmark on a wavelet of `dimension`^3 points and returns a
+    dictionary with the average time taken to merge the points with and
+    without the threaded algorithm.'''
+    ResetSession()
+    half = dimension // 2
+    wavelet = Wavelet(WholeExtent=[-half, dimension - half - 1] * 3)
+    shrink = Shrink(Input=wavelet, ShrinkFactor=1.0)
+    shrink.UpdatePipeline()
+    num_input_points = shrink.GetDataInformation().GetNumberOfPoints()
+
+    results = {}
+    for threaded in (False, True):
+        results[threaded], num_points = harness.average(
+            merge, num_iterations, shrink, threaded, tolerance)
+        print('threaded=%s: %f secs to merge %d points into %d' % \
+              (threaded, results[threaded], num_input_points, num_points))
+    Delete(shrink)
+    Delete(wavelet)
+    return results
+
+
+ARGUMENTS = [
+    (('-d', '--dimension'), dict(dest='dimension', default=100, type=int,
+                                 help='Number of points along each axis of the wavelet')),
+    (('-t', '--tolerance'), dict(dest='tolerance', default=0.0, type=float,
+                                 help='Absolute merging tolerance')),
+    (('-i', '--iterations'), dict(dest='num_iterations', default=3, type=int,
+                                  help='Number of times the points are merged')),
+]
+
+
+def main(argv):
+    harness.main(run, 'Benchmark merging coincident points with Clean to Grid',
+                 ARGUMENTS, argv)
+
+if __name__ == "__main__":
+    import sys
+    main(sys.argv[1:])
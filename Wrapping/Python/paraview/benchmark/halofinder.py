@@ -0,0 +1,132 @@
+'''
+halofinder is a benchmark for the friends-of-friends halo finder and the halo
+center finding of the ANL Halo Finder filter (see vtkPANLHaloFinder). It
+generates a reproducible synthetic particle distribution made of a uniform
+background and of Gaussian clumps, and times finding the halos with one
+thread and with all available threads. It also checks that both runs tag the
+particles and place the halo centers identically.
+'''
+from __future__ import print_function
+from paraview import servermanager
+from paraview.simple import *
+from paraview.benchmark import harness
+
+
+def generate_particles(num_particles, num_clumps, box_size, seed):
+    '''Returns a programmable source producing `num_particles` particles in a
+    box of `box_size`, half of them spread uniformly and half of them in
+    `num_clumps` Gaussian clumps. The same `seed` gives the same particles.'''
+    source = ProgrammableSource(OutputDataSetType='vtkUnstructuredGrid')
+    source.Script = '''
+import numpy
+from vtkmodules.numpy_interface import dataset_adapter as dsa
+from vtkmodules.util import numpy_support
+from vtkmodules.vtkCommonCore import vtkPoints
+from vtkmodules.vtkCommonDataModel import vtkCellArray, VTK_VERTEX
+
+rng = numpy.random.RandomState(%(seed)d)
+n, clumps, rl = %(n)d, %(clumps)d, %(rl)f
+background = rng.uniform(0, rl, (n // 2, 3))
+centers = rng.uniform(0.1 * rl, 0.9 * rl, (clumps, 3))
+owners = rng.randint(0, clumps, n - n // 2)
+sizes = rng.uniform(0.002 * rl, 0.01 * rl, clumps)
+clumped = centers[owners] + rng.normal(size=(n - n // 2, 3)) * sizes[owners, None]
+xyz = numpy.clip(numpy.vstack((background, clumped)), 0, rl).astype(numpy.float32)
+
+output = self.GetOutput()
+points = vtkPoints()
+points.SetData(numpy_support.numpy_to_vtk(xyz, deep=1))
+output.SetPoints(points)
+cells = numpy.empty((n, 2), dtype=numpy.int64)
+cells[:, 0] = 1
+cells[:, 1] = numpy.arange(n)
+ids = numpy_support.numpy_to_vtkIdTypeArray(cells.ravel(), deep=1)
+verts = vtkCellArray()
+verts.SetCells(n, ids)
+output.SetCells(VTK_VERTEX, verts)
+
+out = dsa.WrapDataObject(output)
+velocity = rng.normal(size=(n, 3)).astype(numpy.float32)
+out.PointData.append(velocity[:, 0], 'vx')
+out.PointData.append(velocity[:, 1], 'vy')
+out.PointData.append(velocity[:, 2], 'vz')
+out.PointData.append(numpy.arange(n, dtype=numpy.int64), 'id')
+''' % {'seed': seed, 'n': num_particles, 'clumps': num_clumps,
+       'rl': box_size}
+    return source
+
+
+def find_halos(source, box_size, num_threads, center_finding):
+    '''Finds the halos of `source` with `num_threads` threads and returns the
+    time taken in seconds, the halo tag of each particle and the halo
+    centers.'''
+    from vtkmodules.numpy_interface import dataset_adapter as dsa
+    finder = ANLHaloFinder(Input=source)
+    finder.RL = box_size
+    finder.NP = 256
+    finder.PMin = 100
+    finder.CenterFindingMethod = center_finding
+    finder.NumberOfThreads = num_threads
+    with harness.Timer() as timer:
+        finder.UpdatePipeline()
+
+    particles = dsa.WrapDataObject(servermanager.Fetch(finder, idx=0))
+    halos = dsa.WrapDataObject(servermanager.Fetch(finder, idx=1))
+    tags = particles.PointData['fof_halo_tag']
+    centers = halos.PointData['fof_center'] if center_finding else None
+    Delete(finder)
+    return timer.elapsed, tags, centers
+
+
+def run(num_particles=1000000, num_clumps=500, box_size=256.0,
+        center_finding=1, num_iterations=3, seed=0):
+    '''Runs the benchmark and returns a dictionary with the average time taken
+    to find the halos serially (1 thread) and with all available threads
+    (0).'''
+    import numpy
+    ResetSession()
+    source = generate_particles(num_particles, num_clumps, box_size, seed)
+    source.UpdatePipeline()
+
+    results = {}
+    reference = None
+    for num_threads in (1, 0):
+        results[num_threads], (tags, centers) = harness.average(
+            find_halos, num_iterations, source, box_size, num_threads,
+            center_finding)
+        num_halos = len(numpy.unique(tags[tags >= 0]))
+        print('threads=%d: %f secs to find %d halos in %d particles' % \
+              (num_threads, results[num_threads], num_halos, num_particles))
+        if reference is None:
+            reference = (tags, centers)
+        else:
+            print('identical to the serial results: %s' % \
+                  harness.identical(list(reference), [tags, centers]))
+    Delete(source)
+    return results
+
+
+ARGUMENTS = [
+    (('-n', '--particles'), dict(dest='num_particles', default=1000000, type=int,
+                                 help='Number of particles')),
+    (('-c', '--clumps'), dict(dest='num_clumps', default=500, type=int,
+                              help='Number of Gaussian clumps of particles')),
+    (('-l', '--box-size'), dict(dest='box_size', default=256.0, type=float,
+                                help='Size of the box holding the particles')),
+    (('-m', '--center-finding'), dict(dest='center_finding', default=1, type=int,
+                                      help='Center finding method (0 for none, 1 '
+                                           'for the most bound particle)')),
+    (('-i', '--iterations'), dict(dest='num_iterations', default=3, type=int,
+                                  help='Number of times the halos are found')),
+    (('-s', '--seed'), dict(dest='seed', default=0, type=int,
+                            help='Seed of the particle distribution')),
+]
+
+
+def main(argv):
+    harness.main(run, 'Benchmark the threaded friends-of-friends halo finder',
+                 ARGUMENTS, argv)
+
+if __name__ == "__main__":
+    import sys
+    main(sys.argv[1:])
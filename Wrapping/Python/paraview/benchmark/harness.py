@@ -0,0 +1,94 @@
+'''
+harness has the helpers shared by the benchmarks that compare variants of an
+algorithm, such as largestate: timing a call, averaging it over
+iterations, checking results against a reference run and the command line
+entry point running the benchmark's `run()` function.
+
+A benchmark module defines `run(**kwargs)`, which returns a dictionary of
+timings, and the command line arguments mapping to its keyword arguments::
+
+    ARGUMENTS = [
+        (('-i', '--iterations'), dict(dest='num_iterations', default=3,
+                                      type=int, help='Number of iterations')),
+    ]
+
+    def main(argv):
+        harness.main(run, 'Benchmark something', ARGUMENTS, argv)
+'''
+from __future__ import print_function
+import datetime as dt
+
+
+class Timer(object):
+    '''Context manager measuring the wall time spent in its block, in seconds,
+    in `elapsed`.'''
+
+    def __init__(self):
+        self.elapsed = 0.0
+
+    def __enter__(self):
+        self._start = dt.datetime.now()
+        return self
+
+    def __exit__(self, *args):
+        self.elapsed = (dt.datetime.now() - self._start).total_seconds()
+        return False
+
+
+def average(function, num_iterations, *args, **kwargs):
+    '''Calls `function(*args, **kwargs)` `num_iterations` times. `function`
+    returns the time taken in seconds, or a tuple whose first element is the
+    time taken. Returns the average time and the rest of the tuple returned by
+    the last call (None if `function` only returns the time).'''
+    times = []
+    rest = None
+    for i in range(max(1, num_iterations)):
+        result = function(*args, **kwargs)
+        if isinstance(result, tuple):
+            times.append(result[0])
+            rest = result[1:] if len(result) > 2 else result[1]
+        else:
+            times.append(result)
+    return sum(times) / len(times), rest
+
+
+def identical(reference, values):
+    '''Returns True if `values` are the same as `reference`. Both may be None,
+    numpy arrays or lists of numpy arrays e.g. the `Arrays` of a
+    VTKCompositeDataArray.'''
+    import numpy
+    if reference is None or values is None:
+        return reference is None and values is None
+    if isinstance(reference, (list, tuple)):
+        return len(reference) == len(values) and \
+            all(identical(a, b) for a, b in zip(reference, values))
+    return numpy.array_equal(reference, values)
+
+
+def connect():
+    '''Connects to the server given with `--url` on the command line of
+    pvpython, if any.'''
+    import re
+    from paraview import servermanager
+    from paraview.simple import Connect
+    options = servermanager.vtkProcessModule.GetProcessModule().GetOptions()
+    url = options.GetServerURL()
+    if url:
+        m = re.match('([^:/]*://)?([^:]*)(:([0-9]+))?', url)
+        if m.group(4):
+            Connect(m.group(2), int(m.group(4)))
+        else:
+            Connect(m.group(2))
+
+
+def main(run, description, arguments, argv):
+    '''Parses `argv` and calls `run` with the parsed values as keyword
+    arguments. `arguments` is a list of `(flags, options)` tuples passed to
+    `argparse.ArgumentParser.add_argument`; the `dest` of each option is the
+    name of the keyword argument of `run`. Returns the result of `run`.'''
+    import argparse
+    parser = argparse.ArgumentParser(description=description)
+    for flags, options in arguments:
+        parser.add_argument(*flags, **options)
+    args = parser.parse_args(argv)
+    return run(**vars(args))
@@ -0,0 +1,82 @@
+'''
+largestate is a benchmark for loading state files with a large number of
+proxies. It generates a synthetic state made of several views, each showing
+many pipelines, saves it, and then times loading it back with and without
+batched loading (see vtkSMStateLoader::SetBatchedLoading). It is most useful
+when connected to a remote server since batching reduces the number of
+messages exchanged with the server.
+'''
+from __future__ import print_function
+import os
+from paraview import servermanager
+from paraview.simple import *
+from paraview.benchmark import harness
+
+
+def generate_state(filename, num_views=4, num_pipelines=100):
+    '''Creates `num_views` render views each showing `num_pipelines` short
+    pipelines and saves the state to `filename`.'''
+    ResetSession()
+    layout = GetLayout()
+    for v in range(num_views):
+        view = CreateRenderView()
+        AssignViewToLayout(view=view, layout=layout)
+        for p in range(num_pipelines):
+            sphere = Sphere(Center=[p, v, 0], ThetaResolution=8, PhiResolution=8)
+            shrink = Shrink(Input=sphere)
+            elevation = Elevation(Input=shrink)
+            Show(elevation, view)
+    SaveState(filename)
+
+
+def load_state(filename, batched):
+    '''Loads the state in `filename` in a clean session and returns the time
+    taken in seconds.'''
+    from paraview.modules.vtkPVServerManagerCore import vtkSMStateLoader
+    ResetSession()
+    loader = vtkSMStateLoader()
+    loader.SetSessionProxyManager(servermanager.ProxyManager().SMProxyManager)
+    loader.SetBatchedLoading(batched)
+    with harness.Timer() as timer:
+        servermanager.ProxyManager().LoadState(filename, loader)
+    return timer.elapsed
+
+
+def run(filename='largestate.pvsm', num_views=4, num_pipelines=100,
+        num_iterations=3):
+    '''Runs the benchmark and returns a dictionary with the average time taken
+    to load the state with and without batched loading.'''
+    generate_state(filename, num_views, num_pipelines)
+    num_proxies = len(servermanager.ProxyManager().GetProxiesInGroup('sources'))
+
+    results = {}
+    for batched in (False, True):
+        results[batched], _ = harness.average(load_state, num_iterations,
+                                              filename, batched)
+        print('batched=%s: %f secs to load %d sources (%f sources/sec)' % \
+              (batched, results[batched], num_proxies,
+               num_proxies / results[batched]))
+    os.remove(filename)
+    return results
+
+
+ARGUMENTS = [
+    (('-o', '--output'), dict(dest='filename', default='largestate.pvsm',
+                              type=str, help='Temporary state file to generate')),
+    (('-v', '--views'), dict(dest='num_views', default=4, type=int,
+                             help='Number of views in the state')),
+    (('-p', '--pipelines'), dict(dest='num_pipelines', default=100, type=int,
+                                 help='Number of pipelines shown in each view')),
+    (('-i', '--iterations'), dict(dest='num_iterations', default=3, type=int,
+                                  help='Number of times the state is loaded')),
+]
+
+
+def main(argv):
+    harness.connect()
+    harness.main(run, 'Benchmark loading of large ParaView state files',
+                 ARGUMENTS, argv)
+
+if __name__ == "__main__":
+    import sys
+    main(sys.argv[1:])
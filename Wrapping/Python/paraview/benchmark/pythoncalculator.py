@@ -0,0 +1,96 @@
+'''
+pythoncalculator is a benchmark for the Python Calculator filter (see
+vtkPythonCalculator). It generates a multiblock dataset made of wavelet
+images, each with several arrays, and times evaluating an expression that
+uses only one of them, on the whole dataset and block by block in parallel
+(see vtkPythonCalculator::SetEvaluateBlocksIndependently). It also checks
+that both produce the same results. Set PARAVIEW_LOG_PIPELINE_VERBOSITY to
+INFO to see the conversion and evaluation times of each execution.
+'''
+from __future__ import print_function
+from paraview.benchmark import harness
+
+
+def generate_blocks(num_blocks, dimension, num_arrays):
+    '''Returns a vtkMultiBlockDataSet of `num_blocks` wavelet images of
+    `dimension`^3 points, each with RTData and `num_arrays` other arrays.'''
+    from vtkmodules.vtkImagingCore import vtkRTAnalyticSource
+    from vtkmodules.vtkCommonDataModel import vtkImageData, vtkMultiBlockDataSet
+    from vtkmodules.numpy_interface import dataset_adapter as dsa
+    blocks = vtkMultiBlockDataSet()
+    for b in range(num_blocks):
+        wavelet = vtkRTAnalyticSource()
+        wavelet.SetWholeExtent(0, dimension - 1, 0, dimension - 1,
+                               b * dimension, (b + 1) * dimension - 1)
+        wavelet.Update()
+        image = vtkImageData()
+        image.ShallowCopy(wavelet.GetOutput())
+        output = dsa.WrapDataObject(image)
+        rt = output.PointData['RTData']
+        for a in range(num_arrays):
+            output.PointData.append(rt * (a + 1), 'extra%d' % a)
+        blocks.SetBlock(b, image)
+    return blocks
+
+
+def evaluate(blocks, expression, independently):
+    '''Evaluates `expression` on `blocks` and returns the time taken in
+    seconds and the results.'''
+    from paraview.modules.vtkPVClientServerCorePython import vtkPythonCalculator
+    from vtkmodules.numpy_interface import dataset_adapter as dsa
+    calculator = vtkPythonCalculator()
+    calculator.SetInputData(blocks)
+    calculator.SetExpression(expression)
+    calculator.SetEvaluateBlocksIndependently(independently)
+    with harness.Timer() as timer:
+        calculator.Update()
+    output = dsa.WrapDataObject(calculator.GetOutputDataObject(0))
+    return timer.elapsed, output.PointData['result'].Arrays
+
+
+def run(num_blocks=8, dimension=100, num_arrays=10,
+        expression='sin(RTData) * cos(RTData / 100) + sqrt(abs(RTData))',
+        num_iterations=3):
+    '''Runs the benchmark and returns a dictionary with the average time taken
+    to evaluate the expression on the whole dataset and block by block.'''
+    blocks = generate_blocks(num_blocks, dimension, num_arrays)
+
+    results = {}
+    reference = None
+    for independently in (False, True):
+        results[independently], values = harness.average(
+            evaluate, num_iterations, blocks, expression, independently)
+        print('independently=%s: %f secs for %d blocks of %d points' % \
+              (independently, results[independently], num_blocks,
+               dimension ** 3))
+        if reference is None:
+            reference = values
+        else:
+            print('identical to the whole dataset evaluation: %s' % \
+                  harness.identical(reference, values))
+    return results
+
+
+ARGUMENTS = [
+    (('-b', '--blocks'), dict(dest='num_blocks', default=8, type=int,
+                              help='Number of blocks')),
+    (('-d', '--dimension'), dict(dest='dimension', default=100, type=int,
+                                 help='Number of points along each side of a block')),
+    (('-a', '--arrays'), dict(dest='num_arrays', default=10, type=int,
+                              help='Number of unused arrays in each block')),
+    (('-e', '--expression'), dict(dest='expression',
+                                  default='sin(RTData) * cos(RTData / 100) + '
+                                          'sqrt(abs(RTData))',
+                                  type=str, help='Expression to evaluate')),
+    (('-i', '--iterations'), dict(dest='num_iterations', default=3, type=int,
+                                  help='Number of times the expression is evaluated')),
+]
+
+
+def main(argv):
+    harness.main(run, 'Benchmark the Python Calculator filter', ARGUMENTS,
+                 argv)
+
+if __name__ == "__main__":
+    import sys
+    main(sys.argv[1:])
@@ -0,0 +1,71 @@
+'''
+settingslookup is a benchmark for the proxy creation throughput, which
+is dominated by the settings lookups done for every property of every new
+proxy. It times the creation of many proxies with and without the settings
+lookup index (see vtkSMSettings::SetUseLookupIndex).
+'''
+from __future__ import print_function
+from paraview import servermanager
+from paraview.simple import *
+from paraview.benchmark import harness
+
+
+def create_proxies(num_proxies, use_index):
+    '''Creates and deletes `num_proxies` proxies of a few different types and
+    returns the time taken in seconds.'''
+    from paraview.modules.vtkPVServerManagerCore import vtkSMSettings
+    from paraview.modules.vtkPVServerManagerCore import vtkSMParaViewPipelineController
+    settings = vtkSMSettings.GetInstance()
+    settings.SetUseLookupIndex(use_index)
+
+    pxm = servermanager.ProxyManager().SMProxyManager
+    controller = vtkSMParaViewPipelineController()
+    types = [('sources', 'SphereSource'), ('sources', 'ConeSource'),
+             ('sources', 'CylinderSource'), ('sources', 'PlaneSource')]
+    with harness.Timer() as timer:
+        for i in range(num_proxies):
+            group, name = types[i % len(types)]
+            proxy = pxm.NewProxy(group, name)
+            controller.PreInitializeProxy(proxy)
+            controller.PostInitializeProxy(proxy)
+            del proxy
+    return timer.elapsed
+
+
+def run(num_proxies=10000, num_iterations=3):
+    '''Runs the benchmark and returns a dictionary with the average time taken
+    to create the proxies with and without the lookup index.'''
+    from paraview.modules.vtkPVServerManagerCore import vtkSMSettings
+    settings = vtkSMSettings.GetInstance()
+    previous = settings.GetUseLookupIndex()
+
+    # add a lowest priority collection so that some lookups succeed.
+    settings.AddCollectionFromString(
+        '{ "sources" : { "SphereSource" : { "Radius" : 2.0 } } }', -1.0)
+
+    results = {}
+    for use_index in (False, True):
+        results[use_index], _ = harness.average(create_proxies, num_iterations,
+                                                num_proxies, use_index)
+        print('index=%s: %f secs to create %d proxies (%f proxies/sec)' % \
+              (use_index, results[use_index], num_proxies,
+               num_proxies / results[use_index]))
+    settings.SetUseLookupIndex(previous)
+    return results
+
+
+ARGUMENTS = [
+    (('-n', '--proxies'), dict(dest='num_proxies', default=10000, type=int,
+                               help='Number of proxies to create')),
+    (('-i', '--iterations'), dict(dest='num_iterations', default=3, type=int,
+                                  help='Number of times the proxies are created')),
+]
+
+
+def main(argv):
+    harness.main(run, 'Benchmark proxy creation with and without settings '
+                 'lookup index', ARGUMENTS, argv)
+
+if __name__ == "__main__":
+    import sys
+    main(sys.argv[1:])
@@ -0,0 +1,69 @@
+'''
+spreadsheetsort is a benchmark for sorting large tables in the spreadsheet
+view (see vtkSortedTableStreamer). It shows a wavelet with a given number of
+points in a spreadsheet view sorted by its point scalars, and times fetching
+the first block, which includes the parallel sort, and then a series of
+blocks, which reuse the cached sort. Run it with pvbatch on an increasing
+number of ranks to measure scaling.
+'''
+from __future__ import print_function
+from paraview import servermanager
+from paraview.simple import *
+from paraview.benchmark import harness
+
+
+def fetch(view, blocks, block_size):
+    '''Fetches the first row of each of the given blocks and returns the time
+    taken in seconds.'''
+    ssview = view.GetClientSideObject()
+    with harness.Timer() as timer:
+        for block in blocks:
+            ssview.GetValueByName(block * block_size, 'RTData')
+    return timer.elapsed
+
+
+def run(dimension=200, num_blocks=20, block_size=1024):
+    '''Runs the benchmark on a wavelet of `dimension`^3 points and returns a
+    dictionary with the time taken to fetch the first sorted block, and the
+    average time taken to fetch each of the `num_blocks` following blocks.'''
+    ResetSession()
+    half = dimension // 2
+    wavelet = Wavelet(WholeExtent=[-half, dimension - half - 1] * 3)
+    view = CreateView('SpreadSheetView')
+    view.BlockSize = block_size
+    view.FieldAssociation = 'Point Data'
+    Show(wavelet, view)
+    view.ColumnToSort = 'RTData'
+    view.StillRender()
+
+    num_rows = view.GetClientSideObject().GetNumberOfRows()
+    results = {}
+    results['first'] = fetch(view, [0], block_size)
+    step = max(1, num_rows // (block_size * max(1, num_blocks)))
+    blocks = [(i + 1) * step for i in range(num_blocks)]
+    results['next'] = fetch(view, blocks, block_size) / max(1, num_blocks)
+
+    print('%d rows: first block in %f secs, next blocks in %f secs each' % \
+          (num_rows, results['first'], results['next']))
+    Delete(view)
+    Delete(wavelet)
+    return results
+
+
+ARGUMENTS = [
+    (('-d', '--dimension'), dict(dest='dimension', default=200, type=int,
+                                 help='Number of points along each axis of the wavelet')),
+    (('-b', '--blocks'), dict(dest='num_blocks', default=20, type=int,
+                              help='Number of blocks fetched after the first one')),
+    (('-s', '--block-size'), dict(dest='block_size', default=1024, type=int,
+                                  help='Number of rows per block')),
+]
+
+
+def main(argv):
+    harness.main(run, 'Benchmark sorting large tables in the spreadsheet view',
+                 ARGUMENTS, argv)
+
+if __name__ == "__main__":
+    import sys
+    main(sys.argv[1:])
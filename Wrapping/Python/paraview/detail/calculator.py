@@ -18,13 +18,44 @@ from paraview.vtk import vtkDoubleArray, vtkSelectionNode, vtkSelection, vtkStre
 from paraview.modules import vtkPVClientServerCorePython
 
 import sys
+import time
 if sys.version_info >= (3,):
     xrange = range
 
-def get_arrays(attribs, controller=None):
+def get_referenced_names(expression):
+    """Returns the set of names referenced by `expression`, including in nested
+    scopes such as lambdas and comprehensions, or None if the expression does
+    not compile (in which case evaluating it reports the error)."""
+    def names(code):
+        result = set(code.co_names)
+        for const in code.co_consts:
+            if hasattr(const, "co_names"):
+                result |= names(const)
+        return result
+    try:
+        return names(compile(expression, "<expression>", "eval"))
+    except SyntaxError:
+        return None
+
+def get_mpi_communicator(controller=None):
+    """Returns the mpi4py communicator of `controller`, or of the global
+    controller, when running on more than one MPI process; None otherwise."""
+    if controller is None and vtkMultiProcessController is not None:
+        controller = vtkMultiProcessController.GetGlobalController()
+    if controller and controller.IsA("vtkMPIController") and controller.GetNumberOfProcesses() > 1:
+        from mpi4py import MPI
+        return vtkMPI4PyCommunicator.ConvertToPython(controller.GetCommunicator())
+    return None
+
+def get_arrays(attribs, controller=None, names=None):
     """Returns a 'dict' referring to arrays in dsa.DataSetAttributes or
     dsa.CompositeDataSetAttributes instance.
 
+    When `names` is not None, only the arrays whose variable name is in
+    `names` are added. The arrays are wrapped without copying their values
+    whenever their memory layout allows it, so limiting them to the ones an
+    expression uses avoids converting (and possibly copying) the others.
+
     When running in parallel, this method will ensure that arraynames are
     reduced across all ranks and for any arrays missing on the local process, a
     NoneArray will be added to the returned dictionary. This ensures that
@@ -37,17 +68,15 @@ def get_arrays(attribs, controller=None):
     arrays = dict()
     for key in attribs.keys():
         varname = paraview.make_name_valid(key)
-        arrays[varname] = attribs[key]
+        if names is None or varname in names:
+            arrays[varname] = attribs[key]
 
 
     # If running in parallel, ensure that the arrays are synced up so that
     # missing arrays get NoneArray assigned to them avoiding any unnecessary
     # errors when evaluating expressions.
-    if controller is None and vtkMultiProcessController is not None:
-        controller = vtkMultiProcessController.GetGlobalController()
-    if controller and controller.IsA("vtkMPIController") and controller.GetNumberOfProcesses() > 1:
-        from mpi4py import MPI
-        comm = vtkMPI4PyCommunicator.ConvertToPython(controller.GetCommunicator())
+    comm = get_mpi_communicator(controller)
+    if comm is not None:
         rank = comm.Get_rank()
 
         # reduce the array names across processes to ensure arrays missing on
@@ -157,6 +186,103 @@ def get_data_time(self, do, ininfo):
             pass
     return (t, t_index)
 
+def log_timing(message):
+    """Logs `message` at the pipeline verbosity of vtkPVLogger."""
+    from paraview.modules.vtkPVCore import vtkPVLogger
+    vtkPVLogger.Log(vtkPVLogger.GetPipelineVerbosity(), __file__, 0, message)
+
+def append_result(self, output, retVal):
+    """Adds the value of the expression to `output`."""
+    if retVal is not None and retVal is not dsa.NoneArray:
+        if hasattr(retVal, "Association"):
+            output.GetAttributes(retVal.Association).append(\
+              retVal, self.GetArrayName())
+        else:
+            # if somehow the association was removed we
+            # fall back to the input array association
+            output.GetAttributes(self.GetArrayAssociation()).append(\
+              retVal, self.GetArrayName())
+
+def can_compute_blocks(self, inputs, output, names):
+    """Returns True if the leaves of `inputs[0]` and `output` match and the
+    composite arrays `names` refers to hold one array per leaf, on every
+    process. get_arrays() and the functions that combine values, such as max(),
+    communicate across processes, so all of them must agree on whether the
+    blocks are evaluated independently and on the number of blocks before any
+    of those calls."""
+    in_blocks = list(inputs[0])
+    matching = len(in_blocks) == len(list(output))
+    attribs = inputs[0].GetAttributes(self.GetArrayAssociation())
+    for key in attribs.keys():
+        if not matching:
+            break
+        if names is None or paraview.make_name_valid(key) in names:
+            array = attribs[key]
+            matching = not isinstance(array, dsa.VTKCompositeDataArray) or \
+                len(array.Arrays) == len(in_blocks)
+
+    comm = get_mpi_communicator()
+    if comm is None:
+        return matching
+    gathered = comm.allgather((matching, len(in_blocks)))
+    return all(m for m, n in gathered) and \
+        all(n == len(in_blocks) for m, n in gathered)
+
+def compute_blocks(self, inputs, output, expression, names):
+    """Evaluates `expression` separately on each leaf of the composite
+    dataset `inputs[0]`, with a pool of threads, and appends the results to
+    the matching leaves of `output`. numpy releases the GIL while it processes
+    arrays, so the evaluations of large blocks overlap. When running on
+    several processes, the blocks are evaluated one after the other so that
+    the collective calls the expression makes happen in the same order on
+    every process. Returns False, doing nothing, if can_compute_blocks() does
+    not hold on every process."""
+    from multiprocessing import cpu_count
+    from multiprocessing.pool import ThreadPool
+    if not can_compute_blocks(self, inputs, output, names):
+        return False
+    in_blocks = list(inputs[0])
+    out_blocks = list(output)
+
+    t0 = time.time()
+    # the composite arrays hold one array per leaf, in the same order.
+    arrays = get_arrays(inputs[0].GetAttributes(self.GetArrayAssociation()), names=names)
+    namespaces = []
+    for i, block in enumerate(in_blocks):
+        variables = dict()
+        for varname, array in arrays.items():
+            if isinstance(array, dsa.VTKCompositeDataArray):
+                variables[varname] = array.Arrays[i]
+            else:
+                variables[varname] = array
+        block.time_value = block.t_value = inputs[0].time_value
+        block.time_index = block.t_index = inputs[0].time_index
+        variables.update({ "time_value": block.time_value,
+                           "t_value": block.t_value,
+                           "time_index": block.time_index,
+                           "t_index": block.t_index })
+        namespaces.append(variables)
+    t1 = time.time()
+
+    evaluate = lambda i: compute([in_blocks[i]], expression, ns=namespaces[i])
+    if get_mpi_communicator() is not None:
+        results = [evaluate(i) for i in range(len(in_blocks))]
+    else:
+        pool = ThreadPool(max(1, min(len(in_blocks), cpu_count())))
+        try:
+            results = pool.map(evaluate, range(len(in_blocks)))
+        finally:
+            pool.close()
+            pool.join()
+    t2 = time.time()
+
+    for out_block, retVal in zip(out_blocks, results):
+        append_result(self, out_block, retVal)
+    t3 = time.time()
+    log_timing("python calculator (%d blocks): conversion %f s, evaluation %f s, "
+               "output %f s" % (len(in_blocks), t1 - t0, t2 - t1, t3 - t2))
+    return True
+
 def execute(self, expression):
     """
     **Internal Method**
@@ -183,20 +309,26 @@ def execute(self, expression):
         output.GetPointData().PassData(inputs[0].GetPointData())
         output.GetCellData().PassData(inputs[0].GetCellData())
 
+    # only the arrays the expression refers to are converted.
+    names = get_referenced_names(expression)
+
+    if self.GetEvaluateBlocksIndependently() and len(inputs) == 1 and \
+        isinstance(inputs[0], dsa.CompositeDataSet) and \
+        compute_blocks(self, inputs, output, expression, names):
+        return
+
     # get a dictionary for arrays in the dataset attributes. We pass that
     # as the variables in the eval namespace for compute.
-    variables = get_arrays(inputs[0].GetAttributes(self.GetArrayAssociation()))
+    t0 = time.time()
+    variables = get_arrays(inputs[0].GetAttributes(self.GetArrayAssociation()), names=names)
     variables.update({ "time_value": inputs[0].time_value,
                        "t_value": inputs[0].t_value,
                        "time_index": inputs[0].time_index,
                        "t_index": inputs[0].t_index })
+    t1 = time.time()
     retVal = compute(inputs, expression, ns=variables)
-    if retVal is not None:
-        if hasattr(retVal, "Association"):
-            output.GetAttributes(retVal.Association).append(\
-              retVal, self.GetArrayName())
-        else:
-            # if somehow the association was removed we
-            # fall back to the input array association
-            output.GetAttributes(self.GetArrayAssociation()).append(\
-              retVal, self.GetArrayName())
+    t2 = time.time()
+    append_result(self, output, retVal)
+    t3 = time.time()
+    log_timing("python calculator: conversion %f s, evaluation %f s, output %f s" % \
+               (t1 - t0, t2 - t1, t3 - t2))
@@ -0,0 +1,470 @@
+#==============================================================================
+#
+#  Program:   ParaView
+#  Module:    cinemaexport.py
+#
+#  Copyright (c) Kitware, Inc.
+#  All rights reserved.
+#  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+#
+#     This software is distributed WITHOUT ANY WARRANTY; without even
+#     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#     PURPOSE.  See the above copyright notice for more information.
+#
+#==============================================================================
+r"""
+This module is used by vtkCinemaExporter. It exports the views as
+`cinema_python` does (`pv_introspect.export_scene`), with:
+
+- an explorer that leaves out the images already in the database, shares the
+  samples among the time compartments of pvbatch and only updates filter
+  tracks when their value changes,
+
+- a store of which only the first time compartment writes the description,
+
+- the number of threads of the vtkThreadedImageWriter of the database.
+
+`pv_introspect` creates the store and the explorer of each view itself, so
+`export_scene` and `explore` follow its functions of the same name and reuse
+its helpers.
+"""
+from __future__ import absolute_import, print_function
+
+import math
+import os
+
+import paraview.simple
+import paraview.servermanager as servermanager
+from paraview.tpl.cinema_python.adaptors import explorers
+import paraview.tpl.cinema_python.adaptors.paraview.progress as progress
+import paraview.tpl.cinema_python.adaptors.paraview.pv_explorers as pv_explorers
+import paraview.tpl.cinema_python.adaptors.paraview.pv_introspect as pv_introspect
+from paraview.tpl.cinema_python.database import file_store
+from paraview.tpl.cinema_python.database import store as cinema_store
+
+def get_track_parameters(track):
+    """Returns the names of the parameters that `track` depends on, or None
+    if it must run for every sample."""
+    if isinstance(track, (pv_explorers.Slice, pv_explorers.Contour,
+                          pv_explorers.Templated)):
+        return [track.parameter]
+    if isinstance(track, pv_explorers.Clip):
+        return [track.argument]
+    return None
+
+def set_writer_threads(cs, count):
+    """Encodes and writes the images of the store `cs` on `count` threads of
+    its vtkThreadedImageWriter while the next ones are rendered. 0 keeps the
+    number of threads the writer starts with."""
+    writer = cs.raster_wrangler.threadedwriter
+    if writer is None or count <= 0:
+        return
+    writer.SetMaxThreads(count)
+    writer.Initialize()
+
+def wait_for_writer(cs):
+    """Waits for the images queued by the store `cs` to be written."""
+    wrangler = cs.raster_wrangler
+    if wrangler.threadedwriter is not None:
+        wrangler.threadedwriter.Finalize()
+        wrangler.threadedwriter = None
+
+class FileStore(file_store.FileStore):
+    """Store of a database exported by several time compartments: only the
+    first one writes the description, info.json, and the name of the file of
+    a document can be known before the document is rendered."""
+
+    def __init__(self, dbfilename, definition, writeDescription=True):
+        """Makes a store with the parameters, the metadata and the file name
+        pattern of the store `definition`, which
+        `pv_introspect.make_cinema_store` makes."""
+        super(FileStore, self).__init__(dbfilename)
+        self._set_parameter_list(definition.parameter_list)
+        self._set_parameter_associations(definition.parameter_associations)
+        self.metadata = definition.metadata
+        self.filename_pattern = definition.filename_pattern
+        self.WriteDescription = writeDescription
+
+    def save(self):
+        """overridden to only write the description if asked to"""
+        if self.WriteDescription:
+            super(FileStore, self).save()
+
+    def get_file_name(self, desc):
+        """Returns the name of the file written for the document with the
+        descriptor `desc`."""
+        fname = self._get_filename(desc, readingFile=False)
+        doctype = self.determine_type(desc)
+        if doctype == 'VALUE' or doctype == 'Z':
+            # value and depth rasters are written as float buffers, the ones
+            # without OpenEXR in a zlib compressed file.
+            base, ext = os.path.splitext(fname)
+            fname = base + self.raster_wrangler.floatExtension()
+            if "OpenEXR" not in self.raster_wrangler.backends:
+                base, ext = os.path.splitext(fname)
+                fname = base + ".Z"
+        return fname
+
+class ImageExplorer(pv_explorers.ImageExplorer):
+    """Explorer of `cinema_python` leaving out the samples of the other time
+    compartments and, if asked to, the ones whose file is already in the
+    store. Tracks of filters are only executed again when the value of their
+    parameter changed, so that the output of the pipeline is reused across
+    the samples that only move the camera (innermost in the traversal
+    order). `cs` is a FileStore of this module."""
+
+    def __init__(self, cs, parameters, tracks, view=None, iSave=True,
+                 skipExisting=False, share=(0, 1)):
+        super(ImageExplorer, self).__init__(cs, parameters, tracks, view,
+                                            iSave)
+        self.SkipExisting = skipExisting
+        self.ShareIndex = share[0]
+        self.ShareCount = max(1, share[1])
+        self.Sample = 0
+        self.Applied = {}
+
+    def prepare(self):
+        super(ImageExplorer, self).prepare()
+        self.Sample = 0
+        self.Applied = {}
+
+    def skip(self, desc):
+        sample = self.Sample
+        self.Sample += 1
+        if sample % self.ShareCount != self.ShareIndex:
+            return True
+        if not self.SkipExisting:
+            return False
+
+        # all the processes take part in each render, so the ones running the
+        # script in symmetric mode follow the decision of the first one.
+        fname = self.store.get_file_name(desc)
+        exists = self.iSave and os.path.isfile(fname) and \
+            os.path.getsize(fname) > 0
+        pm = servermanager.vtkProcessModule.GetProcessModule()
+        controller = pm.GetGlobalController()
+        if pm.GetSymmetricMPIMode() and controller and \
+                controller.GetNumberOfProcesses() > 1:
+            from vtkmodules.vtkCommonCore import vtkIntArray
+            flag = vtkIntArray()
+            flag.InsertNextValue(1 if exists else 0)
+            controller.Broadcast(flag, 0)
+            exists = flag.GetValue(0) != 0
+        return exists
+
+    def execute(self, desc):
+        """overridden to leave out samples and to not execute again the
+        tracks whose parameters did not change"""
+        if self.skip(desc):
+            return
+        doc = cinema_store.Document(desc)
+        for track in self.tracks:
+            names = get_track_parameters(track)
+            if names is not None:
+                values = [desc.get(name) for name in names]
+                if self.Applied.get(id(track)) == values:
+                    continue
+                self.Applied[id(track)] = values
+            track.execute(doc)
+        self.insert(doc)
+
+def explore(cs, proxies, iSave=True, currentTime=None, userDefined={},
+            specLevel="A",
+            camType='phi-theta',
+            tracking={},
+            floatValues=True,
+            arrayRanges={},
+            disableValues=False,
+            progressObject=None,
+            skipExisting=False,
+            share=(0, 1)):
+    """Same as `pv_introspect.explore`, with an ImageExplorer of this module
+    created with `skipExisting` and `share`."""
+    view_proxy = paraview.simple.GetActiveView()
+    dist = paraview.simple.GetActiveCamera().GetDistance()
+
+    # associate control points with parameters of the data store
+    params = list(cs.parameter_list.keys())
+    tracks = []
+    if camType == "phi-theta":
+        up = [math.fabs(x) for x in view_proxy.CameraViewUp]
+        uppest = 0
+        if up[1] > up[uppest]:
+            uppest = 1
+        if up[2] > up[uppest]:
+            uppest = 2
+        cinup = [0, 0, 0]
+        cinup[uppest] = 1
+
+        eye = [x for x in view_proxy.CameraPosition]
+        _fp = [x for x in view_proxy.CameraFocalPoint]
+        _cr = [x for x in view_proxy.CenterOfRotation]
+        at = pv_introspect.project_to_at(eye, _fp, _cr)
+
+        cam = pv_explorers.Camera(at, cinup, dist, view_proxy)
+        tracks.append(cam)
+    elif camType != 'static':
+        cam = pv_explorers.PoseCamera(view_proxy, camType, cs)
+        tracks.append(cam)
+
+    cols = []
+
+    ctime_float = None
+    if currentTime:
+        ctime_float = float(currentTime['time'])
+
+    # hide all annotations
+    view_proxy.OrientationAxesVisibility = 0
+
+    for x in proxies:
+        name = x['name']
+        for y in params:
+
+            if (y in pv_introspect.explorerDir) and (name == y):
+                tracks.append(pv_introspect.explorerDir[y])
+
+            if name in y:
+                # visibility of the layer
+                sp = paraview.simple.FindSource(name)
+                if specLevel != "A":
+                    rep = servermanager.GetRepresentation(sp, view_proxy)
+
+                    # hide all annotations
+                    if rep.LookupTable:
+                        rep.SetScalarBarVisibility(view_proxy, False)
+                    tc1 = pv_explorers.SourceProxyInLayer(name, rep, sp)
+                    lt = explorers.Layer('vis', [tc1])
+                    tracks.append(lt)
+
+                    # fields for the layer
+                    cC = pv_explorers.ColorList()
+                    cC.AddDepth('depth')
+                    if not disableValues:
+                        cC.AddLuminance('luminance')
+
+                sp.UpdatePipeline(ctime_float)
+
+                if specLevel != "A":
+                    numVals = 0
+                    if rep.Representation != 'Outline':
+                        numVals = pv_introspect.explore_customized_array_selection(
+                            name, sp, cC, userDefined, disableValues)
+
+                    if numVals == 0:
+                        cC.AddSolidColor('white', [1, 1, 1])
+                    col = pv_explorers.Color("color"+name, cC, rep)
+                    tracks.append(col)
+                    cols.append(col)
+
+    params = pv_introspect.optimize_traversal_order(params)
+
+    explo = ImageExplorer(cs, params, tracks, view_proxy, iSave,
+                          skipExisting=skipExisting, share=share)
+    explo.enableFloatValues(floatValues)
+
+    for c in cols:
+        c.imageExplorer = explo
+
+    eye_values = cs.metadata['camera_eye']
+    at_values = cs.metadata['camera_at']
+    up_values = cs.metadata['camera_up']
+    nearfar_values = cs.metadata['camera_nearfar']
+    viewangle_values = cs.metadata['camera_angle']
+
+    eye = [x for x in view_proxy.CameraPosition]
+    _fp = [x for x in view_proxy.CameraFocalPoint]
+    _cr = [x for x in view_proxy.CenterOfRotation]
+    at = pv_introspect.project_to_at(eye, _fp, _cr)
+    up = [x for x in view_proxy.CameraViewUp]
+    times = paraview.simple.GetAnimationScene().TimeKeeper.TimestepValues
+    if currentTime:
+        times = False
+
+    cam = paraview.simple.GetActiveCamera()
+
+    # if tracking is turned on, find out how to move
+    tracked_source = None
+    if 'object' in tracking:
+        # for now, just emulate animation's best mode with a mode that follows
+        # an object
+        objname = tracking['object']
+        tracked_source = paraview.simple.FindSource(objname)
+        if tracked_source is None:
+            name_upper = objname[0].upper() + objname[1:]
+            tracked_source = paraview.simple.FindSource(name_upper)
+
+    def record_camera():
+        eye_values.append([x for x in eye])
+        at_values.append([x for x in at])
+        up_values.append([x for x in up])
+        nearfar_values.append([x for x in cam.GetClippingRange()])
+        viewangle_values.append(cam.GetViewAngle())
+
+    def save_camera():
+        cs.add_metadata({'camera_eye': eye_values})
+        cs.add_metadata({'camera_at': at_values})
+        cs.add_metadata({'camera_up': up_values})
+        cs.add_metadata({'camera_nearfar': nearfar_values})
+        cs.add_metadata({'camera_angle': viewangle_values})
+
+    if not times:
+        eye, at, up = pv_introspect.track_source(tracked_source, eye, at, up)
+        try:
+            tprop = cs.get_parameter('time')
+            for i in range(len(tprop['values'])):
+                record_camera()
+        except (KeyError):
+            record_camera()
+        save_camera()
+        explo.explore(currentTime, progressObject)
+    else:
+        for t in times:
+            view_proxy.ViewTime = t
+            paraview.simple.Render(view_proxy)
+            minbds, maxbds = pv_introspect.max_bounds()
+            view_proxy.MaxClipBounds = [
+                minbds, maxbds, minbds, maxbds, minbds, maxbds]
+            eye, at, up = pv_introspect.track_source(tracked_source, eye, at, up)
+            record_camera()
+            save_camera()
+
+            pv_introspect.update_all_ranges(cs, arrayRanges)
+            explo.explore({'time': pv_introspect.float_limiter(t)},
+                          progressObject)
+
+    return cs.get_new_files()
+
+def export_scene(baseDirName, viewSelection, trackSelection, arraySelection,
+                 forcetime=False, writerThreads=0, skipExisting=False,
+                 distributeCameras=True):
+    """Same as `pv_introspect.export_scene`, with the following options.
+
+    - writerThreads: number of threads encoding and writing the images while
+      the next ones are rendered, 0 keeps the default of `cinema_python`.
+
+    - skipExisting: leaves out the images that are already in the database,
+      so that an interrupted export can be resumed.
+
+    - distributeCameras: when pvbatch runs with --time-compartments, each
+      compartment renders a share of the camera positions instead of all of
+      them. Only the first compartment writes the database descriptions.
+    """
+    pm = servermanager.vtkProcessModule.GetProcessModule()
+    share = (0, 1)
+    if distributeCameras:
+        share = (pm.GetTimeCompartmentId(), pm.GetNumberOfTimeCompartments())
+    pid = pm.GetPartitionId()
+
+    # save initial state
+    initialView = paraview.simple.GetActiveView()
+    pvstate = pv_introspect.record_visibility()
+
+    # a conservative global bounds for consistent z scaling
+    minbds, maxbds = pv_introspect.max_bounds()
+
+    atLeastOneViewExported = False
+    cinema_dirs = []
+    new_files = {}
+    for viewName, viewParams in viewSelection.items():
+
+        extension = os.path.splitext(viewParams[0])[1]
+
+        # check if this view was selected to export as spec b
+        cinemaParams = viewParams[6]
+        if len(cinemaParams) == 0:
+            print("Skipping view: Not selected to export to cinema")
+            continue
+
+        camType = "none"
+        if "camera" in cinemaParams and cinemaParams["camera"] != "none":
+            camType = cinemaParams["camera"]
+        if camType == "none":
+            print("Skipping view: Not selected to export to cinema.")
+            continue
+
+        specLevel = "A"
+        if "composite" in cinemaParams and cinemaParams["composite"] is True:
+            specLevel = "B"
+
+        # get the view and save the initial status
+        view = paraview.simple.FindView(viewName)
+        paraview.simple.SetActiveView(view)
+        view.ViewSize = [viewParams[4], viewParams[5]]
+
+        view.MaxClipBounds = [minbds, maxbds, minbds, maxbds, minbds, maxbds]
+        view.LockBounds = 1
+
+        fitToScreen = viewParams[2]
+        if fitToScreen != 0:
+            if view.IsA("vtkSMContextViewProxy") is True:
+                view.ResetDisplay()
+            elif view.IsA("vtkSMRenderViewProxy") is False:
+                print(' do not know what to do with a ', view.GetClassName())
+
+        userDefValues = pv_introspect.prepare_selection(trackSelection,
+                                                        arraySelection)
+        for key in ("theta", "phi", "roll"):
+            if key in cinemaParams:
+                userDefValues[key] = cinemaParams[key]
+
+        tracking_def = cinemaParams.get("tracking", {})
+
+        # generate file path
+        viewFileName = viewParams[0]
+        viewDirName = viewFileName[0:viewFileName.rfind("_")]  # strip _num.ext
+        filePath = os.path.join(baseDirName, viewDirName, "info.json")
+        cinema_dirs.append(viewDirName)
+
+        p = pv_introspect.inspect()
+
+        arrayRanges = {}
+        disableValues = cinemaParams.get('noValues', False)
+
+        definition = pv_introspect.make_cinema_store(
+            p, filePath, view, forcetime=forcetime,
+            userDefined=userDefValues,
+            specLevel=specLevel,
+            camType=camType,
+            arrayRanges=arrayRanges,
+            extension=extension,
+            disableValues=disableValues)
+        cs = FileStore(filePath, definition, writeDescription=(share[0] == 0))
+        set_writer_threads(cs, writerThreads)
+        enableFloatVal = cinemaParams.get('floatValues', False)
+
+        progObj = progress.ProgressObject()
+        progObj.StartEvent()
+        currentTime = None
+        if forcetime is not False:
+            currentTime = {'time': forcetime}
+        explore(cs, p, iSave=(pid == 0),
+                currentTime=currentTime,
+                userDefined=userDefValues,
+                specLevel=specLevel,
+                camType=camType,
+                tracking=tracking_def, floatValues=enableFloatVal,
+                arrayRanges=arrayRanges, disableValues=disableValues,
+                progressObject=progObj,
+                skipExisting=skipExisting, share=share)
+        progObj.EndEvent()
+        wait_for_writer(cs)
+
+        new_files[viewName] = cs.get_new_files()
+
+        view.LockBounds = 0
+
+        if pid == 0:
+            cs.save()
+        atLeastOneViewExported = True
+
+    if not atLeastOneViewExported:
+        print("No view was selected to export to cinema.")
+        return
+
+    if share[0] == 0:
+        pv_introspect.make_workspace_file(baseDirName, cinema_dirs)
+
+    # restore initial state
+    paraview.simple.SetActiveView(initialView)
+    pv_introspect.restore_visibility(pvstate)
+    return new_files
@@ -1247,6 +1247,11 @@ def SaveAnimation(filename, viewOrLayout=None, scene=None, **params):
           To save a part of the animation, provide the range in frames or
           timesteps index.
 
+        EncoderThreads (int)
+          Number of threads encoding and writing frames while the next frames
+          are rendered. Defaults to 0, which writes each frame before rendering
+          the next one. Movie formats (`avi` or `ogv`) use at most one thread.
+
     In addition, several format-specific keyword parameters can be specified.
     The format is chosen based on the file extension.
 